@@ -0,0 +1,106 @@
+// Benchmark: connection handshakes per 1000 metadata calls.
+//
+// By default an in-process mock server is started. Pass --url to target any
+// other stand-in instead (e.g. an HTTPS terminator in front of the mock, with
+// --insecure for a self-signed certificate); every new connection counted here
+// is then a TCP + TLS handshake.
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "YandexDiskClient.h"
+#include "MockDiskServer.h"
+
+namespace {
+    struct Result {
+        std::size_t calls = 0;
+        std::size_t handshakes = 0;
+        double seconds = 0;
+    };
+
+    void report(const std::string& name, const Result& r) {
+        std::cout << name << ": " << r.calls << " calls, "
+                  << r.handshakes << " handshakes ("
+                  << (r.calls ? r.handshakes * 1000.0 / r.calls : 0.0) << " per 1000), "
+                  << r.seconds << " s, "
+                  << (r.seconds > 0 ? r.calls / r.seconds : 0.0) << " calls/s" << std::endl;
+    }
+
+    YandexDiskClient::Options makeOptions(const std::string& url, bool insecure, std::size_t pool) {
+        YandexDiskClient::Options options;
+        options.api_base_url = url;
+        options.verify_tls = !insecure;
+        options.connection_pool_size = pool;
+        return options;
+    }
+
+    // A fresh client per call: the behaviour before connection pooling.
+    Result runUnpooled(const std::string& url, bool insecure, std::size_t calls) {
+        Result r;
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < calls; ++i) {
+            YandexDiskClient client("bench-token", makeOptions(url, insecure, 1));
+            client.exists("/");
+            r.handshakes += client.connectionStats().connections_opened;
+        }
+        r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        r.calls = calls;
+        return r;
+    }
+
+    Result runPooled(const std::string& url, bool insecure, std::size_t calls, std::size_t threads) {
+        YandexDiskClient client("bench-token", makeOptions(url, insecure, threads));
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> workers;
+        for (std::size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                for (std::size_t i = t; i < calls; i += threads) client.exists("/");
+            });
+        }
+        for (auto& w : workers) w.join();
+
+        Result r;
+        r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        auto stats = client.connectionStats();
+        r.calls = stats.requests;
+        r.handshakes = stats.connections_opened;
+        return r;
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string url;
+    bool insecure = false;
+    std::size_t calls = 1000;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--url" && i + 1 < argc) url = argv[++i];
+        else if (arg == "--insecure") insecure = true;
+        else if (arg == "--calls" && i + 1 < argc) calls = std::stoul(argv[++i]);
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--url API_URL] [--insecure] [--calls N]" << std::endl;
+            return 2;
+        }
+    }
+
+    std::unique_ptr<MockDiskServer> server;
+    if (url.empty()) {
+        server = std::make_unique<MockDiskServer>();
+        server->start();
+        url = server->apiUrl();
+    }
+
+    std::cout << "Target: " << url << std::endl;
+    report("unpooled (client per call)", runUnpooled(url, insecure, calls));
+    report("pooled, 1 thread", runPooled(url, insecure, calls, 1));
+    report("pooled, 8 threads", runPooled(url, insecure, calls, 8));
+
+    if (server) {
+        std::cout << "Server accepted " << server->stats().connections_accepted
+                  << " connections in total" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,92 @@
+// Benchmark: single-stream download vs ranged multi-connection download.
+//
+// By default an in-process mock server is started with a per-connection
+// bandwidth cap (the situation ranged downloads are meant for) and a test
+// file is stored on it. Pass --url and --path to download an existing file
+// from any other Range-capable stand-in instead.
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+#include "YandexDiskClient.h"
+#include "MockDiskServer.h"
+
+namespace {
+    constexpr double kMiB = 1024.0 * 1024.0;
+
+    void report(const std::string& name, uint64_t bytes, double seconds) {
+        std::cout << name << ": " << bytes / kMiB << " MiB in " << seconds << " s, "
+                  << (seconds > 0 ? bytes / kMiB / seconds : 0.0) << " MiB/s" << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string url;
+    std::string disk_path = "/bench/large.bin";
+    bool insecure = false;
+    uint64_t size_mb = 256;
+    uint64_t bandwidth_mb = 32;
+    std::size_t streams = 8;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--url" && i + 1 < argc) url = argv[++i];
+        else if (arg == "--path" && i + 1 < argc) disk_path = argv[++i];
+        else if (arg == "--insecure") insecure = true;
+        else if (arg == "--size-mb" && i + 1 < argc) size_mb = std::stoull(argv[++i]);
+        else if (arg == "--bandwidth-mb" && i + 1 < argc) bandwidth_mb = std::stoull(argv[++i]);
+        else if (arg == "--streams" && i + 1 < argc) streams = std::stoul(argv[++i]);
+        else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--url API_URL --path DISK_PATH] [--insecure] [--size-mb N]"
+                         " [--bandwidth-mb N] [--streams N]" << std::endl;
+            return 2;
+        }
+    }
+
+    std::unique_ptr<MockDiskServer> server;
+    if (url.empty()) {
+        MockServerConfig config;
+        config.bandwidth_bytes_per_sec = bandwidth_mb * 1024 * 1024;
+        server = std::make_unique<MockDiskServer>(config);
+        server->start();
+        server->putFile(disk_path, std::string(size_mb * 1024 * 1024, 'x'));
+        url = server->apiUrl();
+        std::cout << "Mock server, " << bandwidth_mb << " MiB/s per connection" << std::endl;
+    }
+    std::cout << "Target: " << url << " " << disk_path << std::endl;
+
+    YandexDiskClient::Options options;
+    options.api_base_url = url;
+    options.verify_tls = !insecure;
+    options.connection_pool_size = streams;
+    YandexDiskClient client("bench-token", options);
+
+    namespace fs = std::filesystem;
+    fs::path dir = fs::temp_directory_path() / "ydisk-bench-ranged";
+    fs::create_directories(dir);
+    fs::path local = dir / fs::path(disk_path).filename();
+
+    auto start = std::chrono::steady_clock::now();
+    client.downloadFile(disk_path, dir.string());
+    double single = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    report("single stream", fs::file_size(local), single);
+
+    YandexDiskClient::RangedDownloadOptions fixed;
+    fixed.max_streams = streams;
+    fixed.adaptive = false;
+    auto r = client.downloadFileRanged(disk_path, dir.string(), fixed);
+    report("ranged, " + std::to_string(r.peak_streams) + " streams x " +
+           std::to_string(r.final_chunk_size >> 20) + " MiB", r.bytes_transferred, r.elapsed_seconds);
+
+    YandexDiskClient::RangedDownloadOptions adaptive;
+    adaptive.max_streams = streams;
+    r = client.downloadFileRanged(disk_path, dir.string(), adaptive);
+    report("ranged, adaptive (peak " + std::to_string(r.peak_streams) + " streams, final chunk " +
+           std::to_string(r.final_chunk_size >> 20) + " MiB, " + std::to_string(r.chunks) + " chunks)",
+           r.bytes_transferred, r.elapsed_seconds);
+
+    fs::remove_all(dir);
+    return 0;
+}
@@ -0,0 +1,10 @@
+#ifndef YANDEX_DISK_BENCH_ALLOCATIONS_H
+#define YANDEX_DISK_BENCH_ALLOCATIONS_H
+
+#pragma once
+#include <cstdint>
+
+/// Heap allocations made through operator new since the process started.
+uint64_t allocationCount();
+
+#endif //YANDEX_DISK_BENCH_ALLOCATIONS_H
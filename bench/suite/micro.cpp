@@ -0,0 +1,338 @@
+// Micro benchmarks: URL construction and escaping (with heap allocations per
+// URL), JSON parsing of listings, the formatting helpers and the transform
+// stages by stage and thread count. Nothing here touches the network.
+#include <benchmark/benchmark.h>
+#include <curl/curl.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "YandexDiskClient.h"
+#include "QueryString.h"
+#include "ResourceListing.h"
+#include "TransformPipeline.h"
+#include "allocations.h"
+
+namespace {
+    // Reports heap allocations per iteration of the timed loop.
+    class AllocationCounter {
+    public:
+        AllocationCounter() : start(allocationCount()) {}
+
+        void report(benchmark::State& state) const {
+            const uint64_t count = allocationCount() - start;
+            state.counters["allocs_per_iter"] = benchmark::Counter(
+                    static_cast<double>(count), benchmark::Counter::kAvgIterations);
+        }
+
+    private:
+        uint64_t start;
+    };
+
+    // A disk path of about the given length, mixing ASCII, spaces and Cyrillic.
+    std::string diskPath(std::size_t length) {
+        const std::string parts[] = {"Documents", "Отчёты 2024", "photos", "черновик", "a b c", "v1.2"};
+        std::string path = "disk:";
+        for (std::size_t i = 0; path.size() < length; ++i) path += "/" + parts[i % 6];
+        return path;
+    }
+
+    nlohmann::json listingItem(std::size_t i) {
+        const std::string name = "file-" + std::to_string(i) + ".jpg";
+        nlohmann::json item = {
+                {"name", name},
+                {"path", "disk:/bench/" + name},
+                {"type", "file"},
+                {"size", 1000 + i * 37},
+                {"md5", "d41d8cd98f00b204e9800998ecf8427e"},
+                {"sha256", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"},
+                {"mime_type", "image/jpeg"},
+                {"media_type", "image"},
+                {"created", "2024-05-01T10:00:00+00:00"},
+                {"modified", "2024-05-01T10:00:00+00:00"},
+                {"resource_id", "123456789:" + std::to_string(i)},
+                {"revision", 1714557600000000 + i},
+        };
+        if (i % 10 == 0) item["public_url"] = "https://yadi.sk/d/" + std::to_string(i);
+        return item;
+    }
+
+    // A resource list response as returned by GET /resources.
+    nlohmann::json listing(std::size_t items) {
+        nlohmann::json list = nlohmann::json::array();
+        for (std::size_t i = 0; i < items; ++i) list.push_back(listingItem(i));
+        return {
+                {"name", "bench"},
+                {"path", "disk:/bench"},
+                {"type", "dir"},
+                {"_embedded", {{"items", list}, {"limit", items}, {"offset", 0},
+                               {"total", items}, {"path", "disk:/bench"}}},
+        };
+    }
+
+    // Log lines: the highly compressible kind of body transforms are for.
+    const std::string& logBody() {
+        static const std::string body = [] {
+            std::string text;
+            for (uint64_t i = 0; text.size() < 64u << 20; ++i) {
+                text += "2024-05-01T10:" + std::to_string(10 + i % 50) + ":00." + std::to_string(i % 1000) +
+                        "Z INFO http request_id=" + std::to_string(i * 2654435761u % 1000003) +
+                        " method=GET path=/v1/disk/resources status=200 latency_ms=" +
+                        std::to_string(i % 97) + "\n";
+            }
+            text.resize(64u << 20);
+            return text;
+        }();
+        return body;
+    }
+
+    std::vector<YandexDiskClient::TransformStage> transformStages(int64_t id) {
+        using Stage = YandexDiskClient::TransformStage;
+        const std::string key(32, '\x5a');
+        switch (id) {
+            case 0: return {Stage::zstd()};
+            case 1: return {Stage::gzip()};
+            case 2: return {Stage::aesGcm(key)};
+            default: return {Stage::zstd(), Stage::aesGcm(key)};
+        }
+    }
+
+    const char* transformLabel(int64_t id) {
+        const char* labels[] = {"zstd", "gzip", "aes-gcm", "zstd+aes-gcm"};
+        return labels[id];
+    }
+
+    // Formatting helpers are members; the client never connects here.
+    YandexDiskClient& offlineClient() {
+        static YandexDiskClient client("bench-token", [] {
+            YandexDiskClient::Options options;
+            options.api_base_url = "http://127.0.0.1:9/v1/disk";
+            return options;
+        }());
+        return client;
+    }
+}
+
+static void BM_BuildUrl(benchmark::State& state) {
+    const std::string endpoint = "https://cloud-api.yandex.net/v1/disk/resources";
+    const std::map<std::string, std::string> params = {
+            {"path", diskPath(static_cast<std::size_t>(state.range(0)))},
+            {"fields", "_embedded.items.name,_embedded.items.path,_embedded.items.size"},
+            {"limit", "1000"},
+            {"offset", "0"},
+    };
+    AllocationCounter counter;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(QueryString::build(endpoint, params));
+    }
+    counter.report(state);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BuildUrl)->Arg(16)->Arg(128)->Arg(1024);
+
+// The same URL through the thread's reusable buffer: no map, no result
+// string; after the first iteration nothing should allocate.
+static void BM_UrlBuilder(benchmark::State& state) {
+    const std::string base = "https://cloud-api.yandex.net/v1/disk";
+    const std::string path = diskPath(static_cast<std::size_t>(state.range(0)));
+    const std::string fields = "_embedded.items.name,_embedded.items.path,_embedded.items.size";
+    { UrlBuilder warm(base, "/resources"); warm.param("path", path).param("fields", fields); }
+    AllocationCounter counter;
+    for (auto _ : state) {
+        UrlBuilder url(base, "/resources");
+        url.param("path", path).param("fields", fields).param("limit", 1000).param("offset", 0);
+        benchmark::DoNotOptimize(url.url().data());
+    }
+    counter.report(state);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_UrlBuilder)->Arg(16)->Arg(128)->Arg(1024);
+
+// Percent-encoding alone: the table-driven encoder against libcurl's, which
+// needs an easy handle and returns a fresh string per call.
+static void BM_EscapeTable(benchmark::State& state) {
+    const std::string path = diskPath(static_cast<std::size_t>(state.range(0)));
+    std::string out;
+    out.reserve(path.size() * 3);
+    for (auto _ : state) {
+        out.clear();
+        QueryString::appendEscaped(out, path);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(path.size()));
+}
+BENCHMARK(BM_EscapeTable)->Arg(16)->Arg(128)->Arg(1024);
+
+static void BM_EscapeCurl(benchmark::State& state) {
+    const std::string path = diskPath(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state) {
+        CURL* curl = curl_easy_init();
+        char* escaped = curl_easy_escape(curl, path.c_str(), static_cast<int>(path.size()));
+        benchmark::DoNotOptimize(escaped);
+        curl_free(escaped);
+        curl_easy_cleanup(curl);
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(path.size()));
+}
+BENCHMARK(BM_EscapeCurl)->Arg(16)->Arg(128)->Arg(1024);
+
+static void BM_ParseQuery(benchmark::State& state) {
+    const std::string url = QueryString::build("https://cloud-api.yandex.net/v1/disk/resources",
+                                               {{"path", diskPath(128)}, {"limit", "1000"}, {"offset", "0"}});
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(QueryString::parse(url));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ParseQuery);
+
+static void BM_ParseListing(benchmark::State& state) {
+    const std::string body = listing(static_cast<std::size_t>(state.range(0))).dump();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(nlohmann::json::parse(body));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(body.size()));
+}
+BENCHMARK(BM_ParseListing)->Arg(100)->Arg(1000)->Arg(10000)->Unit(benchmark::kMicrosecond);
+
+// DOM parse plus the per-item lookups listing consumers used to make,
+// against the streaming parse into typed entries below.
+static void BM_ListingDom(benchmark::State& state) {
+    const std::string body = listing(static_cast<std::size_t>(state.range(0))).dump();
+    for (auto _ : state) {
+        nlohmann::json page = nlohmann::json::parse(body);
+        uint64_t bytes = 0;
+        for (const auto& item : page["_embedded"]["items"]) {
+            std::string name = item.value("name", "");
+            std::string path = item.value("path", "");
+            std::string type = item.value("type", "");
+            std::string md5 = item.value("md5", "");
+            std::string modified = item.value("modified", "");
+            bytes += item.value("size", uint64_t{0}) + name.size() + path.size() + type.size() +
+                     md5.size() + modified.size();
+        }
+        benchmark::DoNotOptimize(bytes);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(body.size()));
+}
+BENCHMARK(BM_ListingDom)->Arg(1000)->Arg(10000)->Unit(benchmark::kMicrosecond);
+
+static void BM_ListingStreaming(benchmark::State& state) {
+    const std::string body = listing(static_cast<std::size_t>(state.range(0))).dump();
+    ResourceListing page;
+    for (auto _ : state) {
+        page.parse(body);
+        uint64_t bytes = 0;
+        for (const auto& item : page.items()) {
+            bytes += item.size + item.name.size() + item.path.size() + item.type.size() +
+                     item.md5.size() + item.modified.size();
+        }
+        benchmark::DoNotOptimize(bytes);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(body.size()));
+}
+BENCHMARK(BM_ListingStreaming)->Arg(1000)->Arg(10000)->Unit(benchmark::kMicrosecond);
+
+// One stage (or zstd then AES-GCM) over 64 MiB of logs, by thread count.
+// Bytes are those of the plain body; 1 Gbit/s is about 119 MiB/s.
+static void BM_TransformEncode(benchmark::State& state) {
+    const std::string& body = logBody();
+    YandexDiskClient::TransformOptions options;
+    options.stages = transformStages(state.range(0));
+    options.threads = static_cast<std::size_t>(state.range(1));
+    state.SetLabel(transformLabel(state.range(0)));
+    try {
+        TransformBody probe(std::make_shared<MemoryBody>(body.data(), 0), options);
+    } catch (const std::exception& ex) {
+        state.SkipWithError(ex.what());
+        return;
+    }
+    std::vector<char> buffer(512 * 1024);
+    uint64_t encoded = 0;
+    for (auto _ : state) {
+        TransformBody transformed(std::make_shared<MemoryBody>(body.data(), body.size()), options);
+        encoded = 0;
+        while (std::size_t n = transformed.read(buffer.data(), buffer.size())) encoded += n;
+    }
+    state.counters["ratio"] = static_cast<double>(body.size()) / static_cast<double>(encoded);
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(body.size()));
+}
+BENCHMARK(BM_TransformEncode)
+        ->ArgsProduct({{0, 1, 2, 3}, {1, 4}})
+        ->ArgNames({"stages", "threads"})
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
+
+static void BM_TransformDecode(benchmark::State& state) {
+    const std::string& body = logBody();
+    YandexDiskClient::TransformOptions options;
+    options.stages = transformStages(state.range(0));
+    options.threads = static_cast<std::size_t>(state.range(1));
+    state.SetLabel(transformLabel(state.range(0)));
+    std::string encoded;
+    try {
+        TransformBody transformed(std::make_shared<MemoryBody>(body.data(), body.size()), options);
+        std::vector<char> buffer(512 * 1024);
+        while (std::size_t n = transformed.read(buffer.data(), buffer.size())) encoded.append(buffer.data(), n);
+    } catch (const std::exception& ex) {
+        state.SkipWithError(ex.what());
+        return;
+    }
+    for (auto _ : state) {
+        uint64_t decoded = 0;
+        CallbackTarget sink([&](const char*, std::size_t size) {
+            decoded += size;
+            return true;
+        });
+        TransformTarget target(sink, options);
+        // Pieces the size libcurl hands over.
+        for (std::size_t pos = 0; pos < encoded.size(); pos += 512 * 1024) {
+            target.write(encoded.data() + pos, std::min<std::size_t>(512 * 1024, encoded.size() - pos));
+        }
+        target.finish();
+        benchmark::DoNotOptimize(decoded);
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(body.size()));
+}
+BENCHMARK(BM_TransformDecode)
+        ->ArgsProduct({{0, 1, 2, 3}, {1, 4}})
+        ->ArgNames({"stages", "threads"})
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
+
+static void BM_FormatResourceList(benchmark::State& state) {
+    const nlohmann::json list = listing(static_cast<std::size_t>(state.range(0)));
+    YandexDiskClient& client = offlineClient();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(client.formatResourceList(list));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FormatResourceList)->Arg(100)->Arg(1000)->Arg(10000)->Unit(benchmark::kMicrosecond);
+
+static void BM_FormatTrashResourceList(benchmark::State& state) {
+    nlohmann::json list = listing(static_cast<std::size_t>(state.range(0)));
+    for (auto& item : list["_embedded"]["items"]) {
+        item["origin_path"] = item["path"];
+        item["deleted"] = "2024-06-01T10:00:00+00:00";
+    }
+    YandexDiskClient& client = offlineClient();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(client.formatTrashResourceList(list));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FormatTrashResourceList)->Arg(100)->Arg(1000)->Unit(benchmark::kMicrosecond);
+
+static void BM_FormatQuotaInfo(benchmark::State& state) {
+    const nlohmann::json quota = {
+            {"total_space", 1099511627776ULL}, {"used_space", 351843720888ULL}, {"trash_size", 1073741824ULL}};
+    YandexDiskClient& client = offlineClient();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(client.formatQuotaInfo(quota));
+    }
+}
+BENCHMARK(BM_FormatQuotaInfo);
@@ -0,0 +1,322 @@
+// End-to-end benchmarks against an in-process mock server: file uploads and
+// downloads by size, directory listings by entry count, metadata calls by
+// thread count, directory transfers by file count and worker count, and
+// small-file uploads one by one against packed.
+//
+// The mock answers without latency, so these measure the client's own
+// overhead per request and per byte rather than any network.
+//
+// The local tree benchmarks walk a synthetic tree of empty files, 100k
+// entries unless YDISK_BENCH_TREE_ENTRIES says otherwise (e.g. 10000000).
+// The tree is kept in the temp directory between runs, since writing ten
+// million files takes far longer than walking them.
+#include <benchmark/benchmark.h>
+#include <sys/resource.h>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+#include "YandexDiskClient.h"
+#include "MockDiskServer.h"
+#include "LocalTreeWalker.h"
+
+namespace {
+    namespace fs = std::filesystem;
+
+    constexpr std::size_t kDirectoryFileSize = 16 * 1024;
+
+    struct Environment {
+        MockDiskServer server;
+        std::unique_ptr<YandexDiskClient> client;
+        fs::path local_root = fs::temp_directory_path() / "ydisk-bench-suite";
+
+        Environment() {
+            server.start();
+            YandexDiskClient::Options options;
+            options.api_base_url = server.apiUrl();
+            options.connection_pool_size = 16;
+            client = std::make_unique<YandexDiskClient>("bench-token", options);
+            server.makeDirectory("/bench");
+            fs::remove_all(local_root);
+            fs::create_directories(local_root);
+        }
+
+        ~Environment() {
+            std::error_code ec;
+            fs::remove_all(local_root, ec);
+        }
+    };
+
+    Environment& environment() {
+        static Environment env;
+        return env;
+    }
+
+    std::string content(std::size_t size) {
+        std::string data(size, '\0');
+        for (std::size_t i = 0; i < size; ++i) data[i] = static_cast<char>(i * 131 + (i >> 12));
+        return data;
+    }
+
+    // Seeds a remote directory of `files` files once per process.
+    std::string remoteDirectory(std::size_t files, std::size_t file_size) {
+        static std::mutex mutex;
+        static std::set<std::string> seeded;
+        const std::string path = "/bench/dir-" + std::to_string(files) + "x" + std::to_string(file_size);
+        std::lock_guard<std::mutex> lock(mutex);
+        if (seeded.insert(path).second) {
+            Environment& env = environment();
+            const std::string data = content(file_size);
+            env.server.makeDirectory(path);
+            for (std::size_t i = 0; i < files; ++i) env.server.putFile(path + "/f" + std::to_string(i), data);
+        }
+        return path;
+    }
+
+    // Writes a local directory of `files` files once per process.
+    fs::path localDirectory(std::size_t files, std::size_t file_size) {
+        fs::path path = environment().local_root / ("up-" + std::to_string(files) + "x" + std::to_string(file_size));
+        if (!fs::exists(path)) {
+            fs::create_directories(path);
+            const std::string data = content(file_size);
+            for (std::size_t i = 0; i < files; ++i) {
+                std::ofstream(path / ("f" + std::to_string(i)), std::ios::binary)
+                        .write(data.data(), static_cast<std::streamsize>(data.size()));
+            }
+        }
+        return path;
+    }
+
+    std::size_t treeEntries() {
+        const char* value = std::getenv("YDISK_BENCH_TREE_ENTRIES");
+        return value && *value ? std::strtoull(value, nullptr, 10) : 100000;
+    }
+
+    // A tree of about `entries` empty files, 1000 per directory and 100
+    // directories per parent. Written once and reused by later runs.
+    fs::path syntheticTree(std::size_t entries) {
+        fs::path root = fs::temp_directory_path() / ("ydisk-bench-tree-" + std::to_string(entries));
+        if (fs::exists(root / ".complete")) return root;
+        fs::remove_all(root);
+        for (std::size_t dir = 0; dir * 1000 < entries; ++dir) {
+            fs::path path = root / ("g" + std::to_string(dir / 100)) / ("d" + std::to_string(dir));
+            fs::create_directories(path);
+            for (std::size_t i = dir * 1000; i < entries && i < (dir + 1) * 1000; ++i) {
+                std::ofstream(path / ("f" + std::to_string(i)));
+            }
+        }
+        std::ofstream(root / ".complete");
+        return root;
+    }
+
+    // Growth of the process's peak resident set, in MiB.
+    class PeakMemory {
+    public:
+        PeakMemory() : start(peakKiB()) {}
+
+        void report(benchmark::State& state) const {
+            state.counters["peak_rss_growth_mib"] = static_cast<double>(peakKiB() - start) / 1024.0;
+        }
+
+    private:
+        static long peakKiB() {
+            rusage usage{};
+            getrusage(RUSAGE_SELF, &usage);
+            return usage.ru_maxrss;
+        }
+
+        long start;
+    };
+}
+
+static void BM_UploadFile(benchmark::State& state) {
+    Environment& env = environment();
+    const std::string data = content(static_cast<std::size_t>(state.range(0)));
+    const std::string path = "/bench/upload-" + std::to_string(state.range(0));
+    for (auto _ : state) {
+        env.client->uploadFile(path, YandexDiskClient::UploadSource::memory(data.data(), data.size()));
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_UploadFile)->Arg(4 << 10)->Arg(1 << 20)->Arg(16 << 20)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_DownloadFile(benchmark::State& state) {
+    Environment& env = environment();
+    const std::string path = "/bench/download-" + std::to_string(state.range(0));
+    env.server.putFile(path, content(static_cast<std::size_t>(state.range(0))));
+    auto discard = YandexDiskClient::DownloadSink::callback([](const char*, std::size_t) { return true; });
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(env.client->downloadFile(path, discard));
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DownloadFile)->Arg(4 << 10)->Arg(1 << 20)->Arg(16 << 20)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_ListDirectory(benchmark::State& state) {
+    Environment& env = environment();
+    const std::string path = remoteDirectory(static_cast<std::size_t>(state.range(0)), 0);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(env.client->forEachResource(path, [](const nlohmann::json&) { return true; }));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ListDirectory)->Arg(100)->Arg(1000)->Arg(10000)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// One client shared by all benchmark threads, as an application would.
+static void BM_GetResourceInfo(benchmark::State& state) {
+    Environment& env = environment();
+    const std::string path = remoteDirectory(1, 1024) + "/f0";
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(env.client->getResourceInfo(path));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GetResourceInfo)->ThreadRange(1, 16)->UseRealTime();
+
+static void BM_UploadDirectory(benchmark::State& state) {
+    Environment& env = environment();
+    const std::size_t files = static_cast<std::size_t>(state.range(0));
+    const fs::path local = localDirectory(files, kDirectoryFileSize);
+    YandexDiskClient::TransferOptions options;
+    options.workers = static_cast<std::size_t>(state.range(1));
+    const std::string target = "/bench/updir-" + std::to_string(files) + "-" + std::to_string(state.range(1));
+    env.server.makeDirectory(target);
+    for (auto _ : state) {
+        auto report = env.client->uploadDirectory(target, local.string(), options);
+        if (report.files_failed > 0) {
+            state.SkipWithError("upload failed");
+            break;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(state.iterations() * state.range(0) * static_cast<int64_t>(kDirectoryFileSize));
+}
+BENCHMARK(BM_UploadDirectory)
+        ->ArgsProduct({{16, 256}, {1, 4, 16}})
+        ->ArgNames({"files", "workers"})
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
+
+static void BM_DownloadDirectory(benchmark::State& state) {
+    Environment& env = environment();
+    const std::size_t files = static_cast<std::size_t>(state.range(0));
+    const std::string remote = remoteDirectory(files, kDirectoryFileSize);
+    const fs::path local = env.local_root / ("down-" + std::to_string(files) + "-" + std::to_string(state.range(1)));
+    YandexDiskClient::TransferOptions options;
+    options.workers = static_cast<std::size_t>(state.range(1));
+    for (auto _ : state) {
+        state.PauseTiming();
+        fs::remove_all(local);
+        state.ResumeTiming();
+        auto report = env.client->downloadDirectory(remote, local.string(), options);
+        if (report.files_failed > 0) {
+            state.SkipWithError("download failed");
+            break;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(state.iterations() * state.range(0) * static_cast<int64_t>(kDirectoryFileSize));
+}
+BENCHMARK(BM_DownloadDirectory)
+        ->ArgsProduct({{16, 256}, {1, 4, 16}})
+        ->ArgNames({"files", "workers"})
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
+
+// Many small files sent one request each, or in tar packs of pack_size.
+static void BM_UploadSmallFiles(benchmark::State& state) {
+    Environment& env = environment();
+    const std::size_t files = static_cast<std::size_t>(state.range(0));
+    const fs::path local = localDirectory(files, 1024);
+    YandexDiskClient::TransferOptions options;
+    options.workers = 16;
+    if (state.range(1)) {
+        options.pack_threshold = 64 * 1024;
+        options.pack_size = 256 * 1024;
+    }
+    const std::string target = "/bench/small-" + std::to_string(files) + "-" + std::to_string(state.range(1));
+    env.server.makeDirectory(target);
+    for (auto _ : state) {
+        auto report = env.client->uploadDirectory(target, local.string(), options);
+        if (report.files_failed > 0) {
+            state.SkipWithError("upload failed");
+            break;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(state.iterations() * state.range(0) * 1024);
+}
+BENCHMARK(BM_UploadSmallFiles)
+        ->ArgsProduct({{256, 4096}, {0, 1}})
+        ->ArgNames({"files", "packed"})
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
+
+// Lazy walk of the tree: peak memory should not move with its size.
+// Registered before the collecting walk so the peak it reports is its own.
+static void BM_WalkLocalTree(benchmark::State& state) {
+    const fs::path tree = syntheticTree(treeEntries());
+    PeakMemory memory;
+    std::size_t entries = 0;
+    for (auto _ : state) {
+        LocalTreeWalker walker(tree.string());
+        LocalTreeWalker::Entry entry;
+        while (walker.next(entry)) ++entries;
+    }
+    memory.report(state);
+    state.SetItemsProcessed(static_cast<int64_t>(entries));
+}
+BENCHMARK(BM_WalkLocalTree)->Iterations(1)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// What a transfer that lists the tree up front holds: one record per file.
+static void BM_CollectLocalTree(benchmark::State& state) {
+    struct File {
+        std::string local;
+        std::string relative;
+        uint64_t size;
+    };
+    const fs::path tree = syntheticTree(treeEntries());
+    PeakMemory memory;
+    std::size_t entries = 0;
+    for (auto _ : state) {
+        std::vector<File> files;
+        for (auto it = fs::recursive_directory_iterator(tree); it != fs::recursive_directory_iterator(); ++it) {
+            if (it->is_regular_file()) {
+                files.push_back({it->path().string(), it->path().lexically_relative(tree).generic_string(),
+                                 it->file_size()});
+            }
+        }
+        entries += files.size();
+        benchmark::DoNotOptimize(files.data());
+    }
+    memory.report(state);
+    state.SetItemsProcessed(static_cast<int64_t>(entries));
+}
+BENCHMARK(BM_CollectLocalTree)->Iterations(1)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// The whole upload of the tree. Peak memory here includes the mock, which
+// keeps every uploaded file in its in-memory disk.
+static void BM_UploadTree(benchmark::State& state) {
+    Environment& env = environment();
+    const std::size_t entries = treeEntries();
+    const fs::path tree = syntheticTree(entries);
+    YandexDiskClient::TransferOptions options;
+    options.workers = 16;
+    const std::string target = "/bench/tree-" + std::to_string(entries);
+    env.server.makeDirectory(target);
+    PeakMemory memory;
+    for (auto _ : state) {
+        auto report = env.client->uploadDirectory(target, tree.string(), options);
+        if (report.files_failed > 0) {
+            state.SkipWithError("upload failed");
+            break;
+        }
+    }
+    memory.report(state);
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(entries));
+}
+BENCHMARK(BM_UploadTree)->Iterations(1)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,116 @@
+// Benchmark: client CPU time per GiB uploaded, for each upload source.
+//
+// An in-process mock server receives the uploads; only the CPU time of the
+// uploading thread (where libcurl runs) is counted, so the server's own work
+// is excluded. Pass --url to upload to any other stand-in instead.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "YandexDiskClient.h"
+#include "MockDiskServer.h"
+
+namespace {
+    constexpr double kGiB = 1024.0 * 1024.0 * 1024.0;
+    constexpr double kMiB = 1024.0 * 1024.0;
+
+    double threadCpuSeconds() {
+        timespec ts{};
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+    }
+
+    void run(const std::string& name, uint64_t bytes, std::size_t rounds,
+             const std::function<void()>& upload) {
+        double cpu = 0, wall = 0;
+        for (std::size_t i = 0; i < rounds; ++i) {
+            double cpu_start = threadCpuSeconds();
+            auto start = std::chrono::steady_clock::now();
+            upload();
+            wall += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            cpu += threadCpuSeconds() - cpu_start;
+        }
+        double gib = bytes * rounds / kGiB;
+        std::cout << name << ": " << cpu / gib << " CPU s/GiB, "
+                  << (wall > 0 ? bytes * rounds / kMiB / wall : 0.0) << " MiB/s" << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string url;
+    bool insecure = false;
+    uint64_t size_mb = 256;
+    std::size_t rounds = 4;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--url" && i + 1 < argc) url = argv[++i];
+        else if (arg == "--insecure") insecure = true;
+        else if (arg == "--size-mb" && i + 1 < argc) size_mb = std::stoull(argv[++i]);
+        else if (arg == "--rounds" && i + 1 < argc) rounds = std::stoul(argv[++i]);
+        else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--url API_URL] [--insecure] [--size-mb N] [--rounds N]" << std::endl;
+            return 2;
+        }
+    }
+
+    std::unique_ptr<MockDiskServer> server;
+    if (url.empty()) {
+        server = std::make_unique<MockDiskServer>();
+        server->start();
+        url = server->apiUrl();
+    }
+
+    YandexDiskClient::Options options;
+    options.api_base_url = url;
+    options.verify_tls = !insecure;
+    YandexDiskClient client("bench-token", options);
+    client.createDirectory("/bench-upload");
+
+    const uint64_t size = size_mb * 1024 * 1024;
+    std::vector<char> buffer(size);
+    for (uint64_t i = 0; i < size; ++i) buffer[i] = static_cast<char>(i * 131 + (i >> 12));
+
+    namespace fs = std::filesystem;
+    fs::path local = fs::temp_directory_path() / "ydisk-bench-upload.bin";
+    std::ofstream(local, std::ios::binary).write(buffer.data(), static_cast<std::streamsize>(size));
+    std::cout << size_mb << " MiB x " << rounds << " rounds" << std::endl;
+
+    // Closest to uploads before upload sources: a FILE* read with fread()
+    // from libcurl's read callback.
+    run("FILE* + fread producer", size, rounds, [&] {
+        FILE* file = fopen(local.c_str(), "rb");
+        client.uploadFile("/bench-upload/stdio.bin", YandexDiskClient::UploadSource::producer(
+                [file](char* out, std::size_t capacity) { return fread(out, 1, capacity, file); }, size));
+        fclose(file);
+    });
+    run("memory-mapped file", size, rounds, [&] {
+        client.uploadFile("/bench-upload/mmap.bin", YandexDiskClient::UploadSource::file(local.string()));
+    });
+    run("memory buffer", size, rounds, [&] {
+        client.uploadFile("/bench-upload/memory.bin",
+                          YandexDiskClient::UploadSource::memory(buffer.data(), buffer.size()));
+    });
+    run("producer, chunked", size, rounds, [&] {
+        uint64_t offset = 0;
+        client.uploadFile("/bench-upload/producer.bin", YandexDiskClient::UploadSource::producer(
+                [&](char* out, std::size_t capacity) {
+                    std::size_t n = static_cast<std::size_t>(std::min<uint64_t>(capacity, size - offset));
+                    std::memcpy(out, buffer.data() + offset, n);
+                    offset += n;
+                    return n;
+                }));
+    });
+
+    fs::remove(local);
+    return 0;
+}
@@ -16,6 +16,16 @@ int main() {
         // Upload a local directory to Yandex.Disk
         yandex.uploadDirectory("/backup_folder", "C:/local/backup_folder");
 
+        // Upload with 16 parallel workers and collect per-file errors
+        YandexDiskClient::TransferOptions transfer;
+        transfer.workers = 16;
+        auto report = yandex.uploadDirectory("/backup_folder", "C:/local/backup_folder", transfer);
+        std::cout << "Uploaded " << report.files_transferred << " files, "
+                  << report.throughput() / (1024 * 1024) << " MB/s" << std::endl;
+        for (const auto& error : report.errors) {
+            std::cerr << error.local_path << ": " << error.message << std::endl;
+        }
+
         // Download a directory from Yandex.Disk
         yandex.downloadDirectory("/backup_folder", "C:/local/restore_folder");
 
@@ -6,18 +6,789 @@
 #include <nlohmann/json.hpp>
 #include <filesystem>
 #include <map>
+#include <memory>
+#include <functional>
+#include <iosfwd>
+#include <string_view>
+#include <future>
+#include <vector>
+#include <cstdint>
+
+class CurlPool;
+class TransferJournal;
+class ContentIndex;
+class AsyncLoop;
+class MetadataCache;
+class RemoteIndex;
+class UploadBody;
+class DownloadTarget;
+class BandwidthLimiter;
+class BandwidthFlow;
+class RetryPolicy;
+class Metrics;
 
 /**
  * @brief C++ client for Yandex.Disk REST API.
  */
 class YandexDiskClient {
 public:
+    /**
+     * @brief One HTTP transfer (one attempt of a request), shaped like an
+     *        OpenTelemetry client span.
+     *
+     * Phase times come from libcurl; dns, connect and tls are zero when
+     * an open connection was reused.
+     */
+    struct RequestSpan {
+        /// "<method> <endpoint>", e.g. "GET /resources".
+        std::string name;
+        std::string method;
+        /// API route with ids replaced ("/resources", "/operations/{id}"),
+        /// or "upload" / "download" for file bodies.
+        std::string endpoint;
+        long http_code = 0;
+        /// libcurl result code (0 = the transfer completed).
+        int result = 0;
+        /// 1 for the first try of a request, higher for retries.
+        int attempt = 1;
+        bool new_connection = false;
+        /// Unix time in nanoseconds.
+        uint64_t start_unix_nanos = 0;
+        uint64_t end_unix_nanos = 0;
+        double dns_seconds = 0;
+        double connect_seconds = 0;
+        double tls_seconds = 0;
+        /// From the start until the first response byte.
+        double ttfb_seconds = 0;
+        double total_seconds = 0;
+        uint64_t bytes_sent = 0;
+        uint64_t bytes_received = 0;
+    };
+
+    /**
+     * @brief Client configuration.
+     */
+    struct Options {
+        /// Maximum number of pooled CURL handles (concurrent transfers).
+        std::size_t connection_pool_size = 8;
+        /// Negotiate HTTP/2 over TLS when the server supports it.
+        bool enable_http2 = true;
+        /// REST API root; point it at a mock server for offline tests and benchmarks.
+        std::string api_base_url = "https://cloud-api.yandex.net/v1/disk";
+        /// Connection timeout in milliseconds (0 = libcurl default).
+        long connect_timeout_ms = 0;
+        /// Verify the server certificate and host name.
+        bool verify_tls = true;
+        /// Optional CA bundle path used instead of the system store.
+        std::string ca_info;
+        /// Connections the asynchronous API may open (0 = unlimited); further
+        /// requests wait for a free connection or share one over HTTP/2.
+        std::size_t async_max_connections = 32;
+        /// How long exists(), getResourceInfo(), getResourceList() and the
+        /// metadata check of downloadFile() reuse a response (0 = no cache).
+        long metadata_cache_ttl_ms = 0;
+        /// Memory budget of the metadata cache; least recently used entries go first.
+        std::size_t metadata_cache_max_bytes = 16 * 1024 * 1024;
+        /// Past the TTL, keep entries while the disk revision is unchanged
+        /// (one small request) instead of fetching each of them again.
+        bool metadata_cache_revalidate = true;
+        /// File the metadata cache is loaded from and saved to (empty = memory only).
+        std::string metadata_cache_path;
+        /// Memory-mapped index of the whole remote tree (empty = no index).
+        /// Once built, exists() hits and findIndexedPathsByName() answer from it.
+        std::string remote_index_path;
+        /// Items of the last-uploaded feed read by refreshRemoteIndex(); the
+        /// window doubles while every item in it is new.
+        std::size_t remote_index_feed_limit = 100;
+        /// Upload budget of all file transfers in bytes per second (0 = unlimited).
+        uint64_t upload_bytes_per_second = 0;
+        /// Download budget of all file transfers in bytes per second (0 = unlimited).
+        uint64_t download_bytes_per_second = 0;
+        /// Draw on one budget shared by every client in the process that sets
+        /// this; non-zero limits above are applied to that shared budget.
+        bool share_process_bandwidth = false;
+        /// Attempts per API request, the first included (1 = no retries).
+        /// 429 and 503 are retried for every method, other 5xx answers and
+        /// broken connections only for GET, PUT and DELETE.
+        int retry_max_attempts = 4;
+        /// Backoff bound of the first retry; doubled for each further one
+        /// and drawn at random below the bound.
+        long retry_base_delay_ms = 200;
+        long retry_max_delay_ms = 10000;
+        /// Longest Retry-After that is waited for; a longer one ends the retries.
+        long retry_after_max_ms = 60000;
+        /// Also retry POST (move, copy) after failures where it may have been applied.
+        bool retry_non_idempotent = false;
+        /// API requests in flight at once (0 = no limit). The limit halves on
+        /// 429/503 answers and grows back while requests succeed.
+        std::size_t adaptive_concurrency_max = 32;
+        std::size_t adaptive_concurrency_min = 1;
+        /// Keep per-endpoint latency histograms and byte counters for
+        /// metricsText(). Off, a transfer costs one pointer check.
+        bool enable_metrics = false;
+        /// Called after every HTTP transfer, on the thread that ran it
+        /// (possibly several at once); must not block.
+        std::function<void(const RequestSpan&)> on_request;
+    };
+
+    /**
+     * @brief Counters of the retry layer.
+     */
+    struct RetryStats {
+        /// API request attempts, retries included.
+        uint64_t attempts = 0;
+        uint64_t retries = 0;
+        /// 429 and 503 answers.
+        uint64_t throttled = 0;
+        /// Retries that waited for the server's Retry-After.
+        uint64_t retry_after_waits = 0;
+        /// Requests that still failed after their last allowed attempt.
+        uint64_t exhausted = 0;
+        /// Times the adaptive concurrency limit was halved.
+        uint64_t concurrency_decreases = 0;
+        /// Current adaptive concurrency limit (0 = none).
+        std::size_t concurrency_limit = 0;
+    };
+
+    /**
+     * @brief A job's claim on the bandwidth budget.
+     *
+     * Jobs of a higher priority are served first; lower ones get what the
+     * higher ones leave unused. Jobs of equal priority split the budget in
+     * proportion to their weights.
+     */
+    struct BandwidthShare {
+        int priority = 0;
+        unsigned weight = 1;
+    };
+
+    /**
+     * @brief Connection reuse counters of the client's pool.
+     */
+    struct ConnectionStats {
+        /// Transfers performed through the pool.
+        std::size_t requests = 0;
+        /// New connections (TCP + TLS handshakes) opened by those transfers.
+        std::size_t connections_opened = 0;
+        /// CURL handles created by the pool so far.
+        std::size_t handles_created = 0;
+    };
+
+    /**
+     * @brief Counters of the metadata cache.
+     */
+    struct MetadataCacheStats {
+        std::size_t hits = 0;
+        std::size_t misses = 0;
+        /// Hits on expired entries confirmed by an unchanged disk revision.
+        std::size_t revalidations = 0;
+        /// Entries dropped to stay within the memory budget.
+        std::size_t evictions = 0;
+        /// Entries dropped because this client changed their path.
+        std::size_t invalidations = 0;
+        std::size_t entries = 0;
+        std::size_t bytes = 0;
+    };
+
+    /**
+     * @brief A resource as recorded in the remote index.
+     */
+    struct IndexedResource {
+        /// "disk:/..." path.
+        std::string path;
+        /// "file" or "dir".
+        std::string type;
+        uint64_t size = 0;
+        /// Empty for directories.
+        std::string md5;
+        /// ISO 8601 timestamp; empty for directories and this client's own uploads.
+        std::string modified;
+    };
+
+    /**
+     * @brief Progress snapshot of a directory transfer.
+     */
+    struct TransferProgress {
+        std::size_t files_done = 0;
+        std::size_t files_total = 0;
+        uint64_t bytes_done = 0;
+        uint64_t bytes_total = 0;
+        double elapsed_seconds = 0;
+    };
+
+    /**
+     * @brief Settings of the parallel directory transfer engine.
+     */
+    struct TransferOptions {
+        /// Concurrent workers (0 = Options::connection_pool_size).
+        std::size_t workers = 0;
+        /// Called after every finished file; never called concurrently.
+        std::function<void(const TransferProgress&)> on_progress;
+        /// Checkpoint journal file (empty = none). Rerunning a transfer with the
+        /// same journal skips completed files and resumes partial downloads.
+        std::string journal_path;
+        /// Uploads only: copy content that already exists on the disk server-side
+        /// instead of sending it (see UploadOptions::deduplicate).
+        bool deduplicate = false;
+        /// Priority and weight of the whole transfer under a bandwidth limit.
+        BandwidthShare bandwidth;
+        /// Uploads only: files smaller than this are sent in tar packs under
+        /// "<disk_path>/.ydisk-packs" instead of one by one (0 = off).
+        uint64_t pack_threshold = 0;
+        /// Uploads only: a pack is closed once its members reach this size.
+        uint64_t pack_size = 64ull * 1024 * 1024;
+        /// Uploads only: compress packs with zstd (needs YDISK_WITH_ZSTD).
+        bool pack_compress = false;
+        /// Downloads only: extract the packs of a packed upload into the
+        /// local tree instead of downloading the pack files themselves.
+        bool unpack = false;
+    };
+
+    /**
+     * @brief A file or directory that could not be transferred.
+     */
+    struct TransferError {
+        std::string local_path;
+        std::string disk_path;
+        std::string message;
+    };
+
+    /**
+     * @brief Outcome of a directory transfer.
+     */
+    struct TransferReport {
+        std::size_t files_transferred = 0;
+        std::size_t files_failed = 0;
+        /// Files already completed according to the journal.
+        std::size_t files_skipped = 0;
+        std::size_t directories_created = 0;
+        /// Part of files_transferred that travelled inside packs.
+        std::size_t files_packed = 0;
+        uint64_t bytes_transferred = 0;
+        /// Part of bytes_transferred that was copied server-side instead of sent.
+        uint64_t bytes_deduplicated = 0;
+        double elapsed_seconds = 0;
+        std::vector<TransferError> errors;
+
+        /// Aggregate throughput in bytes per second.
+        double throughput() const {
+            return elapsed_seconds > 0 ? static_cast<double>(bytes_transferred) / elapsed_seconds : 0.0;
+        }
+
+        bool ok() const { return errors.empty(); }
+    };
+
+    /**
+     * @brief Settings of a single file upload.
+     */
+    struct UploadOptions {
+        /// Hash the file first and, if identical content (MD5, size and, when
+        /// reported, SHA-256) already exists on the disk, copy it server-side.
+        bool deduplicate = false;
+    };
+
+    /**
+     * @brief Outcome of a single file upload.
+     */
+    struct UploadResult {
+        /// True if the content was copied server-side instead of sent.
+        bool deduplicated = false;
+        /// Remote file the content was copied from.
+        std::string source_path;
+        uint64_t bytes_sent = 0;
+        uint64_t bytes_saved = 0;
+        std::string md5;
+        /// Only computed when deduplicating.
+        std::string sha256;
+        /// Why server-side copies were given up before the content was sent
+        /// instead (empty if none failed).
+        std::string copy_error;
+    };
+
+    /**
+     * @brief Where the bytes of an upload come from.
+     *
+     * Files are memory-mapped and, like caller buffers, handed to libcurl
+     * without a read callback or stdio buffering; producers are asked for
+     * data in chunks of up to 2 MiB. A source is meant for one upload.
+     */
+    class UploadSource {
+    public:
+        static constexpr uint64_t kUnknownSize = UINT64_MAX;
+
+        /// Fills buffer with up to capacity bytes and returns the count (0 = end).
+        using Producer = std::function<std::size_t(char* buffer, std::size_t capacity)>;
+
+        /**
+         * @brief A local file; streamed with large reads if it cannot be mapped.
+         *
+         * The file must not be truncated during the upload: reading a
+         * mapping past the file's new end raises SIGBUS. Uploads by local
+         * path (uploadFile(disk_dir, local_path), directory transfers)
+         * stream the file instead.
+         * @throws std::runtime_error if the file cannot be opened.
+         */
+        static UploadSource file(const std::string& local_path);
+
+        /// Caller-owned bytes; they must stay valid until the upload returns.
+        static UploadSource memory(const void* data, std::size_t size);
+
+        /// Bytes from a producer; without a size the body is sent chunked.
+        static UploadSource producer(Producer produce, uint64_t size = kUnknownSize);
+
+        uint64_t size() const;
+
+    private:
+        friend class YandexDiskClient;
+        std::shared_ptr<UploadBody> body;
+    };
+
+    /**
+     * @brief Where the bytes of a streamed download go.
+     *
+     * The body is delivered in pieces of up to 512 KiB on the calling
+     * thread as it arrives, with no temporary file. A sink that blocks
+     * (a slow consumer, a full pipe) stalls the transfer instead of
+     * buffering, so memory use stays flat.
+     */
+    class DownloadSink {
+    public:
+        /// Receives each piece in order; returns false to stop after this one.
+        using Consumer = std::function<bool(const char* data, std::size_t size)>;
+
+        static DownloadSink callback(Consumer consume);
+
+        /// The stream must outlive the download; it is flushed at the end.
+        static DownloadSink stream(std::ostream& out);
+
+        /// Caller-owned buffer; a body longer than capacity is an error.
+        static DownloadSink memory(void* buffer, std::size_t capacity);
+
+        /**
+         * @brief A pipe, socket or file descriptor, left open. Non-blocking
+         *        descriptors are waited on while full. A reader that goes
+         *        away fails the download; no SIGPIPE is raised.
+         */
+        static DownloadSink fileDescriptor(int fd);
+
+    private:
+        friend class YandexDiskClient;
+        std::shared_ptr<DownloadTarget> target;
+    };
+
+    /**
+     * @brief One stage of a streaming transform of file bodies.
+     *
+     * Each stage needs its library in the build: zstd (YDISK_WITH_ZSTD),
+     * zlib (YDISK_WITH_ZLIB) or OpenSSL (YDISK_WITH_OPENSSL).
+     */
+    struct TransformStage {
+        enum class Kind {
+            Zstd,
+            Gzip,
+            /// AES-256-GCM with a caller-held key.
+            AesGcm
+        };
+
+        Kind kind = Kind::Zstd;
+        /// Compression level.
+        int level = 0;
+        /// AesGcm: 32-byte key.
+        std::string key;
+
+        static TransformStage zstd(int level = 3);
+        static TransformStage gzip(int level = 6);
+
+        /// @throws std::runtime_error if the key is not 32 bytes.
+        static TransformStage aesGcm(std::string key);
+    };
+
+    /**
+     * @brief Transforms applied to a body while it streams.
+     *
+     * The body is cut into chunks that go through the stages in order on
+     * upload and in reverse on download, several chunks at a time on a
+     * pool of threads. Only a window of chunks is held in memory and
+     * nothing is written to temporary files. Downloads must use the same
+     * stages (and keys) as the upload.
+     */
+    struct TransformOptions {
+        /// E.g. {zstd(), aesGcm(key)}: compress, then encrypt.
+        std::vector<TransformStage> stages;
+        /// Bytes of the body per chunk.
+        std::size_t chunk_size = 1024 * 1024;
+        /// Threads transforming chunks (0 = one per hardware thread).
+        std::size_t threads = 0;
+    };
+
+    /**
+     * @brief Which side a directory sync may change.
+     */
+    enum class SyncDirection {
+        /// Make the disk match the local directory.
+        Upload,
+        /// Make the local directory match the disk.
+        Download,
+        /// Copy changes both ways; when a file differs, the newer side wins.
+        TwoWay
+    };
+
+    /**
+     * @brief Settings of incremental directory sync.
+     */
+    struct SyncOptions {
+        SyncDirection direction = SyncDirection::Upload;
+        /// Concurrent workers for hashing and transfers (0 = Options::connection_pool_size).
+        std::size_t workers = 0;
+        /// Persistent checksum index of local files (empty = hash without caching).
+        std::string index_path;
+        /// One-way only: delete target files and folders missing on the source
+        /// side. Remote deletions go to the trash.
+        bool delete_extraneous = false;
+        /// Called after every finished file; never called concurrently.
+        std::function<void(const TransferProgress&)> on_progress;
+        /// Priority and weight of the sync's transfers under a bandwidth limit.
+        BandwidthShare bandwidth;
+    };
+
+    /**
+     * @brief Outcome of a directory sync.
+     */
+    struct SyncReport {
+        std::size_t files_uploaded = 0;
+        std::size_t files_downloaded = 0;
+        /// Files and folders deleted (one-way sync with delete_extraneous).
+        std::size_t files_deleted = 0;
+        std::size_t files_unchanged = 0;
+        /// Local files whose MD5 had to be computed.
+        std::size_t files_hashed = 0;
+        /// Local files whose MD5 came from the index.
+        std::size_t hash_cache_hits = 0;
+        uint64_t bytes_uploaded = 0;
+        uint64_t bytes_downloaded = 0;
+        double elapsed_seconds = 0;
+        std::vector<TransferError> errors;
+
+        bool ok() const { return errors.empty(); }
+    };
+
+    /**
+     * @brief Settings of paginated listings.
+     */
+    struct ListOptions {
+        /// Items requested per page (the API's `limit`).
+        std::size_t page_size = 1000;
+        /// Comma-separated item fields to return, e.g. "name,path,type,size" (empty = all).
+        std::string fields;
+        /// Request the next page while the callback handles the current one.
+        bool prefetch = true;
+    };
+
+    /**
+     * @brief A listed item, read straight from the response without a JSON tree.
+     *
+     * The views point into the buffer of the page being visited and are
+     * valid only during the callback; copy what must outlive it. Fields
+     * missing from the response (or not selected) are empty.
+     */
+    struct ResourceEntry {
+        std::string_view name;
+        /// Full path, e.g. "disk:/Photos/cat.jpg".
+        std::string_view path;
+        /// "file" or "dir".
+        std::string_view type;
+        std::string_view md5;
+        std::string_view modified;
+        std::string_view mime_type;
+        uint64_t size = 0;
+    };
+
+    /**
+     * @brief Filters and limits of a resource search.
+     *
+     * All filters that are set must match. Text filters apply to the item
+     * name; size bounds only match files.
+     */
+    struct SearchOptions {
+        /// Exact name (empty = any).
+        std::string name;
+        /// Shell-style pattern: `*`, `?` and `[...]` classes, e.g. "*.jp?g".
+        std::string glob;
+        /// ECMAScript regular expression searched for in the name.
+        std::string regex;
+        /// Compare name, glob and regex without regard to ASCII case.
+        bool ignore_case = false;
+        /// "file" or "dir" (empty = both).
+        std::string type;
+        /// MIME type, or a prefix ending in '/' such as "image/".
+        std::string mime_type;
+        uint64_t min_size = 0;
+        /// Largest matching size in bytes (0 = no limit).
+        uint64_t max_size = 0;
+        /// Bounds on `modified` in the server's ISO 8601 format, compared as
+        /// text (e.g. "2024-01-01T00:00:00+00:00"; empty = open).
+        std::string modified_after;
+        std::string modified_before;
+        /// Extra test on the listing item; may be called from several threads
+        /// at once. With a predicate, items carry all fields; otherwise only
+        /// name, path, type, size, mime_type and modified.
+        std::function<bool(const nlohmann::json&)> predicate;
+        /// Stop once this many matches were delivered (0 = all).
+        std::size_t max_results = 0;
+        /// Directory listings in flight at once (0 = Options::connection_pool_size).
+        std::size_t max_in_flight = 0;
+        /// Descend into subdirectories.
+        bool recursive = true;
+    };
+
+    /**
+     * @brief Outcome of a resource search.
+     */
+    struct SearchReport {
+        std::size_t matches = 0;
+        std::size_t directories_listed = 0;
+        std::size_t items_scanned = 0;
+        /// The search ended early (max_results reached or the callback said stop).
+        bool stopped_early = false;
+        double elapsed_seconds = 0;
+        /// Subdirectories that could not be listed; the search goes on without them.
+        std::vector<TransferError> errors;
+    };
+
+    /**
+     * @brief Settings of ranged (multi-connection) file downloads.
+     */
+    struct RangedDownloadOptions {
+        /// Upper bound on parallel connections (also capped by the pool size).
+        std::size_t max_streams = 8;
+        /// Connections used before the first adaptation step.
+        std::size_t initial_streams = 2;
+        /// Size of the first chunks in bytes.
+        uint64_t chunk_size = 8ull * 1024 * 1024;
+        /// Lower bound for adaptive chunk sizing; smaller files use one stream.
+        uint64_t min_chunk_size = 1ull * 1024 * 1024;
+        /// Upper bound for adaptive chunk sizing.
+        uint64_t max_chunk_size = 64ull * 1024 * 1024;
+        /// Adapt chunk size and stream count to the observed bandwidth.
+        bool adaptive = true;
+        /// Called after every finished chunk with (bytes done, bytes total); never called concurrently.
+        std::function<void(uint64_t, uint64_t)> on_progress;
+        /// Priority and weight of all streams together under a bandwidth limit.
+        BandwidthShare bandwidth;
+    };
+
+    /**
+     * @brief Outcome of a ranged download.
+     */
+    struct RangedDownloadReport {
+        uint64_t bytes_transferred = 0;
+        std::size_t chunks = 0;
+        /// Largest number of connections used at the same time.
+        std::size_t peak_streams = 0;
+        /// Chunk size in effect when the download finished.
+        uint64_t final_chunk_size = 0;
+        /// False if the file was fetched as a single stream (small file or no Range support).
+        bool ranged = false;
+        double elapsed_seconds = 0;
+
+        /// Throughput in bytes per second.
+        double throughput() const {
+            return elapsed_seconds > 0 ? static_cast<double>(bytes_transferred) / elapsed_seconds : 0.0;
+        }
+    };
+
+    /**
+     * @brief Kind of request in a batch.
+     */
+    enum class BatchAction {
+        Delete,
+        Move,
+        Copy,
+        Publish,
+        Unpublish,
+        CreateDirectory
+    };
+
+    /**
+     * @brief One item of a batch.
+     */
+    struct BatchOperation {
+        BatchAction action = BatchAction::Delete;
+        /// Target of the action; the source for Move and Copy.
+        std::string path;
+        /// Destination for Move and Copy.
+        std::string to_path;
+        /// Move and Copy: replace an existing destination.
+        bool overwrite = false;
+        /// Delete: remove for good instead of moving to the trash.
+        bool permanently = false;
+    };
+
+    /**
+     * @brief Settings of a batch run.
+     */
+    struct BatchOptions {
+        /// Requests in flight at once (0 = Options::async_max_connections).
+        std::size_t concurrency = 0;
+        /// Wait for long-running operations (answered with 202) to finish.
+        bool wait_for_operations = true;
+        /// Initial delay between rounds of status checks; doubled after every round.
+        long poll_interval_ms = 100;
+        /// Upper bound for the delay between status checks.
+        long max_poll_interval_ms = 2000;
+        /// Stop waiting for operations after this long (0 = no limit).
+        long operation_timeout_ms = 0;
+        /// Status checks of one operation that may fail in a row (5xx, 429,
+        /// network errors) before it is marked Failed; a 4xx reply fails it at once.
+        std::size_t max_failed_status_checks = 5;
+    };
+
+    /**
+     * @brief State of a batch item when the run returned.
+     */
+    enum class BatchStatus {
+        Succeeded,
+        Failed,
+        /// Accepted by the server but not finished (not waited for, or timed out).
+        Pending
+    };
+
+    /**
+     * @brief Outcome of one batch item.
+     */
+    struct BatchResult {
+        BatchStatus status = BatchStatus::Pending;
+        long http_code = 0;
+        std::string error;
+        /// Status URL of a long-running operation (empty if it finished at once).
+        std::string operation_href;
+
+        bool ok() const { return status == BatchStatus::Succeeded; }
+    };
+
+    /**
+     * @brief Outcome of a batch run.
+     */
+    struct BatchReport {
+        /// One result per operation, in the order they were given.
+        std::vector<BatchResult> results;
+        std::size_t succeeded = 0;
+        std::size_t failed = 0;
+        std::size_t pending = 0;
+        /// Items the server answered with 202 and an operation href.
+        std::size_t async_operations = 0;
+        /// Status requests sent while waiting for them.
+        std::size_t status_checks = 0;
+        double elapsed_seconds = 0;
+
+        bool ok() const { return failed == 0 && pending == 0; }
+    };
+
     /**
      * @brief Constructor. Initializes client with OAuth token.
      * @param oauth_token Yandex.Disk OAuth token.
      */
     explicit YandexDiskClient(const std::string& oauth_token);
 
+    /**
+     * @brief Constructor. Initializes client with OAuth token and options.
+     * @param oauth_token Yandex.Disk OAuth token.
+     * @param options Client configuration.
+     */
+    YandexDiskClient(const std::string& oauth_token, const Options& options);
+
+    ~YandexDiskClient();
+    YandexDiskClient(YandexDiskClient&&) noexcept;
+    YandexDiskClient& operator=(YandexDiskClient&&) noexcept;
+
+    /**
+     * @brief Get connection reuse statistics.
+     * @return Counters accumulated since the client was created.
+     */
+    ConnectionStats connectionStats() const;
+
+    /**
+     * @brief Export metrics in the Prometheus text format.
+     *
+     * Always includes the connection, retry and metadata cache counters;
+     * per-endpoint request counters and latency histograms (dns, connect,
+     * tls, ttfb, total) only with Options::enable_metrics.
+     * @return Text for a /metrics endpoint or a textfile collector.
+     */
+    std::string metricsText() const;
+
+    /**
+     * @brief Get retry and adaptive concurrency counters.
+     * @return Counters since the client was created.
+     */
+    RetryStats retryStats() const;
+
+    /**
+     * @brief Change the bandwidth budget while transfers are running.
+     *
+     * With Options::share_process_bandwidth this changes the budget of
+     * every client sharing it.
+     * @param upload_bytes_per_second Upload limit (0 = unlimited).
+     * @param download_bytes_per_second Download limit (0 = unlimited).
+     */
+    void setBandwidthLimits(uint64_t upload_bytes_per_second, uint64_t download_bytes_per_second);
+
+    /**
+     * @brief Get metadata cache statistics.
+     * @return Counters since the client was created (all zero without a cache).
+     */
+    MetadataCacheStats metadataCacheStats() const;
+
+    /**
+     * @brief Drop every cached metadata response, e.g. after changes made
+     *        by another client.
+     */
+    void clearMetadataCache();
+
+    /**
+     * @brief Build the remote index from scratch.
+     *
+     * Pages through the flat list of all files on the disk; directories are
+     * taken from the file paths, so empty directories created elsewhere are
+     * not indexed. The index is saved to Options::remote_index_path.
+     * @return Number of indexed files and directories.
+     * @throws std::runtime_error without an index path, or on API/network error.
+     */
+    std::size_t rebuildRemoteIndex();
+
+    /**
+     * @brief Bring the remote index up to date with the last-uploaded feed.
+     *
+     * Builds the index if it does not exist yet. This client's own changes
+     * are applied as they happen; uploads made elsewhere arrive through the
+     * feed, while deletions and moves made elsewhere need rebuildRemoteIndex().
+     * @return Number of entries added or changed.
+     * @throws std::runtime_error without an index path, or on API/network error.
+     */
+    std::size_t refreshRemoteIndex();
+
+    /**
+     * @brief Look a path up in the remote index without a request.
+     * @return false if the index is not built or does not know the path.
+     */
+    bool findIndexedResource(const std::string& disk_path, IndexedResource& resource) const;
+
+    /**
+     * @brief Find resources by name in the remote index, without requests.
+     *
+     * The answer is only as complete as the index: empty directories made
+     * elsewhere are missing, and items deleted or moved elsewhere stay
+     * until rebuildRemoteIndex(). Use findResourcePathByName() for an
+     * answer from the server.
+     * @param name Name of file or folder.
+     * @param start_path Directory to search below (default: root).
+     * @return Full paths ("disk:/...") of the indexed matches; empty if the
+     *         index is not built.
+     */
+    std::vector<std::string> findIndexedPathsByName(
+            const std::string& name,
+            const std::string& start_path = "/") const;
+
     /**
      * @brief Get disk quota information (total, used, trash).
      * @return JSON object with quota info.
@@ -34,12 +805,71 @@ public:
 
     /**
      * @brief Get list of files and folders at given path.
+     *
+     * Returns the first page only (the server default is 20 items);
+     * use forEachResource() to visit every entry of large directories.
      * @param disk_path Path on Yandex.Disk (default: root "/").
      * @return JSON object with resource list.
      * @throws std::runtime_error on API/network error.
      */
     nlohmann::json getResourceList(const std::string& disk_path = "/");
 
+    /**
+     * @brief Visit every item of a directory, page by page.
+     * @param disk_path Directory on Yandex.Disk.
+     * @param callback Called for each item; return false to stop early.
+     * @return Number of items visited.
+     * @throws std::runtime_error on API/network error or if the path is not a directory.
+     */
+    std::size_t forEachResource(
+            const std::string& disk_path,
+            const std::function<bool(const nlohmann::json&)>& callback);
+
+    /**
+     * @brief Visit every item of a directory, page by page.
+     *
+     * Items are delivered as soon as their page arrives; with prefetch
+     * enabled the next page is requested while the callback runs.
+     * @param disk_path Directory on Yandex.Disk.
+     * @param callback Called for each item; return false to stop early.
+     * @param options Page size, field selection and prefetch.
+     * @return Number of items visited.
+     * @throws std::runtime_error on API/network error or if the path is not a directory.
+     */
+    std::size_t forEachResource(
+            const std::string& disk_path,
+            const std::function<bool(const nlohmann::json&)>& callback,
+            const ListOptions& options);
+
+    /**
+     * @brief Visit every item of a directory as a typed entry.
+     *
+     * Like forEachResource(), but each page is parsed by a streaming parser
+     * that keeps only the entry fields, with their strings in one buffer
+     * per page, instead of building a JSON tree.
+     * @param disk_path Directory on Yandex.Disk.
+     * @param callback Called for each item; return false to stop early.
+     * @return Number of items visited.
+     * @throws std::runtime_error on API/network error or if the path is not a directory.
+     */
+    std::size_t forEachResourceEntry(
+            const std::string& disk_path,
+            const std::function<bool(const ResourceEntry&)>& callback);
+
+    /**
+     * @brief Visit every item of a directory as a typed entry.
+     * @param disk_path Directory on Yandex.Disk.
+     * @param callback Called for each item; return false to stop early.
+     * @param options Page size, field selection (by default the entry fields)
+     *        and prefetch.
+     * @return Number of items visited.
+     * @throws std::runtime_error on API/network error or if the path is not a directory.
+     */
+    std::size_t forEachResourceEntry(
+            const std::string& disk_path,
+            const std::function<bool(const ResourceEntry&)>& callback,
+            const ListOptions& options);
+
     /**
      * @brief Format resource list as human-readable string.
      * @param json JSON object from getResourceList().
@@ -90,6 +920,110 @@ public:
             const std::string& disk_dir,
             const std::string& local_path);
 
+    /**
+     * @brief Upload a file, a memory buffer or a producer's output.
+     * @param disk_path Destination file path on Yandex.Disk (overwritten).
+     * @param source Body of the upload.
+     * @return true on success.
+     * @throws std::runtime_error on API/network error or a failing source.
+     */
+    bool uploadFile(
+            const std::string& disk_path,
+            const UploadSource& source);
+
+    /**
+     * @brief Upload a source through compression and/or encryption stages.
+     *
+     * The stored file is the transformed body (see TransformOptions); read
+     * it back with the downloadFile() overload taking the same options.
+     * @param disk_path Destination file path on Yandex.Disk (overwritten).
+     * @param source Body of the upload.
+     * @param transform Stages, chunk size and threads.
+     * @return true on success.
+     * @throws std::runtime_error on API/network error, a failing source or
+     *         a stage this build does not support.
+     */
+    bool uploadFile(
+            const std::string& disk_path,
+            const UploadSource& source,
+            const TransformOptions& transform);
+
+    /**
+     * @brief Upload a local file, optionally deduplicating against the disk.
+     *
+     * With deduplication the file is hashed (MD5 and SHA-256 in one pass)
+     * and looked up in the remote content index; the index is built with
+     * refreshContentIndex() on first use. A hit is re-checked against the
+     * server and then copied with a server-side copy instead of uploading.
+     * A copy the server runs as a long-running operation is waited for; if
+     * it fails, the reason goes to UploadResult::copy_error and the content
+     * is uploaded.
+     * @param disk_dir Destination directory or file path on Yandex.Disk.
+     * @param local_path Path to local file.
+     * @param options Upload settings.
+     * @return Whether the content was sent or copied, and the bytes saved.
+     * @throws std::runtime_error on API/network error.
+     */
+    UploadResult uploadFile(
+            const std::string& disk_dir,
+            const std::string& local_path,
+            const UploadOptions& options);
+
+    /**
+     * @brief Rebuild the remote content index used for deduplicated uploads.
+     *
+     * Pages through the flat list of all files on the disk with their
+     * checksums.
+     * @return Number of files indexed.
+     * @throws std::runtime_error on API/network error.
+     */
+    std::size_t refreshContentIndex();
+
+    /**
+     * @brief Stream a file from Yandex.Disk into a sink.
+     * @param disk_path Path to file on Yandex.Disk.
+     * @param sink Receiver of the body.
+     * @return Bytes delivered to the sink (fewer if a callback stopped early).
+     * @throws std::runtime_error on API/network error or a failing sink.
+     */
+    uint64_t downloadFile(
+            const std::string& disk_path,
+            const DownloadSink& sink);
+
+    /**
+     * @brief Stream a file uploaded with transforms, decoded, into a sink.
+     * @param disk_path Path to file on Yandex.Disk.
+     * @param sink Receiver of the decoded body.
+     * @param transform The stages the file was uploaded with.
+     * @return Decoded bytes delivered to the sink.
+     * @throws std::runtime_error on API/network error, a failing sink, or
+     *         a body that does not decode (wrong stages or key, corrupt or
+     *         truncated data).
+     */
+    uint64_t downloadFile(
+            const std::string& disk_path,
+            const DownloadSink& sink,
+            const TransformOptions& transform);
+
+    /**
+     * @brief Stream one file of a packed directory upload into a sink.
+     *
+     * The pack indexes under "<disk_root>/.ydisk-packs" are read to find
+     * the member, which is then fetched with a single Range request: its
+     * bytes for a plain pack, or the zstd frame holding it for a
+     * compressed one.
+     * @param disk_root Destination directory of the packed upload.
+     * @param member Path of the file below disk_root, '/'-separated.
+     * @param sink Receiver of the file's contents.
+     * @return Bytes delivered to the sink.
+     * @throws std::runtime_error if no pack holds the file, or on
+     *         API/network error.
+     */
+    uint64_t downloadPackedFile(
+            const std::string& disk_root,
+            const std::string& member,
+            const DownloadSink& sink);
+
     /**
      * @brief Download a file from Yandex.Disk to local directory.
      * @param download_disk_path Path to file on Yandex.Disk.
@@ -101,6 +1035,46 @@ public:
             const std::string& download_disk_path,
             const std::string& local_dir);
 
+    /**
+     * @brief Download a file, resuming an earlier interrupted attempt.
+     *
+     * Data goes to "<file>.part"; the offset durably written so far is
+     * checkpointed in the journal. A later call with the same journal
+     * continues with a Range request from that offset, provided the remote
+     * file (size and md5) is unchanged. The result is checked against the
+     * remote md5 before the file is moved into place.
+     * @param download_disk_path Path to file on Yandex.Disk.
+     * @param local_dir Local directory to save the file.
+     * @param journal_path Checkpoint journal file.
+     * @return true on success.
+     * @throws std::runtime_error on API/network/I/O error or checksum mismatch.
+     */
+    bool downloadFile(
+            const std::string& download_disk_path,
+            const std::string& local_dir,
+            const std::string& journal_path);
+
+    /**
+     * @brief Download a file over several parallel HTTP Range requests.
+     *
+     * The file is preallocated under a ".part" name and every chunk is
+     * written in place with a positioned write; it is renamed to its final
+     * name once complete and removed if the download fails. Starting from
+     * the given chunk size and stream count, the chunk size follows the
+     * per-connection bandwidth and streams are added while they raise the
+     * aggregate throughput. Small files and servers that ignore Range
+     * fall back to a single stream.
+     * @param download_disk_path Path to file on Yandex.Disk.
+     * @param local_dir Local directory to save the file.
+     * @param options Chunking, concurrency and progress callback.
+     * @return Report with chunk and throughput counters.
+     * @throws std::runtime_error on API/network/I/O error.
+     */
+    RangedDownloadReport downloadFileRanged(
+            const std::string& download_disk_path,
+            const std::string& local_dir,
+            const RangedDownloadOptions& options);
+
     /**
      * @brief Recursively upload a local directory to Yandex.Disk.
      * @param disk_path Destination directory on Yandex.Disk.
@@ -112,6 +1086,26 @@ public:
             const std::string& disk_path,
             const std::string& local_path);
 
+    /**
+     * @brief Upload a local directory using a pool of parallel workers.
+     *
+     * The local tree is walked lazily and fed to the workers through a
+     * bounded queue, so memory use does not grow with the number of files.
+     * Each directory is created on a worker before anything inside it is
+     * uploaded, and progress totals grow as the walk proceeds. Per-file
+     * errors are collected in the report instead of aborting the run.
+     * @param disk_path Destination directory on Yandex.Disk.
+     * @param local_path Local directory to upload.
+     * @param options Worker count and progress callback.
+     * @return Report with counters, throughput and per-file errors.
+     * @throws std::runtime_error if the local directory or the destination
+     *         root cannot be used.
+     */
+    TransferReport uploadDirectory(
+            const std::string& disk_path,
+            const std::string& local_path,
+            const TransferOptions& options);
+
     /**
      * @brief Recursively download a directory from Yandex.Disk to local path.
      * @param disk_path Path to directory on Yandex.Disk.
@@ -123,6 +1117,46 @@ public:
             const std::string& disk_path,
             const std::string& local_path);
 
+    /**
+     * @brief Download a directory using pipelined parallel workers.
+     *
+     * Subdirectories are listed concurrently, download hrefs are resolved
+     * ahead of the body transfers, and bodies are fetched on a pool of
+     * workers. File types come from the listing, so no per-file metadata
+     * request is made. Per-file errors are collected in the report.
+     * @param disk_path Path to directory on Yandex.Disk.
+     * @param local_path Local directory to save contents.
+     * @param options Worker count and progress callback.
+     * @return Report with counters, throughput and per-file errors.
+     * @throws std::runtime_error if the remote root is not a directory or
+     *         the local path is not usable.
+     */
+    TransferReport downloadDirectory(
+            const std::string& disk_path,
+            const std::string& local_path,
+            const TransferOptions& options);
+
+    /**
+     * @brief Synchronize a local directory with a directory on Yandex.Disk.
+     *
+     * Both trees are listed (the remote one with size, md5 and modified),
+     * and only files that are missing or differ are transferred. Files of
+     * equal size are compared by MD5; local checksums are computed in
+     * parallel and cached in the index, keyed by inode, size and mtime, so
+     * unchanged files are not hashed again. The contents of local_path map
+     * directly onto disk_path.
+     * @param disk_path Directory on Yandex.Disk.
+     * @param local_path Local directory.
+     * @param options Direction, index, deletion and worker settings.
+     * @return Report with transfer, hashing and per-file error counters.
+     * @throws std::runtime_error if the source root does not exist or
+     *         cannot be listed.
+     */
+    SyncReport syncDirectory(
+            const std::string& disk_path,
+            const std::string& local_path,
+            const SyncOptions& options);
+
     /**
      * @brief Delete a file or directory from Yandex.Disk.
      * @param disk_path Path to file or directory on Yandex.Disk.
@@ -153,6 +1187,20 @@ public:
             bool overwrite = false
     );
 
+    /**
+     * @brief Copy a file or directory on Yandex.Disk (server-side).
+     * @param from_path Source path.
+     * @param to_path Destination path.
+     * @param overwrite Overwrite if destination exists.
+     * @return true on success.
+     * @throws std::runtime_error on API/network error.
+     */
+    bool copyFileOrDir(
+            const std::string& from_path,
+            const std::string& to_path,
+            bool overwrite = false
+    );
+
     /**
      * @brief Rename a file or directory on Yandex.Disk.
      * @param disk_path Path to file or directory.
@@ -211,6 +1259,24 @@ public:
      */
     bool emptyTrash();
 
+    /**
+     * @brief Search a directory tree, streaming matches as they are found.
+     *
+     * Directories are listed breadth-first by a pool of up to
+     * SearchOptions::max_in_flight concurrent listings. Matches are passed
+     * to the callback as soon as their page arrives, in no particular order;
+     * the callback is never called concurrently.
+     * @param start_path Directory to search (not matched itself).
+     * @param options Filters, result limit and concurrency.
+     * @param on_match Called for each matching item; return false to stop.
+     * @return Counters and the subdirectories that failed to list.
+     * @throws std::runtime_error if start_path cannot be listed.
+     */
+    SearchReport searchResources(
+            const std::string& start_path,
+            const SearchOptions& options,
+            const std::function<bool(const nlohmann::json&)>& on_match);
+
     /**
      * @brief Find all resources in trash by name.
      * @param name Name of file or folder.
@@ -220,6 +1286,9 @@ public:
 
     /**
      * @brief Find all resources on disk by name (recursive).
+     *
+     * Always searches on the server; findIndexedPathsByName() answers from
+     * the remote index instead.
      * @param name Name of file or folder.
      * @param start_path Directory to start search from (default: root).
      * @return Vector of full paths for all matches.
@@ -228,13 +1297,168 @@ public:
             const std::string& name,
             const std::string& start_path = "/");
 
+    /**
+     * @brief Run many delete/move/copy/publish/mkdir requests concurrently.
+     *
+     * Requests go through the asynchronous engine with at most
+     * BatchOptions::concurrency of them in flight. Long-running operations
+     * (202 responses) are collected and checked together in rounds, with the
+     * delay between rounds growing up to max_poll_interval_ms, instead of
+     * one polling loop per item. A status check refused with 4xx fails its
+     * item; other failed checks are repeated up to max_failed_status_checks
+     * times in a row. Items run in no particular order, so they
+     * should not depend on each other; a failing item does not stop the others.
+     * @param operations Items to run.
+     * @return Per-item results (same order) and counters.
+     */
+    BatchReport runBatch(const std::vector<BatchOperation>& operations);
+
+    /**
+     * @brief Run a batch with explicit concurrency and polling settings.
+     * @param operations Items to run.
+     * @param options Concurrency, polling and timeout settings.
+     * @return Per-item results (same order) and counters.
+     */
+    BatchReport runBatch(
+            const std::vector<BatchOperation>& operations,
+            const BatchOptions& options);
+
+    /**
+     * @name Asynchronous API
+     *
+     * The *Async methods return immediately. Their requests are driven by a
+     * single background thread (one curl_multi loop per client, started on
+     * first use), so one caller can keep hundreds of requests in flight.
+     * Errors are reported through the future as std::runtime_error, the same
+     * way the blocking methods throw them. Destroying the client fails the
+     * requests that have not finished yet.
+     */
+    ///@{
+
+    /**
+     * @brief Asynchronous getQuotaInfo().
+     * @return Future JSON object with quota info.
+     */
+    std::future<nlohmann::json> getQuotaInfoAsync();
+
+    /**
+     * @brief Asynchronous getResourceList(): the first page of a directory.
+     * @param disk_path Path on Yandex.Disk (default: root "/").
+     * @return Future JSON object with resource list.
+     */
+    std::future<nlohmann::json> getResourceListAsync(const std::string& disk_path = "/");
+
+    /**
+     * @brief Asynchronous uploadFile().
+     * @param disk_dir Destination directory or file path on Yandex.Disk.
+     * @param local_path Path to local file.
+     * @return Future that becomes true once the file is stored.
+     */
+    std::future<bool> uploadFileAsync(
+            const std::string& disk_dir,
+            const std::string& local_path);
+
+    /**
+     * @brief Asynchronous downloadFile().
+     * @param download_disk_path Path to file on Yandex.Disk.
+     * @param local_dir Local directory to save the file.
+     * @return Future that becomes true once the file is written.
+     */
+    std::future<bool> downloadFileAsync(
+            const std::string& download_disk_path,
+            const std::string& local_dir);
+
+    /**
+     * @brief Asynchronous deleteFileOrDir().
+     * @param disk_path Path to file or directory on Yandex.Disk.
+     */
+    std::future<bool> deleteFileOrDirAsync(const std::string& disk_path);
+
+    /**
+     * @brief Asynchronous createDirectory().
+     * @param disk_path Path to directory to create.
+     */
+    std::future<bool> createDirectoryAsync(const std::string& disk_path);
+
+    /**
+     * @brief Asynchronous moveFileOrDir().
+     * @param from_path Source path.
+     * @param to_path Destination path.
+     * @param overwrite Overwrite if destination exists.
+     */
+    std::future<bool> moveFileOrDirAsync(
+            const std::string& from_path,
+            const std::string& to_path,
+            bool overwrite = false);
+
+    /**
+     * @brief Asynchronous copyFileOrDir().
+     * @param from_path Source path.
+     * @param to_path Destination path.
+     * @param overwrite Overwrite if destination exists.
+     */
+    std::future<bool> copyFileOrDirAsync(
+            const std::string& from_path,
+            const std::string& to_path,
+            bool overwrite = false);
+
+    /**
+     * @brief Asynchronous publish().
+     * @param disk_path Path to file or folder on Yandex.Disk.
+     */
+    std::future<bool> publishAsync(const std::string& disk_path);
+
+    /**
+     * @brief Asynchronous unpublish().
+     * @param disk_path Path to file or folder on Yandex.Disk.
+     */
+    std::future<bool> unpublishAsync(const std::string& disk_path);
+
+    /**
+     * @brief Asynchronous exists(); network errors yield false.
+     *
+     * Like every future of this API, it fails if the client is destroyed
+     * before the request completes.
+     * @param disk_path Path to file or directory.
+     */
+    std::future<bool> existsAsync(const std::string& disk_path);
+
+    ///@}
+
 private:
     std::string token;
+    Options options;
+    std::unique_ptr<Metrics> metrics;
+    std::unique_ptr<CurlPool> pool;
+    std::unique_ptr<ContentIndex> content_index;
+    std::unique_ptr<MetadataCache> metadata_cache;
+    std::unique_ptr<RemoteIndex> remote_index;
+    std::shared_ptr<BandwidthLimiter> bandwidth;
+    std::unique_ptr<RetryPolicy> retry_policy;
+    std::unique_ptr<AsyncLoop> async_loop;
+
+    std::string apiUrl(const std::string& suffix) const;
 
     std::string performRequest(const std::string& url,
                                const std::string& method = "GET",
                                long* http_code = nullptr);
 
+    std::string cachedRequest(const std::string& url,
+                              const std::string& disk_path,
+                              long* http_code = nullptr);
+
+    /**
+     * @brief Keep the metadata cache and the remote index in step with a
+     *        mutating request made by this client.
+     *
+     * Static so that asynchronous completions can call it without holding
+     * a pointer to a client that may have been moved.
+     */
+    static void noteChange(MetadataCache* cache, RemoteIndex* index,
+                           const std::string& url, const std::string& method, bool succeeded);
+
+    RemoteIndex& requireRemoteIndex();
+
     std::string getUploadUrl(const std::string& upload_disk_path);
 
     std::string getDownloadUrl(const std::string& download_disk_path);
@@ -247,6 +1471,12 @@ private:
             const std::string& errorMsg
     );
 
+    static std::string linkFromResponse(
+            const std::string& response,
+            const std::string& key,
+            const std::string& errorMsg
+    );
+
     std::string buildUrl(
             const std::string& endpoint,
             const std::map<std::string, std::string>& params
@@ -268,13 +1498,94 @@ private:
 
     std::string makeDiskPath(const std::string& disk_path);
 
-    void checkApiError(const std::string& response);
+    bool ensureDirectory(const std::string& disk_path);
 
-    std::vector<std::string> findPathsByName(
-            const std::string& name,
+    bool downloadHref(
+            const std::string& url,
+            const std::string& local_path,
+            BandwidthFlow* flow = nullptr);
+
+    /// Streams a download href (optionally one "first-last" byte range,
+    /// which must be answered with 206) into a target.
+    uint64_t downloadToTarget(
+            const std::string& url,
+            DownloadTarget& target,
+            const std::string& range = std::string(),
+            BandwidthFlow* flow = nullptr);
+
+    bool downloadHrefResumable(
+            const std::string& url,
+            const std::string& local_path,
+            const std::string& journal_key,
+            uint64_t size,
+            const std::string& md5,
+            TransferJournal& journal,
+            BandwidthFlow* flow = nullptr);
+
+    bool uploadFileTo(
+            const std::string& upload_disk_path,
+            const std::string& local_path,
+            std::string* md5 = nullptr,
+            BandwidthFlow* flow = nullptr);
+
+    bool uploadBody(
+            const std::string& upload_disk_path,
+            UploadBody& body,
+            std::string* md5 = nullptr,
+            BandwidthFlow* flow = nullptr);
+
+    UploadResult uploadFileDeduplicated(
+            const std::string& upload_disk_path,
+            const std::string& local_path,
+            BandwidthFlow* flow = nullptr);
+
+    bool relocateResource(
+            const std::string& endpoint,
+            const std::string& from_path,
+            const std::string& to_path,
+            bool overwrite);
+
+    std::size_t workerCount(const TransferOptions& transfer) const;
+
+    static void throwOnTransferErrors(const TransferReport& report);
+
+    static void checkApiError(const std::string& response);
+
+    std::string relocationUrl(
+            const std::string& endpoint,
+            const std::string& from_path,
+            const std::string& to_path,
+            bool overwrite);
+
+    std::future<bool> requestAsync(const std::string& url, const std::string& method);
+
+    std::string batchRequestUrl(const BatchOperation& operation, std::string& method);
+
+    void waitForOperation(const std::string& href, const BatchOptions& polling);
+
+    std::future<bool> relocateResourceAsync(
+            const std::string& endpoint,
+            const std::string& from_path,
+            const std::string& to_path,
+            bool overwrite);
+
+    std::size_t forEachListedItem(
+            const std::string& endpoint,
+            const std::string& disk_path,
+            const std::function<bool(const nlohmann::json&)>& callback,
+            const ListOptions& list);
+
+    std::size_t forEachListedEntry(
+            const std::string& endpoint,
+            const std::string& disk_path,
+            const std::function<bool(const ResourceEntry&)>& callback,
+            const ListOptions& list);
+
+    SearchReport searchListing(
+            const std::string& endpoint,
             const std::string& start_path,
-            std::function<nlohmann::json(const std::string&)> listFunc,
-            bool recursive = true);
+            const SearchOptions& search,
+            const std::function<bool(const nlohmann::json&)>& on_match);
 
 };
 
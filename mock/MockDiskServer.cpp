@@ -0,0 +1,1143 @@
+#include "MockDiskServer.h"
+#include "Md5.h"
+#include "Sha256.h"
+#include <nlohmann/json.hpp>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+#ifdef MSG_NOSIGNAL
+    constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+    constexpr int kSendFlags = 0;
+#endif
+
+    constexpr uint64_t kTotalSpace = 10ull * 1024 * 1024 * 1024;
+    constexpr std::size_t kIoChunk = 64 * 1024;
+
+    const char* reasonPhrase(int status) {
+        switch (status) {
+            case 100: return "Continue";
+            case 200: return "OK";
+            case 201: return "Created";
+            case 202: return "Accepted";
+            case 204: return "No Content";
+            case 206: return "Partial Content";
+            case 400: return "Bad Request";
+            case 401: return "Unauthorized";
+            case 404: return "Not Found";
+            case 405: return "Method Not Allowed";
+            case 409: return "Conflict";
+            case 416: return "Range Not Satisfiable";
+            case 429: return "Too Many Requests";
+            case 500: return "Internal Server Error";
+            case 503: return "Service Unavailable";
+            default: return "Unknown";
+        }
+    }
+
+    std::string lower(std::string s) {
+        std::transform(s.begin(), s.end(), s.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return s;
+    }
+
+    std::string trim(const std::string& s) {
+        std::size_t b = s.find_first_not_of(" \t");
+        if (b == std::string::npos) return "";
+        std::size_t e = s.find_last_not_of(" \t\r");
+        return s.substr(b, e - b + 1);
+    }
+
+    /**
+     * Paces a byte stream to a fixed rate; a zero rate disables pacing.
+     */
+    class Pacer {
+    public:
+        explicit Pacer(uint64_t rate)
+                : rate(rate), start(std::chrono::steady_clock::now()) {}
+
+        void account(std::size_t bytes) {
+            if (rate == 0) return;
+            total += bytes;
+            auto due = start + std::chrono::microseconds(total * 1000000 / rate);
+            std::this_thread::sleep_until(due);
+        }
+
+    private:
+        uint64_t rate;
+        uint64_t total = 0;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    /**
+     * Keeps only the dotted field paths listed in a `fields` query value,
+     * descending into arrays the way the real API does for "_embedded.items".
+     */
+    void projectFields(const nlohmann::json& src, nlohmann::json& dst,
+                       const std::vector<std::vector<std::string>>& paths) {
+        std::map<std::string, std::vector<std::vector<std::string>>> by_head;
+        std::map<std::string, bool> whole;
+        for (const auto& path : paths) {
+            if (path.empty()) continue;
+            if (path.size() == 1) whole[path[0]] = true;
+            else by_head[path[0]].emplace_back(path.begin() + 1, path.end());
+        }
+        for (auto it = src.begin(); it != src.end(); ++it) {
+            const std::string& key = it.key();
+            if (whole.count(key)) {
+                dst[key] = it.value();
+            } else if (by_head.count(key)) {
+                if (it.value().is_array()) {
+                    nlohmann::json arr = nlohmann::json::array();
+                    for (const auto& element : it.value()) {
+                        nlohmann::json out = nlohmann::json::object();
+                        projectFields(element, out, by_head[key]);
+                        arr.push_back(out);
+                    }
+                    dst[key] = arr;
+                } else if (it.value().is_object()) {
+                    nlohmann::json out = nlohmann::json::object();
+                    projectFields(it.value(), out, by_head[key]);
+                    dst[key] = out;
+                }
+            }
+        }
+    }
+
+    nlohmann::json selectFields(const nlohmann::json& src, const std::string& fields) {
+        std::vector<std::vector<std::string>> paths;
+        std::istringstream list(fields);
+        std::string field;
+        while (std::getline(list, field, ',')) {
+            std::vector<std::string> parts;
+            std::istringstream dotted(field);
+            std::string part;
+            while (std::getline(dotted, part, '.')) parts.push_back(part);
+            paths.push_back(parts);
+        }
+        nlohmann::json dst = nlohmann::json::object();
+        projectFields(src, dst, paths);
+        return dst;
+    }
+
+    bool sendAll(int fd, const char* data, std::size_t len) {
+        while (len > 0) {
+            ssize_t n = ::send(fd, data, len, kSendFlags);
+            if (n <= 0) return false;
+            data += n;
+            len -= static_cast<std::size_t>(n);
+        }
+        return true;
+    }
+}
+
+MockDiskServer::MockDiskServer(const MockServerConfig& config)
+        : cfg(config), rng(config.seed) {
+    Node root;
+    root.dir = true;
+    root.created = root.modified = now();
+    tree["/"] = root;
+}
+
+MockDiskServer::~MockDiskServer() {
+    stop();
+}
+
+void MockDiskServer::start() {
+    if (running) return;
+
+    MockServerConfig c = config();
+    listen_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd < 0) throw std::runtime_error("socket() failed");
+
+    int one = 1;
+    ::setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(c.port);
+    if (::inet_pton(AF_INET, c.bind_address.c_str(), &addr.sin_addr) != 1) {
+        ::close(listen_fd);
+        throw std::runtime_error("Invalid bind address: " + c.bind_address);
+    }
+    if (::bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::listen(listen_fd, 512) != 0) {
+        ::close(listen_fd);
+        throw std::runtime_error("Couldn't listen on " + c.bind_address + ":" +
+                                 std::to_string(c.port));
+    }
+
+    socklen_t len = sizeof(addr);
+    ::getsockname(listen_fd, reinterpret_cast<sockaddr*>(&addr), &len);
+    bound_port = ntohs(addr.sin_port);
+
+    running = true;
+    accept_thread = std::thread(&MockDiskServer::acceptLoop, this);
+}
+
+void MockDiskServer::stop() {
+    if (!running.exchange(false)) return;
+
+    ::shutdown(listen_fd, SHUT_RDWR);
+    ::close(listen_fd);
+    if (accept_thread.joinable()) accept_thread.join();
+
+    std::vector<Worker> finished;
+    {
+        std::lock_guard<std::mutex> lock(connections_mutex);
+        for (int fd : open_fds) ::shutdown(fd, SHUT_RDWR);
+        finished.swap(workers);
+    }
+    for (auto& w : finished) w.thread.join();
+}
+
+std::string MockDiskServer::baseUrl() const {
+    return "http://" + config().bind_address + ":" + std::to_string(bound_port);
+}
+
+std::string MockDiskServer::apiUrl() const {
+    return baseUrl() + "/v1/disk";
+}
+
+void MockDiskServer::setConfig(const MockServerConfig& config) {
+    std::lock_guard<std::mutex> lock(config_mutex);
+    cfg = config;
+}
+
+MockServerConfig MockDiskServer::config() const {
+    std::lock_guard<std::mutex> lock(config_mutex);
+    return cfg;
+}
+
+void MockDiskServer::makeDirectory(const std::string& path) {
+    std::lock_guard<std::mutex> lock(tree_mutex);
+    std::string p = normalize(path);
+    ensureParents(p);
+    if (!tree.count(p)) {
+        Node node;
+        node.dir = true;
+        node.created = node.modified = now();
+        tree[p] = node;
+        ++revision;
+    }
+}
+
+void MockDiskServer::putFile(const std::string& path, const std::string& content) {
+    std::string md5 = Md5::hex(content);
+    std::string sha256 = Sha256::hex(content);
+    std::lock_guard<std::mutex> lock(tree_mutex);
+    std::string p = normalize(path);
+    ensureParents(p);
+    Node node;
+    node.data = std::make_shared<const std::string>(content);
+    node.md5 = md5;
+    node.sha256 = sha256;
+    node.created = node.modified = now();
+    node.uploaded = next_upload++;
+    tree[p] = node;
+    ++revision;
+}
+
+std::string MockDiskServer::fileContent(const std::string& path) const {
+    std::lock_guard<std::mutex> lock(tree_mutex);
+    auto it = tree.find(normalize(path));
+    if (it == tree.end() || it->second.dir || !it->second.data) return "";
+    return *it->second.data;
+}
+
+bool MockDiskServer::contains(const std::string& path) const {
+    std::lock_guard<std::mutex> lock(tree_mutex);
+    return tree.count(normalize(path)) != 0;
+}
+
+MockDiskServer::Stats MockDiskServer::stats() const {
+    Stats s;
+    s.connections_accepted = connections_accepted;
+    s.requests = requests;
+    s.injected_errors = injected_errors;
+    s.bytes_received = bytes_received;
+    s.bytes_sent = bytes_sent;
+    return s;
+}
+
+void MockDiskServer::resetStats() {
+    connections_accepted = 0;
+    requests = 0;
+    injected_errors = 0;
+    bytes_received = 0;
+    bytes_sent = 0;
+}
+
+// === Connection handling ===
+
+void MockDiskServer::acceptLoop() {
+    while (running) {
+        int fd = ::accept(listen_fd, nullptr, nullptr);
+        if (fd < 0) {
+            if (!running) break;
+            continue;
+        }
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+#ifdef SO_NOSIGPIPE
+        ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+        ++connections_accepted;
+
+        std::lock_guard<std::mutex> lock(connections_mutex);
+        auto done = std::make_shared<std::atomic<bool>>(false);
+        open_fds.push_back(fd);
+        workers.push_back(Worker{std::thread([this, fd, done] {
+            serveConnection(fd);
+            {
+                std::lock_guard<std::mutex> lk(connections_mutex);
+                open_fds.erase(std::remove(open_fds.begin(), open_fds.end(), fd), open_fds.end());
+            }
+            ::close(fd);
+            *done = true;
+        }), done});
+
+        // Reap connection threads that have already finished.
+        for (auto it = workers.begin(); it != workers.end();) {
+            if (*it->done) {
+                it->thread.join();
+                it = workers.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+}
+
+void MockDiskServer::serveConnection(int fd) {
+    std::string buffer;
+    while (running) {
+        MockServerConfig c = config();
+        Request req;
+        if (!readRequest(fd, buffer, req, c.bandwidth_bytes_per_sec)) return;
+        ++requests;
+        // The connection may have idled across a setConfig().
+        c = config();
+
+        if (c.latency.count() > 0) std::this_thread::sleep_for(c.latency);
+
+        Response resp;
+        bool inject = false;
+        if (c.error_rate > 0.0) {
+            std::lock_guard<std::mutex> lock(config_mutex);
+            inject = std::uniform_real_distribution<double>(0.0, 1.0)(rng) < c.error_rate;
+        }
+        if (inject) {
+            ++injected_errors;
+            resp = errorResponse(c.error_status,
+                                 c.error_status == 429 ? "TooManyRequestsError" : "ServiceUnavailableError",
+                                 "Injected error.");
+            if (c.retry_after_seconds > 0) {
+                resp.headers.emplace_back("Retry-After", std::to_string(c.retry_after_seconds));
+            }
+        } else {
+            try {
+                resp = dispatch(req);
+            } catch (const std::exception& ex) {
+                resp = errorResponse(500, "InternalServerError", ex.what());
+            }
+        }
+
+        sendResponse(fd, req, resp, c.bandwidth_bytes_per_sec);
+
+        auto conn = req.headers.find("connection");
+        if (conn != req.headers.end() && lower(conn->second) == "close") return;
+    }
+}
+
+bool MockDiskServer::readRequest(int fd, std::string& buffer, Request& req, uint64_t bandwidth) {
+    Pacer pacer(bandwidth);
+    char chunk[kIoChunk];
+
+    auto fill = [&]() -> bool {
+        ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) return false;
+        buffer.append(chunk, static_cast<std::size_t>(n));
+        bytes_received += static_cast<uint64_t>(n);
+        pacer.account(static_cast<std::size_t>(n));
+        return true;
+    };
+
+    std::size_t header_end;
+    while ((header_end = buffer.find("\r\n\r\n")) == std::string::npos) {
+        if (!fill()) return false;
+    }
+
+    std::istringstream head(buffer.substr(0, header_end));
+    buffer.erase(0, header_end + 4);
+
+    std::string line;
+    std::getline(head, line);
+    std::istringstream request_line(line);
+    std::string version;
+    request_line >> req.method >> req.target >> version;
+
+    while (std::getline(head, line)) {
+        std::size_t colon = line.find(':');
+        if (colon == std::string::npos) continue;
+        req.headers[lower(trim(line.substr(0, colon)))] = trim(line.substr(colon + 1));
+    }
+
+    std::size_t qpos = req.target.find('?');
+    req.path = req.target.substr(0, qpos);
+    if (qpos != std::string::npos) {
+        std::istringstream qs(req.target.substr(qpos + 1));
+        std::string pair;
+        while (std::getline(qs, pair, '&')) {
+            std::size_t eq = pair.find('=');
+            std::string key = urlDecode(pair.substr(0, eq));
+            std::string value = eq == std::string::npos ? "" : urlDecode(pair.substr(eq + 1));
+            req.query[key] = value;
+        }
+    }
+
+    auto expect = req.headers.find("expect");
+    if (expect != req.headers.end() && lower(expect->second) == "100-continue") {
+        const char* cont = "HTTP/1.1 100 Continue\r\n\r\n";
+        if (!sendAll(fd, cont, std::strlen(cont))) return false;
+    }
+
+    auto te = req.headers.find("transfer-encoding");
+    if (te != req.headers.end() && lower(te->second).find("chunked") != std::string::npos) {
+        for (;;) {
+            std::size_t eol;
+            while ((eol = buffer.find("\r\n")) == std::string::npos) {
+                if (!fill()) return false;
+            }
+            std::size_t size = std::stoul(buffer.substr(0, eol), nullptr, 16);
+            buffer.erase(0, eol + 2);
+            if (size == 0) {
+                // Skip trailers up to the terminating empty line.
+                for (;;) {
+                    while ((eol = buffer.find("\r\n")) == std::string::npos) {
+                        if (!fill()) return false;
+                    }
+                    bool last = eol == 0;
+                    buffer.erase(0, eol + 2);
+                    if (last) break;
+                }
+                break;
+            }
+            while (buffer.size() < size + 2) {
+                if (!fill()) return false;
+            }
+            req.body.append(buffer, 0, size);
+            buffer.erase(0, size + 2);
+        }
+    } else {
+        auto cl = req.headers.find("content-length");
+        std::size_t length = cl == req.headers.end() ? 0 : std::stoull(cl->second);
+        req.body.reserve(length);
+        while (req.body.size() + buffer.size() < length) {
+            req.body += buffer;
+            buffer.clear();
+            if (!fill()) return false;
+        }
+        std::size_t rest = length - req.body.size();
+        req.body.append(buffer, 0, rest);
+        buffer.erase(0, rest);
+    }
+    return true;
+}
+
+void MockDiskServer::sendResponse(int fd, const Request& req, const Response& resp, uint64_t bandwidth) {
+    const char* body = resp.body.data();
+    std::size_t length = resp.body.size();
+    if (resp.payload) {
+        body = resp.payload->data() + resp.payload_offset;
+        length = static_cast<std::size_t>(resp.payload_length);
+    }
+
+    std::ostringstream head;
+    head << "HTTP/1.1 " << resp.status << " " << reasonPhrase(resp.status) << "\r\n";
+    if (length > 0 || resp.status != 204) {
+        head << "Content-Type: " << resp.content_type << "\r\n";
+    }
+    head << "Content-Length: " << length << "\r\n";
+    for (const auto& [key, value] : resp.headers) {
+        head << key << ": " << value << "\r\n";
+    }
+    head << "\r\n";
+
+    std::string h = head.str();
+    if (!sendAll(fd, h.data(), h.size())) return;
+    bytes_sent += h.size();
+
+    if (req.method == "HEAD") return;
+
+    uint64_t cut = req.path == "/download" ? config().cut_downloads_after : 0;
+    std::size_t limit = cut > 0 && cut < length ? static_cast<std::size_t>(cut) : length;
+
+    Pacer pacer(bandwidth);
+    std::size_t sent = 0;
+    while (sent < limit) {
+        std::size_t n = std::min(kIoChunk, limit - sent);
+        if (!sendAll(fd, body + sent, n)) return;
+        sent += n;
+        bytes_sent += n;
+        pacer.account(n);
+    }
+    // A broken-off body: the client sees the connection drop mid-transfer.
+    if (limit < length) ::shutdown(fd, SHUT_RDWR);
+}
+
+// === Routing ===
+
+MockDiskServer::Response MockDiskServer::dispatch(const Request& req) {
+    const std::string api_prefix = "/v1/disk";
+    if (req.path.compare(0, api_prefix.size(), api_prefix) == 0) {
+        if (!req.headers.count("authorization")) {
+            return errorResponse(401, "UnauthorizedError", "Unauthorized");
+        }
+        return handleApi(req, req.path.substr(api_prefix.size()));
+    }
+    if (req.path == "/upload") return handleUploadBody(req);
+    if (req.path == "/download") return handleDownloadBody(req);
+    return errorResponse(404, "NotFoundError", "Unknown endpoint: " + req.path);
+}
+
+MockDiskServer::Response MockDiskServer::handleApi(const Request& req, const std::string& route) {
+    if (route.empty() || route == "/") {
+        std::lock_guard<std::mutex> lock(tree_mutex);
+        uint64_t trash_size = 0;
+        for (const auto& [path, node] : trash) {
+            if (node.data) trash_size += node.data->size();
+        }
+        nlohmann::json j = {
+                {"total_space", kTotalSpace},
+                {"used_space", usedSpace()},
+                {"trash_size", trash_size},
+                {"max_file_size", kTotalSpace},
+                {"is_paid", false},
+                {"revision", revision}
+        };
+        Response resp;
+        resp.body = j.dump();
+        return resp;
+    }
+    if (route == "/resources") return handleResources(req);
+    if (route == "/resources/files") return filesResponse(req);
+    if (route == "/resources/last-uploaded") return lastUploadedResponse(req);
+    if (route == "/resources/move") return handleMoveCopy(req, false);
+    if (route == "/resources/copy") return handleMoveCopy(req, true);
+
+    if (route == "/resources/publish" || route == "/resources/unpublish") {
+        if (req.method != "PUT") return errorResponse(405, "MethodNotAllowedError", "Use PUT.");
+        std::lock_guard<std::mutex> lock(tree_mutex);
+        std::string path = normalize(req.query.count("path") ? req.query.at("path") : "");
+        auto it = tree.find(path);
+        if (it == tree.end()) return errorResponse(404, "DiskNotFoundError", "Resource not found.");
+        if (route == "/resources/publish") {
+            if (it->second.public_key.empty()) {
+                it->second.public_key = "mock-key-" + std::to_string(next_id++);
+            }
+        } else {
+            it->second.public_key.clear();
+        }
+        ++revision;
+        return linkResponse(apiUrl() + "/resources?path=" + urlEncode(diskPath(path)), "GET", 200);
+    }
+
+    if (route == "/resources/upload") {
+        std::lock_guard<std::mutex> lock(tree_mutex);
+        std::string path = normalize(req.query.count("path") ? req.query.at("path") : "");
+        bool overwrite = req.query.count("overwrite") && req.query.at("overwrite") == "true";
+        auto it = tree.find(path);
+        if (it != tree.end() && (it->second.dir || !overwrite)) {
+            return errorResponse(409, "DiskResourceAlreadyExistsError",
+                                 "Resource \"" + diskPath(path) + "\" already exists.");
+        }
+        auto parent = tree.find(parentOf(path));
+        if (parent == tree.end() || !parent->second.dir) {
+            return errorResponse(409, "DiskPathDoesntExistsError",
+                                 "Specified path \"" + diskPath(path) + "\" doesn't exist.");
+        }
+        Response resp = linkResponse(baseUrl() + "/upload?path=" + urlEncode(path), "PUT", 200);
+        nlohmann::json j = nlohmann::json::parse(resp.body);
+        j["operation_id"] = std::to_string(next_id++);
+        resp.body = j.dump();
+        return resp;
+    }
+
+    if (route == "/resources/download") {
+        std::lock_guard<std::mutex> lock(tree_mutex);
+        std::string path = normalize(req.query.count("path") ? req.query.at("path") : "");
+        auto it = tree.find(path);
+        if (it == tree.end()) return errorResponse(404, "DiskNotFoundError", "Resource not found.");
+        return linkResponse(baseUrl() + "/download?path=" + urlEncode(path), "GET", 200);
+    }
+
+    if (route.compare(0, 12, "/operations/") == 0) return handleOperation(route.substr(12));
+    if (route.compare(0, 6, "/trash") == 0) return handleTrash(req, route.substr(6));
+
+    return errorResponse(404, "NotFoundError", "Unknown endpoint: " + req.path);
+}
+
+MockDiskServer::Response MockDiskServer::handleResources(const Request& req) {
+    std::lock_guard<std::mutex> lock(tree_mutex);
+    std::string path = normalize(req.query.count("path") ? req.query.at("path") : "");
+
+    if (req.method == "GET") {
+        std::string forbidden = config().forbidden_path;
+        if (!forbidden.empty() && normalize(forbidden) == path) {
+            return errorResponse(403, "DiskResourceLockedError", "Resource is locked.");
+        }
+        auto it = tree.find(path);
+        if (it == tree.end()) return errorResponse(404, "DiskNotFoundError", "Resource not found.");
+        return resourceResponse(path, it->second, req, false);
+    }
+
+    if (req.method == "PUT") {
+        auto it = tree.find(path);
+        if (it != tree.end()) {
+            return errorResponse(409, "DiskPathPointsToExistentDirectoryError",
+                                 "Specified path \"" + diskPath(path) + "\" points to existent directory.");
+        }
+        auto parent = tree.find(parentOf(path));
+        if (parent == tree.end() || !parent->second.dir) {
+            return errorResponse(409, "DiskPathDoesntExistsError",
+                                 "Specified path \"" + diskPath(path) + "\" doesn't exist.");
+        }
+        Node node;
+        node.dir = true;
+        node.created = node.modified = now();
+        tree[path] = node;
+        ++revision;
+        return linkResponse(apiUrl() + "/resources?path=" + urlEncode(diskPath(path)), "GET", 201);
+    }
+
+    if (req.method == "DELETE") {
+        auto it = tree.find(path);
+        if (it == tree.end()) return errorResponse(404, "DiskNotFoundError", "Resource not found.");
+        if (path == "/") return errorResponse(400, "FieldValidationError", "Cannot delete root.");
+
+        bool dir = it->second.dir;
+        bool permanently = req.query.count("permanently") && req.query.at("permanently") == "true";
+        MockServerConfig c = config();
+        bool async = c.async_operations && (dir || c.async_file_operations);
+        if (async && c.fail_operations) return operationResponse(true);
+
+        std::string trash_name = "/" + nameOf(path);
+        for (int n = 1; trash.count(trash_name); ++n) {
+            trash_name = "/" + nameOf(path) + "_" + std::to_string(n);
+        }
+        std::string deleted_at = now();
+        for (const std::string& key : subtreeKeys(tree, path)) {
+            if (!permanently) {
+                Node moved = tree[key];
+                moved.origin_path = key;
+                moved.deleted = deleted_at;
+                trash[trash_name + key.substr(path.size())] = moved;
+            }
+            tree.erase(key);
+        }
+        ++revision;
+
+        if (async) return operationResponse();
+        Response resp;
+        resp.status = 204;
+        return resp;
+    }
+
+    return errorResponse(405, "MethodNotAllowedError", "Method not allowed.");
+}
+
+MockDiskServer::Response MockDiskServer::handleMoveCopy(const Request& req, bool copy) {
+    if (req.method != "POST") return errorResponse(405, "MethodNotAllowedError", "Use POST.");
+
+    std::lock_guard<std::mutex> lock(tree_mutex);
+    std::string from = normalize(req.query.count("from") ? req.query.at("from") : "");
+    std::string to = normalize(req.query.count("path") ? req.query.at("path") : "");
+    bool overwrite = req.query.count("overwrite") && req.query.at("overwrite") == "true";
+
+    auto src = tree.find(from);
+    if (src == tree.end()) return errorResponse(404, "DiskNotFoundError", "Resource not found.");
+    if (to == from || (to.size() > from.size() && to.compare(0, from.size(), from) == 0 &&
+                       to[from.size()] == '/')) {
+        return errorResponse(409, "DiskResourceAlreadyExistsError", "Cannot move into itself.");
+    }
+    auto parent = tree.find(parentOf(to));
+    if (parent == tree.end() || !parent->second.dir) {
+        return errorResponse(409, "DiskPathDoesntExistsError",
+                             "Specified path \"" + diskPath(to) + "\" doesn't exist.");
+    }
+    if (tree.count(to)) {
+        if (!overwrite) {
+            return errorResponse(409, "DiskResourceAlreadyExistsError",
+                                 "Resource \"" + diskPath(to) + "\" already exists.");
+        }
+        for (const std::string& key : subtreeKeys(tree, to)) tree.erase(key);
+    }
+
+    bool dir = src->second.dir;
+    MockServerConfig c = config();
+    bool async = c.async_operations && (dir || c.async_file_operations);
+    if (async && c.fail_operations) return operationResponse(true);
+
+    std::vector<std::pair<std::string, Node>> subtree;
+    for (const std::string& key : subtreeKeys(tree, from)) {
+        subtree.emplace_back(key.substr(from.size()), tree[key]);
+        if (!copy) tree.erase(key);
+    }
+    std::string stamp = now();
+    for (auto& [suffix, node] : subtree) {
+        if (copy) {
+            node.created = stamp;
+            node.public_key.clear();
+        }
+        node.modified = stamp;
+        tree[to + suffix] = node;
+    }
+    ++revision;
+
+    if (async) return operationResponse();
+    return linkResponse(apiUrl() + "/resources?path=" + urlEncode(diskPath(to)), "GET", 201);
+}
+
+MockDiskServer::Response MockDiskServer::handleTrash(const Request& req, const std::string& route) {
+    std::lock_guard<std::mutex> lock(tree_mutex);
+    std::string raw = req.query.count("path") ? req.query.at("path") : "";
+
+    if (route == "/resources" && req.method == "DELETE" && raw.empty()) {
+        trash.clear();
+        ++revision;
+        Response resp;
+        resp.status = 204;
+        return resp;
+    }
+
+    std::string path = normalize(raw);
+
+    if (route == "/resources" && req.method == "GET") {
+        if (path == "/") {
+            Node root;
+            root.dir = true;
+            return resourceResponse("/", root, req, true);
+        }
+        auto it = trash.find(path);
+        if (it == trash.end()) return errorResponse(404, "DiskNotFoundError", "Resource not found.");
+        return resourceResponse(path, it->second, req, true);
+    }
+
+    auto it = trash.find(path);
+    if (it == trash.end()) return errorResponse(404, "DiskNotFoundError", "Resource not found.");
+
+    if (route == "/resources" && req.method == "DELETE") {
+        for (const std::string& key : subtreeKeys(trash, path)) trash.erase(key);
+        ++revision;
+        Response resp;
+        resp.status = 204;
+        return resp;
+    }
+
+    if (route == "/resources/restore" && req.method == "PUT") {
+        std::string target = it->second.origin_path;
+        if (req.query.count("name")) target = parentOf(target) + "/" + req.query.at("name");
+        bool overwrite = req.query.count("overwrite") && req.query.at("overwrite") == "true";
+        if (tree.count(target) && !overwrite) {
+            return errorResponse(409, "DiskResourceAlreadyExistsError",
+                                 "Resource \"" + diskPath(target) + "\" already exists.");
+        }
+        ensureParents(target);
+        for (const std::string& key : subtreeKeys(trash, path)) {
+            Node restored = trash[key];
+            restored.origin_path.clear();
+            restored.deleted.clear();
+            tree[target + key.substr(path.size())] = restored;
+            trash.erase(key);
+        }
+        ++revision;
+        return linkResponse(apiUrl() + "/resources?path=" + urlEncode(diskPath(target)), "GET", 201);
+    }
+
+    return errorResponse(405, "MethodNotAllowedError", "Method not allowed.");
+}
+
+MockDiskServer::Response MockDiskServer::handleOperation(const std::string& id) {
+    std::lock_guard<std::mutex> lock(tree_mutex);
+    auto it = operations.find(id);
+    int status_error = config().operation_status_error;
+    if (status_error > 0) return errorResponse(status_error, "OperationStatusError", "Injected status error.");
+    if (it == operations.end()) return errorResponse(404, "DiskNotFoundError", "Operation not found.");
+    bool done = std::chrono::steady_clock::now() >= it->second.done_at;
+    Response resp;
+    resp.body = nlohmann::json{
+            {"status", !done ? "in-progress" : it->second.failed ? "failed" : "success"}
+    }.dump();
+    return resp;
+}
+
+MockDiskServer::Response MockDiskServer::handleUploadBody(const Request& req) {
+    if (req.method != "PUT") return errorResponse(405, "MethodNotAllowedError", "Use PUT.");
+    std::string md5 = Md5::hex(req.body);
+    std::string sha256 = Sha256::hex(req.body);
+    std::lock_guard<std::mutex> lock(tree_mutex);
+    std::string path = normalize(req.query.count("path") ? req.query.at("path") : "");
+    auto parent = tree.find(parentOf(path));
+    if (parent == tree.end() || !parent->second.dir) {
+        return errorResponse(409, "DiskPathDoesntExistsError", "Parent directory doesn't exist.");
+    }
+    Node node;
+    auto existing = tree.find(path);
+    node.created = existing != tree.end() ? existing->second.created : now();
+    node.modified = now();
+    node.data = std::make_shared<const std::string>(req.body);
+    node.md5 = md5;
+    node.sha256 = sha256;
+    node.uploaded = next_upload++;
+    tree[path] = node;
+    ++revision;
+
+    Response resp;
+    resp.status = 201;
+    resp.content_type = "text/plain";
+    return resp;
+}
+
+MockDiskServer::Response MockDiskServer::handleDownloadBody(const Request& req) {
+    if (req.method != "GET" && req.method != "HEAD") {
+        return errorResponse(405, "MethodNotAllowedError", "Use GET.");
+    }
+    std::shared_ptr<const std::string> data;
+    {
+        std::lock_guard<std::mutex> lock(tree_mutex);
+        auto it = tree.find(normalize(req.query.count("path") ? req.query.at("path") : ""));
+        if (it == tree.end() || it->second.dir) {
+            return errorResponse(404, "DiskNotFoundError", "Resource not found.");
+        }
+        data = it->second.data;
+    }
+
+    const bool ranges = !config().ignore_range;
+    Response resp;
+    resp.content_type = "application/octet-stream";
+    if (ranges) resp.headers.emplace_back("Accept-Ranges", "bytes");
+    resp.payload = data;
+    resp.payload_length = data->size();
+
+    auto range = req.headers.find("range");
+    if (ranges && range != req.headers.end() && range->second.compare(0, 6, "bytes=") == 0) {
+        std::string spec = range->second.substr(6);
+        std::size_t dash = spec.find('-');
+        uint64_t total = data->size();
+        uint64_t first = 0;
+        uint64_t last = total == 0 ? 0 : total - 1;
+        try {
+            if (dash == 0) {
+                uint64_t suffix = std::stoull(spec.substr(1));
+                first = suffix >= total ? 0 : total - suffix;
+            } else {
+                first = std::stoull(spec.substr(0, dash));
+                if (dash + 1 < spec.size()) last = std::min<uint64_t>(last, std::stoull(spec.substr(dash + 1)));
+            }
+        } catch (const std::exception&) {
+            return errorResponse(400, "BadRequestError", "Malformed Range header.");
+        }
+        if (first >= total || first > last) {
+            Response bad = errorResponse(416, "RangeNotSatisfiableError", "Range not satisfiable.");
+            bad.headers.emplace_back("Content-Range", "bytes */" + std::to_string(total));
+            return bad;
+        }
+        resp.status = 206;
+        resp.payload_offset = first;
+        resp.payload_length = last - first + 1;
+        resp.headers.emplace_back("Content-Range", "bytes " + std::to_string(first) + "-" +
+                                                   std::to_string(last) + "/" + std::to_string(total));
+    }
+    return resp;
+}
+
+// === Response builders ===
+
+MockDiskServer::Response MockDiskServer::lastUploadedResponse(const Request& req) {
+    if (req.method != "GET") return errorResponse(405, "MethodNotAllowedError", "Use GET.");
+    std::size_t limit = 20;
+    if (req.query.count("limit")) limit = std::stoul(req.query.at("limit"));
+    std::string media_types = req.query.count("media_type") ? "," + req.query.at("media_type") + "," : "";
+
+    nlohmann::json items = nlohmann::json::array();
+    {
+        std::lock_guard<std::mutex> lock(tree_mutex);
+        std::vector<std::pair<uint64_t, std::string>> uploads;
+        for (const auto& [path, node] : tree) {
+            if (node.dir || node.uploaded == 0) continue;
+            if (!media_types.empty() &&
+                media_types.find("," + mimeOf(nameOf(path)).second + ",") == std::string::npos) {
+                continue;
+            }
+            uploads.emplace_back(node.uploaded, path);
+        }
+        // Newest first.
+        std::sort(uploads.begin(), uploads.end(), std::greater<>());
+        for (std::size_t i = 0; i < uploads.size() && i < limit; ++i) {
+            items.push_back(describeNode(uploads[i].second, tree.at(uploads[i].second), false));
+        }
+    }
+
+    nlohmann::json j = {{"items", items}, {"limit", limit}};
+    auto fields = req.query.find("fields");
+    if (fields != req.query.end() && !fields->second.empty()) j = selectFields(j, fields->second);
+
+    Response resp;
+    resp.body = j.dump();
+    return resp;
+}
+
+nlohmann::json MockDiskServer::describeNode(const std::string& p, const Node& n, bool in_trash) {
+    nlohmann::json j = {
+            {"name", p == "/" ? (in_trash ? "trash" : "disk") : nameOf(p)},
+            {"path", (in_trash ? "trash:" : "disk:") + p},
+            {"type", n.dir ? "dir" : "file"},
+            {"created", n.created},
+            {"modified", n.modified},
+    };
+    if (!n.dir) {
+        j["size"] = n.data ? n.data->size() : 0;
+        auto [mime, media] = mimeOf(nameOf(p));
+        j["mime_type"] = mime;
+        j["media_type"] = media;
+        if (!n.md5.empty()) j["md5"] = n.md5;
+        if (!n.sha256.empty()) j["sha256"] = n.sha256;
+    }
+    if (!n.public_key.empty()) {
+        j["public_key"] = n.public_key;
+        j["public_url"] = "https://yadi.sk/d/" + n.public_key;
+    }
+    if (in_trash) {
+        j["origin_path"] = "disk:" + n.origin_path;
+        j["deleted"] = n.deleted;
+    }
+    return j;
+}
+
+MockDiskServer::Response MockDiskServer::filesResponse(const Request& req) {
+    if (req.method != "GET") return errorResponse(405, "MethodNotAllowedError", "Use GET.");
+    std::size_t limit = 20;
+    std::size_t offset = 0;
+    if (req.query.count("limit")) limit = std::stoul(req.query.at("limit"));
+    if (req.query.count("offset")) offset = std::stoul(req.query.at("offset"));
+
+    nlohmann::json items = nlohmann::json::array();
+    {
+        std::lock_guard<std::mutex> lock(tree_mutex);
+        std::size_t index = 0;
+        for (const auto& [path, node] : tree) {
+            if (node.dir) continue;
+            if (index++ < offset) continue;
+            if (items.size() >= limit) break;
+            items.push_back(describeNode(path, node, false));
+        }
+    }
+
+    nlohmann::json j = {{"items", items}, {"limit", limit}, {"offset", offset}};
+    auto fields = req.query.find("fields");
+    if (fields != req.query.end() && !fields->second.empty()) j = selectFields(j, fields->second);
+
+    Response resp;
+    resp.body = j.dump();
+    return resp;
+}
+
+MockDiskServer::Response MockDiskServer::resourceResponse(
+        const std::string& path, const Node& node, const Request& req, bool in_trash) const {
+    const std::map<std::string, Node>& source = in_trash ? trash : tree;
+    const std::string scheme = in_trash ? "trash:" : "disk:";
+
+    auto describe = [&](const std::string& p, const Node& n) {
+        return describeNode(p, n, in_trash);
+    };
+
+    nlohmann::json j = describe(path, node);
+    if (node.dir) {
+        std::size_t limit = 20;
+        std::size_t offset = 0;
+        if (req.query.count("limit")) limit = std::stoul(req.query.at("limit"));
+        if (req.query.count("offset")) offset = std::stoul(req.query.at("offset"));
+        std::size_t max_page = config().max_page_size;
+        if (max_page > 0) limit = std::min(limit, max_page);
+
+        nlohmann::json items = nlohmann::json::array();
+        std::size_t total = 0;
+        std::string prefix = path == "/" ? "/" : path + "/";
+        for (auto it = source.lower_bound(prefix); it != source.end(); ++it) {
+            const std::string& key = it->first;
+            if (key.compare(0, prefix.size(), prefix) != 0) break;
+            if (key.size() == prefix.size() || key.find('/', prefix.size()) != std::string::npos) continue;
+            if (total >= offset && items.size() < limit) items.push_back(describe(key, it->second));
+            ++total;
+        }
+        j["_embedded"] = {
+                {"items", items},
+                {"limit", limit},
+                {"offset", offset},
+                {"total", total},
+                {"path", scheme + path},
+                {"sort", ""}
+        };
+    }
+
+    auto fields = req.query.find("fields");
+    if (fields != req.query.end() && !fields->second.empty()) j = selectFields(j, fields->second);
+
+    Response resp;
+    resp.body = j.dump();
+    return resp;
+}
+
+MockDiskServer::Response MockDiskServer::linkResponse(
+        const std::string& href, const std::string& method, int status) const {
+    Response resp;
+    resp.status = status;
+    resp.body = nlohmann::json{{"href", href}, {"method", method}, {"templated", false}}.dump();
+    return resp;
+}
+
+MockDiskServer::Response MockDiskServer::operationResponse(bool failed) {
+    std::string id = std::to_string(next_id++);
+    operations[id] = Operation{std::chrono::steady_clock::now() + config().operation_duration, failed};
+    return linkResponse(apiUrl() + "/operations/" + id, "GET", 202);
+}
+
+MockDiskServer::Response MockDiskServer::errorResponse(
+        int status, const std::string& error, const std::string& message) {
+    Response resp;
+    resp.status = status;
+    resp.body = nlohmann::json{
+            {"error", error},
+            {"message", message},
+            {"description", message}
+    }.dump();
+    return resp;
+}
+
+// === Path helpers ===
+
+std::string MockDiskServer::normalize(const std::string& path) {
+    std::string p = path;
+    std::size_t colon = p.find(":/");
+    if (colon != std::string::npos && p.find('/') > colon) p = p.substr(colon + 1);
+    if (p.empty() || p[0] != '/') p = "/" + p;
+    while (p.size() > 1 && p.back() == '/') p.pop_back();
+    return p;
+}
+
+std::string MockDiskServer::parentOf(const std::string& path) {
+    std::size_t slash = path.rfind('/');
+    if (slash == 0 || slash == std::string::npos) return "/";
+    return path.substr(0, slash);
+}
+
+std::pair<std::string, std::string> MockDiskServer::mimeOf(const std::string& name) {
+    // A few common types are enough for filtering experiments.
+    static const std::map<std::string, std::pair<std::string, std::string>> types = {
+            {"jpg", {"image/jpeg", "image"}},
+            {"jpeg", {"image/jpeg", "image"}},
+            {"png", {"image/png", "image"}},
+            {"txt", {"text/plain", "text"}},
+            {"json", {"application/json", "text"}},
+            {"mp4", {"video/mp4", "video"}},
+            {"zip", {"application/zip", "compressed"}},
+    };
+    std::size_t dot = name.rfind('.');
+    if (dot != std::string::npos) {
+        std::string ext = name.substr(dot + 1);
+        for (char& c : ext) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        auto it = types.find(ext);
+        if (it != types.end()) return it->second;
+    }
+    return {"application/octet-stream", "data"};
+}
+
+std::string MockDiskServer::nameOf(const std::string& path) {
+    std::size_t slash = path.rfind('/');
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+std::string MockDiskServer::diskPath(const std::string& path) {
+    return "disk:" + path;
+}
+
+std::string MockDiskServer::now() {
+    std::time_t t = std::time(nullptr);
+    std::tm tm{};
+    gmtime_r(&t, &tm);
+    char buf[32];
+    std::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%S+00:00", &tm);
+    return buf;
+}
+
+std::string MockDiskServer::urlEncode(const std::string& value) {
+    static const char* hex = "0123456789ABCDEF";
+    std::string out;
+    for (unsigned char c : value) {
+        if (std::isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
+            out += static_cast<char>(c);
+        } else {
+            out += '%';
+            out += hex[c >> 4];
+            out += hex[c & 0xF];
+        }
+    }
+    return out;
+}
+
+std::string MockDiskServer::urlDecode(const std::string& value) {
+    std::string out;
+    for (std::size_t i = 0; i < value.size(); ++i) {
+        if (value[i] == '%' && i + 2 < value.size()) {
+            out += static_cast<char>(std::stoi(value.substr(i + 1, 2), nullptr, 16));
+            i += 2;
+        } else if (value[i] == '+') {
+            out += ' ';
+        } else {
+            out += value[i];
+        }
+    }
+    return out;
+}
+
+std::vector<std::string> MockDiskServer::subtreeKeys(
+        const std::map<std::string, Node>& nodes, const std::string& root) {
+    std::vector<std::string> keys;
+    for (auto it = nodes.lower_bound(root); it != nodes.end(); ++it) {
+        const std::string& key = it->first;
+        if (key.compare(0, root.size(), root) != 0) break;
+        if (key.size() == root.size() || key[root.size()] == '/' || root == "/") keys.push_back(key);
+    }
+    return keys;
+}
+
+void MockDiskServer::ensureParents(const std::string& path) {
+    std::string parent = parentOf(path);
+    if (parent == path || tree.count(parent)) return;
+    ensureParents(parent);
+    Node node;
+    node.dir = true;
+    node.created = node.modified = now();
+    tree[parent] = node;
+}
+
+uint64_t MockDiskServer::usedSpace() const {
+    uint64_t used = 0;
+    for (const auto& [path, node] : tree) {
+        if (node.data) used += node.data->size();
+    }
+    return used;
+}
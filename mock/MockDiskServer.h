@@ -0,0 +1,226 @@
+#ifndef YANDEX_DISK_CPP_CLIENT_MOCKDISKSERVER_H
+#define YANDEX_DISK_CPP_CLIENT_MOCKDISKSERVER_H
+
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+/**
+ * @brief Configuration of the mock server; can be changed while it runs.
+ */
+struct MockServerConfig {
+    /// Interface to listen on.
+    std::string bind_address = "127.0.0.1";
+    /// TCP port (0 = pick a free ephemeral port).
+    uint16_t port = 0;
+    /// Delay added before every response.
+    std::chrono::milliseconds latency{0};
+    /// Per-connection body bandwidth in bytes per second (0 = unlimited).
+    uint64_t bandwidth_bytes_per_sec = 0;
+    /// Fraction of requests answered with an injected error (0.0 - 1.0).
+    double error_rate = 0.0;
+    /// HTTP status used for injected errors.
+    int error_status = 503;
+    /// Retry-After value sent with injected errors (0 = header omitted).
+    int retry_after_seconds = 0;
+    /// Answer move/copy/delete of directories with 202 and an operation href.
+    bool async_operations = false;
+    /// With async_operations, answer move/copy/delete of single files with 202 as well.
+    bool async_file_operations = false;
+    /// Async operations end with status "failed" and leave the tree untouched.
+    bool fail_operations = false;
+    /// HTTP status of every operation status check (0 = normal replies).
+    int operation_status_error = 0;
+    /// How long an async operation stays "in-progress".
+    std::chrono::milliseconds operation_duration{50};
+    /// Download hrefs ignore Range headers and always send the whole body.
+    bool ignore_range = false;
+    /// Download bodies break off (connection closed) after this many bytes (0 = never).
+    uint64_t cut_downloads_after = 0;
+    /// Largest page of a directory listing, whatever limit is asked for (0 = no cap).
+    std::size_t max_page_size = 0;
+    /// Metadata requests for this path answer 403 (empty = none).
+    std::string forbidden_path;
+    /// Seed for the error injection generator.
+    unsigned seed = 42;
+};
+
+/**
+ * @brief In-process HTTP/1.1 stand-in for the Yandex.Disk REST API.
+ *
+ * Keeps the whole disk in memory and implements quota, resources,
+ * upload/download hrefs (with Range support), trash, publish and async
+ * operations. Used by tests, benchmarks and local experiments. POSIX only.
+ */
+class MockDiskServer {
+public:
+    struct Stats {
+        uint64_t connections_accepted = 0;
+        uint64_t requests = 0;
+        uint64_t injected_errors = 0;
+        uint64_t bytes_received = 0;
+        uint64_t bytes_sent = 0;
+    };
+
+    explicit MockDiskServer(const MockServerConfig& config = MockServerConfig());
+    ~MockDiskServer();
+
+    MockDiskServer(const MockDiskServer&) = delete;
+    MockDiskServer& operator=(const MockDiskServer&) = delete;
+
+    /**
+     * @brief Bind, listen and start the accept thread.
+     * @throws std::runtime_error if the socket cannot be bound.
+     */
+    void start();
+
+    /**
+     * @brief Stop accepting, close all connections and join threads.
+     */
+    void stop();
+
+    uint16_t port() const { return bound_port; }
+
+    /// http://host:port
+    std::string baseUrl() const;
+
+    /// http://host:port/v1/disk, suitable for YandexDiskClient::Options::api_base_url.
+    std::string apiUrl() const;
+
+    void setConfig(const MockServerConfig& config);
+    MockServerConfig config() const;
+
+    /// Create a directory (and missing parents) directly in the tree.
+    void makeDirectory(const std::string& path);
+
+    /// Create or replace a file (and missing parents) directly in the tree.
+    void putFile(const std::string& path, const std::string& content);
+
+    /// Content of a file, or empty string if it does not exist.
+    std::string fileContent(const std::string& path) const;
+
+    bool contains(const std::string& path) const;
+
+    Stats stats() const;
+    void resetStats();
+
+private:
+    struct Node {
+        bool dir = false;
+        std::shared_ptr<const std::string> data;
+        std::string md5;
+        std::string sha256;
+        std::string created;
+        std::string modified;
+        std::string public_key;
+        std::string origin_path;
+        std::string deleted;
+        /// Upload sequence number for the last-uploaded feed (0 = never uploaded).
+        uint64_t uploaded = 0;
+    };
+
+    struct Worker {
+        std::thread thread;
+        std::shared_ptr<std::atomic<bool>> done;
+    };
+
+    struct Operation {
+        std::chrono::steady_clock::time_point done_at;
+        bool failed = false;
+    };
+
+    struct Request {
+        std::string method;
+        std::string target;
+        std::string path;
+        std::map<std::string, std::string> query;
+        std::map<std::string, std::string> headers;
+        std::string body;
+    };
+
+    struct Response {
+        int status = 200;
+        std::string content_type = "application/json; charset=utf-8";
+        std::vector<std::pair<std::string, std::string>> headers;
+        std::string body;
+        /// File content served by the download endpoint instead of body.
+        std::shared_ptr<const std::string> payload;
+        uint64_t payload_offset = 0;
+        uint64_t payload_length = 0;
+    };
+
+    void acceptLoop();
+    void serveConnection(int fd);
+    bool readRequest(int fd, std::string& buffer, Request& req, uint64_t bandwidth);
+    void sendResponse(int fd, const Request& req, const Response& resp, uint64_t bandwidth);
+
+    Response dispatch(const Request& req);
+    Response handleApi(const Request& req, const std::string& route);
+    Response handleResources(const Request& req);
+    Response handleMoveCopy(const Request& req, bool copy);
+    Response handleTrash(const Request& req, const std::string& route);
+    Response handleOperation(const std::string& id);
+    Response handleUploadBody(const Request& req);
+    Response handleDownloadBody(const Request& req);
+
+    Response filesResponse(const Request& req);
+    Response lastUploadedResponse(const Request& req);
+    static nlohmann::json describeNode(const std::string& path, const Node& node, bool in_trash);
+    Response resourceResponse(const std::string& path, const Node& node,
+                              const Request& req, bool trash) const;
+    Response linkResponse(const std::string& href, const std::string& method, int status) const;
+    Response operationResponse(bool failed = false);
+    static Response errorResponse(int status, const std::string& error, const std::string& message);
+
+    static std::string normalize(const std::string& path);
+    static std::string parentOf(const std::string& path);
+    static std::string nameOf(const std::string& path);
+    /// MIME and media type guessed from the file extension.
+    static std::pair<std::string, std::string> mimeOf(const std::string& name);
+    static std::string now();
+    static std::string diskPath(const std::string& path);
+    static std::string urlEncode(const std::string& value);
+    static std::string urlDecode(const std::string& value);
+
+    static std::vector<std::string> subtreeKeys(const std::map<std::string, Node>& nodes,
+                                                const std::string& root);
+    void ensureParents(const std::string& path);
+    uint64_t usedSpace() const;
+
+    mutable std::mutex config_mutex;
+    MockServerConfig cfg;
+    std::mt19937 rng;
+
+    mutable std::mutex tree_mutex;
+    std::map<std::string, Node> tree;
+    std::map<std::string, Node> trash;
+    std::map<std::string, Operation> operations;
+    uint64_t next_id = 1;
+    uint64_t revision = 1;
+    uint64_t next_upload = 1;
+
+    int listen_fd = -1;
+    uint16_t bound_port = 0;
+    std::atomic<bool> running{false};
+    std::thread accept_thread;
+    std::mutex connections_mutex;
+    std::vector<int> open_fds;
+    std::vector<Worker> workers;
+
+    std::atomic<uint64_t> connections_accepted{0};
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> injected_errors{0};
+    std::atomic<uint64_t> bytes_received{0};
+    std::atomic<uint64_t> bytes_sent{0};
+};
+
+#endif //YANDEX_DISK_CPP_CLIENT_MOCKDISKSERVER_H
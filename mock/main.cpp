@@ -0,0 +1,69 @@
+// Local Yandex.Disk stand-in for offline experiments and benchmarks.
+//
+// Usage: yandex-disk-mock-server [--port N] [--latency-ms N] [--bandwidth BYTES_PER_SEC]
+//                                [--error-rate F] [--error-status CODE] [--retry-after S]
+//                                [--async-operations] [--max-page-size N]
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include "MockDiskServer.h"
+
+namespace {
+    volatile std::sig_atomic_t stop_requested = 0;
+
+    void onSignal(int) { stop_requested = 1; }
+}
+
+int main(int argc, char** argv) {
+    MockServerConfig config;
+    config.port = 8080;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                std::cerr << "Missing value for " << arg << std::endl;
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--port") config.port = static_cast<uint16_t>(std::stoi(next()));
+        else if (arg == "--bind") config.bind_address = next();
+        else if (arg == "--latency-ms") config.latency = std::chrono::milliseconds(std::stol(next()));
+        else if (arg == "--bandwidth") config.bandwidth_bytes_per_sec = std::stoull(next());
+        else if (arg == "--error-rate") config.error_rate = std::stod(next());
+        else if (arg == "--error-status") config.error_status = std::stoi(next());
+        else if (arg == "--retry-after") config.retry_after_seconds = std::stoi(next());
+        else if (arg == "--async-operations") config.async_operations = true;
+        else if (arg == "--max-page-size") config.max_page_size = std::stoul(next());
+        else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 2;
+        }
+    }
+
+    MockDiskServer server(config);
+    try {
+        server.start();
+    } catch (const std::exception& ex) {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    std::cout << "Mock Yandex.Disk API listening on " << server.apiUrl() << std::endl;
+    while (!stop_requested) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+
+    server.stop();
+    auto stats = server.stats();
+    std::cout << "Connections: " << stats.connections_accepted
+              << ", requests: " << stats.requests << std::endl;
+    return 0;
+}
@@ -0,0 +1,224 @@
+#include "YandexDiskClient.h"
+#include "AsyncLoop.h"
+#include "MetadataCache.h"
+#include "QueryString.h"
+#include "RemoteIndex.h"
+#include <filesystem>
+#include <stdexcept>
+
+namespace {
+    AsyncLoop::Request apiRequest(const std::string& token, const std::string& url, const std::string& method) {
+        AsyncLoop::Request request;
+        request.url = url;
+        request.method = method;
+        request.token = token;
+        return request;
+    }
+
+    // Same messages as the blocking calls: libcurl errors get the prefix,
+    // local I/O errors are reported as they are.
+    void throwOnFailure(const AsyncLoop::Response& response, const std::string& prefix = "") {
+        if (response.ok()) return;
+        throw std::runtime_error(response.result == CURLE_OK ? response.error : prefix + response.error);
+    }
+
+    template <typename T, typename Produce>
+    void settle(std::promise<T>& promise, Produce&& produce) {
+        try {
+            promise.set_value(produce());
+        } catch (...) {
+            promise.set_exception(std::current_exception());
+        }
+    }
+
+    // check: optional validation of the body before it is parsed.
+    std::future<nlohmann::json> jsonAsync(AsyncLoop& loop, AsyncLoop::Request request,
+                                          void (*check)(const std::string&)) {
+        auto promise = std::make_shared<std::promise<nlohmann::json>>();
+        std::future<nlohmann::json> result = promise->get_future();
+        loop.submit(std::move(request), [promise, check](AsyncLoop::Response& response) {
+            settle(*promise, [&] {
+                throwOnFailure(response);
+                if (check) check(response.body);
+                return nlohmann::json::parse(response.body);
+            });
+        });
+        return result;
+    }
+}
+
+std::future<bool> YandexDiskClient::requestAsync(const std::string& url, const std::string& method) {
+    auto promise = std::make_shared<std::promise<bool>>();
+    std::future<bool> result = promise->get_future();
+    MetadataCache* cache = metadata_cache.get();
+    RemoteIndex* index = remote_index.get();
+    async_loop->submit(apiRequest(token, url, method), [promise, cache, index, url, method](AsyncLoop::Response& response) {
+        noteChange(cache, index, url, method, response.ok() && response.http_code < 300);
+        settle(*promise, [&] {
+            throwOnFailure(response);
+            checkApiError(response.body);
+            return true;
+        });
+    });
+    return result;
+}
+
+std::future<nlohmann::json> YandexDiskClient::getQuotaInfoAsync() {
+    return jsonAsync(*async_loop, apiRequest(token, UrlBuilder(options.api_base_url).url(), "GET"), &checkApiError);
+}
+
+std::future<nlohmann::json> YandexDiskClient::getResourceListAsync(const std::string& disk_path /* = "/" */) {
+    std::string url = UrlBuilder(options.api_base_url, "/resources").param("path", disk_path).url();
+    return jsonAsync(*async_loop, apiRequest(token, url, "GET"), nullptr);
+}
+
+std::future<bool> YandexDiskClient::uploadFileAsync(
+        const std::string& disk_dir,
+        const std::string& local_path)
+{
+    std::string disk_path = makeUploadDiskPath(disk_dir, local_path);
+    std::string url = UrlBuilder(options.api_base_url, "/resources/upload")
+            .param("path", disk_path).param("overwrite", "true").url();
+
+    auto promise = std::make_shared<std::promise<bool>>();
+    std::future<bool> result = promise->get_future();
+    AsyncLoop* loop = async_loop.get();
+    MetadataCache* cache = metadata_cache.get();
+    RemoteIndex* index = remote_index.get();
+
+    loop->submit(apiRequest(token, url, "GET"),
+                 [promise, loop, cache, index, url, disk_path, local_path](AsyncLoop::Response& response) {
+        try {
+            throwOnFailure(response);
+            AsyncLoop::Request put;
+            put.url = linkFromResponse(response.body, "href", "Upload URL not found in API response.");
+            put.method = "PUT";
+            put.upload_path = local_path;
+            put.fail_on_error = true;
+            loop->submit(std::move(put), [promise, cache, index, url, disk_path, local_path](AsyncLoop::Response& uploaded) {
+                if (cache) cache->invalidateRequest(url);
+                std::error_code ec;
+                uint64_t size = std::filesystem::file_size(std::filesystem::path(local_path), ec);
+                if (index && uploaded.ok() && !ec) {
+                    RemoteIndex::Entry entry;
+                    entry.path = disk_path;
+                    entry.size = size;
+                    index->upsert(std::move(entry));
+                }
+                settle(*promise, [&] {
+                    throwOnFailure(uploaded, "File upload error: ");
+                    return true;
+                });
+            });
+        } catch (...) {
+            promise->set_exception(std::current_exception());
+        }
+    });
+    return result;
+}
+
+std::future<bool> YandexDiskClient::downloadFileAsync(
+        const std::string& download_disk_path,
+        const std::string& local_dir)
+{
+    std::string info_url = UrlBuilder(options.api_base_url, "/resources")
+            .param("path", makeDiskPath(download_disk_path)).param("fields", "type").url();
+    std::string href_url = UrlBuilder(options.api_base_url, "/resources/download")
+            .param("path", download_disk_path).url();
+    std::string local_path = makeLocalDownloadPath(download_disk_path, local_dir);
+
+    auto promise = std::make_shared<std::promise<bool>>();
+    std::future<bool> result = promise->get_future();
+    AsyncLoop* loop = async_loop.get();
+    std::string oauth = token;
+
+    // Metadata, then the download link, then the body; each step is started
+    // from the completion of the previous one.
+    loop->submit(apiRequest(token, info_url, "GET"),
+                 [=](AsyncLoop::Response& info) {
+        try {
+            throwOnFailure(info);
+            nlohmann::json meta = nlohmann::json::parse(info.body);
+            if (meta.value("type", "") == "dir") {
+                throw std::runtime_error("Cannot download: '" +
+                download_disk_path + "' is a directory, not a file.");
+            }
+
+            loop->submit(apiRequest(oauth, href_url, "GET"), [=](AsyncLoop::Response& link) {
+                try {
+                    throwOnFailure(link);
+                    AsyncLoop::Request get;
+                    get.url = linkFromResponse(link.body, "href", "Download URL not found in API response.");
+                    get.download_path = local_path;
+                    get.follow_redirects = true;
+                    get.fail_on_error = true;
+                    loop->submit(std::move(get), [promise](AsyncLoop::Response& body) {
+                        settle(*promise, [&] {
+                            throwOnFailure(body, "File download error: ");
+                            return true;
+                        });
+                    });
+                } catch (...) {
+                    promise->set_exception(std::current_exception());
+                }
+            });
+        } catch (...) {
+            promise->set_exception(std::current_exception());
+        }
+    });
+    return result;
+}
+
+std::future<bool> YandexDiskClient::deleteFileOrDirAsync(const std::string& disk_path) {
+    UrlBuilder url(options.api_base_url, "/resources");
+    url.param("path", makeDiskPath(disk_path));
+    return requestAsync(url.url(), "DELETE");
+}
+
+std::future<bool> YandexDiskClient::createDirectoryAsync(const std::string& disk_path) {
+    UrlBuilder url(options.api_base_url, "/resources");
+    url.param("path", makeDiskPath(disk_path));
+    return requestAsync(url.url(), "PUT");
+}
+
+std::future<bool> YandexDiskClient::moveFileOrDirAsync(
+        const std::string& from_path,
+        const std::string& to_path,
+        bool overwrite /* = false */)
+{
+    return requestAsync(relocationUrl(apiUrl("/resources/move"), from_path, to_path, overwrite), "POST");
+}
+
+std::future<bool> YandexDiskClient::copyFileOrDirAsync(
+        const std::string& from_path,
+        const std::string& to_path,
+        bool overwrite /* = false */)
+{
+    return requestAsync(relocationUrl(apiUrl("/resources/copy"), from_path, to_path, overwrite), "POST");
+}
+
+std::future<bool> YandexDiskClient::publishAsync(const std::string& disk_path) {
+    return requestAsync(UrlBuilder(options.api_base_url, "/resources/publish").param("path", disk_path).url(), "PUT");
+}
+
+std::future<bool> YandexDiskClient::unpublishAsync(const std::string& disk_path) {
+    UrlBuilder url(options.api_base_url, "/resources/unpublish");
+    url.param("path", makeDiskPath(disk_path));
+    return requestAsync(url.url(), "PUT");
+}
+
+std::future<bool> YandexDiskClient::existsAsync(const std::string& disk_path) {
+    auto promise = std::make_shared<std::promise<bool>>();
+    std::future<bool> result = promise->get_future();
+    UrlBuilder url(options.api_base_url, "/resources");
+    url.param("path", makeDiskPath(disk_path));
+    async_loop->submit(apiRequest(token, url.url(), "GET"),
+                       [promise](AsyncLoop::Response& response) {
+        settle(*promise, [&] {
+            // A shutdown is no answer about the path: it fails like every other call.
+            if (response.result == CURLE_ABORTED_BY_CALLBACK) throwOnFailure(response);
+            return response.ok() && response.http_code == 200;
+        });
+    });
+    return result;
+}
@@ -0,0 +1,301 @@
+#include "AsyncLoop.h"
+#include "Bandwidth.h"
+#include "CurlPool.h"
+#include "RetryPolicy.h"
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+
+namespace {
+    FILE* openFile(const std::string& path, const char* mode) {
+#if defined(_WIN32)
+        std::wstring wmode(mode, mode + std::char_traits<char>::length(mode));
+        return _wfopen(std::filesystem::path(path).wstring().c_str(), wmode.c_str());
+#else
+        return fopen(path.c_str(), mode);
+#endif
+    }
+
+    // Upper bound for one curl_multi_poll(); submit() wakes the loop earlier.
+    constexpr int kPollTimeoutMs = 1000;
+    // Slots freed by blocking requests do not wake the loop; look again this often.
+    constexpr int kSlotPollMs = 10;
+}
+
+AsyncLoop::AsyncLoop(CurlPool& pool, std::shared_ptr<BandwidthLimiter> bandwidth, RetryPolicy& retry,
+                     std::size_t max_connections)
+        : pool(pool),
+          bandwidth(std::move(bandwidth)),
+          retry(retry) {
+    multi = curl_multi_init();
+    if (!multi) throw std::runtime_error("curl_multi_init() failed");
+    if (max_connections > 0) {
+        curl_multi_setopt(multi, CURLMOPT_MAX_TOTAL_CONNECTIONS, static_cast<long>(max_connections));
+    }
+}
+
+AsyncLoop::~AsyncLoop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    if (thread.joinable()) {
+        curl_multi_wakeup(multi);
+        thread.join();
+    }
+    for (CURL* curl : idle_handles) curl_easy_cleanup(curl);
+    curl_multi_cleanup(multi);
+}
+
+void AsyncLoop::submit(Request request, Completion done) {
+    auto transfer = std::make_unique<Transfer>();
+    transfer->request = std::move(request);
+    transfer->done = std::move(done);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!stopping) {
+            pending.push_back(std::move(transfer));
+            if (!thread.joinable()) thread = std::thread(&AsyncLoop::run, this);
+        }
+    }
+    if (transfer) {
+        transfer->response.result = CURLE_ABORTED_BY_CALLBACK;
+        transfer->response.error = "The client is shutting down";
+        complete(*transfer);
+        return;
+    }
+    curl_multi_wakeup(multi);
+}
+
+void AsyncLoop::run() {
+    for (;;) {
+        std::deque<std::unique_ptr<Transfer>> starting;
+        bool stop;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            starting.swap(pending);
+            stop = stopping;
+        }
+        if (stop) {
+            for (auto& transfer : starting) active.push_back(std::move(transfer));
+            for (auto& transfer : waiting) active.push_back(std::move(transfer));
+            for (auto& transfer : retrying) active.push_back(std::move(transfer));
+            waiting.clear();
+            retrying.clear();
+            break;
+        }
+        for (auto& transfer : starting) {
+            bool file = !transfer->request.upload_path.empty() || !transfer->request.download_path.empty();
+            if (file) start(std::move(transfer));
+            else waiting.push_back(std::move(transfer));
+        }
+        admitWaiting();
+
+        int running = 0;
+        curl_multi_perform(multi, &running);
+
+        int queued = 0;
+        while (CURLMsg* msg = curl_multi_info_read(multi, &queued)) {
+            if (msg->msg != CURLMSG_DONE) continue;
+            Transfer* transfer = nullptr;
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &transfer);
+            finish(transfer, msg->data.result);
+        }
+
+        admitWaiting();
+        curl_multi_poll(multi, nullptr, 0, pollTimeout(), nullptr);
+    }
+
+    // Shutdown: everything still queued or in flight fails.
+    for (auto& transfer : active) {
+        if (transfer->curl) {
+            curl_multi_remove_handle(multi, transfer->curl);
+            idle_handles.push_back(transfer->curl);
+        }
+        curl_slist_free_all(transfer->headers);
+        if (transfer->file) fclose(transfer->file);
+        transfer->response.result = CURLE_ABORTED_BY_CALLBACK;
+        transfer->response.error = "The client is shutting down";
+        complete(*transfer);
+    }
+    active.clear();
+}
+
+void AsyncLoop::start(std::unique_ptr<Transfer> transfer) {
+    const Request& request = transfer->request;
+
+    if (!request.upload_path.empty() || !request.download_path.empty()) {
+        bool upload = !request.upload_path.empty();
+        const std::string& path = upload ? request.upload_path : request.download_path;
+        transfer->file = openFile(path, upload ? "rb" : "wb");
+        if (!transfer->file) {
+            transfer->response.error = (upload ? "Couldn't open the file: " : "Failed to create a file: ") + path;
+            complete(*transfer);
+            return;
+        }
+    }
+
+    CURL* curl;
+    if (!idle_handles.empty()) {
+        curl = idle_handles.back();
+        idle_handles.pop_back();
+        curl_easy_reset(curl);
+    } else {
+        curl = curl_easy_init();
+        if (!curl) {
+            if (transfer->file) fclose(transfer->file);
+            transfer->response.error = "curl_easy_init() failed";
+            complete(*transfer);
+            return;
+        }
+    }
+    pool.configure(curl);
+    // The multi handle keeps its own connection and DNS caches; with the
+    // pool's share attached it would ignore CURLMOPT_MAX_TOTAL_CONNECTIONS.
+    curl_easy_setopt(curl, CURLOPT_SHARE, nullptr);
+    transfer->curl = curl;
+
+    if (!request.token.empty()) {
+        transfer->headers = curl_slist_append(nullptr, ("Authorization: OAuth " + request.token).c_str());
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, transfer->headers);
+    }
+    curl_easy_setopt(curl, CURLOPT_URL, request.url.c_str());
+    curl_easy_setopt(curl, CURLOPT_PRIVATE, transfer.get());
+    if (request.follow_redirects) curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    if (request.fail_on_error) curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
+
+    if (!request.download_path.empty()) {
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &AsyncLoop::writeFile);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, transfer->file);
+    } else {
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &AsyncLoop::writeBody);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &transfer->response.body);
+    }
+
+    if (transfer->file) {
+        transfer->meter = std::make_unique<BandwidthMeter>(bandwidth, nullptr, false);
+        transfer->meter->attach(curl);
+    }
+
+    if (!request.upload_path.empty()) {
+        std::error_code ec;
+        uint64_t size = std::filesystem::file_size(std::filesystem::path(request.upload_path), ec);
+        curl_easy_setopt(curl, CURLOPT_UPLOAD, 1L);
+        curl_easy_setopt(curl, CURLOPT_READFUNCTION, &AsyncLoop::readFile);
+        curl_easy_setopt(curl, CURLOPT_READDATA, transfer->file);
+        if (!ec) curl_easy_setopt(curl, CURLOPT_INFILESIZE_LARGE, (curl_off_t)size);
+    } else if (request.method == "PUT") {
+        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "PUT");
+    } else if (request.method == "DELETE") {
+        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "DELETE");
+    } else if (request.method == "POST") {
+        curl_easy_setopt(curl, CURLOPT_POST, 1L);
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, "");
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, 0L);
+    }
+
+    curl_multi_add_handle(multi, curl);
+    active.push_back(std::move(transfer));
+}
+
+void AsyncLoop::finish(Transfer* transfer, CURLcode result) {
+    auto it = std::find_if(active.begin(), active.end(),
+                           [transfer](const std::unique_ptr<Transfer>& t) { return t.get() == transfer; });
+    if (it == active.end()) return;
+    std::unique_ptr<Transfer> owned = std::move(*it);
+    *it = std::move(active.back());
+    active.pop_back();
+
+    CURL* curl = owned->curl;
+    curl_multi_remove_handle(multi, curl);
+    pool.recordTransfer(curl, result, owned->attempts + 1);
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &owned->response.http_code);
+    curl_off_t retry_after = 0;
+    curl_easy_getinfo(curl, CURLINFO_RETRY_AFTER, &retry_after);
+    idle_handles.push_back(curl);
+    owned->curl = nullptr;
+
+    curl_slist_free_all(owned->headers);
+    owned->headers = nullptr;
+    if (owned->file) {
+        if (fclose(owned->file) != 0 && result == CURLE_OK) {
+            owned->response.error = "Failed to write " + owned->request.download_path;
+        }
+        owned->file = nullptr;
+    }
+
+    if (owned->holds_slot) {
+        retry.release(owned->response.http_code);
+        owned->holds_slot = false;
+        RetryPolicy::Clock::duration delay{};
+        if (retry.shouldRetry(owned->request.method, result, owned->response.http_code,
+                              static_cast<long>(retry_after), ++owned->attempts, delay)) {
+            owned->response = Response{};
+            owned->retry_at = std::chrono::steady_clock::now() + delay;
+            retrying.push_back(std::move(owned));
+            return;
+        }
+    }
+
+    owned->response.result = result;
+    if (result != CURLE_OK) owned->response.error = curl_easy_strerror(result);
+    complete(*owned);
+}
+
+void AsyncLoop::admitWaiting() {
+    auto now = std::chrono::steady_clock::now();
+    for (auto it = retrying.begin(); it != retrying.end();) {
+        if ((*it)->retry_at <= now) {
+            waiting.push_front(std::move(*it));
+            it = retrying.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    while (!waiting.empty() && retry.tryAcquire()) {
+        std::unique_ptr<Transfer> transfer = std::move(waiting.front());
+        waiting.pop_front();
+        transfer->holds_slot = true;
+        start(std::move(transfer));
+    }
+}
+
+int AsyncLoop::pollTimeout() {
+    auto now = std::chrono::steady_clock::now();
+    auto next = now + std::chrono::milliseconds(waiting.empty() ? kPollTimeoutMs : kSlotPollMs);
+    for (auto& transfer : active) {
+        BandwidthMeter* meter = transfer->meter.get();
+        if (!meter || !meter->paused()) continue;
+        meter->resume();
+        if (meter->paused()) next = std::min(next, meter->resumeAt());
+    }
+    for (auto& transfer : retrying) next = std::min(next, transfer->retry_at);
+    auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(next - now).count();
+    // Round up so a short wait does not spin.
+    return static_cast<int>(std::max<long long>(wait + 1, 1));
+}
+
+void AsyncLoop::complete(Transfer& transfer) {
+    if (transfer.holds_slot) {
+        retry.release(0);
+        transfer.holds_slot = false;
+    }
+    // A throwing completion must not take the loop down with it.
+    try {
+        transfer.done(transfer.response);
+    } catch (...) {
+    }
+}
+
+size_t AsyncLoop::writeBody(char* data, size_t size, size_t nmemb, void* userp) {
+    static_cast<std::string*>(userp)->append(data, size * nmemb);
+    return size * nmemb;
+}
+
+size_t AsyncLoop::writeFile(char* data, size_t size, size_t nmemb, void* userp) {
+    return fwrite(data, size, nmemb, static_cast<FILE*>(userp)) * size;
+}
+
+size_t AsyncLoop::readFile(char* buffer, size_t size, size_t nitems, void* userp) {
+    return fread(buffer, size, nitems, static_cast<FILE*>(userp)) * size;
+}
@@ -0,0 +1,135 @@
+#ifndef YANDEX_DISK_CPP_CLIENT_ASYNCLOOP_H
+#define YANDEX_DISK_CPP_CLIENT_ASYNCLOOP_H
+
+#pragma once
+#include <curl/curl.h>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class CurlPool;
+class BandwidthLimiter;
+class BandwidthMeter;
+class RetryPolicy;
+
+/**
+ * @brief One thread driving any number of transfers through a curl_multi handle.
+ *
+ * Requests are queued from any thread and started by the loop; completions
+ * run on the loop thread, so they must not block (submitting follow-up
+ * requests from a completion is fine). Easy handles get the same defaults
+ * as the owning client's CurlPool but reuse connections through the multi
+ * handle's own cache. File transfers are paced by the bandwidth limiter:
+ * a transfer over budget is paused and resumed by the loop, so the others
+ * keep going. API requests (those without a file) take a slot of the
+ * retry policy's concurrency limit, waiting in order when none is free,
+ * and are retried after a delay on the loop when the policy says so.
+ * The thread is started by the first submit().
+ */
+class AsyncLoop {
+public:
+    struct Request {
+        std::string url;
+        /// "GET", "PUT", "POST" or "DELETE".
+        std::string method = "GET";
+        /// Sent as "Authorization: OAuth <token>" (empty = no header).
+        std::string token;
+        /// PUT the contents of this local file.
+        std::string upload_path;
+        /// Write the body to this local file instead of Response::body.
+        std::string download_path;
+        bool follow_redirects = false;
+        /// Treat HTTP codes >= 400 as transfer errors.
+        bool fail_on_error = false;
+    };
+
+    struct Response {
+        /// CURLE_ABORTED_BY_CALLBACK: the loop shut down before the request finished.
+        CURLcode result = CURLE_OK;
+        long http_code = 0;
+        std::string body;
+        /// Set on failure: a libcurl or local I/O error message.
+        std::string error;
+
+        bool ok() const { return result == CURLE_OK && error.empty(); }
+    };
+
+    using Completion = std::function<void(Response&)>;
+
+    /**
+     * @param pool Source of handle defaults; must outlive the loop.
+     * @param bandwidth Budget of the file transfers.
+     * @param retry Retry decisions and concurrency slots; must outlive the loop.
+     * @param max_connections Cap on open connections (0 = unlimited);
+     *        requests above it wait inside libcurl.
+     */
+    AsyncLoop(CurlPool& pool, std::shared_ptr<BandwidthLimiter> bandwidth, RetryPolicy& retry,
+              std::size_t max_connections);
+
+    /**
+     * @brief Stop the loop; unfinished requests complete with an error.
+     */
+    ~AsyncLoop();
+
+    AsyncLoop(const AsyncLoop&) = delete;
+    AsyncLoop& operator=(const AsyncLoop&) = delete;
+
+    void submit(Request request, Completion done);
+
+private:
+    struct Transfer {
+        Request request;
+        Completion done;
+        Response response;
+        CURL* curl = nullptr;
+        curl_slist* headers = nullptr;
+        FILE* file = nullptr;
+        /// File transfers only.
+        std::unique_ptr<BandwidthMeter> meter;
+        int attempts = 0;
+        bool holds_slot = false;
+        /// Earliest start of a retry.
+        std::chrono::steady_clock::time_point retry_at;
+    };
+
+    void run();
+    void start(std::unique_ptr<Transfer> transfer);
+    void finish(Transfer* transfer, CURLcode result);
+    void complete(Transfer& transfer);
+    /// Start waiting API requests while slots are free, due retries first.
+    void admitWaiting();
+    /// Resume paused transfers whose wait is over; returns how long the
+    /// loop may sleep (ms) before a transfer or retry is due.
+    int pollTimeout();
+
+    static size_t writeBody(char* data, size_t size, size_t nmemb, void* userp);
+    static size_t writeFile(char* data, size_t size, size_t nmemb, void* userp);
+    static size_t readFile(char* buffer, size_t size, size_t nitems, void* userp);
+
+    CurlPool& pool;
+    std::shared_ptr<BandwidthLimiter> bandwidth;
+    RetryPolicy& retry;
+    CURLM* multi = nullptr;
+
+    std::mutex mutex;
+    std::deque<std::unique_ptr<Transfer>> pending;
+    bool stopping = false;
+    std::thread thread;
+
+    // Touched by the loop thread only.
+    std::vector<std::unique_ptr<Transfer>> active;
+    /// API requests waiting for a concurrency slot.
+    std::deque<std::unique_ptr<Transfer>> waiting;
+    /// API requests waiting to be retried.
+    std::vector<std::unique_ptr<Transfer>> retrying;
+    std::vector<CURL*> idle_handles;
+};
+
+#endif //YANDEX_DISK_CPP_CLIENT_ASYNCLOOP_H
@@ -0,0 +1,207 @@
+#include "Bandwidth.h"
+#include <algorithm>
+
+namespace {
+    using Clock = BandwidthLimiter::Clock;
+
+    // Depth of each bucket, as time at the current rate.
+    constexpr Clock::duration kBurst = std::chrono::milliseconds(100);
+    // A flow that has not moved bytes for this long no longer claims a share.
+    constexpr Clock::duration kIdle = std::chrono::milliseconds(250);
+    // How often an outranked flow looks again.
+    constexpr Clock::duration kRecheck = std::chrono::milliseconds(50);
+
+    Clock::duration secondsOf(double seconds) {
+        return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+    }
+}
+
+std::shared_ptr<BandwidthLimiter> BandwidthLimiter::process() {
+    static const std::shared_ptr<BandwidthLimiter> shared = std::make_shared<BandwidthLimiter>();
+    return shared;
+}
+
+void BandwidthLimiter::setLimits(uint64_t upload, uint64_t download) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto now = Clock::now();
+    const uint64_t limits[2] = {upload, download};
+    for (Direction direction : {Upload, Download}) {
+        const uint64_t old_rate = rates[direction].exchange(limits[direction]);
+        // Bytes already moved but not yet paid for are owed at the new rate:
+        // forgiving them would let a large read through at once after a cut.
+        // Lifting the limit clears the debt.
+        auto rescale = [&](Clock::time_point& until) {
+            if (until <= now) return;
+            if (old_rate == 0 || limits[direction] == 0) {
+                until = Clock::time_point{};
+                return;
+            }
+            double owed = std::chrono::duration<double>(until - now).count();
+            until = now + secondsOf(owed * static_cast<double>(old_rate) / static_cast<double>(limits[direction]));
+        };
+        rescale(due[direction]);
+        for (BandwidthFlow* flow : flows) rescale(flow->due[direction]);
+    }
+    changed.notify_all();
+}
+
+uint64_t BandwidthLimiter::limit(Direction direction) const {
+    return rates[direction].load();
+}
+
+void BandwidthLimiter::consume(BandwidthFlow& flow, Direction direction, uint64_t bytes) {
+    const uint64_t rate = rates[direction].load();
+    if (rate == 0 || bytes == 0) return;
+    const double cost = static_cast<double>(bytes) / static_cast<double>(rate);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto now = Clock::now();
+    flow.last_active[direction] = now;
+    due[direction] = std::max(due[direction], now - kBurst) + secondsOf(cost);
+
+    // The flow's own bucket runs at its share of the rate, so flows that
+    // all want more than they get converge on their weighted shares.
+    double share = shareLocked(flow, direction, now);
+    if (share > 0) {
+        flow.due[direction] = std::max(flow.due[direction], now - kBurst) + secondsOf(cost / share);
+    }
+}
+
+Clock::duration BandwidthLimiter::delay(BandwidthFlow& flow, Direction direction) {
+    if (rates[direction].load() == 0) return Clock::duration::zero();
+    std::lock_guard<std::mutex> lock(mutex);
+    return delayLocked(flow, direction, Clock::now());
+}
+
+void BandwidthLimiter::wait(BandwidthFlow& flow) {
+    if (rates[Upload].load() == 0 && rates[Download].load() == 0) return;
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        const auto now = Clock::now();
+        auto pause = std::max(delayLocked(flow, Upload, now), delayLocked(flow, Download, now));
+        if (pause <= Clock::duration::zero()) return;
+        changed.wait_for(lock, pause);
+    }
+}
+
+void BandwidthLimiter::join(BandwidthFlow* flow) {
+    std::lock_guard<std::mutex> lock(mutex);
+    flows.push_back(flow);
+}
+
+void BandwidthLimiter::leave(BandwidthFlow* flow) {
+    std::lock_guard<std::mutex> lock(mutex);
+    flows.erase(std::remove(flows.begin(), flows.end(), flow), flows.end());
+    // The others' shares grow.
+    changed.notify_all();
+}
+
+bool BandwidthLimiter::demandingLocked(const BandwidthFlow& flow, Direction direction,
+                                       Clock::time_point now) const {
+    return now - flow.last_active[direction] < kIdle || flow.due[direction] - kBurst > now;
+}
+
+double BandwidthLimiter::shareLocked(const BandwidthFlow& flow, Direction direction,
+                                     Clock::time_point now) const {
+    int top = flow.priority;
+    for (const BandwidthFlow* other : flows) {
+        if (other != &flow && demandingLocked(*other, direction, now)) top = std::max(top, other->priority);
+    }
+    if (flow.priority < top) return 0;
+
+    double total = flow.weight;
+    for (const BandwidthFlow* other : flows) {
+        if (other != &flow && other->priority == top && demandingLocked(*other, direction, now)) {
+            total += other->weight;
+        }
+    }
+    return flow.weight / total;
+}
+
+Clock::duration BandwidthLimiter::delayLocked(BandwidthFlow& flow, Direction direction,
+                                              Clock::time_point now) {
+    if (rates[direction].load() == 0 || !demandingLocked(flow, direction, now)) {
+        return Clock::duration::zero();
+    }
+    if (shareLocked(flow, direction, now) <= 0) {
+        // Still waiting counts as wanting bandwidth, so the flow keeps its
+        // place until the higher priority ones go idle.
+        flow.last_active[direction] = now;
+        return kRecheck;
+    }
+    auto until = std::max(due[direction], flow.due[direction]) - kBurst;
+    return until > now ? until - now : Clock::duration::zero();
+}
+
+BandwidthFlow::BandwidthFlow(std::shared_ptr<BandwidthLimiter> limiter, int priority, unsigned weight)
+        : owner(std::move(limiter)),
+          priority(priority),
+          weight(std::max(weight, 1u)) {
+    owner->join(this);
+}
+
+BandwidthFlow::~BandwidthFlow() {
+    owner->leave(this);
+}
+
+BandwidthMeter::BandwidthMeter(std::shared_ptr<BandwidthLimiter> limiter, BandwidthFlow* flow, bool blocking)
+        : flow(flow),
+          blocking(blocking) {
+    if (!this->flow) {
+        own_flow = std::make_unique<BandwidthFlow>(std::move(limiter), 0, 1);
+        this->flow = own_flow.get();
+    }
+}
+
+void BandwidthMeter::attach(CURL* handle) {
+    curl = handle;
+    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, &BandwidthMeter::progress);
+    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, this);
+    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+}
+
+void BandwidthMeter::resume() {
+    if (!is_paused) return;
+    const auto now = BandwidthLimiter::Clock::now();
+    if (now < resume_at) return;
+    auto pause = delay();
+    if (pause > BandwidthLimiter::Clock::duration::zero()) {
+        resume_at = now + pause;
+        return;
+    }
+    is_paused = false;
+    curl_easy_pause(curl, CURLPAUSE_CONT);
+}
+
+BandwidthLimiter::Clock::duration BandwidthMeter::delay() {
+    BandwidthLimiter& limiter = flow->limiter();
+    return std::max(limiter.delay(*flow, BandwidthLimiter::Upload),
+                    limiter.delay(*flow, BandwidthLimiter::Download));
+}
+
+int BandwidthMeter::progress(void* clientp, curl_off_t, curl_off_t dlnow, curl_off_t, curl_off_t ulnow) {
+    auto* meter = static_cast<BandwidthMeter*>(clientp);
+    if (meter->is_paused) return 0;
+
+    // The counters restart when libcurl follows a redirect.
+    curl_off_t sent = ulnow >= meter->uploaded ? ulnow - meter->uploaded : ulnow;
+    curl_off_t received = dlnow >= meter->downloaded ? dlnow - meter->downloaded : dlnow;
+    meter->uploaded = ulnow;
+    meter->downloaded = dlnow;
+
+    BandwidthLimiter& limiter = meter->flow->limiter();
+    if (sent > 0) limiter.consume(*meter->flow, BandwidthLimiter::Upload, static_cast<uint64_t>(sent));
+    if (received > 0) limiter.consume(*meter->flow, BandwidthLimiter::Download, static_cast<uint64_t>(received));
+
+    if (meter->blocking) {
+        limiter.wait(*meter->flow);
+        return 0;
+    }
+    auto pause = meter->delay();
+    if (pause > BandwidthLimiter::Clock::duration::zero()) {
+        meter->is_paused = true;
+        meter->resume_at = BandwidthLimiter::Clock::now() + pause;
+        curl_easy_pause(meter->curl, CURLPAUSE_ALL);
+    }
+    return 0;
+}
@@ -0,0 +1,135 @@
+#ifndef YANDEX_DISK_CPP_CLIENT_BANDWIDTH_H
+#define YANDEX_DISK_CPP_CLIENT_BANDWIDTH_H
+
+#pragma once
+#include <curl/curl.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class BandwidthFlow;
+
+/**
+ * @brief Token buckets for upload and download bytes, shared fairly between flows.
+ *
+ * A flow is one job (a directory transfer, a single file) and may span
+ * several connections. Bytes are accounted after they moved, so a bucket
+ * can go into debt; the flow then waits until the debt is paid. Among the
+ * flows that currently want bandwidth, only those of the highest priority
+ * are served, and they split the rate in proportion to their weights;
+ * a flow that stops asking (a slow disk, a blocked consumer) leaves its
+ * share to the others. Limits can change at any time. Safe to use from
+ * several threads.
+ */
+class BandwidthLimiter {
+public:
+    enum Direction { Upload = 0, Download = 1 };
+
+    using Clock = std::chrono::steady_clock;
+
+    /// The budget shared by every client that opts into it.
+    static std::shared_ptr<BandwidthLimiter> process();
+
+    /// Bytes per second for each direction (0 = unlimited).
+    void setLimits(uint64_t upload, uint64_t download);
+
+    uint64_t limit(Direction direction) const;
+
+    /// Charge bytes that a flow has just sent or received.
+    void consume(BandwidthFlow& flow, Direction direction, uint64_t bytes);
+
+    /// How long the flow must hold off before moving more bytes (zero = go).
+    Clock::duration delay(BandwidthFlow& flow, Direction direction);
+
+    /// Block until the flow may go on in both directions.
+    void wait(BandwidthFlow& flow);
+
+private:
+    friend class BandwidthFlow;
+
+    void join(BandwidthFlow* flow);
+    void leave(BandwidthFlow* flow);
+
+    bool demandingLocked(const BandwidthFlow& flow, Direction direction, Clock::time_point now) const;
+    /// Fraction of the rate the flow is entitled to right now (0 = outranked).
+    double shareLocked(const BandwidthFlow& flow, Direction direction, Clock::time_point now) const;
+    Clock::duration delayLocked(BandwidthFlow& flow, Direction direction, Clock::time_point now);
+
+    std::atomic<uint64_t> rates[2] = {{0}, {0}};
+
+    mutable std::mutex mutex;
+    std::condition_variable changed;
+    /// Theoretical arrival time of the next byte in each bucket.
+    Clock::time_point due[2];
+    std::vector<BandwidthFlow*> flows;
+};
+
+/**
+ * @brief One job's registration with a limiter; lives as long as the job.
+ */
+class BandwidthFlow {
+public:
+    BandwidthFlow(std::shared_ptr<BandwidthLimiter> limiter, int priority, unsigned weight);
+    ~BandwidthFlow();
+
+    BandwidthFlow(const BandwidthFlow&) = delete;
+    BandwidthFlow& operator=(const BandwidthFlow&) = delete;
+
+    BandwidthLimiter& limiter() const { return *owner; }
+
+private:
+    friend class BandwidthLimiter;
+
+    std::shared_ptr<BandwidthLimiter> owner;
+    int priority;
+    double weight;
+    /// Guarded by the limiter's mutex.
+    BandwidthLimiter::Clock::time_point due[2];
+    BandwidthLimiter::Clock::time_point last_active[2];
+};
+
+/**
+ * @brief Paces one libcurl transfer through CURLOPT_XFERINFOFUNCTION.
+ *
+ * A blocking meter sleeps in the progress callback, which keeps libcurl
+ * from reading or writing the socket meanwhile. A non-blocking one (for
+ * transfers on a shared curl_multi loop) pauses the handle instead and
+ * leaves resume() to the loop. Must outlive the transfer.
+ */
+class BandwidthMeter {
+public:
+    /// Charges the given flow, or a flow of its own with default share.
+    BandwidthMeter(std::shared_ptr<BandwidthLimiter> limiter, BandwidthFlow* flow, bool blocking = true);
+
+    BandwidthMeter(const BandwidthMeter&) = delete;
+    BandwidthMeter& operator=(const BandwidthMeter&) = delete;
+
+    void attach(CURL* curl);
+
+    bool paused() const { return is_paused; }
+    BandwidthLimiter::Clock::time_point resumeAt() const { return resume_at; }
+
+    /// Non-blocking meters: unpause the handle once its wait is over.
+    void resume();
+
+private:
+    static int progress(void* clientp, curl_off_t dltotal, curl_off_t dlnow,
+                        curl_off_t ultotal, curl_off_t ulnow);
+
+    BandwidthLimiter::Clock::duration delay();
+
+    std::unique_ptr<BandwidthFlow> own_flow;
+    BandwidthFlow* flow;
+    bool blocking;
+    CURL* curl = nullptr;
+    curl_off_t uploaded = 0;
+    curl_off_t downloaded = 0;
+    bool is_paused = false;
+    BandwidthLimiter::Clock::time_point resume_at;
+};
+
+#endif //YANDEX_DISK_CPP_CLIENT_BANDWIDTH_H
@@ -0,0 +1,283 @@
+#include "YandexDiskClient.h"
+#include "AsyncLoop.h"
+#include "MetadataCache.h"
+#include "OperationStatus.h"
+#include "QueryString.h"
+#include "RemoteIndex.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    struct Job {
+        std::size_t index;
+        /// Status check of a long-running operation instead of the operation itself.
+        bool poll;
+    };
+
+    // State shared between the calling thread and the loop's completions.
+    struct BatchRun {
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::deque<Job> queue;
+        /// Items waiting for the next round of status checks.
+        std::vector<std::size_t> waiting;
+        std::size_t in_flight = 0;
+        std::size_t polls_in_flight = 0;
+        std::vector<YandexDiskClient::BatchResult> results;
+        /// Failed status checks in a row, per item.
+        std::vector<std::size_t> failed_checks;
+    };
+
+    std::string apiErrorOf(const std::string& body) {
+        auto json = nlohmann::json::parse(body, nullptr, false);
+        if (!json.is_object() || !json.contains("error")) return {};
+        if (json.contains("message") && json["message"].is_string())
+            return "Yandex.Disk API error: " + json["message"].get<std::string>();
+        if (json["error"].is_string())
+            return "Yandex.Disk API error: " + json["error"].get<std::string>();
+        return "Yandex.Disk API error";
+    }
+}
+
+std::string YandexDiskClient::batchRequestUrl(const BatchOperation& operation, std::string& method) {
+    const std::string path = makeDiskPath(operation.path);
+    switch (operation.action) {
+        case BatchAction::Delete: {
+            method = "DELETE";
+            UrlBuilder url(options.api_base_url, "/resources");
+            url.param("path", path);
+            if (operation.permanently) url.param("permanently", "true");
+            return url.url();
+        }
+        case BatchAction::Move:
+            method = "POST";
+            return relocationUrl(apiUrl("/resources/move"), operation.path, operation.to_path, operation.overwrite);
+        case BatchAction::Copy:
+            method = "POST";
+            return relocationUrl(apiUrl("/resources/copy"), operation.path, operation.to_path, operation.overwrite);
+        case BatchAction::Publish:
+            method = "PUT";
+            return UrlBuilder(options.api_base_url, "/resources/publish").param("path", path).url();
+        case BatchAction::Unpublish:
+            method = "PUT";
+            return UrlBuilder(options.api_base_url, "/resources/unpublish").param("path", path).url();
+        case BatchAction::CreateDirectory:
+            method = "PUT";
+            return UrlBuilder(options.api_base_url, "/resources").param("path", path).url();
+    }
+    throw std::runtime_error("Unknown batch action");
+}
+
+YandexDiskClient::BatchReport YandexDiskClient::runBatch(const std::vector<BatchOperation>& operations) {
+    return runBatch(operations, BatchOptions{});
+}
+
+YandexDiskClient::BatchReport YandexDiskClient::runBatch(
+        const std::vector<BatchOperation>& operations,
+        const BatchOptions& batch)
+{
+    const auto started = Clock::now();
+    const std::size_t limit = batch.concurrency > 0 ? batch.concurrency
+                              : std::max<std::size_t>(options.async_max_connections, 1);
+    const auto max_interval = std::chrono::milliseconds(std::max(batch.max_poll_interval_ms, 1L));
+    auto interval = std::min(std::chrono::milliseconds(std::max(batch.poll_interval_ms, 1L)), max_interval);
+
+    BatchReport report;
+    BatchRun run;
+    run.results.resize(operations.size());
+    run.failed_checks.resize(operations.size());
+    for (std::size_t i = 0; i < operations.size(); ++i) run.queue.push_back({i, false});
+
+    auto onOperation = [&run, wait = batch.wait_for_operations](std::size_t index, AsyncLoop::Response& response) {
+        BatchResult result;
+        result.http_code = response.http_code;
+        if (!response.ok()) {
+            result.status = BatchStatus::Failed;
+            result.error = response.error;
+        } else if (!(result.error = apiErrorOf(response.body)).empty()) {
+            result.status = BatchStatus::Failed;
+        } else if (response.http_code == 202) {
+            auto link = nlohmann::json::parse(response.body, nullptr, false);
+            auto href = link.is_object() ? link.find("href") : link.end();
+            if (href != link.end() && href->is_string()) result.operation_href = href->get<std::string>();
+            result.status = result.operation_href.empty() ? BatchStatus::Succeeded : BatchStatus::Pending;
+        } else {
+            result.status = BatchStatus::Succeeded;
+        }
+
+        std::lock_guard<std::mutex> lock(run.mutex);
+        if (result.status == BatchStatus::Pending && wait) run.waiting.push_back(index);
+        run.results[index] = std::move(result);
+        --run.in_flight;
+        run.changed.notify_one();
+    };
+
+    auto onStatus = [&run, max_failed = std::max<std::size_t>(batch.max_failed_status_checks, 1)](
+            std::size_t index, AsyncLoop::Response& response) {
+        OperationStatus status = OperationStatus::read(response.http_code, response.body, response.error);
+
+        std::lock_guard<std::mutex> lock(run.mutex);
+        BatchResult& result = run.results[index];
+        std::size_t& failed_checks = run.failed_checks[index];
+        switch (status.state) {
+            case OperationStatus::State::Succeeded:
+                result.status = BatchStatus::Succeeded;
+                break;
+            case OperationStatus::State::Failed:
+                result.status = BatchStatus::Failed;
+                result.error = status.error;
+                break;
+            case OperationStatus::State::CheckFailed:
+                // Transient failures are retried next round, but not forever.
+                if (++failed_checks >= max_failed) {
+                    result.status = BatchStatus::Failed;
+                    result.error = status.error;
+                    break;
+                }
+                run.waiting.push_back(index);
+                break;
+            case OperationStatus::State::Running:
+                failed_checks = 0;
+                run.waiting.push_back(index);
+                break;
+        }
+        --run.in_flight;
+        --run.polls_in_flight;
+        run.changed.notify_one();
+    };
+
+    auto next_round = Clock::now() + interval;
+    const auto deadline = batch.operation_timeout_ms > 0
+                          ? started + std::chrono::milliseconds(batch.operation_timeout_ms)
+                          : Clock::time_point::max();
+
+    std::unique_lock<std::mutex> lock(run.mutex);
+    for (;;) {
+        std::vector<Job> ready;
+        while (run.in_flight < limit && !run.queue.empty()) {
+            ready.push_back(run.queue.front());
+            run.queue.pop_front();
+            ++run.in_flight;
+        }
+
+        if (!ready.empty()) {
+            // Requests are built and queued without the lock: a completion may
+            // run inline if the loop is shutting down.
+            lock.unlock();
+            for (const Job& job : ready) {
+                AsyncLoop::Request request;
+                request.token = token;
+                if (job.poll) {
+                    request.url = run.results[job.index].operation_href;
+                    async_loop->submit(std::move(request), [&onStatus, i = job.index](AsyncLoop::Response& r) {
+                        onStatus(i, r);
+                    });
+                    continue;
+                }
+                try {
+                    request.url = batchRequestUrl(operations[job.index], request.method);
+                } catch (const std::exception& ex) {
+                    AsyncLoop::Response failed;
+                    failed.error = ex.what();
+                    onOperation(job.index, failed);
+                    continue;
+                }
+                std::string url = request.url, method = request.method;
+                async_loop->submit(std::move(request), [&onOperation, cache = metadata_cache.get(),
+                                                        index = remote_index.get(), url = std::move(url),
+                                                        method = std::move(method), i = job.index](AsyncLoop::Response& r) {
+                    noteChange(cache, index, url, method, r.ok() && r.http_code < 300 && apiErrorOf(r.body).empty());
+                    onOperation(i, r);
+                });
+            }
+            lock.lock();
+            continue;
+        }
+
+        bool operations_done = run.in_flight == run.polls_in_flight && run.queue.empty();
+        if (operations_done && run.polls_in_flight == 0 && run.waiting.empty()) break;
+
+        auto now = Clock::now();
+        if (run.polls_in_flight == 0 && !run.waiting.empty()) {
+            if (now >= deadline) {
+                // Leave the remaining items Pending.
+                run.waiting.clear();
+                continue;
+            }
+            if (now >= next_round) {
+                // One round checks every waiting operation at once.
+                for (std::size_t index : run.waiting) run.queue.push_back({index, true});
+                run.polls_in_flight = run.waiting.size();
+                report.status_checks += run.waiting.size();
+                run.waiting.clear();
+                interval = std::min(interval * 2, max_interval);
+                next_round = now + interval;
+                continue;
+            }
+            run.changed.wait_until(lock, std::min(next_round, deadline));
+            continue;
+        }
+        run.changed.wait(lock);
+    }
+    lock.unlock();
+
+    report.results = std::move(run.results);
+    for (const BatchResult& result : report.results) {
+        if (!result.operation_href.empty()) ++report.async_operations;
+        switch (result.status) {
+            case BatchStatus::Succeeded: ++report.succeeded; break;
+            case BatchStatus::Failed: ++report.failed; break;
+            case BatchStatus::Pending: ++report.pending; break;
+        }
+    }
+    report.elapsed_seconds = std::chrono::duration<double>(Clock::now() - started).count();
+    return report;
+}
+
+void YandexDiskClient::waitForOperation(const std::string& href, const BatchOptions& polling) {
+    const auto started = Clock::now();
+    const auto max_interval = std::chrono::milliseconds(std::max(polling.max_poll_interval_ms, 1L));
+    auto interval = std::min(std::chrono::milliseconds(std::max(polling.poll_interval_ms, 1L)), max_interval);
+    const std::size_t max_failed = std::max<std::size_t>(polling.max_failed_status_checks, 1);
+    std::size_t failed_checks = 0;
+
+    for (;;) {
+        std::this_thread::sleep_for(interval);
+        interval = std::min(interval * 2, max_interval);
+
+        long http_code = 0;
+        std::string body;
+        std::string error;
+        try {
+            body = performRequest(href, "GET", &http_code);
+        } catch (const std::exception& ex) {
+            error = ex.what();
+        }
+
+        OperationStatus status = OperationStatus::read(http_code, body, error);
+        switch (status.state) {
+            case OperationStatus::State::Succeeded:
+                return;
+            case OperationStatus::State::Failed:
+                throw std::runtime_error(status.error);
+            case OperationStatus::State::CheckFailed:
+                if (++failed_checks >= max_failed) throw std::runtime_error(status.error);
+                break;
+            case OperationStatus::State::Running:
+                failed_checks = 0;
+                break;
+        }
+        if (polling.operation_timeout_ms > 0 &&
+            Clock::now() - started >= std::chrono::milliseconds(polling.operation_timeout_ms)) {
+            throw std::runtime_error("Operation did not finish in " +
+                                     std::to_string(polling.operation_timeout_ms) + " ms");
+        }
+    }
+}
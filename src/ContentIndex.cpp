@@ -0,0 +1,60 @@
+#include "ContentIndex.h"
+#include <algorithm>
+
+std::string ContentIndex::keyOf(const std::string& md5, uint64_t size) {
+    return md5 + ":" + std::to_string(size);
+}
+
+void ContentIndex::add(const std::string& md5, uint64_t size, const std::string& sha256, const std::string& path) {
+    if (md5.empty()) return;
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<Match>& matches = entries[keyOf(md5, size)];
+    for (Match& match : matches) {
+        if (match.path == path) {
+            match.sha256 = sha256;
+            return;
+        }
+    }
+    matches.push_back({path, sha256});
+}
+
+std::vector<ContentIndex::Match> ContentIndex::find(const std::string& md5, uint64_t size) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(keyOf(md5, size));
+    if (it == entries.end()) return {};
+    return it->second;
+}
+
+void ContentIndex::remove(const std::string& md5, uint64_t size, const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(keyOf(md5, size));
+    if (it == entries.end()) return;
+    auto& matches = it->second;
+    matches.erase(std::remove_if(matches.begin(), matches.end(),
+                                 [&](const Match& m) { return m.path == path; }),
+                  matches.end());
+    if (matches.empty()) entries.erase(it);
+}
+
+void ContentIndex::reset(std::unordered_map<std::string, std::vector<Match>> replacement) {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries = std::move(replacement);
+    is_loaded = true;
+}
+
+void ContentIndex::loadOnce(const std::function<void()>& load) {
+    std::lock_guard<std::mutex> lock(load_mutex);
+    if (!loaded()) load();
+}
+
+bool ContentIndex::loaded() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return is_loaded;
+}
+
+std::size_t ContentIndex::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::size_t n = 0;
+    for (const auto& [key, matches] : entries) n += matches.size();
+    return n;
+}
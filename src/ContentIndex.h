@@ -0,0 +1,62 @@
+#ifndef YANDEX_DISK_CPP_CLIENT_CONTENTINDEX_H
+#define YANDEX_DISK_CPP_CLIENT_CONTENTINDEX_H
+
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief In-memory map from file content (MD5 and size) to remote paths.
+ *
+ * Filled from the flat file listing of the disk and kept current by the
+ * client's own uploads. Entries may be stale, so callers re-check a match
+ * against the server before relying on it. Safe to use from several threads.
+ */
+class ContentIndex {
+public:
+    struct Match {
+        std::string path;
+        /// Empty if the server did not report it.
+        std::string sha256;
+    };
+
+    void add(const std::string& md5, uint64_t size, const std::string& sha256, const std::string& path);
+
+    std::vector<Match> find(const std::string& md5, uint64_t size) const;
+
+    void remove(const std::string& md5, uint64_t size, const std::string& path);
+
+    /**
+     * @brief Replace the whole index and mark it as loaded.
+     */
+    void reset(std::unordered_map<std::string, std::vector<Match>> entries);
+
+    /**
+     * @brief Run load() if the index is not loaded yet.
+     *
+     * Callers arriving while another thread runs load() wait for it and
+     * then return, so the index is built once however many uploads need
+     * it at the same time. If load() throws, the next caller tries again.
+     */
+    void loadOnce(const std::function<void()>& load);
+
+    /// Index key of a content; used to build the map passed to reset().
+    static std::string keyOf(const std::string& md5, uint64_t size);
+
+    bool loaded() const;
+
+    std::size_t size() const;
+
+private:
+    std::unordered_map<std::string, std::vector<Match>> entries;
+    bool is_loaded = false;
+    mutable std::mutex mutex;
+    /// Held while a first load runs; separate so reset() can take `mutex`.
+    std::mutex load_mutex;
+};
+
+#endif //YANDEX_DISK_CPP_CLIENT_CONTENTINDEX_H
@@ -0,0 +1,103 @@
+#include "CurlPool.h"
+#include "Metrics.h"
+#include <stdexcept>
+
+namespace {
+    std::once_flag curl_global_once;
+}
+
+CurlPool::CurlPool(const Settings& settings)
+        : settings(settings) {
+    if (this->settings.max_handles == 0) this->settings.max_handles = 1;
+
+    std::call_once(curl_global_once, [] { curl_global_init(CURL_GLOBAL_DEFAULT); });
+
+    share = curl_share_init();
+    if (!share) throw std::runtime_error("curl_share_init() failed");
+
+    curl_share_setopt(share, CURLSHOPT_LOCKFUNC, &CurlPool::lockShared);
+    curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, &CurlPool::unlockShared);
+    curl_share_setopt(share, CURLSHOPT_USERDATA, this);
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+}
+
+CurlPool::~CurlPool() {
+    for (CURL* curl : idle) curl_easy_cleanup(curl);
+    curl_share_cleanup(share);
+}
+
+CurlPool::Handle CurlPool::acquire() {
+    CURL* curl = nullptr;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        available.wait(lock, [this] { return !idle.empty() || created < settings.max_handles; });
+        if (!idle.empty()) {
+            curl = idle.back();
+            idle.pop_back();
+        } else {
+            curl = curl_easy_init();
+            if (!curl) throw std::runtime_error("curl_easy_init() failed");
+            ++created;
+        }
+    }
+    curl_easy_reset(curl);
+    configure(curl);
+    return Handle(this, curl);
+}
+
+void CurlPool::release(CURL* curl) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        idle.push_back(curl);
+    }
+    available.notify_one();
+}
+
+void CurlPool::configure(CURL* curl) {
+    curl_easy_setopt(curl, CURLOPT_SHARE, share);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    // Without this libcurl trims the shared cache to a few connections per
+    // handle and concurrent callers keep reconnecting.
+    curl_easy_setopt(curl, CURLOPT_MAXCONNECTS, static_cast<long>(settings.max_handles * 2));
+    if (settings.http2) {
+        curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_2TLS);
+    }
+    if (settings.connect_timeout_ms > 0) {
+        curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, settings.connect_timeout_ms);
+    }
+    if (!settings.verify_tls) {
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
+    }
+    if (!settings.ca_info.empty()) {
+        curl_easy_setopt(curl, CURLOPT_CAINFO, settings.ca_info.c_str());
+    }
+}
+
+void CurlPool::recordTransfer(CURL* curl, CURLcode result, int attempt /* = 1 */) {
+    long connects = 0;
+    curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &connects);
+    requests.fetch_add(1, std::memory_order_relaxed);
+    connections_opened.fetch_add(static_cast<std::size_t>(connects), std::memory_order_relaxed);
+    if (metrics) metrics->record(curl, result, attempt);
+}
+
+CurlPool::Stats CurlPool::stats() const {
+    Stats s;
+    s.requests = requests.load(std::memory_order_relaxed);
+    s.connections_opened = connections_opened.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(mutex);
+    s.handles_created = created;
+    return s;
+}
+
+void CurlPool::lockShared(CURL*, curl_lock_data data, curl_lock_access, void* userptr) {
+    static_cast<CurlPool*>(userptr)->share_locks[data].lock();
+}
+
+void CurlPool::unlockShared(CURL*, curl_lock_data data, void* userptr) {
+    static_cast<CurlPool*>(userptr)->share_locks[data].unlock();
+}
@@ -0,0 +1,112 @@
+#ifndef YANDEX_DISK_CPP_CLIENT_CURLPOOL_H
+#define YANDEX_DISK_CPP_CLIENT_CURLPOOL_H
+
+#pragma once
+#include <curl/curl.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class Metrics;
+
+/**
+ * @brief Bounded pool of reusable CURL easy handles.
+ *
+ * All handles are attached to one CURLSH share object, so DNS results,
+ * TLS sessions and live connections are reused across every request made
+ * by the owning client. Safe to use from several threads.
+ */
+class CurlPool {
+public:
+    /**
+     * @brief RAII lease of a pooled handle; returns it to the pool on destruction.
+     */
+    class Handle {
+    public:
+        Handle(CurlPool* pool, CURL* curl) : pool(pool), curl(curl) {}
+        Handle(Handle&& other) noexcept : pool(other.pool), curl(other.curl) {
+            other.curl = nullptr;
+        }
+        Handle(const Handle&) = delete;
+        Handle& operator=(const Handle&) = delete;
+        Handle& operator=(Handle&&) = delete;
+        ~Handle() { if (curl) pool->release(curl); }
+
+        CURL* get() const { return curl; }
+
+    private:
+        CurlPool* pool;
+        CURL* curl;
+    };
+
+    struct Settings {
+        std::size_t max_handles = 8;
+        bool http2 = true;
+        long connect_timeout_ms = 0;
+        bool verify_tls = true;
+        std::string ca_info;
+    };
+
+    struct Stats {
+        std::size_t requests = 0;
+        std::size_t connections_opened = 0;
+        std::size_t handles_created = 0;
+    };
+
+    explicit CurlPool(const Settings& settings);
+    ~CurlPool();
+
+    CurlPool(const CurlPool&) = delete;
+    CurlPool& operator=(const CurlPool&) = delete;
+
+    /**
+     * @brief Take an idle handle (or create one), blocking while the pool is exhausted.
+     *
+     * The handle is reset to the pool defaults before it is handed out.
+     */
+    Handle acquire();
+
+    /**
+     * @brief Apply the pool defaults (share object, TLS, timeouts) to a handle
+     *        that is not owned by the pool.
+     */
+    void configure(CURL* curl);
+
+    /**
+     * @brief Account a finished transfer (reads CURLINFO_NUM_CONNECTS) and
+     *        pass it on to the metrics, if set.
+     * @param attempt 1 for the first try of a request, higher for retries.
+     */
+    void recordTransfer(CURL* curl, CURLcode result, int attempt = 1);
+
+    /// Metrics to feed with every recorded transfer (null = none).
+    void setMetrics(Metrics* sink) { metrics = sink; }
+
+    Stats stats() const;
+
+private:
+    void release(CURL* curl);
+
+    static void lockShared(CURL*, curl_lock_data data, curl_lock_access, void* userptr);
+    static void unlockShared(CURL*, curl_lock_data data, void* userptr);
+
+    CURLSH* share = nullptr;
+    std::mutex share_locks[CURL_LOCK_DATA_LAST];
+
+    Settings settings;
+
+    mutable std::mutex mutex;
+    std::condition_variable available;
+    std::vector<CURL*> idle;
+    std::size_t created = 0;
+
+    std::atomic<std::size_t> requests{0};
+    std::atomic<std::size_t> connections_opened{0};
+
+    Metrics* metrics = nullptr;
+};
+
+#endif //YANDEX_DISK_CPP_CLIENT_CURLPOOL_H
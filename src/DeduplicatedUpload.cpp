@@ -0,0 +1,156 @@
+#include "YandexDiskClient.h"
+#include "ContentIndex.h"
+#include "Md5.h"
+#include "QueryString.h"
+#include "ResourceListing.h"
+#include "Sha256.h"
+#include <cstdio>
+#include <filesystem>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+    constexpr std::size_t kFilesPageSize = 1000;
+    // A copy still running after this long is given up and the file sent.
+    constexpr long kCopyTimeoutMs = 10 * 60 * 1000;
+
+    // Listings report "disk:/a/b"; callers may pass "/a/b" or "disk:/a/b".
+    std::string withoutScheme(const std::string& path) {
+        const std::string scheme = "disk:";
+        return path.compare(0, scheme.size(), scheme) == 0 ? path.substr(scheme.size()) : path;
+    }
+
+    void hashFile(const std::string& path, std::string& md5, std::string& sha256) {
+#if defined(_WIN32)
+        FILE* file = _wfopen(std::filesystem::path(path).wstring().c_str(), L"rb");
+#else
+        FILE* file = fopen(path.c_str(), "rb");
+#endif
+        if (!file) {
+            throw std::runtime_error("Couldn't open the file: " + path);
+        }
+
+        // Both digests come from one read of the file.
+        Md5 md5_hasher;
+        Sha256 sha_hasher;
+        std::vector<char> chunk(1 << 20);
+        std::size_t n;
+        while ((n = fread(chunk.data(), 1, chunk.size(), file)) > 0) {
+            md5_hasher.update(chunk.data(), n);
+            sha_hasher.update(chunk.data(), n);
+        }
+        bool failed = ferror(file) != 0;
+        fclose(file);
+        if (failed) throw std::runtime_error("Failed to read " + path);
+
+        md5 = md5_hasher.hexDigest();
+        sha256 = sha_hasher.hexDigest();
+    }
+}
+
+YandexDiskClient::UploadResult YandexDiskClient::uploadFile(
+        const std::string& disk_dir,
+        const std::string& local_path,
+        const UploadOptions& upload)
+{
+    std::string disk_path = makeUploadDiskPath(disk_dir, local_path);
+    if (upload.deduplicate) return uploadFileDeduplicated(disk_path, local_path);
+
+    UploadResult result;
+    uploadFileTo(disk_path, local_path, &result.md5);
+    result.bytes_sent = std::filesystem::file_size(std::filesystem::path(local_path));
+    return result;
+}
+
+std::size_t YandexDiskClient::refreshContentIndex() {
+    std::unordered_map<std::string, std::vector<ContentIndex::Match>> entries;
+    std::size_t count = 0;
+    ResourceListing page;
+
+    for (std::size_t offset = 0;; offset += kFilesPageSize) {
+        UrlBuilder url(options.api_base_url, "/resources/files");
+        url.param("limit", kFilesPageSize).param("offset", offset)
+           .param("fields", "items.path,items.md5,items.sha256,items.size");
+        std::string resp = performRequest(url.url(), "GET");
+        checkApiError(resp);
+        page.parse(resp);
+
+        for (const auto& item : page.items()) {
+            if (item.md5.empty()) continue;
+            entries[ContentIndex::keyOf(std::string(item.md5), item.size)].push_back(
+                    {withoutScheme(std::string(item.path)), std::string(item.sha256)});
+            ++count;
+        }
+        if (page.items().size() < kFilesPageSize) break;
+    }
+
+    content_index->reset(std::move(entries));
+    return count;
+}
+
+YandexDiskClient::UploadResult YandexDiskClient::uploadFileDeduplicated(
+        const std::string& upload_disk_path,
+        const std::string& local_path,
+        BandwidthFlow* flow /* = nullptr */)
+{
+    UploadResult result;
+    uint64_t size = std::filesystem::file_size(std::filesystem::path(local_path));
+    hashFile(local_path, result.md5, result.sha256);
+
+    content_index->loadOnce([this] { refreshContentIndex(); });
+
+    const std::string target = withoutScheme(makeDiskPath(upload_disk_path));
+    for (const ContentIndex::Match& match : content_index->find(result.md5, size)) {
+        // The index may be stale: confirm the candidate still holds this content.
+        UrlBuilder url(options.api_base_url, "/resources");
+        url.param("path", match.path).param("fields", "type,size,md5,sha256");
+        long http_code = 0;
+        std::string resp = performRequest(url.url(), "GET", &http_code);
+        nlohmann::json meta = nlohmann::json::parse(resp, nullptr, false);
+        bool same = http_code == 200 && meta.is_object() &&
+                    meta.value("type", "") == "file" &&
+                    meta.value("size", uint64_t{0}) == size &&
+                    meta.value("md5", "") == result.md5 &&
+                    (meta.value("sha256", "").empty() || meta.value("sha256", "") == result.sha256);
+        if (!same) {
+            content_index->remove(result.md5, size, match.path);
+            continue;
+        }
+
+        // The copy only counts once it is done: a 202 is polled to the end,
+        // so a journal never records a file the server has not got.
+        try {
+            if (match.path != target) {
+                long copy_code = 0;
+                std::string reply = performRequest(relocationUrl(apiUrl("/resources/copy"), match.path, target, true),
+                                                   "POST", &copy_code);
+                checkApiError(reply);
+                if (copy_code == 202) {
+                    auto link = nlohmann::json::parse(reply, nullptr, false);
+                    auto href = link.is_object() ? link.find("href") : link.end();
+                    if (href == link.end() || !href->is_string()) {
+                        throw std::runtime_error("Copy accepted without an operation link");
+                    }
+                    BatchOptions polling;
+                    polling.operation_timeout_ms = kCopyTimeoutMs;
+                    waitForOperation(href->get<std::string>(), polling);
+                }
+            }
+        } catch (const std::exception& ex) {
+            if (!result.copy_error.empty()) result.copy_error += "; ";
+            result.copy_error += match.path + ": " + ex.what();
+            continue;
+        }
+        content_index->add(result.md5, size, result.sha256, target);
+        result.deduplicated = true;
+        result.source_path = match.path;
+        result.bytes_saved = size;
+        return result;
+    }
+
+    uploadFileTo(upload_disk_path, local_path, nullptr, flow);
+    content_index->add(result.md5, size, result.sha256, target);
+    result.bytes_sent = size;
+    return result;
+}
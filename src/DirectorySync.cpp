@@ -0,0 +1,398 @@
+#include "YandexDiskClient.h"
+#include "Bandwidth.h"
+#include "HashIndex.h"
+#include "Md5.h"
+#include "WorkerPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+
+namespace {
+    namespace fs = std::filesystem;
+
+    struct LocalFile {
+        fs::path path;
+        uint64_t size = 0;
+        int64_t modified = 0;
+        std::string md5;
+    };
+
+    struct RemoteFile {
+        std::string disk_path;
+        uint64_t size = 0;
+        int64_t modified = 0;
+        std::string md5;
+    };
+
+    int64_t unixSeconds(fs::file_time_type time) {
+        // C++17 has no clock_cast; translate through the current instant.
+        auto sys = std::chrono::system_clock::now() +
+                   std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                           time - fs::file_time_type::clock::now());
+        return std::chrono::duration_cast<std::chrono::seconds>(sys.time_since_epoch()).count();
+    }
+
+    int64_t daysFromCivil(int64_t y, unsigned m, unsigned d) {
+        y -= m <= 2;
+        const int64_t era = (y >= 0 ? y : y - 399) / 400;
+        const unsigned yoe = static_cast<unsigned>(y - era * 400);
+        const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+        const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + static_cast<int64_t>(doe) - 719468;
+    }
+
+    // "2024-05-01T10:20:30+03:00" as returned in `modified`; 0 if malformed.
+    int64_t parseIsoTime(const std::string& text) {
+        int y, mo, d, h, mi, s;
+        if (std::sscanf(text.c_str(), "%d-%d-%dT%d:%d:%d", &y, &mo, &d, &h, &mi, &s) != 6) return 0;
+        int64_t seconds = daysFromCivil(y, static_cast<unsigned>(mo), static_cast<unsigned>(d)) * 86400 +
+                          h * 3600 + mi * 60 + s;
+        std::size_t zone = text.find_first_of("+-", 19);
+        int oh = 0, om = 0;
+        if (zone != std::string::npos && std::sscanf(text.c_str() + zone + 1, "%d:%d", &oh, &om) >= 1) {
+            int64_t offset = oh * 3600 + om * 60;
+            seconds -= text[zone] == '+' ? offset : -offset;
+        }
+        return seconds;
+    }
+
+    std::string parentOf(const std::string& rel) {
+        std::size_t slash = rel.rfind('/');
+        return slash == std::string::npos ? std::string() : rel.substr(0, slash);
+    }
+
+    bool under(const std::string& rel, const std::set<std::string>& dirs) {
+        for (std::string p = parentOf(rel); !p.empty(); p = parentOf(p)) {
+            if (dirs.count(p)) return true;
+        }
+        return false;
+    }
+}
+
+YandexDiskClient::SyncReport YandexDiskClient::syncDirectory(
+        const std::string& disk_path,
+        const std::string& local_path,
+        const SyncOptions& sync)
+{
+    const bool push = sync.direction != SyncDirection::Download;
+    const bool pull = sync.direction != SyncDirection::Upload;
+    const bool prune = sync.delete_extraneous && sync.direction != SyncDirection::TwoWay;
+
+    auto start = std::chrono::steady_clock::now();
+    SyncReport report;
+    std::mutex mutex;
+
+    fs::path local_root(local_path);
+    if (!fs::is_directory(local_root)) {
+        if (sync.direction == SyncDirection::Upload) {
+            throw std::runtime_error("Local directory does not exist: " + local_path);
+        }
+        fs::create_directories(local_root);
+    }
+
+    std::string disk_root = disk_path;
+    while (disk_root.size() > 1 && disk_root.back() == '/') disk_root.pop_back();
+    auto diskPathOf = [&](const std::string& rel) {
+        return (disk_root.back() == '/' ? disk_root : disk_root + "/") + rel;
+    };
+
+    if (!exists(disk_root)) {
+        if (!push) throw std::runtime_error("Remote directory does not exist: " + disk_path);
+        ensureDirectory(disk_root);
+    }
+
+    TransferOptions pool_size;
+    pool_size.workers = sync.workers;
+    const std::size_t n = workerCount(pool_size);
+
+    std::unique_ptr<HashIndex> index;
+    if (!sync.index_path.empty()) index = std::make_unique<HashIndex>(sync.index_path);
+
+    // === Local tree ===
+    std::map<std::string, LocalFile> local_files;
+    std::set<std::string> local_dirs;
+    const fs::path index_file = sync.index_path.empty() ? fs::path() : fs::absolute(sync.index_path);
+    for (auto it = fs::recursive_directory_iterator(local_root);
+         it != fs::recursive_directory_iterator(); ++it) {
+        std::string rel = it->path().lexically_relative(local_root).generic_u8string();
+        if (it->is_directory()) {
+            local_dirs.insert(rel);
+        } else if (it->is_regular_file()) {
+            fs::path absolute = fs::absolute(it->path());
+            if (!index_file.empty() &&
+                (absolute == index_file || absolute == fs::path(index_file.string() + ".tmp"))) {
+                continue;
+            }
+            local_files[rel] = {it->path(), it->file_size(), unixSeconds(it->last_write_time()), ""};
+        }
+    }
+
+    // === Remote tree ===
+    std::map<std::string, RemoteFile> remote_files;
+    std::set<std::string> remote_dirs;
+    // Subtrees that could not be listed are left alone rather than treated as empty.
+    std::set<std::string> unlisted;
+    {
+        // Declared before the pool so queued listings never outlive it.
+        std::function<void(const std::string&, const std::string&)> listDir;
+        WorkerPool listers(n);
+        ListOptions list;
+        list.fields = "name,path,type,size,md5,modified";
+
+        listDir = [&](const std::string& dir_path, const std::string& rel) {
+            forEachResourceEntry(dir_path, [&](const ResourceEntry& item) {
+                std::string name(item.name);
+                std::string child = rel.empty() ? name : rel + "/" + name;
+                std::string child_path(item.path);
+                std::lock_guard<std::mutex> lock(mutex);
+                if (item.type == "dir") {
+                    remote_dirs.insert(child);
+                    listers.submit([&, child_path, child] {
+                        try {
+                            listDir(child_path, child);
+                        } catch (const std::exception& ex) {
+                            std::lock_guard<std::mutex> lock(mutex);
+                            unlisted.insert(child);
+                            report.errors.push_back({"", child_path, ex.what()});
+                        }
+                    });
+                } else {
+                    remote_files[child] = {child_path, item.size,
+                                           parseIsoTime(std::string(item.modified)),
+                                           std::string(item.md5)};
+                }
+                return true;
+            }, list);
+        };
+
+        listDir(disk_root, "");
+        listers.wait();
+    }
+
+    auto skipped = [&](const std::string& rel) {
+        return unlisted.count(rel) || under(rel, unlisted);
+    };
+
+    // === Checksums of files that may be identical ===
+    {
+        WorkerPool hashers(n, n * 4);
+        for (auto& [rel, local] : local_files) {
+            auto remote = remote_files.find(rel);
+            if (remote == remote_files.end() || remote->second.size != local.size ||
+                remote->second.md5.empty()) {
+                continue;
+            }
+            hashers.submit([&, &local = local] {
+                try {
+                    HashIndex::FileKey key = HashIndex::keyOf(local.path);
+                    if (index && index->lookup(key, local.md5)) {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        ++report.hash_cache_hits;
+                        return;
+                    }
+                    local.md5 = Md5::ofFile(local.path.string());
+                    if (index) index->store(key, local.md5);
+                    std::lock_guard<std::mutex> lock(mutex);
+                    ++report.files_hashed;
+                } catch (const std::exception& ex) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    report.errors.push_back({local.path.string(), "", ex.what()});
+                }
+            });
+        }
+        hashers.wait();
+    }
+
+    // === Plan ===
+    struct Job {
+        enum Kind { Upload, Download, DeleteRemote, DeleteLocal } kind;
+        std::string rel;
+        uint64_t size;
+    };
+    std::vector<Job> jobs;
+    std::vector<std::string> make_remote_dirs;
+    std::vector<std::string> make_local_dirs;
+    std::set<std::string> prune_dirs;
+
+    for (const auto& [rel, local] : local_files) {
+        if (skipped(rel)) continue;
+        auto remote = remote_files.find(rel);
+        if (remote == remote_files.end()) {
+            if (push) jobs.push_back({Job::Upload, rel, local.size});
+            else if (prune) jobs.push_back({Job::DeleteLocal, rel, local.size});
+            continue;
+        }
+        const RemoteFile& r = remote->second;
+        if (local.size == r.size && !local.md5.empty() && local.md5 == r.md5) {
+            ++report.files_unchanged;
+            continue;
+        }
+        if (local.size == r.size && local.md5.empty() && !r.md5.empty()) {
+            continue; // hashing failed; already reported
+        }
+        bool upload = sync.direction == SyncDirection::Upload ||
+                      (sync.direction == SyncDirection::TwoWay && local.modified >= r.modified);
+        jobs.push_back({upload ? Job::Upload : Job::Download, rel, upload ? local.size : r.size});
+    }
+    for (const auto& [rel, remote] : remote_files) {
+        if (local_files.count(rel) || skipped(rel)) continue;
+        if (pull) jobs.push_back({Job::Download, rel, remote.size});
+        else if (prune) jobs.push_back({Job::DeleteRemote, rel, remote.size});
+    }
+
+    for (const std::string& rel : local_dirs) {
+        if (remote_dirs.count(rel) || skipped(rel)) continue;
+        if (push) make_remote_dirs.push_back(rel);
+        else if (prune) prune_dirs.insert(rel);
+    }
+    for (const std::string& rel : remote_dirs) {
+        if (local_dirs.count(rel) || skipped(rel)) continue;
+        if (pull) make_local_dirs.push_back(rel);
+        else if (prune) prune_dirs.insert(rel);
+    }
+
+    // === Directories ===
+    for (const std::string& rel : make_local_dirs) {
+        std::error_code ec;
+        fs::create_directories(local_root / fs::u8path(rel), ec);
+        if (ec) report.errors.push_back({(local_root / fs::u8path(rel)).string(), diskPathOf(rel), ec.message()});
+    }
+
+    // Parents sort before their children, so grouping by depth keeps the
+    // parallel creation of each level safe.
+    std::map<std::size_t, std::vector<std::string>> levels;
+    for (const std::string& rel : make_remote_dirs) {
+        levels[static_cast<std::size_t>(std::count(rel.begin(), rel.end(), '/'))].push_back(rel);
+    }
+    std::set<std::string> failed_dirs;
+    {
+        WorkerPool creators(n, n * 4);
+        for (const auto& [depth, rels] : levels) {
+            for (const std::string& rel : rels) {
+                creators.submit([&, rel] {
+                    try {
+                        ensureDirectory(diskPathOf(rel));
+                    } catch (const std::exception& ex) {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        failed_dirs.insert(rel);
+                        report.errors.push_back({(local_root / fs::u8path(rel)).string(), diskPathOf(rel), ex.what()});
+                    }
+                });
+            }
+            creators.wait();
+        }
+    }
+
+    // Only the topmost extraneous directory is deleted; its contents go with it.
+    std::vector<Job> delete_dirs;
+    for (const std::string& rel : prune_dirs) {
+        if (!under(rel, prune_dirs)) {
+            delete_dirs.push_back({push ? Job::DeleteRemote : Job::DeleteLocal, rel, 0});
+        }
+    }
+
+    // === Transfers and deletions ===
+    TransferProgress progress;
+    for (const Job& job : jobs) {
+        if (job.kind == Job::Upload || job.kind == Job::Download) {
+            ++progress.files_total;
+            progress.bytes_total += job.size;
+        }
+    }
+
+    {
+        BandwidthFlow flow(bandwidth, sync.bandwidth.priority, sync.bandwidth.weight);
+        // Declared before the pool so queued jobs never outlive it.
+        auto run = [&](const Job& job) {
+            fs::path local_file = local_root / fs::u8path(job.rel);
+            std::string disk_file = diskPathOf(job.rel);
+            std::string error;
+            try {
+                switch (job.kind) {
+                    case Job::Upload: {
+                        std::string md5;
+                        uploadFileTo(disk_file, local_file.string(), &md5, &flow);
+                        if (index) index->store(HashIndex::keyOf(local_file), md5);
+                        break;
+                    }
+                    case Job::Download: {
+                        const RemoteFile& remote = remote_files.at(job.rel);
+                        // Written aside and renamed on success: a truncated file with a
+                        // fresh mtime would win the next two-way run and be uploaded.
+                        const std::string part = local_file.string() + ".part";
+                        try {
+                            downloadHref(getDownloadUrl(remote.disk_path), part, &flow);
+                            fs::rename(part, local_file);
+                        } catch (...) {
+                            std::error_code ec;
+                            fs::remove(part, ec);
+                            throw;
+                        }
+                        if (index && !remote.md5.empty()) index->store(HashIndex::keyOf(local_file), remote.md5);
+                        break;
+                    }
+                    case Job::DeleteRemote:
+                        deleteFileOrDir(disk_file);
+                        break;
+                    case Job::DeleteLocal:
+                        fs::remove_all(local_file);
+                        break;
+                }
+            } catch (const std::exception& ex) {
+                error = ex.what();
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error.empty()) {
+                report.errors.push_back({local_file.string(), disk_file, error});
+            } else if (job.kind == Job::Upload) {
+                ++report.files_uploaded;
+                report.bytes_uploaded += job.size;
+            } else if (job.kind == Job::Download) {
+                ++report.files_downloaded;
+                report.bytes_downloaded += job.size;
+            } else {
+                ++report.files_deleted;
+            }
+
+            if (job.kind == Job::Upload || job.kind == Job::Download) {
+                ++progress.files_done;
+                if (error.empty()) progress.bytes_done += job.size;
+                if (sync.on_progress) {
+                    progress.elapsed_seconds = std::chrono::duration<double>(
+                            std::chrono::steady_clock::now() - start).count();
+                    sync.on_progress(progress);
+                }
+            }
+        };
+
+        WorkerPool workers(n, n * 2);
+        for (const Job& job : jobs) {
+            if (job.kind == Job::Upload && under(job.rel, failed_dirs)) {
+                std::lock_guard<std::mutex> lock(mutex);
+                report.errors.push_back({(local_root / fs::u8path(job.rel)).string(), diskPathOf(job.rel),
+                                         "Parent directory was not created"});
+                continue;
+            }
+            if ((job.kind == Job::DeleteRemote || job.kind == Job::DeleteLocal) && under(job.rel, prune_dirs)) {
+                continue;
+            }
+            workers.submit([&, job] { run(job); });
+        }
+        for (const Job& job : delete_dirs) {
+            workers.submit([&, job] { run(job); });
+        }
+        workers.wait();
+    }
+
+    if (index) index->save();
+
+    report.elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return report;
+}
@@ -0,0 +1,635 @@
+#include "YandexDiskClient.h"
+#include "Bandwidth.h"
+#include "DownloadTarget.h"
+#include "LocalTreeWalker.h"
+#include "PackArchive.h"
+#include "QueryString.h"
+#include "TransferJournal.h"
+#include "WorkerPool.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+
+namespace {
+    double secondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    std::unique_ptr<TransferJournal> openJournal(const std::string& path) {
+        if (path.empty()) return nullptr;
+        return std::make_unique<TransferJournal>(path);
+    }
+
+    bool startsWith(std::string_view text, std::string_view prefix) {
+        return text.substr(0, prefix.size()) == prefix;
+    }
+
+    bool endsWith(std::string_view text, std::string_view suffix) {
+        return text.size() >= suffix.size() && text.substr(text.size() - suffix.size()) == suffix;
+    }
+
+    // Collects a small download (a pack index or one zstd frame) in memory.
+    CallbackTarget collectInto(std::string& out) {
+        return CallbackTarget([&out](const char* data, std::size_t size) {
+            out.append(data, size);
+            return true;
+        });
+    }
+
+    std::string byteRange(uint64_t offset, uint64_t length) {
+        return std::to_string(offset) + "-" + std::to_string(offset + length - 1);
+    }
+
+    // The pack directory itself or anything below it.
+    bool isPackPath(std::string_view relative) {
+        std::string_view directory = PackIndex::kDirectory;
+        return startsWith(relative, directory) &&
+               (relative.size() == directory.size() || relative[directory.size()] == '/');
+    }
+
+    // Remote counterpart of a local directory being uploaded. It is created
+    // on a worker; the jobs for its contents wait for the outcome. Jobs are
+    // queued in walk order, so a directory's job always leaves the queue
+    // before any job that waits on it.
+    class PendingDirectory {
+    public:
+        void finish(bool created) {
+            std::lock_guard<std::mutex> lock(mutex);
+            done = true;
+            ok = created;
+            ready.notify_all();
+        }
+
+        /// @return whether the directory exists on the disk.
+        bool wait() {
+            std::unique_lock<std::mutex> lock(mutex);
+            ready.wait(lock, [this] { return done; });
+            return ok;
+        }
+
+    private:
+        std::mutex mutex;
+        std::condition_variable ready;
+        bool done = false;
+        bool ok = false;
+    };
+}
+
+std::size_t YandexDiskClient::workerCount(const TransferOptions& transfer) const {
+    if (transfer.workers > 0) return transfer.workers;
+    return options.connection_pool_size > 0 ? options.connection_pool_size : 1;
+}
+
+void YandexDiskClient::throwOnTransferErrors(const TransferReport& report) {
+    if (report.ok()) return;
+    const TransferError& first = report.errors.front();
+    throw std::runtime_error(
+            "Directory transfer failed for " + std::to_string(report.errors.size()) +
+            " item(s); first error: " +
+            (first.local_path.empty() ? first.disk_path : first.local_path) +
+            ": " + first.message);
+}
+
+YandexDiskClient::TransferReport YandexDiskClient::uploadDirectory(
+        const std::string& disk_path,
+        const std::string& local_path,
+        const TransferOptions& transfer)
+{
+    namespace fs = std::filesystem;
+
+    if (!fs::exists(local_path) || !fs::is_directory(local_path)) {
+        throw std::runtime_error("Local directory does not exist: " + local_path);
+    }
+
+    fs::path disk_fs(disk_path);
+    fs::path local_fs(local_path);
+
+    if (disk_fs.empty() || disk_fs == "/" ||
+    !disk_fs.has_filename() ||
+    disk_path.back() == '/' ||
+    disk_path.back() == '\\') {
+        disk_fs /= local_fs.filename();
+    }
+
+    const bool packing = transfer.pack_threshold > 0;
+#if !defined(YDISK_WITH_ZSTD)
+    if (packing && transfer.pack_compress) {
+        throw std::runtime_error("Pack compression needs a build with YDISK_WITH_ZSTD");
+    }
+#endif
+
+    auto start = std::chrono::steady_clock::now();
+    TransferReport report;
+    if (ensureDirectory(disk_fs.generic_string())) ++report.directories_created;
+    const std::string packs_disk = (disk_fs / PackIndex::kDirectory).generic_string();
+    if (packing && ensureDirectory(packs_disk)) ++report.directories_created;
+
+    TransferProgress progress;
+    std::unique_ptr<TransferJournal> journal = openJournal(transfer.journal_path);
+    std::mutex mutex;
+    // All files of the run draw on the budget as one job.
+    BandwidthFlow flow(bandwidth, transfer.bandwidth.priority, transfer.bandwidth.weight);
+
+    // This state and the pack state below are declared before the pool so
+    // queued jobs never outlive them.
+    auto fail = [&](const std::string& local, const std::string& disk, const std::string& error) {
+        std::lock_guard<std::mutex> lock(mutex);
+        report.errors.push_back({local, disk, error});
+    };
+
+    // Remote counterparts of the directories from the root down to the walk's
+    // current position; jobs keep the ones they wait on alive after that.
+    auto root_dir = std::make_shared<PendingDirectory>();
+    root_dir->finish(true);
+    std::vector<std::pair<std::string, std::shared_ptr<PendingDirectory>>> chain;
+
+    // Small files are gathered into packs on the walk thread and each full
+    // pack becomes one job. Pack names carry the start time of the run, so a
+    // rerun never overwrites an archive that an older index describes; the
+    // older packs are removed once every pack of this run is in place.
+    const std::string run_id = std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+    std::vector<std::string> pack_files;
+    bool pack_failed = false;
+    PackIndex pack;
+    uint64_t pack_bytes = 0;
+    std::size_t pack_count = 0;
+
+    // The walk feeds the workers through a bounded queue, so only a few
+    // dozen jobs exist at a time whatever the size of the tree.
+    WorkerPool workers(workerCount(transfer), workerCount(transfer) * 4);
+
+    auto flushPack = [&] {
+        if (pack.members.empty()) return;
+        char number[16];
+        std::snprintf(number, sizeof(number), "%06zu", pack_count++);
+        const std::string name = "pack-" + run_id + "-" + number;
+        pack.archive = name + (transfer.pack_compress ? ".tar.zst" : ".tar");
+
+        workers.submit([&, index = std::move(pack), name] {
+            const std::string archive = packs_disk + "/" + index.archive;
+            const std::size_t members = index.members.size();
+            uint64_t size = 0;
+            for (const PackIndex::Member& member : index.members) size += member.size;
+
+            std::string error;
+            try {
+                PackBody body(local_fs.string(), index, transfer.pack_compress);
+                uploadBody(archive, body, nullptr, &flow);
+                const std::string text = body.index().dump();
+                MemoryBody index_body(text.data(), text.size());
+                uploadBody(packs_disk + "/" + name + PackIndex::kIndexSuffix, index_body, nullptr, &flow);
+            } catch (const std::exception& ex) {
+                error = ex.what();
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            progress.files_done += members;
+            if (error.empty()) {
+                report.files_transferred += members;
+                report.files_packed += members;
+                report.bytes_transferred += size;
+                progress.bytes_done += size;
+                pack_files.push_back(index.archive);
+                pack_files.push_back(name + PackIndex::kIndexSuffix);
+            } else {
+                pack_failed = true;
+                report.files_failed += members;
+                report.errors.push_back({local_fs.string(), archive,
+                                         "Pack of " + std::to_string(members) + " file(s) failed: " + error});
+            }
+            if (transfer.on_progress) {
+                progress.elapsed_seconds = secondsSince(start);
+                transfer.on_progress(progress);
+            }
+        });
+        pack = PackIndex();
+        pack_bytes = 0;
+    };
+
+    LocalTreeWalker walker(local_fs.string());
+    LocalTreeWalker::Entry entry;
+    while (walker.next(entry)) {
+        if (packing && isPackPath(entry.relative)) continue;
+
+        std::size_t slash = entry.relative.rfind('/');
+        std::string_view parent_relative(entry.relative.data(), slash == std::string::npos ? 0 : slash);
+        while (!chain.empty() && chain.back().first != parent_relative) chain.pop_back();
+        std::shared_ptr<PendingDirectory> parent = chain.empty() ? root_dir : chain.back().second;
+
+        std::string disk_target = (disk_fs / fs::path(entry.relative)).generic_string();
+
+        if (entry.directory) {
+            auto dir = std::make_shared<PendingDirectory>();
+            chain.emplace_back(entry.relative, dir);
+            if (!entry.error.empty()) fail(entry.path, disk_target, "Cannot read directory: " + entry.error);
+
+            workers.submit([&, parent, dir, local = entry.path, disk = std::move(disk_target)] {
+                if (!parent->wait()) {
+                    dir->finish(false);
+                    fail(local, disk, "Parent directory was not created");
+                    return;
+                }
+                try {
+                    bool created = ensureDirectory(disk);
+                    dir->finish(true);
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (created) ++report.directories_created;
+                } catch (const std::exception& ex) {
+                    dir->finish(false);
+                    fail(local, disk, ex.what());
+                }
+            });
+            continue;
+        }
+
+        const uint64_t size = entry.size;
+        if (packing && size < transfer.pack_threshold) {
+            pack.members.push_back({entry.relative, size, entry.mtime, 0});
+            pack_bytes += PackIndex::recordSize(entry.relative, size);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                ++progress.files_total;
+                progress.bytes_total += size;
+            }
+            if (pack_bytes >= transfer.pack_size) flushPack();
+            continue;
+        }
+
+        std::string stamp;
+        if (journal) {
+            std::error_code ec;
+            stamp = std::to_string(fs::last_write_time(entry.path, ec).time_since_epoch().count());
+        }
+
+        // The upload API has no partial PUT, so files are resumed whole: a
+        // file recorded as done with the same size and mtime is skipped.
+        TransferJournal::Entry done;
+        bool skip = journal && journal->find("upload:" + disk_target, done) &&
+                    done.done && done.size == size && done.stamp == stamp;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++progress.files_total;
+            progress.bytes_total += size;
+            if (skip) {
+                ++report.files_skipped;
+                ++progress.files_done;
+                progress.bytes_done += size;
+            }
+        }
+        if (skip) continue;
+
+        workers.submit([&, parent, size, local = entry.path, disk = std::move(disk_target),
+                        stamp = std::move(stamp)] {
+            std::string error;
+            if (!parent->wait()) error = "Parent directory was not created";
+            uint64_t saved = 0;
+            if (error.empty()) {
+                try {
+                    std::string md5;
+                    if (transfer.deduplicate) {
+                        UploadResult result = uploadFileDeduplicated(disk, local, &flow);
+                        md5 = result.md5;
+                        saved = result.bytes_saved;
+                    } else {
+                        uploadFileTo(disk, local, journal ? &md5 : nullptr, &flow);
+                    }
+                    if (journal) {
+                        journal->record("upload:" + disk,
+                                        TransferJournal::Entry{size, size, md5, stamp, true});
+                    }
+                } catch (const std::exception& ex) {
+                    error = ex.what();
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            ++progress.files_done;
+            if (error.empty()) {
+                ++report.files_transferred;
+                report.bytes_transferred += size;
+                report.bytes_deduplicated += saved;
+                progress.bytes_done += size;
+            } else {
+                ++report.files_failed;
+                report.errors.push_back({local, disk, error});
+            }
+            if (transfer.on_progress) {
+                progress.elapsed_seconds = secondsSince(start);
+                transfer.on_progress(progress);
+            }
+        });
+    }
+    flushPack();
+    workers.wait();
+
+    // Packs left by earlier runs would extract stale copies of the files;
+    // after a failed pack they are kept so nothing is lost until a rerun.
+    if (packing && !pack_failed) {
+        std::vector<std::string> stale;
+        try {
+            forEachResourceEntry(packs_disk, [&](const ResourceEntry& item) {
+                std::string name(item.name);
+                if (item.type == "file" && startsWith(name, "pack-") &&
+                    std::find(pack_files.begin(), pack_files.end(), name) == pack_files.end()) {
+                    stale.emplace_back(item.path);
+                }
+                return true;
+            });
+            for (const std::string& path : stale) {
+                UrlBuilder url(options.api_base_url, "/resources");
+                url.param("path", path).param("permanently", "true");
+                checkApiError(performRequest(url.url(), "DELETE"));
+            }
+        } catch (const std::exception& ex) {
+            report.errors.push_back({std::string(), packs_disk, std::string("Cannot remove old packs: ") + ex.what()});
+        }
+    }
+
+    report.elapsed_seconds = secondsSince(start);
+    return report;
+}
+
+YandexDiskClient::TransferReport YandexDiskClient::downloadDirectory(
+        const std::string& disk_path,
+        const std::string& local_path,
+        const TransferOptions& transfer)
+{
+    namespace fs = std::filesystem;
+
+    fs::path local_fs(local_path);
+    fs::path disk_fs(disk_path);
+
+    if (!fs::exists(local_fs) || fs::is_directory(local_fs)) {
+        fs::path folder_name = disk_fs.filename();
+        if (folder_name.empty()) {
+            folder_name = disk_fs.parent_path().filename();
+        }
+        local_fs /= folder_name;
+    } else if (fs::exists(local_fs) && !fs::is_directory(local_fs)) {
+        throw std::runtime_error("Local path exists and is not a directory: " +
+        local_path);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    TransferReport report;
+    TransferProgress progress;
+    std::unique_ptr<TransferJournal> journal = openJournal(transfer.journal_path);
+    std::mutex mutex;
+
+    auto finishFile = [&](const fs::path& local_file, const std::string& disk_file,
+                          uint64_t size, const std::string& error) {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++progress.files_done;
+        if (error.empty()) {
+            ++report.files_transferred;
+            report.bytes_transferred += size;
+            progress.bytes_done += size;
+        } else {
+            ++report.files_failed;
+            report.errors.push_back({local_file.string(), disk_file, error});
+        }
+        if (transfer.on_progress) {
+            progress.elapsed_seconds = secondsSince(start);
+            transfer.on_progress(progress);
+        }
+    };
+
+    // Three stages: directory listing, href resolution and body transfer.
+    // Each stage only feeds the next one, so draining them in order finishes
+    // the run. The bounded queues keep href resolution a little ahead of the
+    // transfers without resolving the whole tree up front.
+    std::size_t n = workerCount(transfer);
+    BandwidthFlow flow(bandwidth, transfer.bandwidth.priority, transfer.bandwidth.weight);
+    WorkerPool listers(n);
+    WorkerPool resolvers(std::max<std::size_t>(1, n / 2), n * 2);
+    WorkerPool transfers(n, n * 2);
+
+    ListOptions list;
+    list.fields = journal ? "name,path,type,size,md5" : "name,path,type,size";
+
+    auto enqueueItem = [&](const ResourceEntry& item, const fs::path& local_dir, auto& self) -> void {
+        std::string remote_item_path(item.path);
+        fs::path local_item_path = local_dir / std::string(item.name);
+
+        if (item.type == "dir") {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                ++report.directories_created;
+            }
+            listers.submit([&, remote_item_path, local_item_path] {
+                try {
+                    fs::create_directories(local_item_path);
+                    forEachResourceEntry(remote_item_path, [&](const ResourceEntry& child) {
+                        self(child, local_item_path, self);
+                        return true;
+                    }, list);
+                } catch (const std::exception& ex) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    report.errors.push_back({local_item_path.string(), remote_item_path, ex.what()});
+                }
+            });
+        } else if (item.type == "file") {
+            uint64_t size = item.size;
+            std::string md5(item.md5);
+            std::string key = "download:" + remote_item_path;
+
+            TransferJournal::Entry done;
+            std::error_code ec;
+            bool skip = journal && journal->find(key, done) && done.done &&
+                        done.md5 == md5 && done.size == size &&
+                        fs::file_size(local_item_path, ec) == size && !ec;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                ++progress.files_total;
+                progress.bytes_total += size;
+                if (skip) {
+                    ++report.files_skipped;
+                    ++progress.files_done;
+                    progress.bytes_done += size;
+                }
+            }
+            if (skip) return;
+
+            resolvers.submit([&, remote_item_path, local_item_path, size, md5, key] {
+                std::string href;
+                try {
+                    href = getDownloadUrl(remote_item_path);
+                } catch (const std::exception& ex) {
+                    finishFile(local_item_path, remote_item_path, size, ex.what());
+                    return;
+                }
+                transfers.submit([&, href, remote_item_path, local_item_path, size, md5, key] {
+                    std::string error;
+                    try {
+                        if (journal) {
+                            downloadHrefResumable(href, local_item_path.string(), key, size, md5, *journal, &flow);
+                        } else {
+                            downloadHref(href, local_item_path.string(), &flow);
+                        }
+                    } catch (const std::exception& ex) {
+                        error = ex.what();
+                    }
+                    finishFile(local_item_path, remote_item_path, size, error);
+                });
+            });
+        }
+    };
+
+    // Each pack is one transfer job: its index is fetched first, for the
+    // member totals, then the archive is streamed through the extractor.
+    // Members the archive did not deliver are reported as failed.
+    auto unpackPack = [&](const std::string& packs_path, const std::string& index_path) {
+        PackIndex index;
+        try {
+            std::string text;
+            CallbackTarget collect = collectInto(text);
+            downloadToTarget(getDownloadUrl(index_path), collect, std::string(), &flow);
+            index = PackIndex::parse(text);
+        } catch (const std::exception& ex) {
+            std::lock_guard<std::mutex> lock(mutex);
+            report.errors.push_back({local_fs.string(), index_path, ex.what()});
+            return;
+        }
+
+        const std::string archive = packs_path + "/" + index.archive;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            progress.files_total += index.members.size();
+            for (const PackIndex::Member& member : index.members) progress.bytes_total += member.size;
+        }
+
+        std::size_t extracted = 0;
+        std::string error;
+        try {
+            PackTarget target(local_fs.string(), index.compressed,
+                              [&](const std::string& local_file, uint64_t size) {
+                                  finishFile(local_file, archive, size, std::string());
+                                  {
+                                      std::lock_guard<std::mutex> lock(mutex);
+                                      ++report.files_packed;
+                                  }
+                                  ++extracted;
+                              });
+            downloadToTarget(getDownloadUrl(archive), target, std::string(), &flow);
+        } catch (const std::exception& ex) {
+            error = ex.what();
+        }
+        for (std::size_t i = extracted; i < index.members.size(); ++i) {
+            const PackIndex::Member& member = index.members[i];
+            finishFile(local_fs / fs::path(member.path), archive, member.size,
+                       error.empty() ? "Missing from the pack archive" : error);
+        }
+    };
+
+    auto enqueuePacks = [&](const std::string& packs_path) {
+        listers.submit([&, packs_path] {
+            try {
+                forEachResourceEntry(packs_path, [&](const ResourceEntry& item) {
+                    if (item.type == "file" && endsWith(item.name, PackIndex::kIndexSuffix)) {
+                        transfers.submit([&, packs_path, index_path = std::string(item.path)] {
+                            unpackPack(packs_path, index_path);
+                        });
+                    }
+                    return true;
+                }, list);
+            } catch (const std::exception& ex) {
+                std::lock_guard<std::mutex> lock(mutex);
+                report.errors.push_back({local_fs.string(), packs_path, ex.what()});
+            }
+        });
+    };
+
+    // The root is listed on the calling thread. A failure on its first page
+    // means it is not a directory and nothing has been queued yet, so the
+    // error is rethrown; later failures are recorded like any other.
+    bool root_listed = false;
+    try {
+        forEachResourceEntry(disk_path, [&](const ResourceEntry& item) {
+            if (!root_listed) {
+                fs::create_directories(local_fs);
+                root_listed = true;
+            }
+            if (transfer.unpack && item.type == "dir" && item.name == PackIndex::kDirectory) {
+                enqueuePacks(std::string(item.path));
+            } else {
+                enqueueItem(item, local_fs, enqueueItem);
+            }
+            return true;
+        }, list);
+        fs::create_directories(local_fs);
+    } catch (const std::exception& ex) {
+        if (!root_listed) {
+            throw std::runtime_error("Remote directory does not exist or is not a directory: " +
+            disk_path + " (" + ex.what() + ")");
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        report.errors.push_back({local_fs.string(), disk_path, ex.what()});
+    }
+
+    listers.wait();
+    resolvers.wait();
+    transfers.wait();
+
+    report.elapsed_seconds = secondsSince(start);
+    return report;
+}
+
+uint64_t YandexDiskClient::downloadPackedFile(
+        const std::string& disk_root,
+        const std::string& member,
+        const DownloadSink& sink)
+{
+    if (!sink.target) throw std::runtime_error("Download sink is empty");
+    const std::string packs_disk = (std::filesystem::path(disk_root) / PackIndex::kDirectory).generic_string();
+    std::string wanted = member;
+    while (!wanted.empty() && wanted.front() == '/') wanted.erase(0, 1);
+
+    std::vector<std::string> indexes;
+    forEachResourceEntry(packs_disk, [&](const ResourceEntry& item) {
+        if (item.type == "file" && endsWith(item.name, PackIndex::kIndexSuffix)) indexes.emplace_back(item.path);
+        return true;
+    });
+    // Newest run first: pack names start with the run's start time.
+    std::sort(indexes.rbegin(), indexes.rend());
+
+    for (const std::string& index_path : indexes) {
+        std::string text;
+        CallbackTarget collect = collectInto(text);
+        downloadToTarget(getDownloadUrl(index_path), collect);
+        PackIndex index = PackIndex::parse(text);
+
+        const PackIndex::Member* found = index.find(wanted);
+        if (!found) continue;
+        if (found->size == 0) {
+            sink.target->finish();
+            return 0;
+        }
+
+        std::string url = getDownloadUrl(packs_disk + "/" + index.archive);
+        if (!index.compressed) {
+            return downloadToTarget(url, *sink.target, byteRange(found->offset, found->size));
+        }
+
+        // A compressed member is cut out of the one frame that holds it.
+        const PackIndex::Frame& frame = index.frameOf(*found);
+        std::string compressed;
+        compressed.reserve(frame.size);
+        CallbackTarget collect_frame = collectInto(compressed);
+        downloadToTarget(url, collect_frame, byteRange(frame.offset, frame.size));
+        std::string tar = decompressPackFrame(compressed);
+
+        const uint64_t start = found->offset - frame.tar_offset;
+        if (start + found->size > tar.size()) throw std::runtime_error("Pack frame does not hold " + wanted);
+        if (!sink.target->write(tar.data() + start, found->size)) return found->size;
+        sink.target->finish();
+        return found->size;
+    }
+    throw std::runtime_error("No pack under " + disk_root + " holds " + wanted);
+}
@@ -0,0 +1,116 @@
+#include "YandexDiskClient.h"
+#include "Bandwidth.h"
+#include "CurlPool.h"
+#include "DownloadTarget.h"
+#include "TransformPipeline.h"
+#include <curl/curl.h>
+#include <stdexcept>
+
+namespace {
+    // Pieces handed to the sink; also libcurl's receive buffer.
+    constexpr long kDownloadChunkSize = 512 * 1024;
+
+    struct SinkWriter {
+        DownloadTarget* target;
+        /// Set for Range requests: anything but 206 is refused.
+        CURL* partial_of;
+        uint64_t delivered;
+        bool stopped;
+        /// Set when the sink failed; the transfer is aborted.
+        std::string error;
+    };
+
+    size_t writeToSink(char* data, size_t size, size_t nmemb, void* userp) {
+        auto* writer = static_cast<SinkWriter*>(userp);
+        size_t length = size * nmemb;
+        if (writer->partial_of) {
+            long code = 0;
+            curl_easy_getinfo(writer->partial_of, CURLINFO_RESPONSE_CODE, &code);
+            if (code != 206) {
+                writer->error = "Server ignored the Range request";
+                return 0;
+            }
+            writer->partial_of = nullptr;
+        }
+        try {
+            bool more = writer->target->write(data, length);
+            writer->delivered += length;
+            if (!more) {
+                writer->stopped = true;
+                return 0;
+            }
+        } catch (const std::exception& ex) {
+            writer->error = ex.what();
+            return 0;
+        }
+        return length;
+    }
+}
+
+YandexDiskClient::DownloadSink YandexDiskClient::DownloadSink::callback(Consumer consume) {
+    if (!consume) throw std::runtime_error("Download consumer is empty");
+    DownloadSink sink;
+    sink.target = std::make_shared<CallbackTarget>(std::move(consume));
+    return sink;
+}
+
+YandexDiskClient::DownloadSink YandexDiskClient::DownloadSink::stream(std::ostream& out) {
+    DownloadSink sink;
+    sink.target = std::make_shared<StreamTarget>(out);
+    return sink;
+}
+
+YandexDiskClient::DownloadSink YandexDiskClient::DownloadSink::memory(void* buffer, std::size_t capacity) {
+    DownloadSink sink;
+    sink.target = std::make_shared<MemoryTarget>(buffer, capacity);
+    return sink;
+}
+
+YandexDiskClient::DownloadSink YandexDiskClient::DownloadSink::fileDescriptor(int fd) {
+    DownloadSink sink;
+    sink.target = std::make_shared<DescriptorTarget>(fd);
+    return sink;
+}
+
+uint64_t YandexDiskClient::downloadFile(const std::string& disk_path, const DownloadSink& sink) {
+    if (!sink.target) throw std::runtime_error("Download sink is empty");
+    return downloadToTarget(getDownloadUrl(disk_path), *sink.target);
+}
+
+uint64_t YandexDiskClient::downloadFile(const std::string& disk_path, const DownloadSink& sink,
+                                        const TransformOptions& transform) {
+    if (!sink.target) throw std::runtime_error("Download sink is empty");
+    TransformTarget target(*sink.target, transform);
+    downloadToTarget(getDownloadUrl(disk_path), target);
+    return target.delivered();
+}
+
+uint64_t YandexDiskClient::downloadToTarget(const std::string& url, DownloadTarget& target,
+                                            const std::string& range, BandwidthFlow* flow) {
+    CurlPool::Handle handle = pool->acquire();
+    CURL* curl = handle.get();
+    BandwidthMeter meter(bandwidth, flow);
+    meter.attach(curl);
+
+    SinkWriter writer{&target, range.empty() ? nullptr : curl, 0, false, {}};
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    if (!range.empty()) curl_easy_setopt(curl, CURLOPT_RANGE, range.c_str());
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeToSink);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &writer);
+    curl_easy_setopt(curl, CURLOPT_BUFFERSIZE, kDownloadChunkSize);
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
+
+    CURLcode res = curl_easy_perform(curl);
+    pool->recordTransfer(curl, res);
+
+    if (!writer.error.empty()) throw std::runtime_error("File download error: " + writer.error);
+    if (writer.stopped) return writer.delivered;
+    if (res != CURLE_OK) {
+        throw std::runtime_error("File download error: " +
+                                 std::string(curl_easy_strerror(res)));
+    }
+
+    target.finish();
+    return writer.delivered;
+}
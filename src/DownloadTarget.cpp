@@ -0,0 +1,136 @@
+#include "DownloadTarget.h"
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <cerrno>
+#include <csignal>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if !defined(_WIN32)
+namespace {
+    /**
+     * write() with SIGPIPE blocked for the calling thread. A SIGPIPE the
+     * write raises is taken off the pending set before the mask is restored,
+     * so it is never delivered; one already pending is left alone.
+     */
+    ssize_t writeWithoutSigpipe(int fd, const char* data, std::size_t size) {
+        sigset_t sigpipe;
+        sigemptyset(&sigpipe);
+        sigaddset(&sigpipe, SIGPIPE);
+
+        sigset_t pending;
+        sigemptyset(&pending);
+        sigpending(&pending);
+        bool was_pending = sigismember(&pending, SIGPIPE) == 1;
+
+        sigset_t previous;
+        bool blocked = !was_pending && pthread_sigmask(SIG_BLOCK, &sigpipe, &previous) == 0;
+
+        ssize_t n = ::write(fd, data, size);
+        int saved_errno = errno;
+
+        if (blocked) {
+            if (n < 0 && saved_errno == EPIPE) {
+#if defined(__APPLE__)
+                sigemptyset(&pending);
+                sigpending(&pending);
+                int sig;
+                if (sigismember(&pending, SIGPIPE) == 1) sigwait(&sigpipe, &sig);
+#else
+                const timespec no_wait{0, 0};
+                while (sigtimedwait(&sigpipe, nullptr, &no_wait) < 0 && errno == EINTR) {}
+#endif
+            }
+            pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+        }
+        errno = saved_errno;
+        return n;
+    }
+}
+#endif
+
+DescriptorTarget::DescriptorTarget(int fd) : fd(fd) {
+#if !defined(_WIN32)
+    struct stat st{};
+    is_socket = fstat(fd, &st) == 0 && S_ISSOCK(st.st_mode);
+#if defined(SO_NOSIGPIPE)
+    if (is_socket) {
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+    }
+#endif
+#endif
+}
+
+bool StreamTarget::write(const char* data, std::size_t size) {
+    out.write(data, static_cast<std::streamsize>(size));
+    if (!out) throw std::runtime_error("Failed to write to the output stream");
+    return true;
+}
+
+void StreamTarget::finish() {
+    out.flush();
+    if (!out) throw std::runtime_error("Failed to write to the output stream");
+}
+
+MemoryTarget::MemoryTarget(void* buffer, std::size_t capacity)
+        : buffer(static_cast<char*>(buffer)),
+          capacity(capacity) {}
+
+bool MemoryTarget::write(const char* data, std::size_t size) {
+    if (size > capacity - used) {
+        throw std::runtime_error("Download does not fit in the " + std::to_string(capacity) +
+                                 "-byte buffer");
+    }
+    std::memcpy(buffer + used, data, size);
+    used += size;
+    return true;
+}
+
+bool DescriptorTarget::write(const char* data, std::size_t size) {
+    while (size > 0) {
+#if defined(_WIN32)
+        unsigned chunk = size > 0x40000000u ? 0x40000000u : static_cast<unsigned>(size);
+        int n = _write(fd, data, chunk);
+        if (n <= 0) throw std::runtime_error("Failed to write to file descriptor " + std::to_string(fd));
+#else
+#if defined(MSG_NOSIGNAL)
+        ssize_t n = is_socket ? ::send(fd, data, size, MSG_NOSIGNAL) : writeWithoutSigpipe(fd, data, size);
+#else
+        ssize_t n = is_socket ? ::send(fd, data, size, 0) : writeWithoutSigpipe(fd, data, size);
+#endif
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                pollfd pfd{fd, POLLOUT, 0};
+                if (::poll(&pfd, 1, -1) < 0 && errno != EINTR) {
+                    throw std::runtime_error("Failed to wait for file descriptor " + std::to_string(fd) +
+                                             ": " + std::strerror(errno));
+                }
+                if (pfd.revents & POLLNVAL) {
+                    throw std::runtime_error("File descriptor " + std::to_string(fd) + " is not open");
+                }
+                // The reader is gone: no write can ever complete.
+                if ((pfd.revents & (POLLERR | POLLHUP)) && !(pfd.revents & POLLOUT)) {
+                    throw std::runtime_error("File descriptor " + std::to_string(fd) + " was closed by its reader");
+                }
+                continue;
+            }
+            throw std::runtime_error("Failed to write to file descriptor " + std::to_string(fd) +
+                                     ": " + std::strerror(errno));
+        }
+#endif
+        data += n;
+        size -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
@@ -0,0 +1,89 @@
+#ifndef YANDEX_DISK_CPP_CLIENT_DOWNLOADTARGET_H
+#define YANDEX_DISK_CPP_CLIENT_DOWNLOADTARGET_H
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+
+/**
+ * @brief Receiver of a streamed download, behind YandexDiskClient::DownloadSink.
+ *
+ * write() runs on the transfer thread and may block: libcurl stops reading
+ * from the socket until it returns, which is how a slow consumer pushes
+ * back on the server.
+ */
+class DownloadTarget {
+public:
+    virtual ~DownloadTarget() = default;
+
+    /**
+     * @brief Take the next piece of the body.
+     * @return false to stop the download after this piece (not an error).
+     * @throws std::runtime_error if the bytes cannot be stored.
+     */
+    virtual bool write(const char* data, std::size_t size) = 0;
+
+    /// Called once after the last write of a complete body.
+    virtual void finish() {}
+};
+
+class CallbackTarget : public DownloadTarget {
+public:
+    using Consumer = std::function<bool(const char* data, std::size_t size)>;
+
+    explicit CallbackTarget(Consumer consume) : consume(std::move(consume)) {}
+
+    bool write(const char* data, std::size_t size) override { return consume(data, size); }
+
+private:
+    Consumer consume;
+};
+
+class StreamTarget : public DownloadTarget {
+public:
+    explicit StreamTarget(std::ostream& out) : out(out) {}
+
+    bool write(const char* data, std::size_t size) override;
+    void finish() override;
+
+private:
+    std::ostream& out;
+};
+
+/**
+ * @brief A caller-owned buffer of fixed capacity; a longer body is an error.
+ */
+class MemoryTarget : public DownloadTarget {
+public:
+    MemoryTarget(void* buffer, std::size_t capacity);
+
+    bool write(const char* data, std::size_t size) override;
+
+private:
+    char* buffer;
+    std::size_t capacity;
+    std::size_t used = 0;
+};
+
+/**
+ * @brief A file descriptor (pipe, socket, file); waits while a non-blocking
+ *        descriptor is full. The descriptor is not closed.
+ *
+ * A reader that goes away fails the download with an exception; the
+ * SIGPIPE the write would raise is suppressed, so the process survives.
+ */
+class DescriptorTarget : public DownloadTarget {
+public:
+    explicit DescriptorTarget(int fd);
+
+    bool write(const char* data, std::size_t size) override;
+
+private:
+    int fd;
+    /// Sockets are written with send(), which can suppress SIGPIPE itself.
+    bool is_socket = false;
+};
+
+#endif //YANDEX_DISK_CPP_CLIENT_DOWNLOADTARGET_H
@@ -0,0 +1,81 @@
+#include "HashIndex.h"
+#include <nlohmann/json.hpp>
+#include <fstream>
+#include <stdexcept>
+
+#if !defined(_WIN32)
+#include <sys/stat.h>
+#endif
+
+HashIndex::HashIndex(std::string path) : path(std::move(path)) {
+    std::ifstream in(std::filesystem::path(this->path), std::ios::binary);
+    std::string line;
+    while (std::getline(in, line)) {
+        nlohmann::json j = nlohmann::json::parse(line, nullptr, false);
+        if (j.is_discarded() || !j.is_object() || !j.contains("id")) continue;
+
+        Record record;
+        record.size = j.value("size", uint64_t{0});
+        record.mtime = j.value("mtime", int64_t{0});
+        record.md5 = j.value("md5", "");
+        records[j["id"].get<std::string>()] = record;
+    }
+}
+
+HashIndex::FileKey HashIndex::keyOf(const std::filesystem::path& file) {
+    FileKey key;
+    key.size = std::filesystem::file_size(file);
+    key.mtime = static_cast<int64_t>(std::filesystem::last_write_time(file).time_since_epoch().count());
+#if defined(_WIN32)
+    key.id = file.u8string();
+#else
+    // The inode survives renames and moves inside the tree, so a moved
+    // file keeps its cached checksum.
+    struct stat st {};
+    if (::stat(file.c_str(), &st) == 0) {
+        key.id = std::to_string(st.st_dev) + ":" + std::to_string(st.st_ino);
+    } else {
+        key.id = file.string();
+    }
+#endif
+    return key;
+}
+
+bool HashIndex::lookup(const FileKey& key, std::string& md5) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = records.find(key.id);
+    if (it == records.end() || it->second.size != key.size ||
+        it->second.mtime != key.mtime || it->second.md5.empty()) {
+        return false;
+    }
+    it->second.live = true;
+    md5 = it->second.md5;
+    return true;
+}
+
+void HashIndex::store(const FileKey& key, const std::string& md5) {
+    std::lock_guard<std::mutex> lock(mutex);
+    records[key.id] = Record{key.size, key.mtime, md5, true};
+}
+
+void HashIndex::save() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::filesystem::path target(path);
+    std::filesystem::path tmp(path + ".tmp");
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        for (const auto& [id, record] : records) {
+            if (!record.live) continue;
+            out << nlohmann::json{{"id", id}, {"size", record.size},
+                                  {"mtime", record.mtime}, {"md5", record.md5}}.dump() << "\n";
+        }
+        out.flush();
+        if (!out) throw std::runtime_error("Failed to write hash index: " + tmp.string());
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, target, ec);
+    if (ec) {
+        std::filesystem::remove(tmp, ec);
+        throw std::runtime_error("Failed to write hash index: " + path);
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef YANDEX_DISK_CPP_CLIENT_HASHINDEX_H
+#define YANDEX_DISK_CPP_CLIENT_HASHINDEX_H
+
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+
+/**
+ * @brief Persistent cache of local file checksums.
+ *
+ * Entries are keyed by file identity (device and inode on POSIX, the path
+ * elsewhere) and are only trusted while size and mtime still match, so an
+ * unchanged file is never hashed twice. save() writes only the entries
+ * looked up or stored since load, which drops files that no longer exist.
+ * Safe to use from several threads.
+ */
+class HashIndex {
+public:
+    /**
+     * @brief Identity and change stamp of a local file.
+     */
+    struct FileKey {
+        std::string id;
+        uint64_t size = 0;
+        int64_t mtime = 0;
+    };
+
+    /**
+     * @brief Load the index at path; a missing or unreadable file starts empty.
+     */
+    explicit HashIndex(std::string path);
+
+    /**
+     * @brief Describe a local file for lookups.
+     * @throws std::filesystem::filesystem_error if the file cannot be inspected.
+     */
+    static FileKey keyOf(const std::filesystem::path& file);
+
+    /**
+     * @brief Cached MD5 of the file, if size and mtime are unchanged.
+     * @return true and fills md5 on a hit.
+     */
+    bool lookup(const FileKey& key, std::string& md5);
+
+    void store(const FileKey& key, const std::string& md5);
+
+    /**
+     * @brief Atomically rewrite the index file with the live entries.
+     * @throws std::runtime_error on I/O error.
+     */
+    void save();
+
+private:
+    struct Record {
+        uint64_t size = 0;
+        int64_t mtime = 0;
+        std::string md5;
+        bool live = false;
+    };
+
+    std::string path;
+    std::map<std::string, Record> records;
+    std::mutex mutex;
+};
+
+#endif //YANDEX_DISK_CPP_CLIENT_HASHINDEX_H
@@ -0,0 +1,169 @@
+#include "LocalTreeWalker.h"
+#include <stdexcept>
+
+#if defined(_WIN32)
+#include <chrono>
+#include <filesystem>
+#include <system_error>
+#else
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+
+struct LocalTreeWalker::Level {
+    std::filesystem::directory_iterator it;
+    std::string relative;
+};
+
+LocalTreeWalker::LocalTreeWalker(const std::string& root) : root(root) {
+    std::error_code ec;
+    std::filesystem::directory_iterator it(std::filesystem::path(root), ec);
+    if (ec) throw std::runtime_error("Cannot read local directory: " + root + " (" + ec.message() + ")");
+    stack.push_back({std::move(it), std::string()});
+}
+
+LocalTreeWalker::~LocalTreeWalker() = default;
+
+bool LocalTreeWalker::next(Entry& entry) {
+    namespace fs = std::filesystem;
+    while (!stack.empty()) {
+        Level& level = stack.back();
+        if (level.it == fs::directory_iterator()) {
+            stack.pop_back();
+            continue;
+        }
+
+        const fs::directory_entry& item = *level.it;
+        std::error_code ec;
+        bool link = item.is_symlink(ec);
+        bool directory = item.is_directory(ec);
+        bool file = !directory && item.is_regular_file(ec);
+        uint64_t size = file ? item.file_size(ec) : 0;
+        int64_t mtime = 0;
+        if (file) {
+            // file_clock has no to_sys() before C++20; shift by "now" on both clocks.
+            auto written = item.last_write_time(ec);
+            if (!ec) {
+                auto system = std::chrono::system_clock::now() +
+                              std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                                      written - fs::file_time_type::clock::now());
+                mtime = std::chrono::duration_cast<std::chrono::seconds>(system.time_since_epoch()).count();
+            }
+        }
+        fs::path path = item.path();
+        level.it.increment(ec);
+        if (ec) level.it = fs::directory_iterator();
+        if (!directory && !file) continue;
+
+        entry.relative = level.relative;
+        if (!entry.relative.empty()) entry.relative += '/';
+        entry.relative += path.filename().string();
+        entry.path = path.string();
+        entry.directory = directory;
+        entry.size = size;
+        entry.mtime = mtime;
+        entry.error.clear();
+
+        if (directory && !link) {
+            fs::directory_iterator child(path, ec);
+            if (ec) entry.error = ec.message();
+            else stack.push_back({std::move(child), entry.relative});
+        }
+        return true;
+    }
+    return false;
+}
+
+#else
+
+struct LocalTreeWalker::Level {
+    DIR* dir;
+    std::string relative;
+};
+
+namespace {
+    DIR* openDirectory(int parent, const char* name, int flags) {
+        int fd = parent < 0 ? open(name, flags) : openat(parent, name, flags);
+        if (fd < 0) return nullptr;
+        DIR* dir = fdopendir(fd);
+        if (!dir) close(fd);
+        return dir;
+    }
+}
+
+LocalTreeWalker::LocalTreeWalker(const std::string& root) : root(root) {
+    while (this->root.size() > 1 && this->root.back() == '/') this->root.pop_back();
+    DIR* dir = openDirectory(-1, this->root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (!dir) throw std::runtime_error("Cannot read local directory: " + root + " (" + std::strerror(errno) + ")");
+    stack.push_back({dir, std::string()});
+}
+
+LocalTreeWalker::~LocalTreeWalker() {
+    for (Level& level : stack) closedir(level.dir);
+}
+
+bool LocalTreeWalker::next(Entry& entry) {
+    while (!stack.empty()) {
+        Level& level = stack.back();
+        // readdir() refills its buffer with one getdents call per batch of entries.
+        dirent* item = readdir(level.dir);
+        if (!item) {
+            closedir(level.dir);
+            stack.pop_back();
+            continue;
+        }
+        const char* name = item->d_name;
+        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) continue;
+
+        // d_type saves a stat for directories; files need one for their size
+        // and links for their target's type.
+        const int parent = dirfd(level.dir);
+        bool link = item->d_type == DT_LNK;
+        bool directory = item->d_type == DT_DIR;
+        uint64_t size = 0;
+        int64_t mtime = 0;
+        if (!directory) {
+            struct stat st;
+            if (fstatat(parent, name, &st, 0) != 0) continue;
+            if (S_ISDIR(st.st_mode)) {
+                directory = true;
+                if (item->d_type == DT_UNKNOWN) {
+                    struct stat own;
+                    link = fstatat(parent, name, &own, AT_SYMLINK_NOFOLLOW) == 0 && S_ISLNK(own.st_mode);
+                }
+            } else if (S_ISREG(st.st_mode)) {
+                size = static_cast<uint64_t>(st.st_size);
+                mtime = static_cast<int64_t>(st.st_mtime);
+            } else {
+                continue;
+            }
+        }
+
+        entry.relative = level.relative;
+        if (!entry.relative.empty()) entry.relative += '/';
+        entry.relative += name;
+        entry.path = root;
+        if (entry.path.back() != '/') entry.path += '/';
+        entry.path += entry.relative;
+        entry.directory = directory;
+        entry.size = size;
+        entry.mtime = mtime;
+        entry.error.clear();
+
+        if (directory && !link) {
+            DIR* child = openDirectory(parent, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+            if (child) stack.push_back({child, entry.relative});
+            else entry.error = std::strerror(errno);
+        }
+        return true;
+    }
+    return false;
+}
+
+#endif
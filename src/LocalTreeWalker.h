@@ -0,0 +1,60 @@
+#ifndef YANDEX_DISK_CPP_CLIENT_LOCALTREEWALKER_H
+#define YANDEX_DISK_CPP_CLIENT_LOCALTREEWALKER_H
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Lazy depth-first walk of a local directory tree.
+ *
+ * Only the directories from the root down to the current one are open at
+ * any time (openat + fdopendir on POSIX, where readdir reads entries in
+ * getdents-sized batches; std::filesystem elsewhere), so memory depends on
+ * the depth of the tree, not on its number of entries. A directory is
+ * returned before anything inside it. Symbolic links are followed to get an
+ * entry's type but are never descended into.
+ */
+class LocalTreeWalker {
+public:
+    struct Entry {
+        /// Full local path.
+        std::string path;
+        /// Path below the root, '/'-separated.
+        std::string relative;
+        bool directory = false;
+        /// Files only.
+        uint64_t size = 0;
+        /// Files only: modification time, seconds since the Unix epoch.
+        int64_t mtime = 0;
+        /// Directories only: why its contents could not be read (empty = fine).
+        std::string error;
+    };
+
+    /**
+     * @throws std::runtime_error if the root cannot be opened as a directory.
+     */
+    explicit LocalTreeWalker(const std::string& root);
+    ~LocalTreeWalker();
+
+    LocalTreeWalker(const LocalTreeWalker&) = delete;
+    LocalTreeWalker& operator=(const LocalTreeWalker&) = delete;
+
+    /**
+     * @brief Move to the next file or directory.
+     *
+     * The entry's strings are reassigned rather than reallocated, so a
+     * caller reusing one Entry walks without allocating per entry.
+     * @return false once the whole tree has been visited.
+     */
+    bool next(Entry& entry);
+
+private:
+    struct Level;
+
+    std::string root;
+    std::vector<Level> stack;
+};
+
+#endif //YANDEX_DISK_CPP_CLIENT_LOCALTREEWALKER_H
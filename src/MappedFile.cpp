@@ -0,0 +1,88 @@
+#include "MappedFile.h"
+#include <filesystem>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+#if defined(_WIN32)
+
+bool MappedFile::open(const std::string& path, bool /* sequential */) {
+    close();
+    HANDLE file = CreateFileW(std::filesystem::path(path).wstring().c_str(), GENERIC_READ,
+                              FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || GetFileType(file) != FILE_TYPE_DISK) {
+        CloseHandle(file);
+        return false;
+    }
+    if (size.QuadPart == 0) {
+        CloseHandle(file);
+        is_open = true;
+        return true;
+    }
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping) return false;
+    // The view keeps the mapping alive after its handle is closed.
+    void* mapped = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!mapped) return false;
+    view = static_cast<const char*>(mapped);
+    length = static_cast<std::size_t>(size.QuadPart);
+    is_open = true;
+    return true;
+}
+
+void MappedFile::close() {
+    if (view) UnmapViewOfFile(view);
+    view = nullptr;
+    length = 0;
+    is_open = false;
+}
+
+#else
+
+bool MappedFile::open(const std::string& path, bool sequential) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st {};
+    if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        ::close(fd);
+        return false;
+    }
+    if (st.st_size == 0) {
+        ::close(fd);
+        is_open = true;
+        return true;
+    }
+    void* mapped = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) return false;
+    if (sequential) ::madvise(mapped, static_cast<std::size_t>(st.st_size), MADV_SEQUENTIAL);
+    view = static_cast<const char*>(mapped);
+    length = static_cast<std::size_t>(st.st_size);
+    is_open = true;
+    return true;
+}
+
+void MappedFile::close() {
+    if (view) ::munmap(const_cast<char*>(view), length);
+    view = nullptr;
+    length = 0;
+    is_open = false;
+}
+
+#endif
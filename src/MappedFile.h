@@ -0,0 +1,42 @@
+#ifndef YANDEX_DISK_CPP_CLIENT_MAPPEDFILE_H
+#define YANDEX_DISK_CPP_CLIENT_MAPPEDFILE_H
+
+#pragma once
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief Read-only memory mapping of a whole file (mmap / MapViewOfFile).
+ *
+ * An empty file opens successfully with a null data() and size() 0. The
+ * file must not be truncated while it is mapped: reading past its new end
+ * faults.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @brief Map the file at path, replacing any current mapping.
+     * @param sequential Hint that the mapping will be read front to back once.
+     * @return false if the file cannot be opened or mapped (e.g. a pipe).
+     */
+    bool open(const std::string& path, bool sequential = false);
+
+    void close();
+
+    bool isOpen() const { return is_open; }
+    const char* data() const { return view; }
+    std::size_t size() const { return length; }
+
+private:
+    const char* view = nullptr;
+    std::size_t length = 0;
+    bool is_open = false;
+};
+
+#endif //YANDEX_DISK_CPP_CLIENT_MAPPEDFILE_H
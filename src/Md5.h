@@ -0,0 +1,44 @@
+#ifndef YANDEX_DISK_CPP_CLIENT_MD5_H
+#define YANDEX_DISK_CPP_CLIENT_MD5_H
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Incremental MD5 (RFC 1321), the checksum Yandex.Disk reports as `md5`.
+ */
+class Md5 {
+public:
+    Md5();
+
+    void update(const void* data, std::size_t length);
+
+    /**
+     * @brief Finish the digest and return it as 32 lowercase hex digits.
+     *
+     * The object must not be updated afterwards.
+     */
+    std::string hexDigest();
+
+    /**
+     * @brief Hash a string in one call.
+     */
+    static std::string hex(const std::string& data);
+
+    /**
+     * @brief Hash a whole file.
+     * @throws std::runtime_error if the file cannot be read.
+     */
+    static std::string ofFile(const std::string& path);
+
+private:
+    void transform(const unsigned char block[64]);
+
+    uint32_t state[4];
+    uint64_t length = 0;
+    unsigned char buffer[64];
+};
+
+#endif //YANDEX_DISK_CPP_CLIENT_MD5_H
@@ -0,0 +1,247 @@
+#include "MetadataCache.h"
+#include "QueryString.h"
+#include <nlohmann/json.hpp>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    // Rough per-entry bookkeeping cost (map node, list node, index node).
+    constexpr std::size_t kEntryOverhead = 160;
+
+    int64_t toMillis(MetadataCache::Clock::time_point t) {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(t.time_since_epoch()).count();
+    }
+
+    MetadataCache::Clock::time_point fromMillis(int64_t ms) {
+        return MetadataCache::Clock::time_point(
+                std::chrono::duration_cast<MetadataCache::Clock::duration>(std::chrono::milliseconds(ms)));
+    }
+
+    std::string parentOf(const std::string& path) {
+        std::size_t slash = path.rfind('/');
+        if (slash == std::string::npos || slash == 0) return "/";
+        return path.substr(0, slash);
+    }
+}
+
+MetadataCache::MetadataCache(std::chrono::milliseconds ttl, std::size_t max_bytes, std::string file_path)
+        : time_to_live(ttl),
+          max_bytes(max_bytes),
+          file_path(std::move(file_path)) {
+    if (!this->file_path.empty()) load();
+}
+
+MetadataCache::~MetadataCache() {
+    try {
+        save();
+    } catch (...) {
+    }
+}
+
+std::string MetadataCache::normalize(const std::string& path) {
+    std::string p = path;
+    const std::string scheme = "disk:";
+    if (p.compare(0, scheme.size(), scheme) == 0) p.erase(0, scheme.size());
+    if (p.empty() || p[0] != '/') p.insert(p.begin(), '/');
+    while (p.size() > 1 && p.back() == '/') p.pop_back();
+    return p;
+}
+
+MetadataCache::State MetadataCache::find(const std::string& url, Entry& entry) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(url);
+    if (it == entries.end()) {
+        ++counters.misses;
+        return State::Missing;
+    }
+    lru.splice(lru.begin(), lru, it->second.lru);
+    entry = it->second.entry;
+    if (Clock::now() - entry.stored < time_to_live) {
+        ++counters.hits;
+        return State::Fresh;
+    }
+    return State::Expired;
+}
+
+void MetadataCache::store(const std::string& url, Entry entry) {
+    entry.path = normalize(entry.path);
+    std::size_t size = url.size() + entry.path.size() + entry.body.size() + kEntryOverhead;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto existing = entries.find(url);
+    if (existing != entries.end()) eraseLocked(existing);
+    if (size > max_bytes) return;
+
+    lru.push_front(url);
+    by_path.emplace(entry.path, url);
+    entries[url] = Slot{std::move(entry), lru.begin(), size};
+    bytes += size;
+
+    while (bytes > max_bytes && !lru.empty()) {
+        eraseLocked(entries.find(lru.back()));
+        ++counters.evictions;
+    }
+}
+
+void MetadataCache::revalidated(const std::string& url, Clock::time_point confirmed) {
+    std::lock_guard<std::mutex> lock(mutex);
+    ++counters.revalidations;
+    ++counters.hits;
+    auto it = entries.find(url);
+    if (it != entries.end()) it->second.entry.stored = confirmed;
+}
+
+void MetadataCache::expiredMiss() {
+    std::lock_guard<std::mutex> lock(mutex);
+    ++counters.misses;
+}
+
+void MetadataCache::invalidate(const std::string& path) {
+    std::string p = normalize(path);
+    std::lock_guard<std::mutex> lock(mutex);
+    std::size_t before = entries.size();
+
+    erasePathLocked(parentOf(p));
+    if (p == "/") {
+        entries.clear();
+        lru.clear();
+        by_path.clear();
+        bytes = 0;
+    } else {
+        erasePathLocked(p);
+        // Everything below p: keys in ["p/", "p0"), since '0' follows '/'.
+        auto first = by_path.lower_bound(p + "/");
+        auto last = by_path.lower_bound(p + "0");
+        std::vector<std::string> urls;
+        for (auto it = first; it != last; ++it) urls.push_back(it->second);
+        for (const std::string& url : urls) {
+            auto slot = entries.find(url);
+            if (slot != entries.end()) eraseLocked(slot);
+        }
+    }
+
+    counters.invalidations += before - entries.size();
+}
+
+void MetadataCache::invalidateRequest(const std::string& url) {
+    std::string route = QueryString::route(url);
+    if (route.find("/trash/resources/restore") != std::string::npos) {
+        clear();
+        return;
+    }
+    if (route.find("/trash/") != std::string::npos) return;
+
+    for (const auto& [key, value] : QueryString::parse(url)) {
+        if (key == "path" || key == "from") invalidate(value);
+    }
+}
+
+void MetadataCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    counters.invalidations += entries.size();
+    entries.clear();
+    lru.clear();
+    by_path.clear();
+    bytes = 0;
+}
+
+bool MetadataCache::revision(uint64_t& value, Clock::time_point& checked) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (disk_revision == kNoRevision) return false;
+    value = disk_revision;
+    checked = revision_checked;
+    return true;
+}
+
+void MetadataCache::setRevision(uint64_t value, Clock::time_point checked) {
+    std::lock_guard<std::mutex> lock(mutex);
+    disk_revision = value;
+    revision_checked = checked;
+}
+
+MetadataCache::Stats MetadataCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    Stats s = counters;
+    s.entries = entries.size();
+    s.bytes = bytes;
+    return s;
+}
+
+void MetadataCache::eraseLocked(std::unordered_map<std::string, Slot>::iterator it) {
+    auto range = by_path.equal_range(it->second.entry.path);
+    for (auto p = range.first; p != range.second; ++p) {
+        if (p->second == it->first) {
+            by_path.erase(p);
+            break;
+        }
+    }
+    lru.erase(it->second.lru);
+    bytes -= it->second.bytes;
+    entries.erase(it);
+}
+
+void MetadataCache::erasePathLocked(const std::string& path) {
+    auto range = by_path.equal_range(path);
+    std::vector<std::string> urls;
+    for (auto it = range.first; it != range.second; ++it) urls.push_back(it->second);
+    for (const std::string& url : urls) {
+        auto slot = entries.find(url);
+        if (slot != entries.end()) eraseLocked(slot);
+    }
+}
+
+void MetadataCache::load() {
+    std::ifstream in(std::filesystem::path(file_path), std::ios::binary);
+    std::string line;
+    while (std::getline(in, line)) {
+        nlohmann::json j = nlohmann::json::parse(line, nullptr, false);
+        if (j.is_discarded() || !j.is_object()) continue;
+
+        if (j.contains("disk_revision")) {
+            disk_revision = j.value("disk_revision", kNoRevision);
+            revision_checked = fromMillis(j.value("checked", int64_t{0}));
+            continue;
+        }
+        if (!j.contains("url")) continue;
+
+        Entry entry;
+        entry.http_code = j.value("code", 0L);
+        entry.body = j.value("body", "");
+        entry.path = j.value("path", "");
+        entry.revision = j.value("revision", kNoRevision);
+        entry.stored = fromMillis(j.value("stored", int64_t{0}));
+        store(j["url"].get<std::string>(), std::move(entry));
+    }
+}
+
+void MetadataCache::save() const {
+    if (file_path.empty()) return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::filesystem::path target(file_path);
+    std::filesystem::path tmp(file_path + ".tmp");
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (disk_revision != kNoRevision) {
+            out << nlohmann::json{{"disk_revision", disk_revision},
+                                  {"checked", toMillis(revision_checked)}}.dump() << "\n";
+        }
+        // Oldest first, so reloading restores the LRU order.
+        for (auto it = lru.rbegin(); it != lru.rend(); ++it) {
+            const Entry& entry = entries.at(*it).entry;
+            out << nlohmann::json{{"url", *it}, {"code", entry.http_code}, {"body", entry.body},
+                                  {"path", entry.path}, {"revision", entry.revision},
+                                  {"stored", toMillis(entry.stored)}}.dump() << "\n";
+        }
+        out.flush();
+        if (!out) throw std::runtime_error("Failed to write metadata cache: " + tmp.string());
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, target, ec);
+    if (ec) {
+        std::filesystem::remove(tmp, ec);
+        throw std::runtime_error("Failed to write metadata cache: " + file_path);
+    }
+}
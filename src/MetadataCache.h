@@ -0,0 +1,139 @@
+#ifndef YANDEX_DISK_CPP_CLIENT_METADATACACHE_H
+#define YANDEX_DISK_CPP_CLIENT_METADATACACHE_H
+
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/**
+ * @brief LRU cache of metadata GET responses, keyed by request URL.
+ *
+ * Every entry also records the disk path it describes, so a change to a
+ * path can drop the entries of that path, of everything below it and of
+ * its parent directory (whose listing changed too). Entries remember the
+ * disk revision known before they were fetched; an entry older than the
+ * TTL can be revalidated when the disk revision has not moved since.
+ * With a file path the cache is loaded on construction and saved on
+ * destruction. Safe to use from several threads.
+ */
+class MetadataCache {
+public:
+    using Clock = std::chrono::system_clock;
+
+    /// Revision value meaning "not known".
+    static constexpr uint64_t kNoRevision = UINT64_MAX;
+
+    struct Entry {
+        long http_code = 0;
+        std::string body;
+        std::string path;
+        uint64_t revision = kNoRevision;
+        Clock::time_point stored;
+    };
+
+    enum class State { Missing, Fresh, Expired };
+
+    struct Stats {
+        std::size_t hits = 0;
+        std::size_t misses = 0;
+        /// Expired entries confirmed by an unchanged disk revision.
+        std::size_t revalidations = 0;
+        std::size_t evictions = 0;
+        std::size_t invalidations = 0;
+        std::size_t entries = 0;
+        std::size_t bytes = 0;
+    };
+
+    MetadataCache(std::chrono::milliseconds ttl, std::size_t max_bytes, std::string file_path);
+    ~MetadataCache();
+
+    MetadataCache(const MetadataCache&) = delete;
+    MetadataCache& operator=(const MetadataCache&) = delete;
+
+    /**
+     * @brief Look up a URL; Fresh and Expired entries are copied to entry.
+     *
+     * Counts a hit for Fresh and a miss for Missing; an Expired lookup is
+     * settled by revalidated() or store().
+     */
+    State find(const std::string& url, Entry& entry);
+
+    void store(const std::string& url, Entry entry);
+
+    /**
+     * @brief Mark an expired entry as confirmed at the given time.
+     */
+    void revalidated(const std::string& url, Clock::time_point confirmed);
+
+    /// Count a miss for an Expired lookup that had to be refetched.
+    void expiredMiss();
+
+    /**
+     * @brief Drop the entries of a path, everything below it and its parent.
+     */
+    void invalidate(const std::string& path);
+
+    /**
+     * @brief Invalidate what a mutating API request touches: the paths in
+     *        its `path` and `from` query parameters. A trash restore clears
+     *        everything, since its destination is not part of the URL.
+     */
+    void invalidateRequest(const std::string& url);
+
+    void clear();
+
+    /**
+     * @brief Last disk revision seen and when it was fetched.
+     * @return false if no revision is known.
+     */
+    bool revision(uint64_t& value, Clock::time_point& checked) const;
+
+    void setRevision(uint64_t value, Clock::time_point checked);
+
+    std::chrono::milliseconds ttl() const { return time_to_live; }
+
+    Stats stats() const;
+
+    /**
+     * @brief Write all entries to the cache file (no-op without one).
+     */
+    void save() const;
+
+    /// "disk:/a/b/" -> "/a/b"
+    static std::string normalize(const std::string& path);
+
+private:
+    struct Slot {
+        Entry entry;
+        std::list<std::string>::iterator lru;
+        std::size_t bytes;
+    };
+
+    void load();
+    void eraseLocked(std::unordered_map<std::string, Slot>::iterator it);
+    void erasePathLocked(const std::string& path);
+
+    std::chrono::milliseconds time_to_live;
+    std::size_t max_bytes;
+    std::string file_path;
+
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, Slot> entries;
+    /// Most recently used first.
+    std::list<std::string> lru;
+    /// Normalized path -> URLs of its entries.
+    std::multimap<std::string, std::string> by_path;
+    std::size_t bytes = 0;
+
+    uint64_t disk_revision = kNoRevision;
+    Clock::time_point revision_checked;
+
+    Stats counters;
+};
+
+#endif //YANDEX_DISK_CPP_CLIENT_METADATACACHE_H
@@ -0,0 +1,197 @@
+#include "Metrics.h"
+#include <chrono>
+
+namespace {
+    double secondsOf(curl_off_t micros) {
+        return micros > 0 ? static_cast<double>(micros) / 1e6 : 0.0;
+    }
+
+    curl_off_t timeOf(CURL* curl, CURLINFO info) {
+        curl_off_t value = 0;
+        curl_easy_getinfo(curl, info, &value);
+        return value;
+    }
+
+    std::string escapeLabel(const std::string& value) {
+        std::string escaped;
+        escaped.reserve(value.size());
+        for (char c : value) {
+            if (c == '\\' || c == '"') escaped += '\\';
+            if (c == '\n') {
+                escaped += "\\n";
+                continue;
+            }
+            escaped += c;
+        }
+        return escaped;
+    }
+
+    const char* const kPhaseNames[] = {"dns", "connect", "tls", "ttfb", "total"};
+}
+
+const std::array<double, Metrics::kBuckets> Metrics::kBounds = {
+        0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10};
+
+Metrics::Metrics(std::string api_base_url, bool histograms, Observer observer)
+        : api_base_url(std::move(api_base_url)),
+          histograms(histograms),
+          observer(std::move(observer)) {}
+
+void Metrics::Histogram::observe(double seconds) {
+    std::size_t bucket = 0;
+    while (bucket < kBuckets && seconds > kBounds[bucket]) ++bucket;
+    ++counts[bucket];
+    sum += seconds;
+    ++count;
+}
+
+std::string Metrics::endpointOf(const std::string& url, const std::string& method) const {
+    if (url.compare(0, api_base_url.size(), api_base_url) != 0) {
+        return method == "PUT" ? "upload" : "download";
+    }
+    const std::size_t query = url.find('?', api_base_url.size());
+    std::string path = url.substr(api_base_url.size(),
+                                  query == std::string::npos ? std::string::npos : query - api_base_url.size());
+    if (path.empty()) return "/";
+    // Operation ids are unique per request and would grow a series each.
+    const std::string operations = "/operations/";
+    if (path.compare(0, operations.size(), operations) == 0) return operations + "{id}";
+    return path;
+}
+
+void Metrics::record(CURL* curl, CURLcode result, int attempt) {
+    const auto end = std::chrono::system_clock::now();
+
+    Span span;
+    span.result = result;
+    span.attempt = attempt;
+
+    char* method = nullptr;
+    curl_easy_getinfo(curl, CURLINFO_EFFECTIVE_METHOD, &method);
+    span.method = method ? method : "GET";
+    char* url = nullptr;
+    curl_easy_getinfo(curl, CURLINFO_EFFECTIVE_URL, &url);
+    span.endpoint = endpointOf(url ? url : "", span.method);
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &span.http_code);
+
+    long connects = 0;
+    curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &connects);
+    span.new_connection = connects > 0;
+
+    // libcurl reports every phase as time since the start of the transfer.
+    const curl_off_t dns = timeOf(curl, CURLINFO_NAMELOOKUP_TIME_T);
+    const curl_off_t connect = timeOf(curl, CURLINFO_CONNECT_TIME_T);
+    const curl_off_t tls = timeOf(curl, CURLINFO_APPCONNECT_TIME_T);
+    const curl_off_t total = timeOf(curl, CURLINFO_TOTAL_TIME_T);
+    if (span.new_connection) {
+        span.dns_seconds = secondsOf(dns);
+        span.connect_seconds = secondsOf(connect - dns);
+        span.tls_seconds = tls > 0 ? secondsOf(tls - connect) : 0.0;
+    }
+    span.ttfb_seconds = secondsOf(timeOf(curl, CURLINFO_STARTTRANSFER_TIME_T));
+    span.total_seconds = secondsOf(total);
+
+    curl_off_t sent = 0, received = 0;
+    curl_easy_getinfo(curl, CURLINFO_SIZE_UPLOAD_T, &sent);
+    curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD_T, &received);
+    span.bytes_sent = static_cast<uint64_t>(sent);
+    span.bytes_received = static_cast<uint64_t>(received);
+
+    const auto since_epoch = std::chrono::duration_cast<std::chrono::nanoseconds>(end.time_since_epoch());
+    span.end_unix_nanos = static_cast<uint64_t>(since_epoch.count());
+    span.start_unix_nanos = span.end_unix_nanos - static_cast<uint64_t>(total > 0 ? total : 0) * 1000;
+
+    if (histograms) {
+        std::lock_guard<std::mutex> lock(mutex);
+        accountLocked(span);
+    }
+    if (observer) {
+        // A failing observer must not fail the request it observes.
+        try {
+            observer(span);
+        } catch (...) {
+        }
+    }
+}
+
+void Metrics::accountLocked(const Span& span) {
+    Series& s = series[{span.method, span.endpoint}];
+    if (span.result == CURLE_OK || span.result == CURLE_HTTP_RETURNED_ERROR) {
+        ++s.responses[span.http_code];
+    } else {
+        ++s.errors;
+    }
+    if (span.attempt > 1) ++s.retries;
+    s.bytes_sent += span.bytes_sent;
+    s.bytes_received += span.bytes_received;
+
+    if (span.new_connection) {
+        s.phases[Dns].observe(span.dns_seconds);
+        s.phases[Connect].observe(span.connect_seconds);
+        if (span.tls_seconds > 0) s.phases[Tls].observe(span.tls_seconds);
+    }
+    if (span.http_code > 0) s.phases[Ttfb].observe(span.ttfb_seconds);
+    s.phases[Total].observe(span.total_seconds);
+}
+
+void Metrics::writePrometheus(std::ostream& out) const {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto labels = [](const std::pair<std::string, std::string>& key) {
+        return "method=\"" + escapeLabel(key.first) + "\",endpoint=\"" + escapeLabel(key.second) + "\"";
+    };
+
+    out << "# HELP ydisk_requests_total HTTP responses by status code.\n"
+        << "# TYPE ydisk_requests_total counter\n";
+    for (const auto& [key, s] : series) {
+        for (const auto& [code, count] : s.responses) {
+            out << "ydisk_requests_total{" << labels(key) << ",code=\"" << code << "\"} " << count << '\n';
+        }
+    }
+
+    out << "# HELP ydisk_request_errors_total Transfers that failed without an HTTP response.\n"
+        << "# TYPE ydisk_request_errors_total counter\n";
+    for (const auto& [key, s] : series) {
+        if (s.errors) out << "ydisk_request_errors_total{" << labels(key) << "} " << s.errors << '\n';
+    }
+
+    out << "# HELP ydisk_request_retries_total Transfers that repeated an earlier failed attempt.\n"
+        << "# TYPE ydisk_request_retries_total counter\n";
+    for (const auto& [key, s] : series) {
+        if (s.retries) out << "ydisk_request_retries_total{" << labels(key) << "} " << s.retries << '\n';
+    }
+
+    out << "# HELP ydisk_request_sent_bytes_total Request body bytes sent.\n"
+        << "# TYPE ydisk_request_sent_bytes_total counter\n";
+    for (const auto& [key, s] : series) {
+        out << "ydisk_request_sent_bytes_total{" << labels(key) << "} " << s.bytes_sent << '\n';
+    }
+
+    out << "# HELP ydisk_request_received_bytes_total Response body bytes received.\n"
+        << "# TYPE ydisk_request_received_bytes_total counter\n";
+    for (const auto& [key, s] : series) {
+        out << "ydisk_request_received_bytes_total{" << labels(key) << "} " << s.bytes_received << '\n';
+    }
+
+    out << "# HELP ydisk_request_duration_seconds Request phases: dns, connect and tls for new "
+           "connections, ttfb until the first response byte, total.\n"
+        << "# TYPE ydisk_request_duration_seconds histogram\n";
+    for (const auto& [key, s] : series) {
+        for (int phase = 0; phase < PhaseCount; ++phase) {
+            const Histogram& h = s.phases[phase];
+            if (h.count == 0) continue;
+            const std::string prefix = "ydisk_request_duration_seconds_bucket{" + labels(key) +
+                                       ",phase=\"" + kPhaseNames[phase] + "\",le=\"";
+            uint64_t cumulative = 0;
+            for (std::size_t i = 0; i < kBuckets; ++i) {
+                cumulative += h.counts[i];
+                out << prefix << kBounds[i] << "\"} " << cumulative << '\n';
+            }
+            out << prefix << "+Inf\"} " << h.count << '\n';
+            out << "ydisk_request_duration_seconds_sum{" << labels(key) << ",phase=\"" << kPhaseNames[phase]
+                << "\"} " << h.sum << '\n';
+            out << "ydisk_request_duration_seconds_count{" << labels(key) << ",phase=\"" << kPhaseNames[phase]
+                << "\"} " << h.count << '\n';
+        }
+    }
+}
@@ -0,0 +1,104 @@
+#ifndef YANDEX_DISK_CPP_CLIENT_METRICS_H
+#define YANDEX_DISK_CPP_CLIENT_METRICS_H
+
+#pragma once
+#include <curl/curl.h>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+
+/**
+ * @brief Per-endpoint request metrics and spans, read from libcurl's timing.
+ *
+ * Every finished transfer is turned into a span: the method, the API route
+ * (ids replaced, query dropped), the phase times and the bytes moved. The
+ * span goes to the observer, if any, and with histograms enabled into the
+ * per-(method, endpoint) counters and latency histograms that
+ * writePrometheus() exports. Connection phases (dns, connect, tls) are
+ * only observed for transfers that opened a new connection; on a reused
+ * one they would all be zero. Safe to use from several threads.
+ */
+class Metrics {
+public:
+    struct Span {
+        std::string method;
+        std::string endpoint;
+        long http_code = 0;
+        CURLcode result = CURLE_OK;
+        int attempt = 1;
+        bool new_connection = false;
+        uint64_t start_unix_nanos = 0;
+        uint64_t end_unix_nanos = 0;
+        double dns_seconds = 0;
+        double connect_seconds = 0;
+        double tls_seconds = 0;
+        double ttfb_seconds = 0;
+        double total_seconds = 0;
+        uint64_t bytes_sent = 0;
+        uint64_t bytes_received = 0;
+    };
+
+    using Observer = std::function<void(const Span&)>;
+
+    /**
+     * @param api_base_url Prefix of API URLs; anything else is a file transfer.
+     * @param histograms Keep counters and histograms for writePrometheus().
+     * @param observer Called with every span (may be empty).
+     */
+    Metrics(std::string api_base_url, bool histograms, Observer observer);
+
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+
+    /**
+     * @brief Account a finished transfer.
+     * @param attempt 1 for the first try of a request, higher for retries.
+     */
+    void record(CURL* curl, CURLcode result, int attempt);
+
+    /// Write the counters and histograms in the Prometheus text format.
+    void writePrometheus(std::ostream& out) const;
+
+    /// Route of a request URL, e.g. "/resources" or "/operations/{id}".
+    std::string endpointOf(const std::string& url, const std::string& method) const;
+
+private:
+    enum Phase { Dns, Connect, Tls, Ttfb, Total, PhaseCount };
+
+    static constexpr std::size_t kBuckets = 13;
+    static const std::array<double, kBuckets> kBounds;
+
+    struct Histogram {
+        /// Observations per bucket (not cumulative); the last one is +Inf.
+        std::array<uint64_t, kBuckets + 1> counts{};
+        double sum = 0;
+        uint64_t count = 0;
+
+        void observe(double seconds);
+    };
+
+    struct Series {
+        std::map<long, uint64_t> responses;
+        uint64_t errors = 0;
+        uint64_t retries = 0;
+        uint64_t bytes_sent = 0;
+        uint64_t bytes_received = 0;
+        Histogram phases[PhaseCount];
+    };
+
+    void accountLocked(const Span& span);
+
+    std::string api_base_url;
+    bool histograms;
+    Observer observer;
+
+    mutable std::mutex mutex;
+    std::map<std::pair<std::string, std::string>, Series> series;
+};
+
+#endif //YANDEX_DISK_CPP_CLIENT_METRICS_H
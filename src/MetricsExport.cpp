@@ -0,0 +1,60 @@
+#include "YandexDiskClient.h"
+#include "Metrics.h"
+#include <locale>
+#include <sstream>
+
+namespace {
+    void writeMetric(std::ostream& out, const char* name, const char* type, const char* help, uint64_t value) {
+        out << "# HELP " << name << ' ' << help << '\n'
+            << "# TYPE " << name << ' ' << type << '\n'
+            << name << ' ' << value << '\n';
+    }
+}
+
+std::string YandexDiskClient::metricsText() const {
+    std::ostringstream out;
+    out.imbue(std::locale::classic());
+
+    ConnectionStats connections = connectionStats();
+    writeMetric(out, "ydisk_transfers_total", "counter",
+                "Transfers performed through the connection pool.", connections.requests);
+    writeMetric(out, "ydisk_connections_opened_total", "counter",
+                "New connections (TCP + TLS handshakes).", connections.connections_opened);
+    writeMetric(out, "ydisk_curl_handles", "gauge",
+                "CURL handles created by the pool.", connections.handles_created);
+
+    RetryStats retries = retryStats();
+    writeMetric(out, "ydisk_api_attempts_total", "counter",
+                "API request attempts, retries included.", retries.attempts);
+    writeMetric(out, "ydisk_api_retries_total", "counter",
+                "API requests sent again after a failed attempt.", retries.retries);
+    writeMetric(out, "ydisk_api_throttled_total", "counter",
+                "429 and 503 answers.", retries.throttled);
+    writeMetric(out, "ydisk_api_retry_after_waits_total", "counter",
+                "Retries that waited for the server's Retry-After.", retries.retry_after_waits);
+    writeMetric(out, "ydisk_api_retries_exhausted_total", "counter",
+                "Requests that still failed after their last allowed attempt.", retries.exhausted);
+    writeMetric(out, "ydisk_api_concurrency_decreases_total", "counter",
+                "Times the adaptive concurrency limit was halved.", retries.concurrency_decreases);
+    writeMetric(out, "ydisk_api_concurrency_limit", "gauge",
+                "Current adaptive concurrency limit (0 = none).", retries.concurrency_limit);
+
+    MetadataCacheStats cache = metadataCacheStats();
+    writeMetric(out, "ydisk_metadata_cache_hits_total", "counter",
+                "Metadata requests answered from the cache.", cache.hits);
+    writeMetric(out, "ydisk_metadata_cache_misses_total", "counter",
+                "Metadata requests sent to the API.", cache.misses);
+    writeMetric(out, "ydisk_metadata_cache_revalidations_total", "counter",
+                "Expired entries confirmed by an unchanged disk revision.", cache.revalidations);
+    writeMetric(out, "ydisk_metadata_cache_evictions_total", "counter",
+                "Entries dropped to stay within the memory budget.", cache.evictions);
+    writeMetric(out, "ydisk_metadata_cache_invalidations_total", "counter",
+                "Entries dropped because this client changed their path.", cache.invalidations);
+    writeMetric(out, "ydisk_metadata_cache_entries", "gauge",
+                "Entries in the metadata cache.", cache.entries);
+    writeMetric(out, "ydisk_metadata_cache_bytes", "gauge",
+                "Bytes held by the metadata cache.", cache.bytes);
+
+    if (metrics && options.enable_metrics) metrics->writePrometheus(out);
+    return out.str();
+}
@@ -0,0 +1,40 @@
+#include "OperationStatus.h"
+#include <nlohmann/json.hpp>
+
+OperationStatus OperationStatus::read(long http_code, const std::string& body,
+                                      const std::string& transport_error) {
+    OperationStatus result;
+    if (!transport_error.empty()) {
+        result.error = transport_error;
+        return result;
+    }
+
+    auto json = nlohmann::json::parse(body, nullptr, false);
+    if (http_code >= 400) {
+        result.state = http_code == 429 || http_code >= 500 ? State::CheckFailed : State::Failed;
+        if (http_code == 404) {
+            result.error = "Operation not found";
+        } else if (json.is_object() && json.contains("message") && json["message"].is_string()) {
+            result.error = "Status check failed: " + json["message"].get<std::string>();
+        } else {
+            result.error = "Status check failed with HTTP " + std::to_string(http_code);
+        }
+        return result;
+    }
+
+    auto status = json.is_object() ? json.find("status") : json.end();
+    if (status == json.end() || !status->is_string()) {
+        result.error = "Status check returned no status";
+        return result;
+    }
+    const std::string& text = status->get_ref<const std::string&>();
+    if (text == "success") {
+        result.state = State::Succeeded;
+    } else if (text == "failed") {
+        result.state = State::Failed;
+        result.error = "Operation failed";
+    } else {
+        result.state = State::Running;
+    }
+    return result;
+}
@@ -0,0 +1,37 @@
+#ifndef YANDEX_DISK_CPP_CLIENT_OPERATIONSTATUS_H
+#define YANDEX_DISK_CPP_CLIENT_OPERATIONSTATUS_H
+
+#pragma once
+#include <string>
+
+/**
+ * @brief What one status check of a long-running operation says.
+ *
+ * Operations answered with 202 are polled on their href until the server
+ * reports "success" or "failed". A 4xx reply to the check is final (the
+ * operation is unknown, or the token no longer grants access); a 5xx or
+ * 429 reply, a transport error or a body without a status string is a
+ * failed check that callers repeat a bounded number of times.
+ */
+struct OperationStatus {
+    enum class State {
+        Running,
+        Succeeded,
+        Failed,
+        CheckFailed
+    };
+
+    State state = State::CheckFailed;
+    /// Reason for Failed and CheckFailed.
+    std::string error;
+
+    /**
+     * @param http_code Status of the reply (0 if none arrived).
+     * @param body Body of the reply.
+     * @param transport_error Set if the request itself failed.
+     */
+    static OperationStatus read(long http_code, const std::string& body,
+                                const std::string& transport_error = {});
+};
+
+#endif //YANDEX_DISK_CPP_CLIENT_OPERATIONSTATUS_H
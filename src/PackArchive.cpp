@@ -0,0 +1,591 @@
+#include "PackArchive.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+#if defined(YDISK_WITH_ZSTD)
+#include <zstd.h>
+#endif
+
+namespace {
+    constexpr std::size_t kBlock = 512;
+    // Largest size an 11-digit octal ustar field can hold.
+    constexpr uint64_t kMaxMemberSize = 077777777777ULL;
+
+    uint64_t padded(uint64_t size) {
+        return (size + kBlock - 1) / kBlock * kBlock;
+    }
+
+    FILE* openFile(const std::string& path, const char* mode) {
+#if defined(_WIN32)
+        std::wstring wmode(mode, mode + std::char_traits<char>::length(mode));
+        return _wfopen(std::filesystem::path(path).wstring().c_str(), wmode.c_str());
+#else
+        return fopen(path.c_str(), mode);
+#endif
+    }
+
+    // Writes value as zero-padded octal filling width - 1 digits and a NUL.
+    void octal(char* field, std::size_t width, uint64_t value) {
+        field[width - 1] = '\0';
+        for (std::size_t i = width - 1; i-- > 0;) {
+            field[i] = static_cast<char>('0' + (value & 7));
+            value >>= 3;
+        }
+    }
+
+    uint64_t parseOctal(const char* field, std::size_t width) {
+        uint64_t value = 0;
+        for (std::size_t i = 0; i < width && field[i]; ++i) {
+            if (field[i] == ' ') continue;
+            if (field[i] < '0' || field[i] > '7') throw std::runtime_error("Corrupt pack archive header");
+            value = value * 8 + static_cast<uint64_t>(field[i] - '0');
+        }
+        return value;
+    }
+
+    unsigned headerChecksum(const char* block) {
+        unsigned sum = 0;
+        for (std::size_t i = 0; i < kBlock; ++i) {
+            sum += (i >= 148 && i < 156) ? ' ' : static_cast<unsigned char>(block[i]);
+        }
+        return sum;
+    }
+
+    std::string headerBlock(const std::string& name, const std::string& prefix,
+                            uint64_t size, int64_t mtime, char type) {
+        char block[kBlock] = {};
+        std::memcpy(block, name.data(), std::min<std::size_t>(name.size(), 100));
+        octal(block + 100, 8, 0644);
+        octal(block + 108, 8, 0);
+        octal(block + 116, 8, 0);
+        octal(block + 124, 12, size);
+        octal(block + 136, 12, mtime > 0 ? static_cast<uint64_t>(mtime) : 0);
+        block[156] = type;
+        std::memcpy(block + 257, "ustar", 6);
+        std::memcpy(block + 263, "00", 2);
+        std::memcpy(block + 345, prefix.data(), std::min<std::size_t>(prefix.size(), 155));
+        octal(block + 148, 7, headerChecksum(block));
+        block[155] = ' ';
+        return std::string(block, kBlock);
+    }
+
+    // Splits a path over the ustar prefix and name fields; false if it does not fit.
+    bool splitPath(const std::string& path, std::string& prefix, std::string& name) {
+        if (path.size() <= 100) {
+            prefix.clear();
+            name = path;
+            return true;
+        }
+        std::size_t from = path.size() - 101;
+        std::size_t slash = path.find('/', from);
+        if (slash == std::string::npos || slash == 0 || slash > 155) return false;
+        prefix = path.substr(0, slash);
+        name = path.substr(slash + 1);
+        return true;
+    }
+
+    // A pax "path" record: "<length> path=<value>\n", the length counting itself.
+    std::string paxPathRecord(const std::string& path) {
+        const std::string body = " path=" + path + "\n";
+        std::size_t length = body.size() + 1;
+        while (std::to_string(length).size() + body.size() != length) ++length;
+        return std::to_string(length) + body;
+    }
+
+    // Header blocks of a member: a pax header first when the path needs one.
+    std::string memberHeader(const PackIndex::Member& member) {
+        std::string prefix, name;
+        if (splitPath(member.path, prefix, name)) {
+            return headerBlock(name, prefix, member.size, member.mtime, '0');
+        }
+        std::string record = paxPathRecord(member.path);
+        std::string header = headerBlock("PaxHeaders/" + member.path.substr(member.path.size() - 80),
+                                         "", record.size(), member.mtime, 'x');
+        header += record;
+        header.resize(header.size() + static_cast<std::size_t>(padded(record.size()) - record.size()), '\0');
+        header += headerBlock(member.path.substr(member.path.size() - 100), "", member.size, member.mtime, '0');
+        return header;
+    }
+
+    bool safeRelativePath(const std::string& path) {
+        if (path.empty() || path.front() == '/' || path.front() == '\\') return false;
+        if (path.size() > 1 && path[1] == ':') return false;
+        std::size_t start = 0;
+        while (start <= path.size()) {
+            std::size_t end = path.find_first_of("/\\", start);
+            if (end == std::string::npos) end = path.size();
+            if (path.compare(start, end - start, "..") == 0 && end - start == 2) return false;
+            start = end + 1;
+        }
+        return true;
+    }
+}
+
+// ---- PackIndex ----
+
+std::string PackIndex::dump() const {
+    nlohmann::json frame_list = nlohmann::json::array();
+    for (const Frame& frame : frames) {
+        frame_list.push_back({{"offset", frame.offset}, {"size", frame.size}, {"tar_offset", frame.tar_offset}});
+    }
+    nlohmann::json member_list = nlohmann::json::array();
+    for (const Member& member : members) {
+        member_list.push_back({{"path", member.path}, {"size", member.size},
+                               {"mtime", member.mtime}, {"offset", member.offset}});
+    }
+    return nlohmann::json{
+            {"format", "ydisk-pack"},
+            {"version", 1},
+            {"archive", archive},
+            {"compression", compressed ? "zstd" : "none"},
+            {"frames", frame_list},
+            {"members", member_list},
+    }.dump();
+}
+
+PackIndex PackIndex::parse(const std::string& text) {
+    nlohmann::json json = nlohmann::json::parse(text, nullptr, false);
+    if (!json.is_object() || json.value("format", "") != "ydisk-pack" || json.value("version", 0) != 1) {
+        throw std::runtime_error("Not a pack index");
+    }
+    PackIndex index;
+    index.archive = json.value("archive", "");
+    std::string compression = json.value("compression", "none");
+    if (compression != "none" && compression != "zstd") {
+        throw std::runtime_error("Unknown pack compression: " + compression);
+    }
+    index.compressed = compression == "zstd";
+    for (const auto& frame : json.value("frames", nlohmann::json::array())) {
+        index.frames.push_back({frame.value("offset", uint64_t{0}), frame.value("size", uint64_t{0}),
+                                frame.value("tar_offset", uint64_t{0})});
+    }
+    for (const auto& member : json.value("members", nlohmann::json::array())) {
+        index.members.push_back({member.value("path", ""), member.value("size", uint64_t{0}),
+                                 member.value("mtime", int64_t{0}), member.value("offset", uint64_t{0})});
+    }
+    if (index.archive.empty() || (index.compressed && index.frames.empty() && !index.members.empty())) {
+        throw std::runtime_error("Incomplete pack index");
+    }
+    return index;
+}
+
+const PackIndex::Member* PackIndex::find(const std::string& path) const {
+    for (const Member& member : members) {
+        if (member.path == path) return &member;
+    }
+    return nullptr;
+}
+
+const PackIndex::Frame& PackIndex::frameOf(const Member& member) const {
+    auto next = std::upper_bound(frames.begin(), frames.end(), member.offset,
+                                 [](uint64_t offset, const Frame& frame) { return offset < frame.tar_offset; });
+    if (next == frames.begin()) throw std::runtime_error("Pack index has no frame for " + member.path);
+    return *(next - 1);
+}
+
+uint64_t PackIndex::recordSize(const std::string& path, uint64_t size) {
+    std::string prefix, name;
+    uint64_t header = kBlock;
+    if (!splitPath(path, prefix, name)) header += kBlock + padded(paxPathRecord(path).size());
+    return header + padded(size);
+}
+
+// ---- PackBody ----
+
+#if defined(YDISK_WITH_ZSTD)
+
+class PackBody::Compressor {
+public:
+    Compressor() : context(ZSTD_createCCtx()), staged(128 * 1024) {
+        if (!context) throw std::runtime_error("ZSTD_createCCtx() failed");
+        ZSTD_CCtx_setParameter(context, ZSTD_c_compressionLevel, 3);
+    }
+
+    ~Compressor() { ZSTD_freeCCtx(context); }
+
+    ZSTD_CCtx* context;
+    std::vector<char> staged;
+    std::size_t staged_pos = 0;
+    std::size_t staged_len = 0;
+
+    bool frame_open = false;
+    /// The staged bytes end on a member boundary past kFrameSize.
+    bool end_after_stage = false;
+    bool ending = false;
+    bool tar_done = false;
+    bool finished = false;
+
+    uint64_t written = 0;
+    uint64_t frame_raw = 0;
+    PackIndex::Frame frame;
+};
+
+#else
+
+class PackBody::Compressor {};
+
+#endif
+
+PackBody::PackBody(std::string local_root, PackIndex index, bool compress)
+        : local_root(std::move(local_root)), pack(std::move(index)) {
+    pack.compressed = compress;
+    pack.frames.clear();
+    uint64_t total = 2 * kBlock;
+    for (const PackIndex::Member& member : pack.members) {
+        if (member.size > kMaxMemberSize) throw std::runtime_error("File too large for a pack: " + member.path);
+        total += PackIndex::recordSize(member.path, member.size);
+    }
+    length = total;
+    if (compress) {
+#if defined(YDISK_WITH_ZSTD)
+        compressor = std::make_unique<Compressor>();
+        length = kUnknownSize;
+#else
+        throw std::runtime_error("Pack compression needs a build with YDISK_WITH_ZSTD");
+#endif
+    }
+}
+
+PackBody::~PackBody() {
+    if (file) std::fclose(file);
+}
+
+std::size_t PackBody::produce(char* buffer, std::size_t capacity, bool& member_done) {
+    member_done = false;
+    if (member == pack.members.size()) {
+        std::size_t n = std::min<std::size_t>(capacity, trailer_left);
+        std::memset(buffer, 0, n);
+        trailer_left -= n;
+        tar_written += n;
+        return n;
+    }
+
+    PackIndex::Member& current = pack.members[member];
+    if (!started) {
+        header = memberHeader(current);
+        header_sent = 0;
+        data_sent = 0;
+        padding_left = padded(current.size) - current.size;
+        current.offset = tar_written + header.size();
+        if (current.size > 0) {
+            file = openFile(local_root + "/" + current.path, "rb");
+            if (!file) throw std::runtime_error("Cannot open " + local_root + "/" + current.path);
+        }
+        started = true;
+    }
+
+    std::size_t n;
+    if (header_sent < header.size()) {
+        n = std::min(capacity, header.size() - header_sent);
+        std::memcpy(buffer, header.data() + header_sent, n);
+        header_sent += n;
+    } else if (data_sent < current.size) {
+        std::size_t want = static_cast<std::size_t>(std::min<uint64_t>(capacity, current.size - data_sent));
+        n = std::fread(buffer, 1, want, file);
+        if (n == 0) throw std::runtime_error("File changed while packing: " + local_root + "/" + current.path);
+        data_sent += n;
+    } else {
+        n = static_cast<std::size_t>(std::min<uint64_t>(capacity, padding_left));
+        std::memset(buffer, 0, n);
+        padding_left -= n;
+    }
+    tar_written += n;
+
+    if (header_sent == header.size() && data_sent == current.size && padding_left == 0) {
+        if (file) {
+            std::fclose(file);
+            file = nullptr;
+        }
+        started = false;
+        ++member;
+        member_done = true;
+    }
+    return n;
+}
+
+std::size_t PackBody::read(char* buffer, std::size_t capacity) {
+    if (!compressor) {
+        bool member_done;
+        return produce(buffer, capacity, member_done);
+    }
+
+#if defined(YDISK_WITH_ZSTD)
+    Compressor& c = *compressor;
+    ZSTD_outBuffer out{buffer, capacity, 0};
+    while (out.pos < out.size && !c.finished) {
+        if (c.ending) {
+            ZSTD_inBuffer in{nullptr, 0, 0};
+            std::size_t left = ZSTD_compressStream2(c.context, &out, &in, ZSTD_e_end);
+            if (ZSTD_isError(left)) throw std::runtime_error(std::string("zstd: ") + ZSTD_getErrorName(left));
+            if (left == 0) {
+                c.frame.size = c.written + out.pos - c.frame.offset;
+                pack.frames.push_back(c.frame);
+                c.ending = false;
+                c.frame_open = false;
+                c.finished = c.tar_done;
+            }
+            continue;
+        }
+        if (c.staged_pos < c.staged_len) {
+            ZSTD_inBuffer in{c.staged.data() + c.staged_pos, c.staged_len - c.staged_pos, 0};
+            std::size_t hint = ZSTD_compressStream2(c.context, &out, &in, ZSTD_e_continue);
+            if (ZSTD_isError(hint)) throw std::runtime_error(std::string("zstd: ") + ZSTD_getErrorName(hint));
+            c.staged_pos += in.pos;
+            continue;
+        }
+        if (c.end_after_stage) {
+            c.end_after_stage = false;
+            c.ending = true;
+            continue;
+        }
+
+        bool member_done = false;
+        std::size_t n = produce(c.staged.data(), c.staged.size(), member_done);
+        if (n == 0) {
+            c.tar_done = true;
+            if (c.frame_open) c.ending = true;
+            else c.finished = true;
+            continue;
+        }
+        if (!c.frame_open) {
+            c.frame_open = true;
+            c.frame_raw = 0;
+            c.frame.offset = c.written + out.pos;
+            c.frame.tar_offset = tar_written - n;
+        }
+        c.frame_raw += n;
+        c.staged_pos = 0;
+        c.staged_len = n;
+        if (member_done && c.frame_raw >= kFrameSize) c.end_after_stage = true;
+    }
+    c.written += out.pos;
+    return out.pos;
+#else
+    return 0;
+#endif
+}
+
+// ---- PackTarget ----
+
+#if defined(YDISK_WITH_ZSTD)
+
+class PackTarget::Decompressor {
+public:
+    Decompressor() : context(ZSTD_createDCtx()), buffer(ZSTD_DStreamOutSize()) {
+        if (!context) throw std::runtime_error("ZSTD_createDCtx() failed");
+    }
+
+    ~Decompressor() { ZSTD_freeDCtx(context); }
+
+    // Decompresses input and passes every piece of output on; with no
+    // input, drains what the context still holds.
+    template <typename Sink>
+    void run(const char* data, std::size_t size, Sink&& sink) {
+        ZSTD_inBuffer in{data, size, 0};
+        ZSTD_outBuffer out;
+        do {
+            out = {buffer.data(), buffer.size(), 0};
+            std::size_t consumed = in.pos;
+            std::size_t hint = ZSTD_decompressStream(context, &out, &in);
+            if (ZSTD_isError(hint)) throw std::runtime_error(std::string("zstd: ") + ZSTD_getErrorName(hint));
+            // A call that moved nothing says nothing about the frame.
+            if (in.pos > consumed || out.pos > 0) last = hint;
+            if (out.pos > 0) sink(buffer.data(), out.pos);
+        } while (in.pos < in.size || out.pos == out.size);
+    }
+
+    /// Whether the input ended on a frame boundary.
+    bool complete() const { return last == 0; }
+
+private:
+    ZSTD_DCtx* context;
+    std::vector<char> buffer;
+    std::size_t last = 0;
+};
+
+#else
+
+class PackTarget::Decompressor {};
+
+#endif
+
+PackTarget::PackTarget(std::string local_root, bool compressed, OnMember on_member)
+        : local_root(std::move(local_root)), on_member(std::move(on_member)) {
+    if (compressed) {
+#if defined(YDISK_WITH_ZSTD)
+        decompressor = std::make_unique<Decompressor>();
+#else
+        throw std::runtime_error("Compressed packs need a build with YDISK_WITH_ZSTD");
+#endif
+    }
+}
+
+PackTarget::~PackTarget() {
+    if (out) std::fclose(out);
+}
+
+bool PackTarget::write(const char* data, std::size_t size) {
+#if defined(YDISK_WITH_ZSTD)
+    if (decompressor) {
+        decompressor->run(data, size, [this](const char* bytes, std::size_t n) { consume(bytes, n); });
+        return true;
+    }
+#endif
+    consume(data, size);
+    return true;
+}
+
+void PackTarget::finish() {
+#if defined(YDISK_WITH_ZSTD)
+    if (decompressor) {
+        decompressor->run(nullptr, 0, [this](const char* bytes, std::size_t n) { consume(bytes, n); });
+        if (!decompressor->complete()) throw std::runtime_error("Pack archive is truncated");
+    }
+#endif
+    if (state != State::End) throw std::runtime_error("Pack archive is truncated");
+}
+
+void PackTarget::startMember() {
+    if (!safeRelativePath(name)) throw std::runtime_error("Unsafe path in pack archive: " + name);
+    out_path = local_root + "/" + name;
+    std::filesystem::create_directories(std::filesystem::path(out_path).parent_path());
+    out = openFile(out_path, "wb");
+    if (!out) throw std::runtime_error("Cannot create " + out_path);
+    out_size = remaining;
+}
+
+void PackTarget::finishMember() {
+    int closed = std::fclose(out);
+    out = nullptr;
+    if (closed != 0) throw std::runtime_error("Failed to write " + out_path);
+    if (on_member) on_member(out_path, out_size);
+}
+
+void PackTarget::consume(const char* data, std::size_t size) {
+    // Ends the data of the current entry (possibly empty).
+    auto endOfData = [this] {
+        if (type == 'x') {
+            // Records are "<length> <key>=<value>\n"; only the path is used.
+            std::size_t pos = 0;
+            while (pos < pax_data.size()) {
+                std::size_t space = pax_data.find(' ', pos);
+                std::size_t length = std::strtoull(pax_data.c_str() + pos, nullptr, 10);
+                if (space == std::string::npos || length == 0 || pos + length > pax_data.size()) break;
+                std::string record = pax_data.substr(space + 1, pos + length - space - 2);
+                if (record.compare(0, 5, "path=") == 0) pax_path = record.substr(5);
+                pos += length;
+            }
+        } else if (out) {
+            finishMember();
+        }
+        state = padding > 0 ? State::Padding : State::Header;
+    };
+
+    while (size > 0) {
+        switch (state) {
+            case State::Header: {
+                std::size_t n = std::min(size, kBlock - block_fill);
+                std::memcpy(block + block_fill, data, n);
+                block_fill += n;
+                data += n;
+                size -= n;
+                if (block_fill < kBlock) return;
+                block_fill = 0;
+
+                if (std::all_of(block, block + kBlock, [](char c) { return c == 0; })) {
+                    if (++zero_blocks == 2) state = State::End;
+                    break;
+                }
+                zero_blocks = 0;
+                if (parseOctal(block + 148, 8) != headerChecksum(block)) {
+                    throw std::runtime_error("Corrupt pack archive header");
+                }
+                type = block[156];
+                remaining = parseOctal(block + 124, 12);
+                padding = padded(remaining) - remaining;
+                if (type != 'x') {
+                    if (!pax_path.empty()) {
+                        name = pax_path;
+                        pax_path.clear();
+                    } else {
+                        name.assign(block, strnlen(block, 100));
+                        if (std::memcmp(block + 257, "ustar", 5) == 0 && block[345]) {
+                            name = std::string(block + 345, strnlen(block + 345, 155)) + "/" + name;
+                        }
+                    }
+                }
+
+                if (type == 'x') {
+                    pax_data.clear();
+                    state = State::PaxData;
+                } else if (type == '0' || type == '\0') {
+                    startMember();
+                    state = State::Data;
+                } else {
+                    if (type == '5' && safeRelativePath(name)) {
+                        std::filesystem::create_directories(std::filesystem::path(local_root + "/" + name));
+                    }
+                    state = State::Data;
+                }
+                if (remaining == 0) endOfData();
+                break;
+            }
+            case State::Data:
+            case State::PaxData: {
+                std::size_t n = static_cast<std::size_t>(std::min<uint64_t>(size, remaining));
+                if (state == State::PaxData) {
+                    pax_data.append(data, n);
+                } else if (out && std::fwrite(data, 1, n, out) != n) {
+                    throw std::runtime_error("Failed to write " + out_path);
+                }
+                remaining -= n;
+                data += n;
+                size -= n;
+                if (remaining == 0) endOfData();
+                break;
+            }
+            case State::Padding: {
+                std::size_t n = static_cast<std::size_t>(std::min<uint64_t>(size, padding));
+                padding -= n;
+                data += n;
+                size -= n;
+                if (padding == 0) state = State::Header;
+                break;
+            }
+            case State::End:
+                return;
+        }
+    }
+}
+
+std::string decompressPackFrame(const std::string& frame) {
+#if defined(YDISK_WITH_ZSTD)
+    ZSTD_DCtx* context = ZSTD_createDCtx();
+    if (!context) throw std::runtime_error("ZSTD_createDCtx() failed");
+    std::string result;
+    std::vector<char> buffer(ZSTD_DStreamOutSize());
+    ZSTD_inBuffer in{frame.data(), frame.size(), 0};
+    std::size_t last = 0;
+    ZSTD_outBuffer out;
+    do {
+        out = {buffer.data(), buffer.size(), 0};
+        std::size_t consumed = in.pos;
+        std::size_t hint = ZSTD_decompressStream(context, &out, &in);
+        if (ZSTD_isError(hint)) {
+            ZSTD_freeDCtx(context);
+            throw std::runtime_error(std::string("zstd: ") + ZSTD_getErrorName(hint));
+        }
+        if (in.pos > consumed || out.pos > 0) last = hint;
+        result.append(buffer.data(), out.pos);
+    } while (in.pos < in.size || out.pos == out.size);
+    ZSTD_freeDCtx(context);
+    if (last != 0) throw std::runtime_error("Pack frame is truncated");
+    return result;
+#else
+    (void)frame;
+    throw std::runtime_error("Compressed packs need a build with YDISK_WITH_ZSTD");
+#endif
+}
@@ -0,0 +1,175 @@
+#ifndef YANDEX_DISK_CPP_CLIENT_PACKARCHIVE_H
+#define YANDEX_DISK_CPP_CLIENT_PACKARCHIVE_H
+
+#pragma once
+#include "DownloadTarget.h"
+#include "UploadBody.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Sidecar index of one pack archive.
+ *
+ * A pack is a ustar archive of small files, optionally compressed as a
+ * series of independent zstd frames that each end on a member boundary
+ * (concatenated frames are a valid .zst stream, so `zstd -d | tar x`
+ * still works). The index gives every member's data offset in the tar
+ * stream and, for compressed packs, the frames, which is enough to fetch
+ * one member with a single Range request.
+ */
+struct PackIndex {
+    struct Member {
+        /// Path below the root of the packed upload, '/'-separated.
+        std::string path;
+        uint64_t size = 0;
+        /// Seconds since the Unix epoch.
+        int64_t mtime = 0;
+        /// Offset of the member's data in the uncompressed tar stream.
+        uint64_t offset = 0;
+    };
+
+    struct Frame {
+        /// Position and length of the frame in the compressed archive.
+        uint64_t offset = 0;
+        uint64_t size = 0;
+        /// Where the frame's content starts in the uncompressed tar stream.
+        uint64_t tar_offset = 0;
+    };
+
+    /// File name of the archive, next to the index.
+    std::string archive;
+    bool compressed = false;
+    std::vector<Frame> frames;
+    std::vector<Member> members;
+
+    /// Archive and index files live in this directory under the upload root.
+    static constexpr const char* kDirectory = ".ydisk-packs";
+    static constexpr const char* kIndexSuffix = ".index.json";
+
+    std::string dump() const;
+
+    /// @throws std::runtime_error if the text is not a pack index.
+    static PackIndex parse(const std::string& text);
+
+    /// The member with the given path, or nullptr.
+    const Member* find(const std::string& path) const;
+
+    /// The frame holding a member's data (compressed packs only).
+    const Frame& frameOf(const Member& member) const;
+
+    /// Bytes a member takes in the tar stream: headers, data and padding.
+    static uint64_t recordSize(const std::string& path, uint64_t size);
+};
+
+/**
+ * @brief Upload body that writes a pack archive while it is being sent.
+ *
+ * Member files are opened one at a time as the archive reaches them, so
+ * only one read buffer and, when compressing, one zstd context are held.
+ * The index is complete once the body has been read to the end.
+ */
+class PackBody : public UploadBody {
+public:
+    /**
+     * @param local_root Directory the member paths are relative to.
+     * @param index Archive name and members (path, size, mtime); offsets
+     *        and frames are filled in as the archive is written.
+     * @param compress Compress with zstd.
+     * @throws std::runtime_error if compression was asked for in a build
+     *         without zstd.
+     */
+    PackBody(std::string local_root, PackIndex index, bool compress);
+    ~PackBody() override;
+
+    uint64_t size() const override { return length; }
+    std::size_t read(char* buffer, std::size_t capacity) override;
+
+    const PackIndex& index() const { return pack; }
+
+    /// Frames end at the first member boundary after this much tar data.
+    static constexpr std::size_t kFrameSize = 256 * 1024;
+
+private:
+    class Compressor;
+
+    /// Next bytes of the uncompressed tar stream, never past the end of
+    /// the current member's record. Sets member_done at each record's end.
+    std::size_t produce(char* buffer, std::size_t capacity, bool& member_done);
+
+    std::string local_root;
+    PackIndex pack;
+    uint64_t length;
+
+    std::size_t member = 0;
+    /// Header block(s) of the current member, and how much is sent.
+    std::string header;
+    std::size_t header_sent = 0;
+    uint64_t data_sent = 0;
+    uint64_t padding_left = 0;
+    bool started = false;
+    std::FILE* file = nullptr;
+    uint64_t tar_written = 0;
+    std::size_t trailer_left = 1024;
+
+    std::unique_ptr<Compressor> compressor;
+};
+
+/**
+ * @brief Download target that extracts a pack archive as it arrives.
+ *
+ * Regular file members are written below the local root (parent
+ * directories are created); other entry types are skipped. Paths that are
+ * absolute or climb out of the root are rejected.
+ */
+class PackTarget : public DownloadTarget {
+public:
+    /// Called after each extracted file with its local path and size.
+    using OnMember = std::function<void(const std::string& local_path, uint64_t size)>;
+
+    PackTarget(std::string local_root, bool compressed, OnMember on_member);
+    ~PackTarget() override;
+
+    bool write(const char* data, std::size_t size) override;
+
+    /// @throws std::runtime_error if the archive ended early.
+    void finish() override;
+
+private:
+    class Decompressor;
+
+    void consume(const char* data, std::size_t size);
+    void startMember();
+    void finishMember();
+
+    std::string local_root;
+    OnMember on_member;
+    std::unique_ptr<Decompressor> decompressor;
+
+    enum class State { Header, Data, Padding, PaxData, End };
+    State state = State::Header;
+    char block[512];
+    std::size_t block_fill = 0;
+    uint64_t remaining = 0;
+    uint64_t padding = 0;
+    char type = 0;
+    std::string name;
+    std::string pax_path;
+    std::string pax_data;
+    std::string out_path;
+    uint64_t out_size = 0;
+    std::FILE* out = nullptr;
+    int zero_blocks = 0;
+};
+
+/**
+ * @brief Decompress a complete zstd frame (or several) into memory.
+ * @throws std::runtime_error on corrupt data or in a build without zstd.
+ */
+std::string decompressPackFrame(const std::string& frame);
+
+#endif //YANDEX_DISK_CPP_CLIENT_PACKARCHIVE_H
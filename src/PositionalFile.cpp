@@ -0,0 +1,107 @@
+#include "PositionalFile.h"
+#include <filesystem>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+
+PositionalFile::PositionalFile(const std::string& path) : path(path) {
+    HANDLE h = CreateFileW(std::filesystem::path(path).wstring().c_str(),
+                           GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                           FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Failed to create a file: " + path);
+    }
+    handle = h;
+}
+
+PositionalFile::~PositionalFile() {
+    if (handle) CloseHandle(static_cast<HANDLE>(handle));
+}
+
+void PositionalFile::preallocate(uint64_t size) {
+    LARGE_INTEGER end;
+    end.QuadPart = static_cast<LONGLONG>(size);
+    if (!SetFilePointerEx(static_cast<HANDLE>(handle), end, nullptr, FILE_BEGIN) ||
+        !SetEndOfFile(static_cast<HANDLE>(handle))) {
+        throw std::runtime_error("Failed to preallocate " + std::to_string(size) +
+                                 " bytes for " + path);
+    }
+}
+
+void PositionalFile::writeAt(const char* data, std::size_t length, uint64_t offset) {
+    while (length > 0) {
+        OVERLAPPED ov = {};
+        ov.Offset = static_cast<DWORD>(offset & 0xFFFFFFFFu);
+        ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        DWORD chunk = length > 0x40000000u ? 0x40000000u : static_cast<DWORD>(length);
+        DWORD written = 0;
+        if (!WriteFile(static_cast<HANDLE>(handle), data, chunk, &written, &ov) || written == 0) {
+            throw std::runtime_error("Failed to write to " + path);
+        }
+        data += written;
+        length -= written;
+        offset += written;
+    }
+}
+
+void PositionalFile::close() {
+    if (!handle) return;
+    BOOL ok = CloseHandle(static_cast<HANDLE>(handle));
+    handle = nullptr;
+    if (!ok) throw std::runtime_error("Failed to close " + path);
+}
+
+#else
+
+PositionalFile::PositionalFile(const std::string& path) : path(path) {
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to create a file: " + path);
+    }
+}
+
+PositionalFile::~PositionalFile() {
+    if (fd >= 0) ::close(fd);
+}
+
+void PositionalFile::preallocate(uint64_t size) {
+    if (size == 0) return;
+#if defined(__linux__)
+    if (::posix_fallocate(fd, 0, static_cast<off_t>(size)) == 0) return;
+#endif
+    if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        throw std::runtime_error("Failed to preallocate " + std::to_string(size) +
+                                 " bytes for " + path + ": " + std::strerror(errno));
+    }
+}
+
+void PositionalFile::writeAt(const char* data, std::size_t length, uint64_t offset) {
+    while (length > 0) {
+        ssize_t n = ::pwrite(fd, data, length, static_cast<off_t>(offset));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error("Failed to write to " + path + ": " + std::strerror(errno));
+        }
+        data += n;
+        length -= static_cast<std::size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+}
+
+void PositionalFile::close() {
+    if (fd < 0) return;
+    int rc = ::close(fd);
+    fd = -1;
+    if (rc != 0) throw std::runtime_error("Failed to close " + path + ": " + std::strerror(errno));
+}
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef YANDEX_DISK_CPP_CLIENT_POSITIONALFILE_H
+#define YANDEX_DISK_CPP_CLIENT_POSITIONALFILE_H
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Output file written at explicit offsets (pwrite / overlapped WriteFile).
+ *
+ * Writes at distinct offsets may be issued from several threads at once,
+ * which lets ranged downloads place every chunk directly where it belongs.
+ */
+class PositionalFile {
+public:
+    /**
+     * @brief Create (or truncate) a file for writing.
+     * @throws std::runtime_error if the file cannot be created.
+     */
+    explicit PositionalFile(const std::string& path);
+    ~PositionalFile();
+
+    PositionalFile(const PositionalFile&) = delete;
+    PositionalFile& operator=(const PositionalFile&) = delete;
+
+    /**
+     * @brief Reserve the final size so chunks never extend the file.
+     *
+     * Uses posix_fallocate where available and falls back to setting the
+     * file length.
+     * @throws std::runtime_error if the space cannot be reserved.
+     */
+    void preallocate(uint64_t size);
+
+    /**
+     * @brief Write the whole buffer at the given offset.
+     * @throws std::runtime_error on I/O error.
+     */
+    void writeAt(const char* data, std::size_t length, uint64_t offset);
+
+    /**
+     * @brief Flush and close the file; further writes are invalid.
+     * @throws std::runtime_error if closing fails.
+     */
+    void close();
+
+private:
+    std::string path;
+#if defined(_WIN32)
+    void* handle = nullptr;
+#else
+    int fd = -1;
+#endif
+};
+
+#endif //YANDEX_DISK_CPP_CLIENT_POSITIONALFILE_H
@@ -0,0 +1,142 @@
+#include "QueryString.h"
+#include <array>
+#include <charconv>
+
+namespace {
+    int hexValue(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    // Bytes that go into a query unescaped: ALPHA / DIGIT / "-" / "." / "_" / "~".
+    constexpr std::array<bool, 256> unreservedTable() {
+        std::array<bool, 256> table{};
+        for (int c = '0'; c <= '9'; ++c) table[c] = true;
+        for (int c = 'A'; c <= 'Z'; ++c) table[c] = true;
+        for (int c = 'a'; c <= 'z'; ++c) table[c] = true;
+        table['-'] = table['.'] = table['_'] = table['~'] = true;
+        return table;
+    }
+
+    constexpr std::array<bool, 256> kUnreserved = unreservedTable();
+
+    // The reusable buffer of the calling thread and whether a builder holds it.
+    struct ThreadBuffer {
+        std::string text;
+        bool busy = false;
+    };
+
+    thread_local ThreadBuffer thread_buffer;
+}
+
+std::string QueryString::build(const std::string& endpoint, const std::map<std::string, std::string>& params) {
+    std::size_t length = endpoint.size();
+    for (const auto& [key, value] : params) length += key.size() + value.size() * 3 + 2;
+
+    std::string url;
+    url.reserve(length);
+    url += endpoint;
+    bool first = true;
+    for (const auto& [key, value] : params) {
+        url += (first ? '?' : '&');
+        url += key;
+        url += '=';
+        appendEscaped(url, value);
+        first = false;
+    }
+    return url;
+}
+
+void QueryString::appendEscaped(std::string& out, std::string_view value) {
+    static constexpr char kHex[] = "0123456789ABCDEF";
+
+    // Size for the worst case (every byte escaped), write through a pointer
+    // and trim: no per-byte bounds checks or appends.
+    const std::size_t start = out.size();
+    out.resize(start + value.size() * 3);
+    char* dst = &out[start];
+    for (char c : value) {
+        const auto byte = static_cast<unsigned char>(c);
+        if (kUnreserved[byte]) {
+            *dst++ = c;
+        } else {
+            dst[0] = '%';
+            dst[1] = kHex[byte >> 4];
+            dst[2] = kHex[byte & 0x0F];
+            dst += 3;
+        }
+    }
+    out.resize(static_cast<std::size_t>(dst - out.data()));
+}
+
+std::string QueryString::decode(const std::string& value) {
+    std::string out;
+    out.reserve(value.size());
+    for (std::size_t i = 0; i < value.size(); ++i) {
+        if (value[i] == '%' && i + 2 < value.size() && hexValue(value[i + 1]) >= 0 &&
+            hexValue(value[i + 2]) >= 0) {
+            out.push_back(static_cast<char>(hexValue(value[i + 1]) * 16 + hexValue(value[i + 2])));
+            i += 2;
+        } else {
+            out.push_back(value[i]);
+        }
+    }
+    return out;
+}
+
+std::map<std::string, std::string> QueryString::parse(const std::string& url) {
+    std::map<std::string, std::string> params;
+    std::size_t query = url.find('?');
+    if (query == std::string::npos) return params;
+
+    std::size_t pos = query + 1;
+    while (pos <= url.size()) {
+        std::size_t end = url.find('&', pos);
+        if (end == std::string::npos) end = url.size();
+        std::size_t eq = url.find('=', pos);
+        if (eq != std::string::npos && eq < end) {
+            params[decode(url.substr(pos, eq - pos))] = decode(url.substr(eq + 1, end - eq - 1));
+        }
+        pos = end + 1;
+    }
+    return params;
+}
+
+std::string QueryString::route(const std::string& url) {
+    return url.substr(0, url.find('?'));
+}
+
+UrlBuilder::UrlBuilder(std::string_view base, std::string_view route) {
+    if (!thread_buffer.busy) {
+        thread_buffer.busy = true;
+        leased = true;
+        buffer = &thread_buffer.text;
+        buffer->clear();
+    } else {
+        buffer = &owned;
+    }
+    buffer->append(base);
+    buffer->append(route);
+    has_query = buffer->find('?') != std::string::npos;
+}
+
+UrlBuilder::~UrlBuilder() {
+    if (leased) thread_buffer.busy = false;
+}
+
+UrlBuilder& UrlBuilder::param(std::string_view key, std::string_view value) {
+    buffer->push_back(has_query ? '&' : '?');
+    has_query = true;
+    buffer->append(key);
+    buffer->push_back('=');
+    QueryString::appendEscaped(*buffer, value);
+    return *this;
+}
+
+UrlBuilder& UrlBuilder::param(std::string_view key, uint64_t value) {
+    char digits[20];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    return param(key, std::string_view(digits, static_cast<std::size_t>(result.ptr - digits)));
+}
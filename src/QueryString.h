@@ -0,0 +1,72 @@
+#ifndef YANDEX_DISK_CPP_CLIENT_QUERYSTRING_H
+#define YANDEX_DISK_CPP_CLIENT_QUERYSTRING_H
+
+#pragma once
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Building the query of a request URL and reading it back.
+ */
+class QueryString {
+public:
+    /// Append percent-encoded parameters to an endpoint.
+    static std::string build(const std::string& endpoint, const std::map<std::string, std::string>& params);
+
+    /**
+     * @brief Percent-encode a value onto `out`.
+     *
+     * Everything but the RFC 3986 unreserved characters is escaped, with
+     * upper-case hex digits, exactly as curl_easy_escape() does.
+     */
+    static void appendEscaped(std::string& out, std::string_view value);
+
+    /// Percent-decode a query value ('+' is left as is; buildUrl never emits it).
+    static std::string decode(const std::string& value);
+
+    /**
+     * @brief Decoded parameters of a URL's query (a repeated key keeps its
+     *        last value).
+     */
+    static std::map<std::string, std::string> parse(const std::string& url);
+
+    /// The URL without its query.
+    static std::string route(const std::string& url);
+};
+
+/**
+ * @brief Builds a request URL in a buffer reused by the calling thread.
+ *
+ * Once the buffer has grown to the longest URL the thread has built,
+ * building a URL allocates nothing. The URL stays valid while the builder
+ * lives, so a builder made in a call's argument list lasts for the call:
+ *
+ *     performRequest(UrlBuilder(base, "/resources").param("path", path).url(), "GET");
+ *
+ * A builder made while another one is alive in the same thread (a request
+ * issued from inside a request) gets a buffer of its own.
+ */
+class UrlBuilder {
+public:
+    explicit UrlBuilder(std::string_view base, std::string_view route = {});
+    ~UrlBuilder();
+
+    UrlBuilder(const UrlBuilder&) = delete;
+    UrlBuilder& operator=(const UrlBuilder&) = delete;
+
+    /// Append `key=value`, percent-encoding the value.
+    UrlBuilder& param(std::string_view key, std::string_view value);
+    UrlBuilder& param(std::string_view key, uint64_t value);
+
+    const std::string& url() const { return *buffer; }
+
+private:
+    std::string* buffer;
+    std::string owned;
+    bool leased = false;
+    bool has_query = false;
+};
+
+#endif //YANDEX_DISK_CPP_CLIENT_QUERYSTRING_H
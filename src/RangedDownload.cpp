@@ -0,0 +1,310 @@
+#include "YandexDiskClient.h"
+#include "Bandwidth.h"
+#include "CurlPool.h"
+#include "PositionalFile.h"
+#include "QueryString.h"
+#include <curl/curl.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+    // Chunks are sized to take about this long on one connection, which
+    // keeps per-request overhead small without making the tail too long.
+    constexpr double kTargetChunkSeconds = 1.0;
+    // A stream count is kept only if it beats the previous one by this factor.
+    constexpr double kMinStreamGain = 1.10;
+    constexpr uint64_t kChunkAlignment = 64 * 1024;
+
+    struct ChunkSink {
+        PositionalFile* file;
+        CURL* curl;
+        uint64_t offset;
+        uint64_t remaining;
+        bool checked = false;
+        bool not_partial = false;
+        std::string error;
+    };
+
+    size_t writeChunk(char* data, size_t size, size_t nmemb, void* userp) {
+        auto* sink = static_cast<ChunkSink*>(userp);
+        size_t n = size * nmemb;
+
+        if (!sink->checked) {
+            long code = 0;
+            curl_easy_getinfo(sink->curl, CURLINFO_RESPONSE_CODE, &code);
+            if (code != 206) {
+                sink->not_partial = true;
+                return 0;
+            }
+            sink->checked = true;
+        }
+        if (n > sink->remaining) {
+            sink->error = "Server sent more data than the requested range";
+            return 0;
+        }
+        try {
+            sink->file->writeAt(data, n, sink->offset);
+        } catch (const std::exception& ex) {
+            sink->error = ex.what();
+            return 0;
+        }
+        sink->offset += n;
+        sink->remaining -= n;
+        return n;
+    }
+
+    // Removes the partial file on every path that does not complete it.
+    struct PartialFile {
+        std::string path;
+        bool completed = false;
+
+        ~PartialFile() {
+            if (completed) return;
+            std::error_code ec;
+            std::filesystem::remove(path, ec);
+        }
+    };
+
+    uint64_t clampChunk(double bytes, const YandexDiskClient::RangedDownloadOptions& o) {
+        uint64_t size = bytes > 0 ? static_cast<uint64_t>(bytes) : o.chunk_size;
+        size = std::max(o.min_chunk_size, std::min(o.max_chunk_size, size));
+        if (size > kChunkAlignment) size -= size % kChunkAlignment;
+        return size;
+    }
+}
+
+YandexDiskClient::RangedDownloadReport YandexDiskClient::downloadFileRanged(
+        const std::string& download_disk_path,
+        const std::string& local_dir,
+        const RangedDownloadOptions& ranged)
+{
+    UrlBuilder info_url(options.api_base_url, "/resources");
+    info_url.param("path", makeDiskPath(download_disk_path)).param("fields", "type,size");
+    std::string info_resp = performRequest(info_url.url(), "GET");
+    checkApiError(info_resp);
+    nlohmann::json meta = nlohmann::json::parse(info_resp);
+
+    if (meta.value("type", "") == "dir") {
+        throw std::runtime_error("Cannot download: '" +
+        download_disk_path + "' is a directory, not a file.");
+    }
+
+    const uint64_t total = meta.value("size", uint64_t{0});
+    const std::string local_path = makeLocalDownloadPath(download_disk_path, local_dir);
+    const std::string href = getDownloadUrl(download_disk_path);
+
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = [&] {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    BandwidthFlow flow(bandwidth, ranged.bandwidth.priority, ranged.bandwidth.weight);
+
+    // Chunks land in a ".part" file that replaces local_path only once the
+    // whole body is there, so a failed download never looks complete.
+    PartialFile part{local_path + ".part"};
+    auto complete = [&] {
+        std::filesystem::rename(part.path, local_path);
+        part.completed = true;
+    };
+
+    RangedDownloadReport report;
+    auto singleStream = [&] {
+        downloadHref(href, part.path, &flow);
+        complete();
+        report = RangedDownloadReport{};
+        report.bytes_transferred = total;
+        report.chunks = 1;
+        report.peak_streams = 1;
+        report.final_chunk_size = total;
+        report.elapsed_seconds = elapsed();
+        return report;
+    };
+
+    std::size_t max_streams = std::max<std::size_t>(1, std::min(ranged.max_streams, options.connection_pool_size));
+    uint64_t min_chunk = std::max<uint64_t>(1, ranged.min_chunk_size);
+    if (max_streams < 2 || total < 2 * min_chunk) return singleStream();
+
+    // Never plan more streams than there are minimum-size chunks.
+    max_streams = static_cast<std::size_t>(std::min<uint64_t>(max_streams, total / min_chunk));
+
+    PositionalFile file(part.path);
+    file.preallocate(total);
+
+    std::mutex mutex;
+    std::condition_variable changed;
+
+    std::string source_url = href;
+    uint64_t next_offset = 0;
+    uint64_t bytes_done = 0;
+    uint64_t chunk_size = std::min(clampChunk(static_cast<double>(ranged.chunk_size), ranged),
+                                   std::max(min_chunk, total / (max_streams * 4)));
+    std::size_t allowed = ranged.adaptive
+            ? std::max<std::size_t>(1, std::min(ranged.initial_streams, max_streams))
+            : max_streams;
+    std::size_t running = 0;
+    bool stop = false;
+    bool range_unsupported = false;
+    std::string error;
+
+    // Bandwidth controller state: a smoothed per-connection rate drives the
+    // chunk size; the aggregate rate of each stream count decides whether
+    // doubling the streams paid off.
+    double stream_rate = 0;
+    bool growth_done = !ranged.adaptive;
+    std::size_t previous_allowed = allowed;
+    double previous_level_rate = 0;
+    std::size_t level_chunks = 0;
+    uint64_t level_bytes = 0;
+    double level_start = 0;
+
+    // Chunks larger than this would leave streams idle near the end.
+    const uint64_t tail_limit = std::max(min_chunk, total / (max_streams * 4));
+
+    auto adapt = [&](uint64_t length, double seconds) {
+        if (!ranged.adaptive || seconds <= 0) return;
+
+        double rate = static_cast<double>(length) / seconds;
+        stream_rate = stream_rate > 0 ? 0.7 * stream_rate + 0.3 * rate : rate;
+
+        if (growth_done) {
+            chunk_size = std::min(tail_limit, clampChunk(stream_rate * kTargetChunkSeconds, ranged));
+            return;
+        }
+
+        // While probing stream counts the chunk size stays fixed, so the
+        // levels are measured under the same conditions.
+        ++level_chunks;
+        level_bytes += length;
+        double window = elapsed() - level_start;
+        if (level_chunks < allowed || window <= 0) return;
+
+        double level_rate = static_cast<double>(level_bytes) / window;
+        if (previous_level_rate > 0 && level_rate < previous_level_rate * kMinStreamGain) {
+            // The last doubling did not help; settle on the better level.
+            if (level_rate < previous_level_rate) allowed = previous_allowed;
+            growth_done = true;
+        } else if (allowed >= max_streams) {
+            growth_done = true;
+        } else {
+            previous_allowed = allowed;
+            previous_level_rate = level_rate;
+            allowed = std::min(max_streams, allowed * 2);
+        }
+        level_chunks = 0;
+        level_bytes = 0;
+        level_start = elapsed();
+    };
+
+    auto fetchChunk = [&](const std::string& url, uint64_t offset, uint64_t length,
+                          std::string* effective_url) {
+        CurlPool::Handle handle = pool->acquire();
+        CURL* curl = handle.get();
+        BandwidthMeter meter(bandwidth, &flow);
+        meter.attach(curl);
+
+        ChunkSink sink{&file, curl, offset, length, false, false, {}};
+        std::string range = std::to_string(offset) + "-" + std::to_string(offset + length - 1);
+
+        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(curl, CURLOPT_RANGE, range.c_str());
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeChunk);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &sink);
+        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+        curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
+        curl_easy_setopt(curl, CURLOPT_BUFFERSIZE, 256L * 1024);
+
+        CURLcode res = curl_easy_perform(curl);
+        pool->recordTransfer(curl, res);
+
+        if (sink.not_partial) return false;
+        if (!sink.error.empty()) throw std::runtime_error(sink.error);
+        if (res != CURLE_OK) {
+            throw std::runtime_error("File download error: " +
+                                     std::string(curl_easy_strerror(res)));
+        }
+        if (sink.remaining != 0) {
+            throw std::runtime_error("Incomplete range " + range + " (" +
+                                     std::to_string(sink.remaining) + " bytes missing)");
+        }
+
+        char* effective = nullptr;
+        curl_easy_getinfo(curl, CURLINFO_EFFECTIVE_URL, &effective);
+        if (effective) *effective_url = effective;
+        return true;
+    };
+
+    auto worker = [&](std::size_t index) {
+        for (;;) {
+            uint64_t offset;
+            uint64_t length;
+            std::string url;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&] { return stop || next_offset >= total || index < allowed; });
+                if (stop || next_offset >= total) return;
+                offset = next_offset;
+                length = std::min(chunk_size, total - offset);
+                next_offset += length;
+                url = source_url;
+                ++running;
+                report.peak_streams = std::max(report.peak_streams, running);
+            }
+
+            auto chunk_start = std::chrono::steady_clock::now();
+            std::string effective_url;
+            bool partial = false;
+            std::string chunk_error;
+            try {
+                partial = fetchChunk(url, offset, length, &effective_url);
+            } catch (const std::exception& ex) {
+                chunk_error = ex.what();
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - chunk_start).count();
+
+            std::lock_guard<std::mutex> lock(mutex);
+            --running;
+            if (!chunk_error.empty() || !partial) {
+                if (!chunk_error.empty() && error.empty()) error = chunk_error;
+                if (chunk_error.empty()) range_unsupported = true;
+                stop = true;
+                changed.notify_all();
+                return;
+            }
+
+            // Later chunks skip the redirect to the storage node.
+            if (!effective_url.empty()) source_url = effective_url;
+            bytes_done += length;
+            ++report.chunks;
+            adapt(length, seconds);
+            if (ranged.on_progress) ranged.on_progress(bytes_done, total);
+            changed.notify_all();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(max_streams);
+    for (std::size_t i = 0; i < max_streams; ++i) {
+        threads.emplace_back(worker, i);
+    }
+    for (auto& t : threads) t.join();
+
+    file.close();
+
+    if (range_unsupported && error.empty()) return singleStream();
+    if (!error.empty()) {
+        throw std::runtime_error("Ranged download failed: " + error);
+    }
+
+    complete();
+    report.bytes_transferred = bytes_done;
+    report.final_chunk_size = chunk_size;
+    report.ranged = true;
+    report.elapsed_seconds = elapsed();
+    return report;
+}
@@ -0,0 +1,414 @@
+#include "RemoteIndex.h"
+#include "QueryString.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+    constexpr char kMagic[8] = {'Y', 'D', 'R', 'I', 'D', 'X', '0', '1'};
+
+    // File layout: Header, Record[count] sorted by path, uint32_t[count]
+    // record numbers sorted by (name, path), then the string pool. Native
+    // byte order: the file is a local cache, not an exchange format.
+    struct Header {
+        char magic[8];
+        uint64_t count;
+        uint64_t records_offset;
+        uint64_t names_offset;
+        uint64_t strings_offset;
+        uint64_t strings_size;
+    };
+
+    std::string parentOf(const std::string& path) {
+        std::size_t slash = path.rfind('/');
+        if (slash == std::string::npos || slash == 0) return "/";
+        return path.substr(0, slash);
+    }
+
+    std::string_view nameOf(std::string_view path) {
+        std::size_t slash = path.rfind('/');
+        return slash == std::string_view::npos ? path : path.substr(slash + 1);
+    }
+
+    // path is dir itself or inside it.
+    bool isUnder(std::string_view path, const std::string& dir) {
+        if (dir == "/") return true;
+        return path.size() >= dir.size() && path.compare(0, dir.size(), dir) == 0 &&
+               (path.size() == dir.size() || path[dir.size()] == '/');
+    }
+
+    RemoteIndex::Entry directory(const std::string& path) {
+        RemoteIndex::Entry entry;
+        entry.path = path;
+        entry.dir = true;
+        return entry;
+    }
+}
+
+struct RemoteIndex::Record {
+    uint64_t path_offset;
+    uint32_t path_length;
+    uint32_t dir;
+    uint64_t size;
+    uint64_t modified_offset;
+    uint32_t modified_length;
+    uint32_t md5_length;
+    char md5[32];
+};
+
+RemoteIndex::RemoteIndex(std::string file_path) : file_path(std::move(file_path)) {
+    mapFile();
+}
+
+RemoteIndex::~RemoteIndex() {
+    try {
+        save();
+    } catch (...) {
+    }
+    unmapFile();
+}
+
+std::string RemoteIndex::normalize(const std::string& path) {
+    std::string p = path;
+    const std::string scheme = "disk:";
+    if (p.compare(0, scheme.size(), scheme) == 0) p.erase(0, scheme.size());
+    if (p.empty() || p[0] != '/') p.insert(p.begin(), '/');
+    while (p.size() > 1 && p.back() == '/') p.pop_back();
+    return p;
+}
+
+bool RemoteIndex::loaded() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return is_loaded;
+}
+
+void RemoteIndex::mapFile() {
+    if (!mapping.open(file_path) || mapping.size() < sizeof(Header)) {
+        mapping.close();
+        return;
+    }
+    data = mapping.data();
+    data_size = mapping.size();
+
+    // Only the header is checked; the file is written atomically by save().
+    const auto* header = reinterpret_cast<const Header*>(data);
+    bool valid = std::memcmp(header->magic, kMagic, sizeof(kMagic)) == 0 &&
+                 header->records_offset + header->count * sizeof(Record) <= data_size &&
+                 header->names_offset + header->count * sizeof(uint32_t) <= data_size &&
+                 header->strings_offset + header->strings_size <= data_size;
+    if (!valid) {
+        unmapFile();
+        return;
+    }
+    is_loaded = true;
+}
+
+void RemoteIndex::unmapFile() {
+    mapping.close();
+    data = nullptr;
+    data_size = 0;
+}
+
+std::size_t RemoteIndex::baseCount() const {
+    return data ? static_cast<std::size_t>(reinterpret_cast<const Header*>(data)->count) : 0;
+}
+
+const RemoteIndex::Record* RemoteIndex::baseRecord(std::size_t index) const {
+    const auto* header = reinterpret_cast<const Header*>(data);
+    return reinterpret_cast<const Record*>(data + header->records_offset) + index;
+}
+
+std::string_view RemoteIndex::basePath(std::size_t index) const {
+    const auto* header = reinterpret_cast<const Header*>(data);
+    const Record* record = baseRecord(index);
+    if (record->path_offset + record->path_length > header->strings_size) return {};
+    return {data + header->strings_offset + record->path_offset, record->path_length};
+}
+
+std::string_view RemoteIndex::baseName(std::size_t index) const {
+    return nameOf(basePath(index));
+}
+
+RemoteIndex::Entry RemoteIndex::baseEntry(std::size_t index) const {
+    const auto* header = reinterpret_cast<const Header*>(data);
+    const Record* record = baseRecord(index);
+    Entry entry;
+    entry.path = std::string(basePath(index));
+    entry.dir = record->dir != 0;
+    entry.size = record->size;
+    entry.md5.assign(record->md5, std::min<std::size_t>(record->md5_length, sizeof(record->md5)));
+    if (record->modified_offset + record->modified_length <= header->strings_size) {
+        entry.modified.assign(data + header->strings_offset + record->modified_offset, record->modified_length);
+    }
+    return entry;
+}
+
+std::size_t RemoteIndex::baseLowerBound(const std::string& path) const {
+    std::size_t first = 0, count = baseCount();
+    while (count > 0) {
+        std::size_t step = count / 2;
+        if (basePath(first + step) < path) {
+            first += step + 1;
+            count -= step + 1;
+        } else {
+            count = step;
+        }
+    }
+    return first;
+}
+
+bool RemoteIndex::lookup(const std::string& path, Entry& entry) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return is_loaded && lookupLocked(normalize(path), entry);
+}
+
+bool RemoteIndex::lookupLocked(const std::string& path, Entry& entry) const {
+    auto change = overlay.find(path);
+    if (change != overlay.end()) {
+        if (change->second.removed) return false;
+        entry = change->second.entry;
+        return true;
+    }
+    std::size_t index = baseLowerBound(path);
+    if (index == baseCount() || basePath(index) != path) return false;
+    entry = baseEntry(index);
+    return true;
+}
+
+std::vector<RemoteIndex::Entry> RemoteIndex::subtreeLocked(const std::string& path) const {
+    std::map<std::string, Entry> merged;
+    // Children sort between "p/" and "p0" ('0' follows '/'), but so do
+    // siblings such as "p-1"; isUnder() filters those out.
+    std::size_t first = path == "/" ? 0 : baseLowerBound(path);
+    std::size_t last = path == "/" ? baseCount() : baseLowerBound(path + "0");
+    for (std::size_t i = first; i < last; ++i) {
+        if (isUnder(basePath(i), path)) merged.emplace(std::string(basePath(i)), baseEntry(i));
+    }
+
+    auto it = path == "/" ? overlay.begin() : overlay.lower_bound(path);
+    auto end = path == "/" ? overlay.end() : overlay.lower_bound(path + "0");
+    for (; it != end; ++it) {
+        if (!isUnder(it->first, path)) continue;
+        if (it->second.removed) {
+            merged.erase(it->first);
+        } else {
+            merged[it->first] = it->second.entry;
+        }
+    }
+
+    std::vector<Entry> entries;
+    entries.reserve(merged.size());
+    for (auto& [p, entry] : merged) entries.push_back(std::move(entry));
+    return entries;
+}
+
+std::vector<std::string> RemoteIndex::findByName(const std::string& name, const std::string& under) const {
+    const std::string dir = normalize(under);
+    std::vector<std::string> paths;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!is_loaded) return paths;
+
+    if (data) {
+        const auto* header = reinterpret_cast<const Header*>(data);
+        const auto* names = reinterpret_cast<const uint32_t*>(data + header->names_offset);
+        const uint32_t* end = names + header->count;
+        const uint32_t* first = std::lower_bound(names, end, name, [&](uint32_t index, const std::string& value) {
+            return baseName(index) < value;
+        });
+        for (const uint32_t* it = first; it != end && baseName(*it) == name; ++it) {
+            std::string_view path = basePath(*it);
+            if (!isUnder(path, dir) || path.size() == dir.size()) continue;
+            std::string key(path);
+            if (!overlay.count(key)) paths.push_back(std::move(key));
+        }
+    }
+    for (const auto& [path, change] : overlay) {
+        if (!change.removed && nameOf(path) == name && isUnder(path, dir) && path != dir) paths.push_back(path);
+    }
+
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
+bool RemoteIndex::upsert(Entry entry) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return is_loaded && upsertLocked(std::move(entry));
+}
+
+bool RemoteIndex::upsertLocked(Entry entry) {
+    entry.path = normalize(entry.path);
+    if (entry.path == "/") return false;
+
+    Entry known;
+    for (std::string dir = parentOf(entry.path); dir != "/"; dir = parentOf(dir)) {
+        if (lookupLocked(dir, known) && known.dir) break;
+        overlay[dir] = Change{false, directory(dir)};
+    }
+
+    if (lookupLocked(entry.path, known)) {
+        // Our own uploads do not know the server's timestamp; an empty one
+        // matches any.
+        bool same = known.dir == entry.dir && known.size == entry.size && known.md5 == entry.md5 &&
+                    (known.modified.empty() || entry.modified.empty() || known.modified == entry.modified);
+        if (same) {
+            if (known.modified.empty() && !entry.modified.empty()) overlay[entry.path] = Change{false, entry};
+            return false;
+        }
+    }
+    std::string path = entry.path;
+    overlay[path] = Change{false, std::move(entry)};
+    return true;
+}
+
+void RemoteIndex::remove(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (is_loaded) removeLocked(normalize(path));
+}
+
+void RemoteIndex::removeLocked(const std::string& path) {
+    if (path == "/") return;
+    for (const Entry& entry : subtreeLocked(path)) overlay[entry.path] = Change{true, {}};
+}
+
+void RemoteIndex::relocate(const std::string& from, const std::string& to, bool copy) {
+    const std::string source = normalize(from);
+    const std::string target = normalize(to);
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!is_loaded || source == "/" || target == "/" || source == target) return;
+
+    std::vector<Entry> moved = subtreeLocked(source);
+    removeLocked(target);
+    if (!copy) removeLocked(source);
+    for (Entry& entry : moved) {
+        entry.path = target + entry.path.substr(source.size());
+        upsertLocked(std::move(entry));
+    }
+}
+
+void RemoteIndex::applyRequest(const std::string& url, const std::string& method) {
+    const std::string route = QueryString::route(url);
+    if (route.find("/trash/") != std::string::npos) return;
+
+    auto endsWith = [&](const std::string& suffix) {
+        return route.size() >= suffix.size() &&
+               route.compare(route.size() - suffix.size(), suffix.size(), suffix) == 0;
+    };
+    auto params = QueryString::parse(url);
+    const std::string& path = params["path"];
+    if (path.empty()) return;
+
+    if (method == "POST" && (endsWith("/resources/move") || endsWith("/resources/copy"))) {
+        if (!params["from"].empty()) relocate(params["from"], path, endsWith("/resources/copy"));
+    } else if (endsWith("/resources") && method == "DELETE") {
+        remove(path);
+    } else if (endsWith("/resources") && method == "PUT") {
+        upsert(directory(path));
+    }
+}
+
+std::size_t RemoteIndex::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::size_t count = baseCount();
+    for (const auto& [path, change] : overlay) {
+        std::size_t index = baseLowerBound(path);
+        bool in_base = index < baseCount() && basePath(index) == path;
+        if (change.removed && in_base) --count;
+        if (!change.removed && !in_base) ++count;
+    }
+    return count;
+}
+
+void RemoteIndex::rebuild(std::vector<Entry> files) {
+    std::map<std::string, Entry> tree;
+    tree.emplace("/", directory("/"));
+    for (Entry& file : files) {
+        file.path = normalize(file.path);
+        for (std::string dir = parentOf(file.path); dir != "/"; dir = parentOf(dir)) {
+            if (!tree.emplace(dir, directory(dir)).second) break;
+        }
+        std::string path = file.path;
+        tree[path] = std::move(file);
+    }
+
+    std::vector<Entry> entries;
+    entries.reserve(tree.size());
+    for (auto& [path, entry] : tree) entries.push_back(std::move(entry));
+
+    std::lock_guard<std::mutex> lock(mutex);
+    writeFile(entries);
+    overlay.clear();
+}
+
+void RemoteIndex::save() {
+    std::lock_guard<std::mutex> lock(mutex);
+    // Changes on top of an index that was never built would read as the
+    // whole disk later.
+    if (!is_loaded) {
+        overlay.clear();
+        return;
+    }
+    if (overlay.empty()) return;
+    writeFile(subtreeLocked("/"));
+    overlay.clear();
+}
+
+void RemoteIndex::writeFile(const std::vector<Entry>& entries) {
+    Header header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.count = entries.size();
+    header.records_offset = sizeof(Header);
+    header.names_offset = header.records_offset + entries.size() * sizeof(Record);
+    header.strings_offset = header.names_offset + entries.size() * sizeof(uint32_t);
+
+    std::vector<Record> records(entries.size());
+    std::string strings;
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        const Entry& entry = entries[i];
+        Record& record = records[i];
+        std::memset(&record, 0, sizeof(Record));
+        record.path_offset = strings.size();
+        record.path_length = static_cast<uint32_t>(entry.path.size());
+        strings += entry.path;
+        record.modified_offset = strings.size();
+        record.modified_length = static_cast<uint32_t>(entry.modified.size());
+        strings += entry.modified;
+        record.dir = entry.dir ? 1 : 0;
+        record.size = entry.size;
+        record.md5_length = static_cast<uint32_t>(std::min(entry.md5.size(), sizeof(record.md5)));
+        std::memcpy(record.md5, entry.md5.data(), record.md5_length);
+    }
+    header.strings_size = strings.size();
+
+    std::vector<uint32_t> names(entries.size());
+    for (std::size_t i = 0; i < names.size(); ++i) names[i] = static_cast<uint32_t>(i);
+    // Entries are sorted by path, so a stable sort keeps equal names in path order.
+    std::stable_sort(names.begin(), names.end(), [&](uint32_t a, uint32_t b) {
+        return nameOf(entries[a].path) < nameOf(entries[b].path);
+    });
+
+    std::filesystem::path target(file_path);
+    std::filesystem::path tmp(file_path + ".tmp");
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(records.data()),
+                  static_cast<std::streamsize>(records.size() * sizeof(Record)));
+        out.write(reinterpret_cast<const char*>(names.data()),
+                  static_cast<std::streamsize>(names.size() * sizeof(uint32_t)));
+        out.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+        out.flush();
+        if (!out) throw std::runtime_error("Failed to write remote index: " + tmp.string());
+    }
+
+    // Windows cannot replace a mapped file.
+    unmapFile();
+    is_loaded = false;
+    std::error_code ec;
+    std::filesystem::rename(tmp, target, ec);
+    if (ec) std::filesystem::remove(tmp);
+    mapFile();
+    if (ec || !is_loaded) throw std::runtime_error("Failed to write remote index: " + file_path);
+}
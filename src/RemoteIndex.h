@@ -0,0 +1,134 @@
+#ifndef YANDEX_DISK_CPP_CLIENT_REMOTEINDEX_H
+#define YANDEX_DISK_CPP_CLIENT_REMOTEINDEX_H
+
+#pragma once
+#include "MappedFile.h"
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Memory-mapped index of the remote tree: path -> type, size, md5, modified.
+ *
+ * The index file holds records sorted by path plus a second array sorted by
+ * name, so both lookups are binary searches over the mapping and nothing is
+ * parsed on open. Changes since the last save() live in a small in-memory
+ * overlay that shadows the mapped records; save() merges the two into a new
+ * file and maps it. Directories are known from the paths of their files and
+ * from this client's own changes. Paths are stored without the "disk:"
+ * scheme. Safe to use from several threads.
+ */
+class RemoteIndex {
+public:
+    struct Entry {
+        std::string path;
+        bool dir = false;
+        uint64_t size = 0;
+        std::string md5;
+        std::string modified;
+    };
+
+    /**
+     * @brief Map the index file at path; a missing or invalid file leaves
+     *        the index unloaded until rebuild().
+     */
+    explicit RemoteIndex(std::string file_path);
+
+    /**
+     * @brief Saves pending changes.
+     */
+    ~RemoteIndex();
+
+    RemoteIndex(const RemoteIndex&) = delete;
+    RemoteIndex& operator=(const RemoteIndex&) = delete;
+
+    bool loaded() const;
+
+    /**
+     * @brief Replace the index with a full file listing and save it.
+     *
+     * Parent directories of every file are added.
+     * @throws std::runtime_error if the file cannot be written.
+     */
+    void rebuild(std::vector<Entry> files);
+
+    bool lookup(const std::string& path, Entry& entry) const;
+
+    /**
+     * @brief Paths of every entry with the given name below a directory, sorted.
+     */
+    std::vector<std::string> findByName(const std::string& name, const std::string& under) const;
+
+    /**
+     * @brief Add or update an entry and its parent directories.
+     * @return true if the entry was new or differed from the indexed one.
+     */
+    bool upsert(Entry entry);
+
+    /// Drop a path and everything below it.
+    void remove(const std::string& path);
+
+    /**
+     * @brief Re-key a path and everything below it (copy keeps the source).
+     */
+    void relocate(const std::string& from, const std::string& to, bool copy);
+
+    /**
+     * @brief Apply a successful mutating API request made by the client:
+     *        create, delete, move or copy of the paths in its query.
+     */
+    void applyRequest(const std::string& url, const std::string& method);
+
+    std::size_t size() const;
+
+    /**
+     * @brief Merge pending changes into a new index file and map it.
+     * @throws std::runtime_error if the file cannot be written.
+     */
+    void save();
+
+    /// "disk:/a/b/" -> "/a/b"
+    static std::string normalize(const std::string& path);
+
+private:
+    struct Record;
+
+    void mapFile();
+    void unmapFile();
+    std::size_t baseCount() const;
+    const Record* baseRecord(std::size_t index) const;
+    std::string_view basePath(std::size_t index) const;
+    std::string_view baseName(std::size_t index) const;
+    Entry baseEntry(std::size_t index) const;
+    /// Index of the first mapped record whose path is not less than path.
+    std::size_t baseLowerBound(const std::string& path) const;
+
+    bool lookupLocked(const std::string& path, Entry& entry) const;
+    /// Every entry at or below path, overlay applied, sorted by path.
+    std::vector<Entry> subtreeLocked(const std::string& path) const;
+    bool upsertLocked(Entry entry);
+    void removeLocked(const std::string& path);
+    void writeFile(const std::vector<Entry>& entries);
+
+    std::string file_path;
+    mutable std::mutex mutex;
+
+    MappedFile mapping;
+    /// mapping.data() once the header has been checked.
+    const char* data = nullptr;
+    std::size_t data_size = 0;
+    bool is_loaded = false;
+
+    struct Change {
+        bool removed = false;
+        Entry entry;
+    };
+
+    /// Changes since the mapped file was written, by path.
+    std::map<std::string, Change> overlay;
+};
+
+#endif //YANDEX_DISK_CPP_CLIENT_REMOTEINDEX_H
@@ -0,0 +1,100 @@
+#include "YandexDiskClient.h"
+#include "QueryString.h"
+#include "RemoteIndex.h"
+#include "ResourceListing.h"
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    constexpr std::size_t kFilesPageSize = 1000;
+    // Past this window the feed is not worth reading; rebuild instead.
+    constexpr std::size_t kMaxFeedLimit = 10000;
+    const char* const kIndexFields = "items.path,items.type,items.size,items.md5,items.modified";
+
+    RemoteIndex::Entry entryOf(const ResourceListing::Item& item) {
+        RemoteIndex::Entry entry;
+        entry.path = item.path;
+        entry.dir = item.type == "dir";
+        entry.size = item.size;
+        entry.md5 = item.md5;
+        entry.modified = item.modified;
+        return entry;
+    }
+}
+
+RemoteIndex& YandexDiskClient::requireRemoteIndex() {
+    if (!remote_index) throw std::runtime_error("Remote index path is not set in the client options");
+    return *remote_index;
+}
+
+std::size_t YandexDiskClient::rebuildRemoteIndex() {
+    RemoteIndex& index = requireRemoteIndex();
+    std::vector<RemoteIndex::Entry> files;
+    ResourceListing page;
+
+    for (std::size_t offset = 0;; offset += kFilesPageSize) {
+        UrlBuilder url(options.api_base_url, "/resources/files");
+        url.param("limit", kFilesPageSize).param("offset", offset).param("fields", kIndexFields);
+        std::string resp = performRequest(url.url(), "GET");
+        checkApiError(resp);
+        page.parse(resp);
+
+        for (const auto& item : page.items()) files.push_back(entryOf(item));
+        if (page.items().size() < kFilesPageSize) break;
+    }
+
+    index.rebuild(std::move(files));
+    return index.size();
+}
+
+std::size_t YandexDiskClient::refreshRemoteIndex() {
+    RemoteIndex& index = requireRemoteIndex();
+    if (!index.loaded()) return rebuildRemoteIndex();
+
+    std::size_t changed = 0;
+    ResourceListing page;
+    for (std::size_t limit = std::max<std::size_t>(options.remote_index_feed_limit, 1);; limit *= 2) {
+        if (limit > kMaxFeedLimit) return rebuildRemoteIndex();
+
+        UrlBuilder url(options.api_base_url, "/resources/last-uploaded");
+        url.param("limit", limit).param("fields", kIndexFields);
+        std::string resp = performRequest(url.url(), "GET");
+        checkApiError(resp);
+        page.parse(resp);
+
+        // Newest first: once the oldest item of the window is already known,
+        // the window reaches back past everything uploaded since last time.
+        bool oldest_is_new = false;
+        for (const auto& item : page.items()) {
+            oldest_is_new = index.upsert(entryOf(item));
+            if (oldest_is_new) ++changed;
+        }
+        if (!oldest_is_new || page.items().size() < limit) break;
+    }
+
+    index.save();
+    return changed;
+}
+
+bool YandexDiskClient::findIndexedResource(const std::string& disk_path, IndexedResource& resource) const {
+    RemoteIndex::Entry entry;
+    if (!remote_index || !remote_index->lookup(disk_path, entry)) return false;
+    resource.path = "disk:" + entry.path;
+    resource.type = entry.dir ? "dir" : "file";
+    resource.size = entry.size;
+    resource.md5 = entry.md5;
+    resource.modified = entry.modified;
+    return true;
+}
+
+std::vector<std::string> YandexDiskClient::findIndexedPathsByName(
+        const std::string& name,
+        const std::string& start_path /* = "/" */) const {
+    std::vector<std::string> results;
+    if (!remote_index || !remote_index->loaded()) return results;
+    for (const std::string& path : remote_index->findByName(name, start_path.empty() ? "/" : start_path)) {
+        results.push_back("disk:" + path);
+    }
+    return results;
+}
@@ -0,0 +1,154 @@
+#include "ResourceListing.h"
+#include <nlohmann/json.hpp>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+std::string_view StringArena::store(const std::string& value) {
+    if (value.empty()) return {};
+    char* out;
+    if (value.size() > kBlockSize) {
+        // A long string gets a block of its own; the open block stays open.
+        large.push_back(std::make_unique<char[]>(value.size()));
+        reserved += value.size();
+        out = large.back().get();
+    } else {
+        if (value.size() > capacity - used) {
+            blocks.push_back(std::make_unique<char[]>(kBlockSize));
+            reserved += kBlockSize;
+            capacity = kBlockSize;
+            used = 0;
+        }
+        out = blocks.back().get() + used;
+        used += value.size();
+    }
+    std::memcpy(out, value.data(), value.size());
+    return {out, value.size()};
+}
+
+void StringArena::clear() {
+    // The first block is kept, so an arena reused page after page stops allocating.
+    large.clear();
+    if (blocks.size() > 1) blocks.resize(1);
+    reserved = blocks.size() * kBlockSize;
+    capacity = reserved;
+    used = 0;
+}
+
+class ResourceListing::Handler : public nlohmann::json_sax<nlohmann::json> {
+public:
+    explicit Handler(ResourceListing& page) : page(page) {}
+
+    bool found = false;
+    std::string error;
+
+    bool null() override { return true; }
+    bool boolean(bool) override { return true; }
+    bool number_integer(number_integer_t value) override {
+        return number_unsigned(value > 0 ? static_cast<number_unsigned_t>(value) : 0);
+    }
+    bool number_unsigned(number_unsigned_t value) override {
+        Zone zone = top();
+        if (zone == ItemObject && member == "size") {
+            page.entries.back().size = value;
+        } else if (zone == Embedded || zone == Top) {
+            if (member == "limit") page.page_limit = value;
+            else if (member == "offset") page.page_offset = value;
+            else if (member == "total") {
+                page.page_total = value;
+                page.has_total = true;
+            }
+        }
+        return true;
+    }
+    bool number_float(number_float_t, const string_t&) override { return true; }
+    bool binary(binary_t&) override { return true; }
+
+    bool string(string_t& value) override {
+        if (top() != ItemObject) return true;
+        ResourceListing::Item& item = page.entries.back();
+        if (member == "name") item.name = page.arena.store(value);
+        else if (member == "path") item.path = page.arena.store(value);
+        else if (member == "type") item.type = page.arena.store(value);
+        else if (member == "md5") item.md5 = page.arena.store(value);
+        else if (member == "sha256") item.sha256 = page.arena.store(value);
+        else if (member == "modified") item.modified = page.arena.store(value);
+        else if (member == "mime_type") item.mime_type = page.arena.store(value);
+        return true;
+    }
+
+    bool key(string_t& name) override {
+        member.assign(name);
+        return true;
+    }
+
+    bool start_object(std::size_t) override {
+        Zone zone = Skipped;
+        if (zones.empty()) zone = Top;
+        else if (top() == Top && member == "_embedded") zone = Embedded;
+        else if (top() == ItemArray) {
+            zone = ItemObject;
+            page.entries.emplace_back();
+        }
+        zones.push_back(zone);
+        return true;
+    }
+
+    bool end_object() override {
+        zones.pop_back();
+        return true;
+    }
+
+    bool start_array(std::size_t) override {
+        Zone zone = Skipped;
+        if ((top() == Embedded || top() == Top) && member == "items") {
+            zone = ItemArray;
+            found = true;
+        }
+        zones.push_back(zone);
+        return true;
+    }
+
+    bool end_array() override {
+        zones.pop_back();
+        return true;
+    }
+
+    bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& ex) override {
+        error = ex.what();
+        return false;
+    }
+
+private:
+    enum Zone { Skipped, Top, Embedded, ItemArray, ItemObject };
+
+    Zone top() const { return zones.empty() ? Skipped : zones.back(); }
+
+    ResourceListing& page;
+    std::vector<Zone> zones;
+    // Name of the member whose value comes next.
+    std::string member;
+};
+
+bool ResourceListing::parse(const std::string& body) {
+    arena.clear();
+    entries.clear();
+    page_limit = page_offset = page_total = 0;
+    has_total = false;
+
+    Handler handler(*this);
+    if (!nlohmann::json::sax_parse(body, &handler)) {
+        throw std::runtime_error("Invalid listing JSON: " + handler.error);
+    }
+    return handler.found;
+}
+
+std::string ResourceListing::embeddedFields(const std::string& item_fields) {
+    std::string fields = "type,_embedded.limit,_embedded.offset,_embedded.total";
+    std::istringstream names(item_fields);
+    std::string field;
+    while (std::getline(names, field, ',')) {
+        if (!field.empty()) fields += ",_embedded.items." + field;
+    }
+    return fields;
+}
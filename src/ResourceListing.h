@@ -0,0 +1,95 @@
+#ifndef YANDEX_DISK_CPP_CLIENT_RESOURCELISTING_H
+#define YANDEX_DISK_CPP_CLIENT_RESOURCELISTING_H
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Bump allocator for the strings of one listing page.
+ *
+ * Strings are copied into large blocks and handed out as views; blocks
+ * never move, so views stay valid until clear() or destruction.
+ */
+class StringArena {
+public:
+    StringArena() = default;
+    StringArena(StringArena&&) noexcept = default;
+    StringArena& operator=(StringArena&&) noexcept = default;
+
+    std::string_view store(const std::string& value);
+
+    /// Forget every string, keeping the first block for reuse.
+    void clear();
+
+    std::size_t bytesReserved() const { return reserved; }
+
+private:
+    static constexpr std::size_t kBlockSize = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> blocks;
+    std::vector<std::unique_ptr<char[]>> large;
+    std::size_t used = 0;
+    std::size_t capacity = 0;
+    std::size_t reserved = 0;
+};
+
+/**
+ * @brief One page of a resource listing, parsed without building a JSON tree.
+ *
+ * The body is read with a SAX parser. Only the fields of the items of
+ * "_embedded.items" (folder and trash listings) or of a top-level "items"
+ * array (the flat file list, the last-uploaded feed) are kept, as views
+ * into the page's arena; everything else is skipped as it streams past.
+ */
+class ResourceListing {
+public:
+    struct Item {
+        std::string_view name;
+        std::string_view path;
+        std::string_view type;
+        std::string_view md5;
+        std::string_view sha256;
+        std::string_view modified;
+        std::string_view mime_type;
+        uint64_t size = 0;
+    };
+
+    /**
+     * @brief Parse a response body, replacing the current page.
+     * @return false if the body has no items array (e.g. the path is a file).
+     * @throws std::runtime_error if the body is not valid JSON.
+     */
+    bool parse(const std::string& body);
+
+    const std::vector<Item>& items() const { return entries; }
+
+    /// Paging counters of "_embedded" (or of the top level for flat lists).
+    uint64_t limit() const { return page_limit; }
+    uint64_t offset() const { return page_offset; }
+    bool hasTotal() const { return has_total; }
+    uint64_t total() const { return page_total; }
+
+    /**
+     * @brief The `fields` query value selecting the given item fields of an
+     *        "_embedded" listing, plus the paging counters.
+     * @param item_fields Comma-separated item fields, e.g. "name,path,size".
+     */
+    static std::string embeddedFields(const std::string& item_fields);
+
+private:
+    class Handler;
+
+    StringArena arena;
+    std::vector<Item> entries;
+    uint64_t page_limit = 0;
+    uint64_t page_offset = 0;
+    uint64_t page_total = 0;
+    bool has_total = false;
+};
+
+#endif //YANDEX_DISK_CPP_CLIENT_RESOURCELISTING_H
@@ -0,0 +1,263 @@
+#include "YandexDiskClient.h"
+#include "WorkerPool.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <regex>
+#include <stdexcept>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    char lower(char c) {
+        return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+
+    bool sameChar(char a, char b, bool ignore_case) {
+        return ignore_case ? lower(a) == lower(b) : a == b;
+    }
+
+    // Matches one "[...]" class at pattern[p]; advances p past it. A class
+    // without a closing bracket is taken as a literal '['.
+    bool matchClass(const std::string& pattern, std::size_t& p, char c, bool ignore_case) {
+        std::size_t i = p + 1;
+        bool negate = i < pattern.size() && (pattern[i] == '!' || pattern[i] == '^');
+        if (negate) ++i;
+        std::size_t first = i;
+        bool matched = false;
+        for (; i < pattern.size() && (pattern[i] != ']' || i == first); ++i) {
+            if (i + 2 < pattern.size() && pattern[i + 1] == '-' && pattern[i + 2] != ']') {
+                char lo = pattern[i], hi = pattern[i + 2];
+                if ((c >= lo && c <= hi) || (ignore_case && lower(c) >= lower(lo) && lower(c) <= lower(hi))) {
+                    matched = true;
+                }
+                i += 2;
+            } else if (sameChar(pattern[i], c, ignore_case)) {
+                matched = true;
+            }
+        }
+        if (i >= pattern.size()) {
+            ++p;
+            return c == '[';
+        }
+        p = i + 1;
+        return matched != negate;
+    }
+
+    // Iterative glob match with single-star backtracking.
+    bool globMatch(const std::string& pattern, std::string_view name, bool ignore_case) {
+        std::size_t p = 0, n = 0;
+        std::size_t star = std::string::npos, resume = 0;
+        while (n < name.size()) {
+            if (p < pattern.size() && pattern[p] == '*') {
+                star = p++;
+                resume = n;
+                continue;
+            }
+            if (p < pattern.size()) {
+                std::size_t next = p;
+                bool ok;
+                if (pattern[p] == '?') {
+                    ok = true;
+                    ++next;
+                } else if (pattern[p] == '[') {
+                    ok = matchClass(pattern, next, name[n], ignore_case);
+                } else {
+                    ok = sameChar(pattern[p], name[n], ignore_case);
+                    ++next;
+                }
+                if (ok) {
+                    p = next;
+                    ++n;
+                    continue;
+                }
+            }
+            if (star == std::string::npos) return false;
+            p = star + 1;
+            n = ++resume;
+        }
+        while (p < pattern.size() && pattern[p] == '*') ++p;
+        return p == pattern.size();
+    }
+
+    bool equalName(const std::string& a, std::string_view b, bool ignore_case) {
+        if (a.size() != b.size()) return false;
+        for (std::size_t i = 0; i < a.size(); ++i) {
+            if (!sameChar(a[i], b[i], ignore_case)) return false;
+        }
+        return true;
+    }
+
+    const nlohmann::json& asJson(const nlohmann::json& item) {
+        return item;
+    }
+
+    // The same members the listing would have returned with the search's
+    // field selection.
+    nlohmann::json asJson(const YandexDiskClient::ResourceEntry& entry) {
+        nlohmann::json item = {
+                {"name", entry.name},
+                {"path", entry.path},
+                {"type", entry.type},
+        };
+        if (entry.type == "file") {
+            item["size"] = entry.size;
+            if (!entry.mime_type.empty()) item["mime_type"] = entry.mime_type;
+        }
+        if (!entry.modified.empty()) item["modified"] = entry.modified;
+        return item;
+    }
+
+    class Matcher {
+    public:
+        explicit Matcher(const YandexDiskClient::SearchOptions& search) : search(search) {
+            if (!search.regex.empty()) {
+                auto flags = std::regex::ECMAScript;
+                if (search.ignore_case) flags |= std::regex::icase;
+                pattern = std::regex(search.regex, flags);
+            }
+        }
+
+        bool operator()(const YandexDiskClient::ResourceEntry& item) const {
+            const std::string_view name = item.name;
+            const std::string_view type = item.type;
+
+            if (!search.name.empty() && !equalName(search.name, name, search.ignore_case)) return false;
+            if (!search.glob.empty() && !globMatch(search.glob, name, search.ignore_case)) return false;
+            if (!search.regex.empty() && !std::regex_search(name.begin(), name.end(), pattern)) return false;
+            if (!search.type.empty() && type != search.type) return false;
+
+            if (!search.mime_type.empty()) {
+                std::string_view mime = item.mime_type;
+                bool prefix = search.mime_type.back() == '/';
+                if (prefix ? mime.substr(0, search.mime_type.size()) != search.mime_type
+                           : mime != search.mime_type) {
+                    return false;
+                }
+            }
+
+            if (search.min_size > 0 || search.max_size > 0) {
+                if (type != "file") return false;
+                if (item.size < search.min_size) return false;
+                if (search.max_size > 0 && item.size > search.max_size) return false;
+            }
+
+            if (!search.modified_after.empty() || !search.modified_before.empty()) {
+                std::string_view modified = item.modified;
+                if (!search.modified_after.empty() && modified < search.modified_after) return false;
+                if (!search.modified_before.empty() && modified > search.modified_before) return false;
+            }
+            return true;
+        }
+
+        bool operator()(const nlohmann::json& item) const {
+            const std::string name = item.value("name", "");
+            const std::string type = item.value("type", "");
+            const std::string mime_type = item.value("mime_type", "");
+            const std::string modified = item.value("modified", "");
+            YandexDiskClient::ResourceEntry entry;
+            entry.name = name;
+            entry.type = type;
+            entry.mime_type = mime_type;
+            entry.modified = modified;
+            entry.size = item.value("size", uint64_t{0});
+            return (*this)(entry) && (!search.predicate || search.predicate(item));
+        }
+
+    private:
+        const YandexDiskClient::SearchOptions& search;
+        std::regex pattern;
+    };
+}
+
+YandexDiskClient::SearchReport YandexDiskClient::searchResources(
+        const std::string& start_path,
+        const SearchOptions& search,
+        const std::function<bool(const nlohmann::json&)>& on_match)
+{
+    return searchListing(apiUrl("/resources"), start_path, search, on_match);
+}
+
+YandexDiskClient::SearchReport YandexDiskClient::searchListing(
+        const std::string& endpoint,
+        const std::string& start_path,
+        const SearchOptions& search,
+        const std::function<bool(const nlohmann::json&)>& on_match)
+{
+    const auto start = Clock::now();
+    const Matcher matches(search);
+
+    // Without a predicate only the entry fields are needed, so pages are
+    // parsed into typed entries and JSON is built for matches alone.
+    ListOptions list;
+    if (!search.predicate) list.fields = "name,path,type,size,mime_type,modified";
+    // Each worker has exactly one listing request outstanding, so the pool
+    // size is the in-flight budget.
+    list.prefetch = false;
+
+    SearchReport report;
+    std::mutex mutex;
+    std::atomic<bool> stop{false};
+
+    // Returns false once the search should end.
+    auto visit = [&](const auto& item) {
+        if (stop.load(std::memory_order_relaxed)) return false;
+        bool hit = matches(item);
+        std::lock_guard<std::mutex> lock(mutex);
+        ++report.items_scanned;
+        if (!hit || stop.load(std::memory_order_relaxed)) return !stop.load(std::memory_order_relaxed);
+        ++report.matches;
+        bool more = on_match(asJson(item));
+        if (!more || (search.max_results > 0 && report.matches >= search.max_results)) {
+            report.stopped_early = true;
+            stop.store(true, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    };
+
+    std::size_t workers = search.max_in_flight > 0 ? search.max_in_flight : options.connection_pool_size;
+    WorkerPool pool(search.recursive ? workers : 1);
+
+    auto listDirectory = [&](const std::string& dir, auto& self) -> void {
+        auto descend = [&](const std::string& child) {
+            pool.submit([&, child] {
+                if (stop.load(std::memory_order_relaxed)) return;
+                try {
+                    self(child, self);
+                } catch (const std::exception& ex) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    report.errors.push_back({"", child, ex.what()});
+                }
+            });
+        };
+        if (search.predicate) {
+            forEachListedItem(endpoint, dir, [&](const nlohmann::json& item) {
+                if (search.recursive && item.value("type", "") == "dir") descend(item.value("path", ""));
+                return visit(item);
+            }, list);
+        } else {
+            forEachListedEntry(endpoint, dir, [&](const ResourceEntry& item) {
+                if (search.recursive && item.type == "dir") descend(std::string(item.path));
+                return visit(item);
+            }, list);
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        ++report.directories_listed;
+    };
+
+    // The start directory is listed on the calling thread so that a bad
+    // path is reported as an exception, as the blocking calls do.
+    try {
+        listDirectory(start_path, listDirectory);
+    } catch (...) {
+        // Queued subdirectories refer to listDirectory; let them drain first.
+        stop.store(true, std::memory_order_relaxed);
+        pool.wait();
+        throw;
+    }
+    pool.wait();
+
+    report.elapsed_seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return report;
+}
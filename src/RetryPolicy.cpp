@@ -0,0 +1,132 @@
+#include "RetryPolicy.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // Refusals arriving within this interval are one congestion signal.
+    constexpr auto kDecreaseInterval = std::chrono::milliseconds(200);
+
+    bool throttledStatus(long http_code) {
+        return http_code == 429 || http_code == 503;
+    }
+
+    // The request never reached the server.
+    bool notSent(CURLcode result) {
+        return result == CURLE_COULDNT_RESOLVE_HOST ||
+               result == CURLE_COULDNT_RESOLVE_PROXY ||
+               result == CURLE_COULDNT_CONNECT ||
+               result == CURLE_SSL_CONNECT_ERROR;
+    }
+
+    bool transient(CURLcode result) {
+        return result == CURLE_OPERATION_TIMEDOUT ||
+               result == CURLE_SEND_ERROR ||
+               result == CURLE_RECV_ERROR ||
+               result == CURLE_GOT_NOTHING ||
+               result == CURLE_PARTIAL_FILE ||
+               result == CURLE_HTTP2 ||
+               result == CURLE_HTTP2_STREAM;
+    }
+}
+
+RetryPolicy::RetryPolicy(const Settings& settings)
+        : settings(settings),
+          limit(static_cast<double>(settings.max_concurrency)),
+          rng(std::random_device{}()) {
+    this->settings.min_concurrency = std::max<std::size_t>(1, settings.min_concurrency);
+    if (settings.max_concurrency > 0) {
+        limit = std::max(limit, static_cast<double>(this->settings.min_concurrency));
+    }
+}
+
+bool RetryPolicy::idempotent(const std::string& method) {
+    return method == "GET" || method == "HEAD" || method == "PUT" || method == "DELETE";
+}
+
+bool RetryPolicy::retryable(const std::string& method, CURLcode result, long http_code) const {
+    // With CURLOPT_FAILONERROR an error status arrives as a transfer error.
+    if (result != CURLE_OK && result != CURLE_HTTP_RETURNED_ERROR) {
+        if (notSent(result)) return true;
+        return transient(result) && (idempotent(method) || settings.retry_non_idempotent);
+    }
+    if (throttledStatus(http_code)) return true;
+    return (http_code == 500 || http_code == 502 || http_code == 504) &&
+           (idempotent(method) || settings.retry_non_idempotent);
+}
+
+bool RetryPolicy::shouldRetry(const std::string& method, CURLcode result, long http_code,
+                              long retry_after, int attempt, Clock::duration& delay) {
+    std::lock_guard<std::mutex> lock(mutex);
+    ++counters.attempts;
+    if (throttledStatus(http_code)) ++counters.throttled;
+
+    if (!retryable(method, result, http_code)) return false;
+    if (attempt >= settings.max_attempts) {
+        ++counters.exhausted;
+        return false;
+    }
+
+    if (retry_after > 0) {
+        auto wait = std::chrono::seconds(retry_after);
+        if (wait > settings.max_retry_after) {
+            ++counters.exhausted;
+            return false;
+        }
+        delay = wait;
+        ++counters.retry_after_waits;
+    } else {
+        delay = backoffLocked(attempt);
+    }
+    ++counters.retries;
+    return true;
+}
+
+RetryPolicy::Clock::duration RetryPolicy::backoffLocked(int attempt) {
+    // Full jitter: anywhere between zero and the exponential bound.
+    double bound = static_cast<double>(settings.base_delay.count()) * std::ldexp(1.0, std::min(attempt - 1, 30));
+    bound = std::min(bound, static_cast<double>(settings.max_delay.count()));
+    double ms = std::uniform_real_distribution<double>(0.0, bound)(rng);
+    return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(ms));
+}
+
+void RetryPolicy::acquire() {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (settings.max_concurrency > 0) {
+        available.wait(lock, [this] { return in_flight < static_cast<std::size_t>(limit); });
+    }
+    ++in_flight;
+}
+
+bool RetryPolicy::tryAcquire() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (settings.max_concurrency > 0 && in_flight >= static_cast<std::size_t>(limit)) return false;
+    ++in_flight;
+    return true;
+}
+
+void RetryPolicy::release(long http_code) {
+    std::lock_guard<std::mutex> lock(mutex);
+    --in_flight;
+    if (settings.max_concurrency > 0) {
+        const double floor = static_cast<double>(settings.min_concurrency);
+        const double ceiling = static_cast<double>(std::max(settings.max_concurrency, settings.min_concurrency));
+        if (throttledStatus(http_code)) {
+            auto now = Clock::now();
+            if (now - last_decrease >= kDecreaseInterval) {
+                limit = std::max(floor, limit / 2);
+                last_decrease = now;
+                ++counters.concurrency_decreases;
+            }
+        } else if (http_code > 0 && http_code < 500) {
+            limit = std::min(ceiling, limit + 1.0 / limit);
+        }
+    }
+    available.notify_all();
+}
+
+RetryPolicy::Stats RetryPolicy::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    Stats s = counters;
+    s.concurrency_limit = settings.max_concurrency > 0 ? static_cast<std::size_t>(limit) : 0;
+    return s;
+}
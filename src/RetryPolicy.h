@@ -0,0 +1,125 @@
+#ifndef YANDEX_DISK_CPP_CLIENT_RETRYPOLICY_H
+#define YANDEX_DISK_CPP_CLIENT_RETRYPOLICY_H
+
+#pragma once
+#include <curl/curl.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <string>
+
+/**
+ * @brief Retry decisions and an adaptive concurrency limit for API requests.
+ *
+ * An attempt is retried when the server refused it (429, 503) or failed
+ * transiently (other 5xx, timeouts, broken connections). Requests that
+ * may have taken effect are only retried if their method is idempotent;
+ * connection failures and refusals are safe for every method. The wait
+ * is the response's Retry-After when there is one, otherwise exponential
+ * backoff with full jitter.
+ *
+ * The concurrency limit follows AIMD: every 429/503 halves it (at most
+ * once per interval, so one burst of refusals counts once) and every
+ * other answer raises it by 1/limit, up to the configured maximum.
+ * Safe to use from several threads.
+ */
+class RetryPolicy {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Settings {
+        /// Attempts per request, the first one included (1 = no retries).
+        int max_attempts = 4;
+        std::chrono::milliseconds base_delay{200};
+        std::chrono::milliseconds max_delay{10000};
+        /// A longer Retry-After ends the retries instead of blocking.
+        std::chrono::milliseconds max_retry_after{60000};
+        /// Also retry POST after failures where the server may have acted.
+        bool retry_non_idempotent = false;
+        /// Concurrent requests allowed (0 = no limit).
+        std::size_t max_concurrency = 32;
+        std::size_t min_concurrency = 1;
+    };
+
+    struct Stats {
+        uint64_t attempts = 0;
+        uint64_t retries = 0;
+        /// 429 and 503 responses.
+        uint64_t throttled = 0;
+        /// Retries that waited for the server's Retry-After.
+        uint64_t retry_after_waits = 0;
+        /// Requests that still failed after the last allowed attempt.
+        uint64_t exhausted = 0;
+        uint64_t concurrency_decreases = 0;
+        /// Current concurrency limit (0 = none).
+        std::size_t concurrency_limit = 0;
+    };
+
+    /**
+     * @brief RAII concurrency slot: taken on construction, returned with
+     *        the status passed to release(), or with 0 (no response) if
+     *        the attempt ended in an exception.
+     */
+    class Slot {
+    public:
+        explicit Slot(RetryPolicy& policy) : policy(&policy) { policy.acquire(); }
+        Slot(const Slot&) = delete;
+        Slot& operator=(const Slot&) = delete;
+        ~Slot() { if (policy) policy->release(0); }
+
+        void release(long http_code) {
+            RetryPolicy* owner = policy;
+            policy = nullptr;
+            if (owner) owner->release(http_code);
+        }
+
+    private:
+        RetryPolicy* policy;
+    };
+
+    explicit RetryPolicy(const Settings& settings);
+
+    RetryPolicy(const RetryPolicy&) = delete;
+    RetryPolicy& operator=(const RetryPolicy&) = delete;
+
+    /**
+     * @brief Account a finished attempt and decide whether to try again.
+     * @param attempt Attempts made so far, this one included.
+     * @param retry_after Seconds from the Retry-After header (0 = none).
+     * @param delay Wait before the next attempt, when true is returned.
+     */
+    bool shouldRetry(const std::string& method, CURLcode result, long http_code,
+                     long retry_after, int attempt, Clock::duration& delay);
+
+    /// Take a concurrency slot, blocking while the limit is reached.
+    void acquire();
+
+    /// Take a slot if one is free.
+    bool tryAcquire();
+
+    /// Return a slot, feeding the HTTP status (0 = no response) into the limit.
+    void release(long http_code);
+
+    Stats stats() const;
+
+    static bool idempotent(const std::string& method);
+
+private:
+    bool retryable(const std::string& method, CURLcode result, long http_code) const;
+    Clock::duration backoffLocked(int attempt);
+
+    Settings settings;
+
+    mutable std::mutex mutex;
+    std::condition_variable available;
+    double limit;
+    std::size_t in_flight = 0;
+    Clock::time_point last_decrease;
+    std::mt19937_64 rng;
+    Stats counters;
+};
+
+#endif //YANDEX_DISK_CPP_CLIENT_RETRYPOLICY_H
@@ -0,0 +1,38 @@
+#ifndef YANDEX_DISK_CPP_CLIENT_SHA256_H
+#define YANDEX_DISK_CPP_CLIENT_SHA256_H
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Incremental SHA-256 (FIPS 180-4), the checksum Yandex.Disk reports as `sha256`.
+ */
+class Sha256 {
+public:
+    Sha256();
+
+    void update(const void* data, std::size_t length);
+
+    /**
+     * @brief Finish the digest and return it as 64 lowercase hex digits.
+     *
+     * The object must not be updated afterwards.
+     */
+    std::string hexDigest();
+
+    /**
+     * @brief Hash a string in one call.
+     */
+    static std::string hex(const std::string& data);
+
+private:
+    void transform(const unsigned char block[64]);
+
+    uint32_t state[8];
+    uint64_t length = 0;
+    unsigned char buffer[64];
+};
+
+#endif //YANDEX_DISK_CPP_CLIENT_SHA256_H
@@ -0,0 +1,111 @@
+#include "TransferJournal.h"
+#include <nlohmann/json.hpp>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+    FILE* openFile(const std::string& path, const char* mode) {
+#if defined(_WIN32)
+        std::wstring wmode(mode, mode + std::char_traits<char>::length(mode));
+        return _wfopen(std::filesystem::path(path).wstring().c_str(), wmode.c_str());
+#else
+        return fopen(path.c_str(), mode);
+#endif
+    }
+
+    std::string serialize(const std::string& key, const TransferJournal::Entry& entry) {
+        nlohmann::json line = {
+                {"key", key},
+                {"offset", entry.offset},
+                {"size", entry.size},
+                {"md5", entry.md5},
+                {"stamp", entry.stamp},
+                {"done", entry.done}
+        };
+        return line.dump() + "\n";
+    }
+}
+
+TransferJournal::TransferJournal(const std::string& path) : path(path) {
+    load();
+    rewrite();
+}
+
+TransferJournal::~TransferJournal() {
+    if (file) fclose(file);
+}
+
+bool TransferJournal::syncFile(FILE* f) {
+    if (fflush(f) != 0) return false;
+#if defined(_WIN32)
+    return _commit(_fileno(f)) == 0;
+#else
+    return fsync(fileno(f)) == 0;
+#endif
+}
+
+void TransferJournal::load() {
+    std::ifstream in(std::filesystem::path(path), std::ios::binary);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty()) continue;
+        nlohmann::json j = nlohmann::json::parse(line, nullptr, false);
+        // A torn line from an interrupted write is skipped.
+        if (j.is_discarded() || !j.is_object() || !j.contains("key")) continue;
+
+        Entry entry;
+        entry.offset = j.value("offset", uint64_t{0});
+        entry.size = j.value("size", uint64_t{0});
+        entry.md5 = j.value("md5", "");
+        entry.stamp = j.value("stamp", "");
+        entry.done = j.value("done", false);
+        entries[j["key"].get<std::string>()] = entry;
+    }
+}
+
+void TransferJournal::rewrite() {
+    // Compact to one line per key, then swap the file in atomically.
+    std::string tmp = path + ".tmp";
+    FILE* out = openFile(tmp, "wb");
+    if (!out) throw std::runtime_error("Failed to create transfer journal: " + tmp);
+    for (const auto& [key, entry] : entries) {
+        std::string line = serialize(key, entry);
+        fwrite(line.data(), 1, line.size(), out);
+    }
+    bool ok = syncFile(out);
+    ok = fclose(out) == 0 && ok;
+
+    std::error_code ec;
+    if (ok) std::filesystem::rename(tmp, path, ec);
+    if (!ok || ec) {
+        std::filesystem::remove(tmp, ec);
+        throw std::runtime_error("Failed to write transfer journal: " + path);
+    }
+
+    file = openFile(path, "ab");
+    if (!file) throw std::runtime_error("Failed to open transfer journal: " + path);
+}
+
+bool TransferJournal::find(const std::string& key, Entry& entry) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(key);
+    if (it == entries.end()) return false;
+    entry = it->second;
+    return true;
+}
+
+void TransferJournal::record(const std::string& key, const Entry& entry) {
+    std::string line = serialize(key, entry);
+    std::lock_guard<std::mutex> lock(mutex);
+    entries[key] = entry;
+    if (fwrite(line.data(), 1, line.size(), file) != line.size() || !syncFile(file)) {
+        throw std::runtime_error("Failed to write transfer journal: " + path);
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef YANDEX_DISK_CPP_CLIENT_TRANSFERJOURNAL_H
+#define YANDEX_DISK_CPP_CLIENT_TRANSFERJOURNAL_H
+
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string>
+
+/**
+ * @brief Append-only on-disk record of per-file transfer progress.
+ *
+ * Every update is one JSON line, flushed and synced before record()
+ * returns, so a crash loses at most the line being written; a torn last
+ * line is ignored on load. The latest line for a key wins. When opened,
+ * the journal is compacted to one line per key. Safe to use from several
+ * threads.
+ */
+class TransferJournal {
+public:
+    struct Entry {
+        /// Bytes known to be durably stored at the destination.
+        uint64_t offset = 0;
+        /// Full size of the file.
+        uint64_t size = 0;
+        /// MD5 of the file (empty if not known yet).
+        std::string md5;
+        /// Source identity used to detect changes (e.g. local mtime).
+        std::string stamp;
+        bool done = false;
+    };
+
+    /**
+     * @brief Load the journal at path (if any) and open it for appending.
+     * @throws std::runtime_error if the file cannot be opened.
+     */
+    explicit TransferJournal(const std::string& path);
+    ~TransferJournal();
+
+    TransferJournal(const TransferJournal&) = delete;
+    TransferJournal& operator=(const TransferJournal&) = delete;
+
+    /**
+     * @brief Look up the latest entry of a key.
+     * @return true and fills entry if the key is known.
+     */
+    bool find(const std::string& key, Entry& entry) const;
+
+    /**
+     * @brief Durably record the state of a key.
+     * @throws std::runtime_error on I/O error.
+     */
+    void record(const std::string& key, const Entry& entry);
+
+    /**
+     * @brief Flush stdio buffers of a file and sync it to stable storage.
+     * @return false if the sync failed.
+     */
+    static bool syncFile(FILE* file);
+
+private:
+    void load();
+    void rewrite();
+
+    std::string path;
+    FILE* file = nullptr;
+    std::map<std::string, Entry> entries;
+    mutable std::mutex mutex;
+};
+
+#endif //YANDEX_DISK_CPP_CLIENT_TRANSFERJOURNAL_H
@@ -0,0 +1,541 @@
+#include "TransformPipeline.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+#if defined(YDISK_WITH_ZSTD)
+#include <zstd.h>
+#endif
+#if defined(YDISK_WITH_ZLIB)
+#include <zlib.h>
+#endif
+#if defined(YDISK_WITH_OPENSSL)
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#endif
+
+namespace {
+    using Kind = YandexDiskClient::TransformStage::Kind;
+
+    constexpr char kMagic[4] = {'Y', 'D', 'X', 'F'};
+    constexpr unsigned char kVersion = 1;
+    constexpr std::size_t kFixedHeader = 10;
+    constexpr uint32_t kLastRecord = 0x80000000u;
+    constexpr std::size_t kMaxChunkSize = 64 * 1024 * 1024;
+    constexpr std::size_t kKeySize = 32;
+    constexpr std::size_t kNonceSize = 12;
+    constexpr std::size_t kTagSize = 16;
+
+    void putU32(std::string& out, uint32_t value) {
+        for (int shift = 24; shift >= 0; shift -= 8) out.push_back(static_cast<char>((value >> shift) & 0xff));
+    }
+
+    uint32_t getU32(const char* data) {
+        uint32_t value = 0;
+        for (int i = 0; i < 4; ++i) value = (value << 8) | static_cast<unsigned char>(data[i]);
+        return value;
+    }
+
+    const char* stageName(Kind kind) {
+        switch (kind) {
+            case Kind::Zstd: return "zstd";
+            case Kind::Gzip: return "gzip";
+            case Kind::AesGcm: return "AES-GCM";
+        }
+        return "unknown";
+    }
+
+    void requireSupport(Kind kind) {
+        switch (kind) {
+            case Kind::Zstd:
+#if !defined(YDISK_WITH_ZSTD)
+                throw std::runtime_error("The zstd stage needs a build with YDISK_WITH_ZSTD");
+#endif
+                return;
+            case Kind::Gzip:
+#if !defined(YDISK_WITH_ZLIB)
+                throw std::runtime_error("The gzip stage needs a build with YDISK_WITH_ZLIB");
+#endif
+                return;
+            case Kind::AesGcm:
+#if !defined(YDISK_WITH_OPENSSL)
+                throw std::runtime_error("The AES-GCM stage needs a build with YDISK_WITH_OPENSSL");
+#endif
+                return;
+        }
+        throw std::runtime_error("Unknown transform stage");
+    }
+
+    // Largest output of a stage for the given input; generous enough for
+    // both compressors' worst case on incompressible data.
+    std::size_t outputBound(Kind kind, std::size_t input) {
+        return kind == Kind::AesGcm ? input + kTagSize : input + input / 64 + 1024;
+    }
+
+    std::size_t transformThreads(const YandexDiskClient::TransformOptions& options) {
+        if (options.threads > 0) return options.threads;
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+#if defined(YDISK_WITH_ZSTD)
+    // One pair of contexts per thread, reused across chunks.
+    struct ZstdContexts {
+        ZSTD_CCtx* compress = ZSTD_createCCtx();
+        ZSTD_DCtx* decompress = ZSTD_createDCtx();
+
+        ~ZstdContexts() {
+            ZSTD_freeCCtx(compress);
+            ZSTD_freeDCtx(decompress);
+        }
+    };
+
+    ZstdContexts& zstdContexts() {
+        thread_local ZstdContexts contexts;
+        if (!contexts.compress || !contexts.decompress) throw std::runtime_error("Cannot create zstd contexts");
+        return contexts;
+    }
+
+    std::string zstdCompress(const std::string& in, int level) {
+        std::string out(ZSTD_compressBound(in.size()), '\0');
+        std::size_t n = ZSTD_compressCCtx(zstdContexts().compress, &out[0], out.size(), in.data(), in.size(), level);
+        if (ZSTD_isError(n)) throw std::runtime_error(std::string("zstd: ") + ZSTD_getErrorName(n));
+        out.resize(n);
+        return out;
+    }
+
+    std::string zstdDecompress(const std::string& in, std::size_t limit) {
+        unsigned long long size = ZSTD_getFrameContentSize(in.data(), in.size());
+        if (size == ZSTD_CONTENTSIZE_ERROR || size == ZSTD_CONTENTSIZE_UNKNOWN || size > limit) {
+            throw std::runtime_error("Corrupt zstd chunk");
+        }
+        std::string out(static_cast<std::size_t>(size), '\0');
+        std::size_t n = ZSTD_decompressDCtx(zstdContexts().decompress, &out[0], out.size(), in.data(), in.size());
+        if (ZSTD_isError(n) || n != size) throw std::runtime_error("Corrupt zstd chunk");
+        return out;
+    }
+#endif
+
+#if defined(YDISK_WITH_ZLIB)
+    std::string gzipCompress(const std::string& in, int level) {
+        z_stream stream{};
+        // 15 + 16: the largest window, with a gzip wrapper.
+        if (deflateInit2(&stream, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            throw std::runtime_error("Cannot start gzip compression");
+        }
+        std::string out(deflateBound(&stream, static_cast<uLong>(in.size())), '\0');
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+        stream.avail_in = static_cast<uInt>(in.size());
+        stream.next_out = reinterpret_cast<Bytef*>(&out[0]);
+        stream.avail_out = static_cast<uInt>(out.size());
+        int result = deflate(&stream, Z_FINISH);
+        out.resize(stream.total_out);
+        deflateEnd(&stream);
+        if (result != Z_STREAM_END) throw std::runtime_error("gzip compression failed");
+        return out;
+    }
+
+    std::string gzipDecompress(const std::string& in, std::size_t limit) {
+        z_stream stream{};
+        if (inflateInit2(&stream, 15 + 16) != Z_OK) throw std::runtime_error("Cannot start gzip decompression");
+        std::string out(limit, '\0');
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+        stream.avail_in = static_cast<uInt>(in.size());
+        stream.next_out = reinterpret_cast<Bytef*>(&out[0]);
+        stream.avail_out = static_cast<uInt>(out.size());
+        int result = inflate(&stream, Z_FINISH);
+        bool consumed = stream.avail_in == 0;
+        out.resize(stream.total_out);
+        inflateEnd(&stream);
+        if (result != Z_STREAM_END || !consumed) throw std::runtime_error("Corrupt gzip chunk");
+        return out;
+    }
+#endif
+
+#if defined(YDISK_WITH_OPENSSL)
+    struct CipherContext {
+        EVP_CIPHER_CTX* context = EVP_CIPHER_CTX_new();
+
+        ~CipherContext() { EVP_CIPHER_CTX_free(context); }
+    };
+
+    EVP_CIPHER_CTX* cipherContext() {
+        thread_local CipherContext cipher;
+        if (!cipher.context) throw std::runtime_error("Cannot create an AES-GCM context");
+        return cipher.context;
+    }
+
+    const unsigned char* bytes(const std::string& text) {
+        return reinterpret_cast<const unsigned char*>(text.data());
+    }
+
+    std::string randomBytes(std::size_t count) {
+        std::string out(count, '\0');
+        if (RAND_bytes(reinterpret_cast<unsigned char*>(&out[0]), static_cast<int>(count)) != 1) {
+            throw std::runtime_error("Cannot draw a random AES-GCM nonce");
+        }
+        return out;
+    }
+
+    std::string aesEncrypt(const std::string& in, const std::string& key, const std::string& nonce,
+                           const std::string& aad) {
+        EVP_CIPHER_CTX* context = cipherContext();
+        std::string out(in.size() + kTagSize, '\0');
+        auto* cipher = reinterpret_cast<unsigned char*>(&out[0]);
+        int length = 0;
+        int final_length = 0;
+        bool ok = EVP_EncryptInit_ex(context, EVP_aes_256_gcm(), nullptr, bytes(key), bytes(nonce)) == 1 &&
+                  EVP_EncryptUpdate(context, nullptr, &length, bytes(aad), static_cast<int>(aad.size())) == 1 &&
+                  (in.empty() || EVP_EncryptUpdate(context, cipher, &length, bytes(in), static_cast<int>(in.size())) == 1) &&
+                  EVP_EncryptFinal_ex(context, cipher + in.size(), &final_length) == 1 &&
+                  EVP_CIPHER_CTX_ctrl(context, EVP_CTRL_GCM_GET_TAG, kTagSize, cipher + in.size()) == 1;
+        if (!ok) throw std::runtime_error("AES-GCM encryption failed");
+        return out;
+    }
+
+    std::string aesDecrypt(const std::string& in, const std::string& key, const std::string& nonce,
+                           const std::string& aad) {
+        if (in.size() < kTagSize) throw std::runtime_error("Corrupt AES-GCM chunk");
+        EVP_CIPHER_CTX* context = cipherContext();
+        const std::size_t size = in.size() - kTagSize;
+        std::string out(size, '\0');
+        auto* plain = reinterpret_cast<unsigned char*>(&out[0]);
+        std::string tag = in.substr(size);
+        int length = 0;
+        int final_length = 0;
+        bool ok = EVP_DecryptInit_ex(context, EVP_aes_256_gcm(), nullptr, bytes(key), bytes(nonce)) == 1 &&
+                  EVP_DecryptUpdate(context, nullptr, &length, bytes(aad), static_cast<int>(aad.size())) == 1 &&
+                  (size == 0 || EVP_DecryptUpdate(context, plain, &length, bytes(in), static_cast<int>(size)) == 1) &&
+                  EVP_CIPHER_CTX_ctrl(context, EVP_CTRL_GCM_SET_TAG, kTagSize, &tag[0]) == 1 &&
+                  EVP_DecryptFinal_ex(context, plain + size, &final_length) == 1;
+        if (!ok) throw std::runtime_error("AES-GCM authentication failed (wrong key or corrupt data)");
+        return out;
+    }
+
+    // The base nonce with the chunk index in its low 8 bytes.
+    std::string chunkNonce(const std::string& base, uint64_t index) {
+        std::string nonce = base;
+        for (int i = 0; i < 8; ++i) nonce[kNonceSize - 1 - i] ^= static_cast<char>((index >> (8 * i)) & 0xff);
+        return nonce;
+    }
+
+    std::string chunkAad(const std::string& header, uint64_t index, bool last) {
+        std::string aad = header;
+        for (int shift = 56; shift >= 0; shift -= 8) aad.push_back(static_cast<char>((index >> shift) & 0xff));
+        aad.push_back(last ? 1 : 0);
+        return aad;
+    }
+#endif
+}
+
+YandexDiskClient::TransformStage YandexDiskClient::TransformStage::zstd(int level) {
+    TransformStage stage;
+    stage.kind = Kind::Zstd;
+    stage.level = level;
+    return stage;
+}
+
+YandexDiskClient::TransformStage YandexDiskClient::TransformStage::gzip(int level) {
+    TransformStage stage;
+    stage.kind = Kind::Gzip;
+    stage.level = level;
+    return stage;
+}
+
+YandexDiskClient::TransformStage YandexDiskClient::TransformStage::aesGcm(std::string key) {
+    if (key.size() != kKeySize) throw std::runtime_error("AES-GCM key must be 32 bytes");
+    TransformStage stage;
+    stage.kind = Kind::AesGcm;
+    stage.key = std::move(key);
+    return stage;
+}
+
+ChunkCodec::ChunkCodec(const std::vector<TransformStage>& list, std::size_t chunk_size)
+        : chunk_size(chunk_size) {
+    if (chunk_size == 0 || chunk_size > kMaxChunkSize) {
+        throw std::runtime_error("Transform chunk size must be between 1 byte and 64 MiB");
+    }
+    for (const TransformStage& stage : list) stages.push_back({stage.kind, stage.level, stage.key, {}});
+    prepare(list);
+
+    header_bytes.assign(kMagic, sizeof(kMagic));
+    header_bytes.push_back(static_cast<char>(kVersion));
+    header_bytes.push_back(static_cast<char>(stages.size()));
+    putU32(header_bytes, static_cast<uint32_t>(chunk_size));
+    for (Stage& stage : stages) {
+        header_bytes.push_back(static_cast<char>(stage.kind));
+#if defined(YDISK_WITH_OPENSSL)
+        if (stage.kind == Kind::AesGcm) {
+            stage.nonce = randomBytes(kNonceSize);
+            header_bytes += stage.nonce;
+        }
+#endif
+    }
+}
+
+void ChunkCodec::prepare(const std::vector<TransformStage>& list) {
+    if (list.empty() || list.size() > 255) throw std::runtime_error("A transform needs between 1 and 255 stages");
+    bounds.assign(1, chunk_size);
+    for (const TransformStage& stage : list) {
+        requireSupport(stage.kind);
+        if (stage.kind == Kind::AesGcm && stage.key.size() != kKeySize) {
+            throw std::runtime_error("AES-GCM key must be 32 bytes");
+        }
+        bounds.push_back(outputBound(stage.kind, bounds.back()));
+    }
+}
+
+std::size_t ChunkCodec::parseHeader(const std::vector<TransformStage>& list, const char* data,
+                                    std::size_t size, std::unique_ptr<ChunkCodec>& codec) {
+    if (std::memcmp(data, kMagic, std::min(size, sizeof(kMagic))) != 0) {
+        throw std::runtime_error("Not a transformed body");
+    }
+    if (size < kFixedHeader) return 0;
+    if (static_cast<unsigned char>(data[4]) != kVersion) throw std::runtime_error("Unsupported transform format version");
+    const std::size_t count = static_cast<unsigned char>(data[5]);
+    if (count != list.size()) {
+        throw std::runtime_error("Body was transformed with " + std::to_string(count) + " stage(s), " +
+                                 std::to_string(list.size()) + " given");
+    }
+
+    std::unique_ptr<ChunkCodec> parsed(new ChunkCodec());
+    parsed->chunk_size = getU32(data + 6);
+    if (parsed->chunk_size == 0 || parsed->chunk_size > kMaxChunkSize) {
+        throw std::runtime_error("Corrupt transformed body: bad chunk size");
+    }
+
+    std::size_t pos = kFixedHeader;
+    for (const TransformStage& stage : list) {
+        if (pos == size) return 0;
+        auto kind = static_cast<Kind>(static_cast<unsigned char>(data[pos++]));
+        if (kind != stage.kind) {
+            throw std::runtime_error("Body was transformed with different stages (found " +
+                                     std::string(stageName(kind)) + " where " + stageName(stage.kind) +
+                                     " was given)");
+        }
+        Stage parsed_stage{stage.kind, stage.level, stage.key, {}};
+        if (kind == Kind::AesGcm) {
+            if (size - pos < kNonceSize) return 0;
+            parsed_stage.nonce.assign(data + pos, kNonceSize);
+            pos += kNonceSize;
+        }
+        parsed->stages.push_back(std::move(parsed_stage));
+    }
+    parsed->prepare(list);
+    parsed->header_bytes.assign(data, pos);
+    codec = std::move(parsed);
+    return pos;
+}
+
+// index and last only feed AES-GCM, which a build may leave out.
+std::string ChunkCodec::encode([[maybe_unused]] uint64_t index, [[maybe_unused]] bool last,
+                              const std::string& chunk) const {
+    std::string current;
+    const std::string* in = &chunk;
+    for (const Stage& stage : stages) {
+        switch (stage.kind) {
+#if defined(YDISK_WITH_ZSTD)
+            case Kind::Zstd: current = zstdCompress(*in, stage.level); break;
+#endif
+#if defined(YDISK_WITH_ZLIB)
+            case Kind::Gzip: current = gzipCompress(*in, stage.level); break;
+#endif
+#if defined(YDISK_WITH_OPENSSL)
+            case Kind::AesGcm:
+                current = aesEncrypt(*in, stage.key, chunkNonce(stage.nonce, index),
+                                     chunkAad(header_bytes, index, last));
+                break;
+#endif
+            default: requireSupport(stage.kind);
+        }
+        in = &current;
+    }
+
+    std::string record;
+    record.reserve(4 + in->size());
+    putU32(record, static_cast<uint32_t>(in->size()) | (last ? kLastRecord : 0));
+    record += *in;
+    return record;
+}
+
+std::string ChunkCodec::decode([[maybe_unused]] uint64_t index, [[maybe_unused]] bool last,
+                              const std::string& payload) const {
+    std::string current;
+    const std::string* in = &payload;
+    for (std::size_t i = stages.size(); i-- > 0;) {
+        const Stage& stage = stages[i];
+        switch (stage.kind) {
+#if defined(YDISK_WITH_ZSTD)
+            case Kind::Zstd: current = zstdDecompress(*in, bounds[i]); break;
+#endif
+#if defined(YDISK_WITH_ZLIB)
+            case Kind::Gzip: current = gzipDecompress(*in, bounds[i]); break;
+#endif
+#if defined(YDISK_WITH_OPENSSL)
+            case Kind::AesGcm:
+                current = aesDecrypt(*in, stage.key, chunkNonce(stage.nonce, index),
+                                     chunkAad(header_bytes, index, last));
+                break;
+#endif
+            default: requireSupport(stage.kind);
+        }
+        if (current.size() > bounds[i]) throw std::runtime_error("Corrupt transformed body: chunk too large");
+        in = &current;
+    }
+    return in == &current ? std::move(current) : payload;
+}
+
+OrderedChunks::OrderedChunks(Function function, std::size_t threads, std::size_t window)
+        : function(std::move(function)), window(std::max<std::size_t>(1, window)), pool(threads) {}
+
+OrderedChunks::~OrderedChunks() {
+    pool.wait();
+}
+
+bool OrderedChunks::full() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return slots.size() >= window;
+}
+
+bool OrderedChunks::empty() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return slots.empty();
+}
+
+bool OrderedChunks::ready() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return !slots.empty() && slots.front()->done;
+}
+
+void OrderedChunks::push(std::string chunk, bool last) {
+    auto slot = std::make_shared<Slot>();
+    uint64_t index;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        slots.push_back(slot);
+        index = next_index++;
+    }
+    pool.submit([this, slot, index, last, chunk = std::move(chunk)] {
+        std::string data;
+        std::string error;
+        try {
+            data = function(index, last, chunk);
+        } catch (const std::exception& ex) {
+            error = ex.what();
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        slot->data = std::move(data);
+        slot->error = std::move(error);
+        slot->done = true;
+        finished.notify_all();
+    });
+}
+
+std::string OrderedChunks::pop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (slots.empty()) throw std::runtime_error("No chunk in the pipeline");
+    finished.wait(lock, [this] { return slots.front()->done; });
+    std::shared_ptr<Slot> slot = std::move(slots.front());
+    slots.pop_front();
+    if (!slot->error.empty()) throw std::runtime_error(slot->error);
+    return std::move(slot->data);
+}
+
+TransformBody::TransformBody(std::shared_ptr<UploadBody> source,
+                             const YandexDiskClient::TransformOptions& options)
+        : source(std::move(source)),
+          codec(options.stages, options.chunk_size),
+          chunks([this](uint64_t index, bool last, const std::string& chunk) {
+                     return codec.encode(index, last, chunk);
+                 },
+                 transformThreads(options), 2 * transformThreads(options)),
+          out(codec.header()) {}
+
+std::size_t TransformBody::read(char* buffer, std::size_t capacity) {
+    while (out_pos == out.size()) {
+        // Keep a window of chunks ahead of what libcurl has taken. A short
+        // chunk means the source ended, so it is the last record.
+        while (!source_done && !chunks.full()) {
+            std::string chunk(codec.chunkSize(), '\0');
+            std::size_t filled = 0;
+            while (filled < chunk.size()) {
+                std::size_t n = source->read(&chunk[filled], chunk.size() - filled);
+                if (n == 0) break;
+                filled += n;
+            }
+            source_done = filled < chunk.size();
+            chunk.resize(filled);
+            chunks.push(std::move(chunk), source_done);
+        }
+        if (chunks.empty()) return 0;
+        out = chunks.pop();
+        out_pos = 0;
+    }
+    std::size_t n = std::min(capacity, out.size() - out_pos);
+    std::memcpy(buffer, out.data() + out_pos, n);
+    out_pos += n;
+    return n;
+}
+
+TransformTarget::TransformTarget(DownloadTarget& inner, const YandexDiskClient::TransformOptions& options)
+        : inner(inner), stages(options.stages), threads(transformThreads(options)) {
+    if (stages.empty()) throw std::runtime_error("A transform needs between 1 and 255 stages");
+    for (const YandexDiskClient::TransformStage& stage : stages) requireSupport(stage.kind);
+}
+
+bool TransformTarget::deliver(const std::string& chunk) {
+    if (chunk.empty()) return true;
+    delivered_bytes += chunk.size();
+    if (!inner.write(chunk.data(), chunk.size())) stopped = true;
+    return !stopped;
+}
+
+bool TransformTarget::write(const char* data, std::size_t size) {
+    if (stopped) return false;
+    pending.append(data, size);
+    if (!codec) {
+        std::size_t used = ChunkCodec::parseHeader(stages, pending.data(), pending.size(), codec);
+        if (used == 0) return true;
+        pending_pos = used;
+        chunks = std::make_unique<OrderedChunks>(
+                [this](uint64_t index, bool last, const std::string& payload) {
+                    return codec->decode(index, last, payload);
+                },
+                threads, 2 * threads);
+    }
+
+    while (pending.size() - pending_pos >= 4) {
+        if (last_seen) throw std::runtime_error("Data after the end of a transformed body");
+        const uint32_t word = getU32(pending.data() + pending_pos);
+        const std::size_t length = word & ~kLastRecord;
+        if (length > codec->maxRecord()) throw std::runtime_error("Corrupt transformed body: record too large");
+        if (pending.size() - pending_pos - 4 < length) break;
+
+        while (chunks->full()) {
+            if (!deliver(chunks->pop())) return false;
+        }
+        last_seen = (word & kLastRecord) != 0;
+        chunks->push(pending.substr(pending_pos + 4, length), last_seen);
+        pending_pos += 4 + length;
+    }
+    while (chunks->ready()) {
+        if (!deliver(chunks->pop())) return false;
+    }
+
+    // Drop consumed bytes once they are the larger part of the buffer, so
+    // it holds about one record whatever the length of the body.
+    if (pending_pos > pending.size() / 2) {
+        pending.erase(0, pending_pos);
+        pending_pos = 0;
+    }
+    return true;
+}
+
+void TransformTarget::finish() {
+    if (!codec || !last_seen) throw std::runtime_error("Transformed body is truncated");
+    if (pending_pos != pending.size()) throw std::runtime_error("Data after the end of a transformed body");
+    while (!chunks->empty()) {
+        if (!deliver(chunks->pop())) return;
+    }
+    inner.finish();
+}
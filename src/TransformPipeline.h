@@ -0,0 +1,194 @@
+#ifndef YANDEX_DISK_CPP_CLIENT_TRANSFORMPIPELINE_H
+#define YANDEX_DISK_CPP_CLIENT_TRANSFORMPIPELINE_H
+
+#pragma once
+#include "YandexDiskClient.h"
+#include "DownloadTarget.h"
+#include "UploadBody.h"
+#include "WorkerPool.h"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Applies the stages of a TransformOptions to one chunk at a time.
+ *
+ * A transformed body is a header followed by records:
+ *
+ *     "YDXF" | version (1) | stage count | chunk size (u32 BE)
+ *            | per stage: kind, and for AES-GCM a 12-byte nonce base
+ *     record: u32 BE length, top bit set on the last record | payload
+ *
+ * Every chunk goes through all stages on its own (one zstd frame, one gzip
+ * member, one GCM message), so chunks can be processed on any thread. The
+ * last record holds the short tail of the body, and is empty when the body
+ * fills its chunks exactly. AES-GCM uses the nonce base with the
+ * chunk index in its low 8 bytes, and authenticates the header, the index
+ * and the last-record flag, so a reordered, truncated or extended body
+ * fails to decrypt.
+ *
+ * encode() and decode() are const and safe to call concurrently.
+ */
+class ChunkCodec {
+public:
+    using TransformStage = YandexDiskClient::TransformStage;
+
+    /**
+     * @brief Codec for encoding: draws the nonces and builds the header.
+     * @throws std::runtime_error for an invalid stage or one this build
+     *         does not support.
+     */
+    ChunkCodec(const std::vector<TransformStage>& stages, std::size_t chunk_size);
+
+    /**
+     * @brief Codec for decoding a body that starts with the given header.
+     * @return Header bytes consumed, or 0 if more bytes are needed.
+     * @throws std::runtime_error if the header does not match the stages.
+     */
+    static std::size_t parseHeader(const std::vector<TransformStage>& stages, const char* data,
+                                   std::size_t size, std::unique_ptr<ChunkCodec>& codec);
+
+    const std::string& header() const { return header_bytes; }
+    std::size_t chunkSize() const { return chunk_size; }
+
+    /// Largest payload a record of this body may have.
+    std::size_t maxRecord() const { return bounds.back(); }
+
+    /// Chunk through every stage, framed as a record.
+    std::string encode(uint64_t index, bool last, const std::string& chunk) const;
+
+    /// Record payload back to the chunk, through the stages in reverse.
+    std::string decode(uint64_t index, bool last, const std::string& payload) const;
+
+private:
+    struct Stage {
+        TransformStage::Kind kind;
+        int level;
+        std::string key;
+        std::string nonce;
+    };
+
+    ChunkCodec() = default;
+    void prepare(const std::vector<TransformStage>& stages);
+
+    std::vector<Stage> stages;
+    std::size_t chunk_size = 0;
+    /// bounds[i]: largest input of stage i; the last is the record limit.
+    std::vector<std::size_t> bounds;
+    std::string header_bytes;
+};
+
+/**
+ * @brief Runs a function over a stream of chunks on a pool of threads and
+ *        hands the results back in order.
+ *
+ * At most `window` chunks are queued, running or waiting to be taken, so
+ * memory is bounded whatever the length of the stream.
+ */
+class OrderedChunks {
+public:
+    using Function = std::function<std::string(uint64_t index, bool last, const std::string& chunk)>;
+
+    OrderedChunks(Function function, std::size_t threads, std::size_t window);
+    ~OrderedChunks();
+
+    OrderedChunks(const OrderedChunks&) = delete;
+    OrderedChunks& operator=(const OrderedChunks&) = delete;
+
+    bool full() const;
+    bool empty() const;
+
+    /// Whether the oldest result is ready, so pop() will not block.
+    bool ready() const;
+
+    /// Queue the next chunk; call only when not full().
+    void push(std::string chunk, bool last);
+
+    /**
+     * @brief Take the oldest result, waiting for it if needed.
+     * @throws std::runtime_error with the function's error for that chunk.
+     */
+    std::string pop();
+
+private:
+    struct Slot {
+        std::string data;
+        std::string error;
+        bool done = false;
+    };
+
+    Function function;
+    std::size_t window;
+    uint64_t next_index = 0;
+    std::deque<std::shared_ptr<Slot>> slots;
+    mutable std::mutex mutex;
+    std::condition_variable finished;
+    // Declared last so its threads are joined before the slots go away.
+    WorkerPool pool;
+};
+
+/**
+ * @brief Upload body that transforms another body on the fly.
+ *
+ * Chunks are read from the source as libcurl asks for data and encoded a
+ * window ahead on the pipeline's threads. The size is unknown up front, so
+ * the body is sent chunked.
+ */
+class TransformBody : public UploadBody {
+public:
+    /// @throws std::runtime_error for stages this build does not support.
+    TransformBody(std::shared_ptr<UploadBody> source, const YandexDiskClient::TransformOptions& options);
+
+    uint64_t size() const override { return kUnknownSize; }
+    std::size_t read(char* buffer, std::size_t capacity) override;
+
+private:
+    std::shared_ptr<UploadBody> source;
+    ChunkCodec codec;
+    OrderedChunks chunks;
+    std::string out;
+    std::size_t out_pos = 0;
+    bool source_done = false;
+};
+
+/**
+ * @brief Download target that decodes a transformed body into another
+ *        target.
+ *
+ * Records are decoded a window ahead on the pipeline's threads and written
+ * to the inner target in order, on the transfer thread.
+ */
+class TransformTarget : public DownloadTarget {
+public:
+    TransformTarget(DownloadTarget& inner, const YandexDiskClient::TransformOptions& options);
+
+    bool write(const char* data, std::size_t size) override;
+
+    /// @throws std::runtime_error if the body ended before its last record.
+    void finish() override;
+
+    /// Decoded bytes handed to the inner target.
+    uint64_t delivered() const { return delivered_bytes; }
+
+private:
+    bool deliver(const std::string& chunk);
+
+    DownloadTarget& inner;
+    std::vector<YandexDiskClient::TransformStage> stages;
+    std::size_t threads;
+    std::unique_ptr<ChunkCodec> codec;
+    std::unique_ptr<OrderedChunks> chunks;
+    std::string pending;
+    std::size_t pending_pos = 0;
+    bool last_seen = false;
+    bool stopped = false;
+    uint64_t delivered_bytes = 0;
+};
+
+#endif //YANDEX_DISK_CPP_CLIENT_TRANSFORMPIPELINE_H
@@ -0,0 +1,76 @@
+#include "UploadBody.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+namespace {
+    // libcurl needs a non-null pointer even for an empty body.
+    const char kEmpty[1] = {0};
+}
+
+MemoryBody::MemoryBody(const void* data, std::size_t size)
+        : bytes(size > 0 ? static_cast<const char*>(data) : kEmpty),
+          length(size) {}
+
+std::size_t MemoryBody::read(char* buffer, std::size_t capacity) {
+    std::size_t n = std::min(capacity, length - offset);
+    std::memcpy(buffer, bytes + offset, n);
+    offset += n;
+    return n;
+}
+
+FileBody::FileBody(const std::string& path, bool map) : path(path) {
+    if (map && mapping.open(path, true)) {
+        length = mapping.size();
+        return;
+    }
+#if defined(_WIN32)
+    stream = _wfopen(std::filesystem::path(path).wstring().c_str(), L"rb");
+#else
+    stream = fopen(path.c_str(), "rb");
+#endif
+    if (!stream) throw std::runtime_error("Couldn't open the file: " + path);
+    // The data is read in chunks as large as libcurl asks for; a stdio
+    // buffer would only add a copy.
+    setvbuf(stream, nullptr, _IONBF, 0);
+    std::error_code ec;
+    if (std::filesystem::is_regular_file(std::filesystem::path(path), ec)) {
+        uint64_t size = std::filesystem::file_size(std::filesystem::path(path), ec);
+        if (!ec) length = size;
+    }
+}
+
+FileBody::~FileBody() {
+    if (stream) fclose(stream);
+}
+
+const char* FileBody::contiguous() const {
+    if (!mapping.isOpen()) return nullptr;
+    return mapping.size() > 0 ? mapping.data() : kEmpty;
+}
+
+std::size_t FileBody::read(char* buffer, std::size_t capacity) {
+    if (mapping.isOpen()) {
+        std::size_t n = static_cast<std::size_t>(std::min<uint64_t>(capacity, mapping.size() - offset));
+        std::memcpy(buffer, mapping.data() + offset, n);
+        offset += n;
+        return n;
+    }
+    std::size_t n = fread(buffer, 1, capacity, stream);
+    if (n == 0 && ferror(stream)) throw std::runtime_error("Failed to read " + path);
+    // The request announced the size; a file cut short must not pass as complete.
+    if (n == 0 && capacity > 0 && length != kUnknownSize && offset < length) {
+        throw std::runtime_error("File shrank during upload: " + path);
+    }
+    offset += n;
+    return n;
+}
+
+ProducerBody::ProducerBody(Producer produce, uint64_t size)
+        : produce(std::move(produce)),
+          length(size) {}
+
+std::size_t ProducerBody::read(char* buffer, std::size_t capacity) {
+    return std::min(produce(buffer, capacity), capacity);
+}
@@ -0,0 +1,99 @@
+#ifndef YANDEX_DISK_CPP_CLIENT_UPLOADBODY_H
+#define YANDEX_DISK_CPP_CLIENT_UPLOADBODY_H
+
+#pragma once
+#include "MappedFile.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+
+/**
+ * @brief Bytes of one upload, behind YandexDiskClient::UploadSource.
+ *
+ * Bodies that are already in memory (a mapped file, a caller's buffer)
+ * expose it through contiguous() and are handed to libcurl as is; the
+ * others are pulled through read().
+ */
+class UploadBody {
+public:
+    static constexpr uint64_t kUnknownSize = UINT64_MAX;
+
+    virtual ~UploadBody() = default;
+
+    virtual uint64_t size() const = 0;
+
+    /// The whole body if it is in memory, else nullptr.
+    virtual const char* contiguous() const { return nullptr; }
+
+    /**
+     * @brief Copy the next bytes into buffer.
+     * @return Bytes copied; 0 at the end.
+     * @throws std::runtime_error on a read error.
+     */
+    virtual std::size_t read(char* buffer, std::size_t capacity) = 0;
+};
+
+/**
+ * @brief A caller-owned buffer; it must outlive the upload.
+ */
+class MemoryBody : public UploadBody {
+public:
+    MemoryBody(const void* data, std::size_t size);
+
+    uint64_t size() const override { return length; }
+    const char* contiguous() const override { return bytes; }
+    std::size_t read(char* buffer, std::size_t capacity) override;
+
+private:
+    const char* bytes;
+    std::size_t length;
+    std::size_t offset = 0;
+};
+
+/**
+ * @brief A local file: memory-mapped, or streamed with large reads where it
+ *        cannot be mapped (pipes, devices) or mapping is not asked for.
+ */
+class FileBody : public UploadBody {
+public:
+    /**
+     * @param map Map the file if possible. A mapped file that another
+     *        process truncates during the upload faults (SIGBUS) instead of
+     *        failing the transfer, so only explicit file sources map.
+     * @throws std::runtime_error if the file cannot be opened.
+     */
+    FileBody(const std::string& path, bool map);
+    ~FileBody() override;
+
+    uint64_t size() const override { return length; }
+    const char* contiguous() const override;
+    std::size_t read(char* buffer, std::size_t capacity) override;
+
+private:
+    std::string path;
+    MappedFile mapping;
+    FILE* stream = nullptr;
+    uint64_t length = kUnknownSize;
+    uint64_t offset = 0;
+};
+
+/**
+ * @brief Bytes pulled from a caller's producer function.
+ */
+class ProducerBody : public UploadBody {
+public:
+    using Producer = std::function<std::size_t(char* buffer, std::size_t capacity)>;
+
+    ProducerBody(Producer produce, uint64_t size);
+
+    uint64_t size() const override { return length; }
+    std::size_t read(char* buffer, std::size_t capacity) override;
+
+private:
+    Producer produce;
+    uint64_t length;
+};
+
+#endif //YANDEX_DISK_CPP_CLIENT_UPLOADBODY_H
@@ -0,0 +1,39 @@
+#include "YandexDiskClient.h"
+#include "TransformPipeline.h"
+#include "UploadBody.h"
+#include <stdexcept>
+
+YandexDiskClient::UploadSource YandexDiskClient::UploadSource::file(const std::string& local_path) {
+    UploadSource source;
+    source.body = std::make_shared<FileBody>(local_path, true);
+    return source;
+}
+
+YandexDiskClient::UploadSource YandexDiskClient::UploadSource::memory(const void* data, std::size_t size) {
+    UploadSource source;
+    source.body = std::make_shared<MemoryBody>(data, size);
+    return source;
+}
+
+YandexDiskClient::UploadSource YandexDiskClient::UploadSource::producer(Producer produce, uint64_t size) {
+    if (!produce) throw std::runtime_error("Upload producer is empty");
+    UploadSource source;
+    source.body = std::make_shared<ProducerBody>(std::move(produce), size);
+    return source;
+}
+
+uint64_t YandexDiskClient::UploadSource::size() const {
+    return body ? body->size() : 0;
+}
+
+bool YandexDiskClient::uploadFile(const std::string& disk_path, const UploadSource& source) {
+    if (!source.body) throw std::runtime_error("Upload source is empty");
+    return uploadBody(disk_path, *source.body);
+}
+
+bool YandexDiskClient::uploadFile(const std::string& disk_path, const UploadSource& source,
+                                  const TransformOptions& transform) {
+    if (!source.body) throw std::runtime_error("Upload source is empty");
+    TransformBody body(source.body, transform);
+    return uploadBody(disk_path, body);
+}
@@ -0,0 +1,61 @@
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool(std::size_t threads, std::size_t queue_limit)
+        : queue_limit(queue_limit) {
+    if (threads == 0) threads = 1;
+    this->threads.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i) {
+        this->threads.emplace_back(&WorkerPool::run, this);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    has_work.notify_all();
+    for (auto& t : threads) t.join();
+}
+
+void WorkerPool::submit(std::function<void()> task) {
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (queue_limit > 0) {
+            has_room.wait(lock, [this] { return queue.size() < queue_limit; });
+        }
+        queue.push_back(std::move(task));
+    }
+    has_work.notify_one();
+}
+
+void WorkerPool::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return queue.empty() && active == 0; });
+}
+
+void WorkerPool::run() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            has_work.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (queue.empty()) return;
+            task = std::move(queue.front());
+            queue.pop_front();
+            ++active;
+        }
+        has_room.notify_one();
+
+        try {
+            task();
+        } catch (...) {
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --active;
+            if (queue.empty() && active == 0) idle.notify_all();
+        }
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef YANDEX_DISK_CPP_CLIENT_WORKERPOOL_H
+#define YANDEX_DISK_CPP_CLIENT_WORKERPOOL_H
+
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Fixed set of threads draining a FIFO task queue.
+ *
+ * With a non-zero queue limit, submit() blocks while the queue is full, which
+ * keeps producers from running arbitrarily far ahead of the workers. Tasks
+ * must handle their own errors; exceptions escaping a task are discarded.
+ */
+class WorkerPool {
+public:
+    /**
+     * @param threads Number of worker threads (at least one is started).
+     * @param queue_limit Maximum queued tasks; 0 means unbounded.
+     */
+    explicit WorkerPool(std::size_t threads, std::size_t queue_limit = 0);
+
+    /**
+     * @brief Finish all queued tasks and join the workers.
+     */
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    void submit(std::function<void()> task);
+
+    /**
+     * @brief Block until the queue is empty and no task is running.
+     */
+    void wait();
+
+    std::size_t size() const { return threads.size(); }
+
+private:
+    void run();
+
+    std::vector<std::thread> threads;
+    std::deque<std::function<void()>> queue;
+    std::size_t queue_limit;
+    std::size_t active = 0;
+    bool stopping = false;
+
+    std::mutex mutex;
+    std::condition_variable has_work;
+    std::condition_variable has_room;
+    std::condition_variable idle;
+};
+
+#endif //YANDEX_DISK_CPP_CLIENT_WORKERPOOL_H
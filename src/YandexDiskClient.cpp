@@ -1,42 +1,307 @@
 #include "YandexDiskClient.h"
+#include "AsyncLoop.h"
+#include "Bandwidth.h"
+#include "ContentIndex.h"
+#include "CurlPool.h"
+#include "Md5.h"
+#include "MetadataCache.h"
+#include "Metrics.h"
+#include "QueryString.h"
+#include "RemoteIndex.h"
+#include "ResourceListing.h"
+#include "RetryPolicy.h"
+#include "TransferJournal.h"
+#include "UploadBody.h"
 #include <curl/curl.h>
 #include <stdexcept>
 #include <filesystem>
 #include <map>
 #include <iomanip>
 #include <sstream>
+#include <future>
+#include <thread>
 
 size_t WriteCallback(void* contents, size_t size, size_t nmemb, void* userp) {
     ((std::string*)userp)->append((char*)contents, size * nmemb);
     return size * nmemb;
 }
 
+namespace {
+    // Bytes downloaded between two journal checkpoints.
+    constexpr uint64_t kCheckpointBytes = 8ull * 1024 * 1024;
+
+    // Item fields requested for typed entries unless the caller selects others.
+    const char* const kEntryFields = "name,path,type,size,md5,modified,mime_type";
+
+    FILE* openFile(const std::string& path, const char* mode) {
+#if defined(_WIN32)
+        std::wstring wmode(mode, mode + std::char_traits<char>::length(mode));
+        return _wfopen(std::filesystem::path(path).wstring().c_str(), wmode.c_str());
+#else
+        return fopen(path.c_str(), mode);
+#endif
+    }
+
+    // Whether a listing goes on after a page. The server may return fewer
+    // items than the limit asked for, so "total" decides when it is given;
+    // only listings without one end on a short page.
+    bool morePages(std::size_t offset, std::size_t count, std::size_t limit, bool has_total, std::size_t total) {
+        if (count == 0) return false;
+        return has_total ? offset + count < total : count == limit;
+    }
+
+    // libcurl's largest upload buffer: fewer, larger reads from the source.
+    constexpr long kUploadChunkSize = 2 * 1024 * 1024;
+
+    struct BodyReader {
+        UploadBody* body;
+        Md5* md5;
+        /// Set when the source failed; the transfer is aborted.
+        std::string error;
+    };
+
+    size_t readBody(char* buffer, size_t size, size_t nitems, void* userp) {
+        auto* reader = static_cast<BodyReader*>(userp);
+        try {
+            size_t n = reader->body->read(buffer, size * nitems);
+            if (reader->md5) reader->md5->update(buffer, n);
+            return n;
+        } catch (const std::exception& ex) {
+            reader->error = ex.what();
+            return CURL_READFUNC_ABORT;
+        }
+    }
+
+    struct ResumeSink {
+        FILE* file;
+        CURL* curl;
+        std::string part_path;
+        uint64_t written;
+        uint64_t checkpointed;
+        Md5 md5;
+        TransferJournal* journal;
+        const std::string* key;
+        TransferJournal::Entry entry;
+        bool checked = false;
+        std::string error;
+
+        void checkpoint() {
+            if (!TransferJournal::syncFile(file)) throw std::runtime_error("Failed to sync " + part_path);
+            entry.offset = written;
+            journal->record(*key, entry);
+            checkpointed = written;
+        }
+    };
+
+    size_t writeResumable(char* data, size_t size, size_t nmemb, void* userp) {
+        auto* sink = static_cast<ResumeSink*>(userp);
+        size_t n = size * nmemb;
+        try {
+            if (!sink->checked) {
+                long code = 0;
+                curl_easy_getinfo(sink->curl, CURLINFO_RESPONSE_CODE, &code);
+                if (sink->written > 0 && code != 206) {
+                    // The server ignored the Range header; start over.
+                    fflush(sink->file);
+                    std::filesystem::resize_file(sink->part_path, 0);
+                    sink->written = 0;
+                    sink->checkpointed = 0;
+                    sink->md5 = Md5();
+                }
+                sink->checked = true;
+            }
+            if (fwrite(data, 1, n, sink->file) != n) {
+                sink->error = "Failed to write " + sink->part_path;
+                return 0;
+            }
+            sink->md5.update(data, n);
+            sink->written += n;
+            if (sink->written - sink->checkpointed >= kCheckpointBytes) sink->checkpoint();
+        } catch (const std::exception& ex) {
+            sink->error = ex.what();
+            return 0;
+        }
+        return n;
+    }
+
+    CURLcode performOnce(CURL* curl, const std::string& token, const std::string& url,
+                         const std::string& method, std::string& response) {
+        struct curl_slist* headers = nullptr;
+        headers = curl_slist_append(headers, ("Authorization: OAuth " + token).c_str());
+
+        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
+
+        if (method == "PUT") {
+            curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "PUT");
+        } else if (method == "DELETE") {
+            curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "DELETE");
+            curl_easy_setopt(curl, CURLOPT_NOBODY, 0L);
+        } else if (method == "POST") {
+            // An empty body must be set explicitly; without POSTFIELDS libcurl
+            // would stream the request body from stdin.
+            curl_easy_setopt(curl, CURLOPT_POST, 1L);
+            curl_easy_setopt(curl, CURLOPT_POSTFIELDS, "");
+            curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, 0L);
+        }
+
+        CURLcode res = curl_easy_perform(curl);
+        curl_slist_free_all(headers);
+        return res;
+    }
+
+    void hashPrefix(Md5& md5, const std::string& path, uint64_t length) {
+        FILE* file = openFile(path, "rb");
+        if (!file) throw std::runtime_error("Couldn't open the file: " + path);
+        std::vector<char> chunk(1 << 20);
+        while (length > 0) {
+            size_t n = fread(chunk.data(), 1, static_cast<size_t>(std::min<uint64_t>(chunk.size(), length)), file);
+            if (n == 0) break;
+            md5.update(chunk.data(), n);
+            length -= n;
+        }
+        fclose(file);
+        if (length > 0) throw std::runtime_error("Failed to read " + path);
+    }
+
+    Metrics::Observer spanObserver(std::function<void(const YandexDiskClient::RequestSpan&)> on_request) {
+        if (!on_request) return {};
+        return [on_request = std::move(on_request)](const Metrics::Span& s) {
+            YandexDiskClient::RequestSpan span;
+            span.name = s.method + " " + s.endpoint;
+            span.method = s.method;
+            span.endpoint = s.endpoint;
+            span.http_code = s.http_code;
+            span.result = static_cast<int>(s.result);
+            span.attempt = s.attempt;
+            span.new_connection = s.new_connection;
+            span.start_unix_nanos = s.start_unix_nanos;
+            span.end_unix_nanos = s.end_unix_nanos;
+            span.dns_seconds = s.dns_seconds;
+            span.connect_seconds = s.connect_seconds;
+            span.tls_seconds = s.tls_seconds;
+            span.ttfb_seconds = s.ttfb_seconds;
+            span.total_seconds = s.total_seconds;
+            span.bytes_sent = s.bytes_sent;
+            span.bytes_received = s.bytes_received;
+            on_request(span);
+        };
+    }
+}
+
 
 YandexDiskClient::YandexDiskClient(const std::string& oauth_token)
-        : token(oauth_token) {}
+        : YandexDiskClient(oauth_token, Options{}) {}
+
+YandexDiskClient::YandexDiskClient(const std::string& oauth_token, const Options& options)
+        : token(oauth_token),
+          options(options) {
+    CurlPool::Settings settings;
+    settings.max_handles = options.connection_pool_size;
+    settings.http2 = options.enable_http2;
+    settings.connect_timeout_ms = options.connect_timeout_ms;
+    settings.verify_tls = options.verify_tls;
+    settings.ca_info = options.ca_info;
+    pool = std::make_unique<CurlPool>(settings);
+    content_index = std::make_unique<ContentIndex>();
+    if (options.metadata_cache_ttl_ms > 0) {
+        metadata_cache = std::make_unique<MetadataCache>(
+                std::chrono::milliseconds(options.metadata_cache_ttl_ms),
+                options.metadata_cache_max_bytes,
+                options.metadata_cache_path);
+    }
+    if (!options.remote_index_path.empty()) {
+        remote_index = std::make_unique<RemoteIndex>(options.remote_index_path);
+    }
+    if (options.share_process_bandwidth) {
+        bandwidth = BandwidthLimiter::process();
+        if (options.upload_bytes_per_second > 0 || options.download_bytes_per_second > 0) {
+            bandwidth->setLimits(options.upload_bytes_per_second, options.download_bytes_per_second);
+        }
+    } else {
+        bandwidth = std::make_shared<BandwidthLimiter>();
+        bandwidth->setLimits(options.upload_bytes_per_second, options.download_bytes_per_second);
+    }
+    RetryPolicy::Settings retry;
+    retry.max_attempts = std::max(options.retry_max_attempts, 1);
+    retry.base_delay = std::chrono::milliseconds(options.retry_base_delay_ms);
+    retry.max_delay = std::chrono::milliseconds(options.retry_max_delay_ms);
+    retry.max_retry_after = std::chrono::milliseconds(options.retry_after_max_ms);
+    retry.retry_non_idempotent = options.retry_non_idempotent;
+    retry.max_concurrency = options.adaptive_concurrency_max;
+    retry.min_concurrency = options.adaptive_concurrency_min;
+    retry_policy = std::make_unique<RetryPolicy>(retry);
+    async_loop = std::make_unique<AsyncLoop>(*pool, bandwidth, *retry_policy, options.async_max_connections);
+
+    while (!this->options.api_base_url.empty() && this->options.api_base_url.back() == '/') {
+        this->options.api_base_url.pop_back();
+    }
+    if (options.enable_metrics || options.on_request) {
+        metrics = std::make_unique<Metrics>(this->options.api_base_url, options.enable_metrics,
+                                            spanObserver(options.on_request));
+        pool->setMetrics(metrics.get());
+    }
+}
+
+YandexDiskClient::~YandexDiskClient() = default;
+YandexDiskClient::YandexDiskClient(YandexDiskClient&&) noexcept = default;
+YandexDiskClient& YandexDiskClient::operator=(YandexDiskClient&&) noexcept = default;
+
+YandexDiskClient::ConnectionStats YandexDiskClient::connectionStats() const {
+    CurlPool::Stats s = pool->stats();
+    ConnectionStats stats;
+    stats.requests = s.requests;
+    stats.connections_opened = s.connections_opened;
+    stats.handles_created = s.handles_created;
+    return stats;
+}
+
+YandexDiskClient::RetryStats YandexDiskClient::retryStats() const {
+    RetryPolicy::Stats s = retry_policy->stats();
+    RetryStats stats;
+    stats.attempts = s.attempts;
+    stats.retries = s.retries;
+    stats.throttled = s.throttled;
+    stats.retry_after_waits = s.retry_after_waits;
+    stats.exhausted = s.exhausted;
+    stats.concurrency_decreases = s.concurrency_decreases;
+    stats.concurrency_limit = s.concurrency_limit;
+    return stats;
+}
+
+void YandexDiskClient::setBandwidthLimits(uint64_t upload_bytes_per_second, uint64_t download_bytes_per_second) {
+    bandwidth->setLimits(upload_bytes_per_second, download_bytes_per_second);
+}
+
+YandexDiskClient::MetadataCacheStats YandexDiskClient::metadataCacheStats() const {
+    MetadataCacheStats stats;
+    if (!metadata_cache) return stats;
+    MetadataCache::Stats s = metadata_cache->stats();
+    stats.hits = s.hits;
+    stats.misses = s.misses;
+    stats.revalidations = s.revalidations;
+    stats.evictions = s.evictions;
+    stats.invalidations = s.invalidations;
+    stats.entries = s.entries;
+    stats.bytes = s.bytes;
+    return stats;
+}
+
+void YandexDiskClient::clearMetadataCache() {
+    if (metadata_cache) metadata_cache->clear();
+}
+
+std::string YandexDiskClient::apiUrl(const std::string& suffix) const {
+    return options.api_base_url + suffix;
+}
 
 std::string YandexDiskClient::buildUrl(
         const std::string& endpoint,
         const std::map<std::string, std::string>& params
 ) {
-    CURL* curl = curl_easy_init();
-    if (!curl) throw std::runtime_error("curl_easy_init() failed");
-
-    std::string url = endpoint;
-    bool first = true;
-    for (const auto& [key, value] : params) {
-        char* escaped = curl_easy_escape(curl, value.c_str(), 0);
-        if (!escaped) {
-            curl_easy_cleanup(curl);
-            throw std::runtime_error("curl_easy_escape() failed");
-        }
-        url += (first ? "?" : "&");
-        url += key + "=" + escaped;
-        curl_free(escaped);
-        first = false;
-    }
-    curl_easy_cleanup(curl);
-    return url;
+    return QueryString::build(endpoint, params);
 }
 
 std::string YandexDiskClient::buildUrl(
@@ -44,19 +309,11 @@ std::string YandexDiskClient::buildUrl(
         const std::string& path,
         const std::string& extraParams
 ) {
-    CURL* curl = curl_easy_init();
-    if (!curl) throw std::runtime_error("curl_easy_init() failed");
-
-    char* escaped = curl_easy_escape(curl, path.c_str(), 0);
-    if (!escaped) {
-        curl_easy_cleanup(curl);
-        throw std::runtime_error("curl_easy_escape() failed");
-    }
-
-    std::string url = endpoint + escaped + extraParams;
-    curl_free(escaped);
-    curl_easy_cleanup(curl);
-
+    std::string url;
+    url.reserve(endpoint.size() + path.size() * 3 + extraParams.size());
+    url += endpoint;
+    QueryString::appendEscaped(url, path);
+    url += extraParams;
     return url;
 }
 
@@ -69,7 +326,15 @@ std::string YandexDiskClient::getLinkByKey(
 ) {
     std::string url = buildUrl(endpoint, path, extraParams);
     std::string resp = performRequest(url);
-    auto json = nlohmann::json::parse(resp);
+    return linkFromResponse(resp, key, errorMsg);
+}
+
+std::string YandexDiskClient::linkFromResponse(
+        const std::string& response,
+        const std::string& key,
+        const std::string& errorMsg
+) {
+    auto json = nlohmann::json::parse(response);
 
     if (json.contains(key) && !json[key].is_null())
         return json[key].get<std::string>();
@@ -84,42 +349,128 @@ std::string YandexDiskClient::performRequest(
         const std::string& method /* = "GET" */,
         long* http_code /* = nullptr */)
 {
-    CURL* curl = curl_easy_init();
     std::string response;
-    if (!curl) throw std::runtime_error("curl_easy_init() failed");
+    long code = 0;
+    CURLcode res = CURLE_OK;
+
+    for (int attempt = 1;; ++attempt) {
+        long retry_after = 0;
+        response.clear();
+        code = 0;
+        RetryPolicy::Slot slot(*retry_policy);
+        {
+            CurlPool::Handle handle = pool->acquire();
+            res = performOnce(handle.get(), token, url, method, response);
+            pool->recordTransfer(handle.get(), res, attempt);
+            curl_easy_getinfo(handle.get(), CURLINFO_RESPONSE_CODE, &code);
+            curl_off_t wait = 0;
+            if (curl_easy_getinfo(handle.get(), CURLINFO_RETRY_AFTER, &wait) == CURLE_OK) {
+                retry_after = static_cast<long>(wait);
+            }
+        }
+        slot.release(code);
 
-    struct curl_slist* headers = nullptr;
-    headers = curl_slist_append(headers, ("Authorization: OAuth " + token).c_str());
+        RetryPolicy::Clock::duration delay{};
+        if (!retry_policy->shouldRetry(method, res, code, retry_after, attempt, delay)) break;
+        std::this_thread::sleep_for(delay);
+    }
+    if (http_code) *http_code = code;
 
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
+    // An upload link is only requested right before the file changes.
+    if (method != "GET" || url.find("/resources/upload?") != std::string::npos) {
+        noteChange(metadata_cache.get(), remote_index.get(), url, method, res == CURLE_OK && code < 300);
+    }
 
-    if (method == "PUT") {
-        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "PUT");
-    } else if (method == "DELETE") {
-        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "DELETE");
-        curl_easy_setopt(curl, CURLOPT_NOBODY, 0L);
-    } else if (method == "POST") {
-        curl_easy_setopt(curl, CURLOPT_POST, 1L);
+    if (res != CURLE_OK) throw std::runtime_error(curl_easy_strerror(res));
+    return response;
+}
+
+void YandexDiskClient::noteChange(
+        MetadataCache* cache,
+        RemoteIndex* index,
+        const std::string& url,
+        const std::string& method,
+        bool succeeded)
+{
+    // The cache is dropped even after a failure: the change may have
+    // happened anyway.
+    if (cache) cache->invalidateRequest(url);
+    if (index && succeeded) index->applyRequest(url, method);
+}
+
+std::string YandexDiskClient::cachedRequest(
+        const std::string& url,
+        const std::string& disk_path,
+        long* http_code /* = nullptr */)
+{
+    if (!metadata_cache) return performRequest(url, "GET", http_code);
+
+    using Clock = MetadataCache::Clock;
+    uint64_t revision = MetadataCache::kNoRevision;
+    Clock::time_point checked;
+
+    // Asks the API for the current disk revision.
+    auto checkRevision = [&] {
+        checked = Clock::now();
+        long code = 0;
+        std::string resp = performRequest(UrlBuilder(options.api_base_url).param("fields", "revision").url(), "GET", &code);
+        auto json = nlohmann::json::parse(resp, nullptr, false);
+        if (code != 200 || !json.is_object() || !json.contains("revision")) return false;
+        revision = json["revision"].get<uint64_t>();
+        metadata_cache->setRevision(revision, checked);
+        return true;
+    };
+
+    MetadataCache::Entry entry;
+    MetadataCache::State state = metadata_cache->find(url, entry);
+
+    if (state == MetadataCache::State::Fresh) {
+        if (http_code) *http_code = entry.http_code;
+        return entry.body;
     }
 
-    CURLcode res = curl_easy_perform(curl);
+    if (state == MetadataCache::State::Expired) {
+        if (options.metadata_cache_revalidate && entry.revision != MetadataCache::kNoRevision) {
+            // One revision check, made after the entry was stored, confirms
+            // every entry fetched under the same revision.
+            bool known = metadata_cache->revision(revision, checked) &&
+                         checked > entry.stored && Clock::now() - checked < metadata_cache->ttl();
+            if (known || checkRevision()) {
+                if (revision == entry.revision) {
+                    metadata_cache->revalidated(url, checked);
+                    if (http_code) *http_code = entry.http_code;
+                    return entry.body;
+                }
+            }
+        }
+        metadata_cache->expiredMiss();
+    }
+
+    // The revision known before the fetch; if it still holds later, nothing
+    // has changed since this response was produced. Without one yet, entries
+    // could never be revalidated, so the first miss asks for it.
+    if (!metadata_cache->revision(revision, checked) &&
+        !(options.metadata_cache_revalidate && checkRevision())) {
+        revision = MetadataCache::kNoRevision;
+    }
 
     long code = 0;
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &code);
+    std::string resp = performRequest(url, "GET", &code);
     if (http_code) *http_code = code;
-
-    curl_slist_free_all(headers);
-    curl_easy_cleanup(curl);
-
-    if (res != CURLE_OK) throw std::runtime_error(curl_easy_strerror(res));
-    return response;
+    if (code == 200 || code == 404) {
+        MetadataCache::Entry fetched;
+        fetched.http_code = code;
+        fetched.body = resp;
+        fetched.path = disk_path;
+        fetched.revision = revision;
+        fetched.stored = Clock::now();
+        metadata_cache->store(url, std::move(fetched));
+    }
+    return resp;
 }
 
 nlohmann::json YandexDiskClient::getQuotaInfo() {
-    std::string url = buildUrl("https://cloud-api.yandex.net/v1/disk", {});
+    std::string url = buildUrl(apiUrl(""), {});
     std::string resp = performRequest(url, "GET");
     checkApiError(resp);
     return nlohmann::json::parse(resp);
@@ -147,15 +498,150 @@ std::string YandexDiskClient::formatQuotaInfo(const nlohmann::json& quota) {
 }
 
 nlohmann::json YandexDiskClient::getResourceList(const std::string& disk_path /* = "/" */) {
-    std::string url = buildUrl(
-            "https://cloud-api.yandex.net/v1/disk/resources?path=",
-            disk_path,
-            ""
-    );
-    std::string resp = performRequest(url);
+    UrlBuilder url(options.api_base_url, "/resources");
+    url.param("path", disk_path);
+    std::string resp = cachedRequest(url.url(), disk_path);
     return nlohmann::json::parse(resp);
 }
 
+std::size_t YandexDiskClient::forEachResource(
+        const std::string& disk_path,
+        const std::function<bool(const nlohmann::json&)>& callback) {
+    return forEachResource(disk_path, callback, ListOptions{});
+}
+
+std::size_t YandexDiskClient::forEachResource(
+        const std::string& disk_path,
+        const std::function<bool(const nlohmann::json&)>& callback,
+        const ListOptions& list) {
+    return forEachListedItem(apiUrl("/resources"), disk_path, callback, list);
+}
+
+std::size_t YandexDiskClient::forEachListedItem(
+        const std::string& endpoint,
+        const std::string& disk_path,
+        const std::function<bool(const nlohmann::json&)>& callback,
+        const ListOptions& list) {
+
+    const std::size_t limit = list.page_size > 0 ? list.page_size : 1000;
+
+    // Item fields are selected inside "_embedded.items"; paging counters are
+    // always requested so the loop knows where the listing ends.
+    std::string fields;
+    if (!list.fields.empty()) fields = ResourceListing::embeddedFields(list.fields);
+
+    auto fetchPage = [this, endpoint, disk_path, limit, fields](std::size_t offset) {
+        UrlBuilder url(endpoint);
+        url.param("path", makeDiskPath(disk_path)).param("limit", limit).param("offset", offset);
+        if (!fields.empty()) url.param("fields", fields);
+
+        std::string resp = performRequest(url.url(), "GET");
+        checkApiError(resp);
+        nlohmann::json page = nlohmann::json::parse(resp);
+        if (!page.contains("_embedded") || !page["_embedded"].contains("items")) {
+            throw std::runtime_error("Not a directory: " + disk_path);
+        }
+        return page;
+    };
+
+    std::size_t visited = 0;
+    std::size_t offset = 0;
+    nlohmann::json page = fetchPage(offset);
+
+    for (;;) {
+        const nlohmann::json& embedded = page["_embedded"];
+        const nlohmann::json& items = embedded["items"];
+        std::size_t count = items.size();
+        const auto total = embedded.find("total");
+        bool has_total = total != embedded.end() && total->is_number_unsigned();
+        bool more = morePages(offset, count, limit, has_total, has_total ? total->get<std::size_t>() : 0);
+
+        std::future<nlohmann::json> next;
+        if (more && list.prefetch) {
+            next = std::async(std::launch::async, fetchPage, offset + count);
+        }
+
+        for (const auto& item : items) {
+            ++visited;
+            if (!callback(item)) return visited;
+        }
+
+        if (!more) break;
+        offset += count;
+        page = list.prefetch ? next.get() : fetchPage(offset);
+    }
+    return visited;
+}
+
+std::size_t YandexDiskClient::forEachResourceEntry(
+        const std::string& disk_path,
+        const std::function<bool(const ResourceEntry&)>& callback) {
+    return forEachResourceEntry(disk_path, callback, ListOptions{});
+}
+
+std::size_t YandexDiskClient::forEachResourceEntry(
+        const std::string& disk_path,
+        const std::function<bool(const ResourceEntry&)>& callback,
+        const ListOptions& list) {
+    return forEachListedEntry(apiUrl("/resources"), disk_path, callback, list);
+}
+
+std::size_t YandexDiskClient::forEachListedEntry(
+        const std::string& endpoint,
+        const std::string& disk_path,
+        const std::function<bool(const ResourceEntry&)>& callback,
+        const ListOptions& list) {
+
+    const std::size_t limit = list.page_size > 0 ? list.page_size : 1000;
+    const std::string fields = ResourceListing::embeddedFields(list.fields.empty() ? kEntryFields : list.fields);
+
+    auto fetchPage = [this, endpoint, disk_path, limit, fields](std::size_t offset) {
+        UrlBuilder url(endpoint);
+        url.param("path", makeDiskPath(disk_path))
+                .param("limit", limit)
+                .param("offset", offset)
+                .param("fields", fields);
+
+        std::string resp = performRequest(url.url(), "GET");
+        checkApiError(resp);
+        ResourceListing page;
+        if (!page.parse(resp)) throw std::runtime_error("Not a directory: " + disk_path);
+        return page;
+    };
+
+    std::size_t visited = 0;
+    std::size_t offset = 0;
+    ResourceListing page = fetchPage(offset);
+
+    for (;;) {
+        const std::size_t count = page.items().size();
+        bool more = morePages(offset, count, limit, page.hasTotal(), page.total());
+
+        std::future<ResourceListing> next;
+        if (more && list.prefetch) {
+            next = std::async(std::launch::async, fetchPage, offset + count);
+        }
+
+        ResourceEntry entry;
+        for (const ResourceListing::Item& item : page.items()) {
+            entry.name = item.name;
+            entry.path = item.path;
+            entry.type = item.type;
+            entry.md5 = item.md5;
+            entry.modified = item.modified;
+            entry.mime_type = item.mime_type;
+            entry.size = item.size;
+            ++visited;
+            if (!callback(entry)) return visited;
+        }
+
+        if (!more) break;
+        offset += count;
+        page = list.prefetch ? next.get() : fetchPage(offset);
+    }
+    return visited;
+}
+
 std::string YandexDiskClient::formatResourceList(const nlohmann::json& json) {
     std::ostringstream oss;
     int idx = 1;
@@ -174,14 +660,10 @@ std::string YandexDiskClient::formatResourceList(const nlohmann::json& json) {
 
 std::string YandexDiskClient::getResourceInfo(const std::string& disk_path) {
 
-    std::map<std::string, std::string> params = {
-            {"path", makeDiskPath(disk_path)}
-    };
-    std::string url = buildUrl(
-            "https://cloud-api.yandex.net/v1/disk/resources",
-            params);
+    UrlBuilder url(options.api_base_url, "/resources");
+    url.param("path", makeDiskPath(disk_path));
 
-    std::string resp = performRequest(url, "GET");
+    std::string resp = cachedRequest(url.url(), disk_path);
     checkApiError(resp);
 
     nlohmann::json info = nlohmann::json::parse(resp);
@@ -214,7 +696,7 @@ std::string YandexDiskClient::getResourceInfo(const std::string& disk_path) {
 
 bool YandexDiskClient::publish(const std::string& path) {
     std::string url = buildUrl(
-            "https://cloud-api.yandex.net/v1/disk/resources/publish?path=",
+            apiUrl("/resources/publish?path="),
             path,
             ""
     );
@@ -226,16 +708,10 @@ bool YandexDiskClient::publish(const std::string& path) {
 
 bool YandexDiskClient::unpublish(const std::string& disk_path) {
 
-    std::map<std::string, std::string> params = {
-            {"path", makeDiskPath(disk_path)}
-    };
-
-    std::string url = buildUrl(
-            "https://cloud-api.yandex.net/v1/disk/resources/unpublish",
-            params
-            );
+    UrlBuilder url(options.api_base_url, "/resources/unpublish");
+    url.param("path", makeDiskPath(disk_path));
 
-    std::string resp = performRequest(url, "PUT");
+    std::string resp = performRequest(url.url(), "PUT");
     checkApiError(resp);
 
     return true;
@@ -244,7 +720,7 @@ bool YandexDiskClient::unpublish(const std::string& disk_path) {
 std::string YandexDiskClient::getPublicDownloadLink(const std::string& disk_path) {
     return getLinkByKey(
             disk_path,
-            "https://cloud-api.yandex.net/v1/disk/resources?path=",
+            apiUrl("/resources?path="),
             "public_url",
             "",
             "The file or directory has not been published! "
@@ -255,7 +731,7 @@ std::string YandexDiskClient::getPublicDownloadLink(const std::string& disk_path
 std::string YandexDiskClient::getUploadUrl(const std::string& upload_disk_path) {
     return getLinkByKey(
             upload_disk_path,
-            "https://cloud-api.yandex.net/v1/disk/resources/upload?path=",
+            apiUrl("/resources/upload?path="),
             "href",
             "&overwrite=true",
             "Upload URL not found in API response."
@@ -265,7 +741,7 @@ std::string YandexDiskClient::getUploadUrl(const std::string& upload_disk_path)
 std::string YandexDiskClient::getDownloadUrl(const std::string& download_disk_path) {
     return getLinkByKey(
             download_disk_path,
-            "https://cloud-api.yandex.net/v1/disk/resources/download?path=",
+            apiUrl("/resources/download?path="),
             "href",
             "",
             "Download URL not found in API response."
@@ -328,46 +804,84 @@ bool YandexDiskClient::uploadFile(
         const std::string& disk_dir,
         const std::string& local_path) {
 
-    std::string upload_disk_path = makeUploadDiskPath(disk_dir, local_path);
+    return uploadFileTo(makeUploadDiskPath(disk_dir, local_path), local_path);
+}
 
-    std::string url = getUploadUrl(upload_disk_path);
+bool YandexDiskClient::uploadFileTo(
+        const std::string& upload_disk_path,
+        const std::string& local_path,
+        std::string* md5 /* = nullptr */,
+        BandwidthFlow* flow /* = nullptr */) {
+    // Streamed, not mapped: a file truncated mid-upload (a rotated log, say)
+    // then fails this transfer instead of faulting the process.
+    FileBody body(local_path, false);
+    return uploadBody(upload_disk_path, body, md5, flow);
+}
 
-#if defined(_WIN32)
-    FILE* file = _wfopen(std::filesystem::path(local_path).wstring().c_str(), L"rb");
-#else
-    FILE* file = fopen(local_path.c_str(), "rb");
-#endif
+bool YandexDiskClient::uploadBody(
+        const std::string& upload_disk_path,
+        UploadBody& body,
+        std::string* md5 /* = nullptr */,
+        BandwidthFlow* flow /* = nullptr */) {
 
-    if (!file) {
-        throw std::runtime_error("Couldn't open the file: " + local_path);
-    }
+    std::string url = getUploadUrl(upload_disk_path);
 
-    CURL* curl = curl_easy_init();
-    if (!curl) {
-        fclose(file);
-        throw std::runtime_error("curl_easy_init() failed");
-    }
+    CurlPool::Handle handle = pool->acquire();
+    CURL* curl = handle.get();
+    BandwidthMeter meter(bandwidth, flow);
+    meter.attach(curl);
 
-    fseek(file, 0, SEEK_END);
-    long filesize = ftell(file);
-    fseek(file, 0, SEEK_SET);
+    const uint64_t size = body.size();
+    Md5 hasher;
+    BodyReader reader{&body, md5 ? &hasher : nullptr, {}};
+    curl_slist* headers = nullptr;
 
     curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_UPLOAD, 1L);
-    curl_easy_setopt(curl, CURLOPT_PUT, 1L);
-    curl_easy_setopt(curl, CURLOPT_READDATA, file);
-    curl_easy_setopt(curl, CURLOPT_INFILESIZE_LARGE, (curl_off_t)filesize);
+    curl_easy_setopt(curl, CURLOPT_UPLOAD_BUFFERSIZE, kUploadChunkSize);
+    if (const char* bytes = body.contiguous()) {
+        // The whole body is already in memory: libcurl sends it from there,
+        // with no read callback in between.
+        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "PUT");
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE_LARGE, (curl_off_t)size);
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, bytes);
+        // POSTFIELDS implies a form content type; the upload href wants none.
+        headers = curl_slist_append(headers, "Content-Type:");
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+        if (md5) hasher.update(bytes, static_cast<std::size_t>(size));
+    } else {
+        curl_easy_setopt(curl, CURLOPT_UPLOAD, 1L);
+        // The checksum is computed from the bytes as they are sent.
+        curl_easy_setopt(curl, CURLOPT_READFUNCTION, readBody);
+        curl_easy_setopt(curl, CURLOPT_READDATA, &reader);
+        // An unknown size is sent with chunked transfer encoding.
+        if (size != UploadBody::kUnknownSize) {
+            curl_easy_setopt(curl, CURLOPT_INFILESIZE_LARGE, (curl_off_t)size);
+        }
+    }
+    curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
 
     CURLcode res = curl_easy_perform(curl);
+    pool->recordTransfer(curl, res);
+    curl_slist_free_all(headers);
 
-    fclose(file);
-    curl_easy_cleanup(curl);
+    if (metadata_cache) metadata_cache->invalidate(makeDiskPath(upload_disk_path));
 
+    if (!reader.error.empty()) throw std::runtime_error("File upload error: " + reader.error);
     if (res != CURLE_OK) {
         throw std::runtime_error("File upload error: " +
                                  std::string(curl_easy_strerror(res)));
     }
 
+    if (md5) *md5 = hasher.hexDigest();
+    if (remote_index) {
+        RemoteIndex::Entry entry;
+        entry.path = makeDiskPath(upload_disk_path);
+        curl_off_t sent = 0;
+        curl_easy_getinfo(curl, CURLINFO_SIZE_UPLOAD_T, &sent);
+        entry.size = size != UploadBody::kUnknownSize ? size : static_cast<uint64_t>(sent);
+        if (md5) entry.md5 = *md5;
+        remote_index->upsert(std::move(entry));
+    }
     return true;
 }
 
@@ -376,13 +890,9 @@ bool YandexDiskClient::downloadFile(
         const std::string& local_dir)
 {
 
-    std::map<std::string, std::string> params = {
-            {"path", makeDiskPath(download_disk_path)}
-    };
-    std::string info_url = buildUrl(
-            "https://cloud-api.yandex.net/v1/disk/resources",
-            params);
-    std::string info_resp = performRequest(info_url, "GET");
+    UrlBuilder info_url(options.api_base_url, "/resources");
+    info_url.param("path", makeDiskPath(download_disk_path));
+    std::string info_resp = cachedRequest(info_url.url(), download_disk_path);
     nlohmann::json meta = nlohmann::json::parse(info_resp);
 
     if (meta.value("type", "") == "dir") {
@@ -393,116 +903,176 @@ bool YandexDiskClient::downloadFile(
     std::string local_path = makeLocalDownloadPath(download_disk_path, local_dir);
     std::string url = getDownloadUrl(download_disk_path);
 
-#if defined(_WIN32)
-    FILE* file = _wfopen(std::filesystem::path(local_path).wstring().c_str(), L"wb");
-#else
-    FILE* file = fopen(local_path.c_str(), "wb");
-#endif
+    return downloadHref(url, local_path);
+}
+
+bool YandexDiskClient::downloadHref(
+        const std::string& url,
+        const std::string& local_path,
+        BandwidthFlow* flow /* = nullptr */)
+{
+    CurlPool::Handle handle = pool->acquire();
+    CURL* curl = handle.get();
+    BandwidthMeter meter(bandwidth, flow);
+    meter.attach(curl);
+
+    std::unique_ptr<FILE, int (*)(FILE*)> file(openFile(local_path, "wb"), &fclose);
     if (!file) {
         throw std::runtime_error("Failed to create a file: " + local_path);
     }
 
-    CURL* curl = curl_easy_init();
-    if (!curl) {
-        fclose(file);
-        throw std::runtime_error("curl_easy_init() failed");
-    }
-
     curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, file);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, file.get());
     curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, nullptr);
     curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
 
     CURLcode res = curl_easy_perform(curl);
+    pool->recordTransfer(curl, res);
 
-    fclose(file);
-    curl_easy_cleanup(curl);
+    // fclose flushes the last buffer; a full disk only shows up here.
+    bool closed = fclose(file.release()) == 0;
 
     if (res != CURLE_OK) {
         throw std::runtime_error("File download error: " +
                                  std::string(curl_easy_strerror(res)));
     }
+    if (!closed) {
+        throw std::runtime_error("Failed to write " + local_path);
+    }
 
     return true;
 }
 
-bool YandexDiskClient::uploadDirectory(
-        const std::string& disk_path,
-        const std::string& local_path)
+bool YandexDiskClient::downloadFile(
+        const std::string& download_disk_path,
+        const std::string& local_dir,
+        const std::string& journal_path)
 {
-    namespace fs = std::filesystem;
-
-    if (!fs::exists(local_path) || !fs::is_directory(local_path)) {
-        throw std::runtime_error("Local directory does not exist: " + local_path);
-    }
-
-    fs::path disk_fs(disk_path);
-    fs::path local_fs(local_path);
+    UrlBuilder info_url(options.api_base_url, "/resources");
+    info_url.param("path", makeDiskPath(download_disk_path)).param("fields", "type,size,md5");
+    std::string info_resp = cachedRequest(info_url.url(), download_disk_path);
+    checkApiError(info_resp);
+    nlohmann::json meta = nlohmann::json::parse(info_resp);
 
-    if (disk_fs.empty() || disk_fs == "/" ||
-    !disk_fs.has_filename() ||
-    disk_path.back() == '/' ||
-    disk_path.back() == '\\') {
-        disk_fs /= local_fs.filename();
+    if (meta.value("type", "") == "dir") {
+        throw std::runtime_error("Cannot download: '" +
+        download_disk_path + "' is a directory, not a file.");
     }
 
-    createDirectory(disk_fs.generic_string());
-
-    for (const auto& entry : fs::recursive_directory_iterator(local_fs)) {
-        fs::path rel_path = fs::relative(entry.path(), local_fs);
-        std::string disk_target = (disk_fs / rel_path).generic_string();
-
-        if (entry.is_directory()) {
-            createDirectory(disk_target);
-        } else if (entry.is_regular_file()) {
-            uploadFile(disk_target, entry.path().string());
-        }
-    }
+    std::string local_path = makeLocalDownloadPath(download_disk_path, local_dir);
+    std::string url = getDownloadUrl(download_disk_path);
 
-    return true;
+    TransferJournal journal(journal_path);
+    return downloadHrefResumable(url, local_path,
+                                 "download:" + makeDiskPath(download_disk_path),
+                                 meta.value("size", uint64_t{0}),
+                                 meta.value("md5", ""),
+                                 journal);
 }
 
-bool YandexDiskClient::downloadDirectory(
-        const std::string& disk_path,
-        const std::string& local_path)
+bool YandexDiskClient::downloadHrefResumable(
+        const std::string& url,
+        const std::string& local_path,
+        const std::string& journal_key,
+        uint64_t size,
+        const std::string& md5,
+        TransferJournal& journal,
+        BandwidthFlow* flow /* = nullptr */)
 {
     namespace fs = std::filesystem;
+    std::string part_path = local_path + ".part";
+
+    // Resume only if the journal describes the same remote file and the
+    // partial file still holds at least the checkpointed bytes.
+    uint64_t offset = 0;
+    TransferJournal::Entry previous;
+    if (journal.find(journal_key, previous) && !previous.done &&
+        previous.size == size && previous.md5 == md5) {
+        std::error_code ec;
+        uint64_t on_disk = fs::file_size(part_path, ec);
+        if (!ec && on_disk >= previous.offset) offset = previous.offset;
+    }
 
-    nlohmann::json info = getResourceList(disk_path);
-    if (!info.contains("_embedded") || !info["_embedded"].contains("items")) {
-        throw std::runtime_error("Remote directory does not exist or is not a directory: " +
-        disk_path);
+    ResumeSink sink{nullptr, nullptr, part_path, offset, offset, Md5(), &journal, &journal_key,
+                    TransferJournal::Entry{offset, size, md5, "", false}, false, {}};
+    if (offset > 0) {
+        // Bytes past the checkpoint were never confirmed durable.
+        fs::resize_file(part_path, offset);
+        hashPrefix(sink.md5, part_path, offset);
     }
 
-    fs::path local_fs(local_path);
-    fs::path disk_fs(disk_path);
+    sink.file = openFile(part_path, offset > 0 ? "ab" : "wb");
+    if (!sink.file) {
+        throw std::runtime_error("Failed to create a file: " + part_path);
+    }
 
-    if (!fs::exists(local_fs) || fs::is_directory(local_fs)) {
-        fs::path folder_name = disk_fs.filename();
-        if (folder_name.empty()) {
-            folder_name = disk_fs.parent_path().filename();
-        }
-        local_fs /= folder_name;
-    } else if (fs::exists(local_fs) && !fs::is_directory(local_fs)) {
-        throw std::runtime_error("Local path exists and is not a directory: " +
-        local_path);
+    CURLcode res = CURLE_OK;
+    if (offset < size || size == 0) {
+        CurlPool::Handle handle = pool->acquire();
+        CURL* curl = handle.get();
+        sink.curl = curl;
+        BandwidthMeter meter(bandwidth, flow);
+        meter.attach(curl);
+
+        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeResumable);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &sink);
+        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+        curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
+        // CURLOPT_RANGE rather than RESUME_FROM: libcurl fails a 200 to the
+        // latter before the body arrives, while writeResumable can start over.
+        std::string range = std::to_string(offset) + "-";
+        if (offset > 0) curl_easy_setopt(curl, CURLOPT_RANGE, range.c_str());
+
+        res = curl_easy_perform(curl);
+        pool->recordTransfer(curl, res);
     }
 
-    fs::create_directories(local_fs);
+    // Whatever arrived is kept for the next attempt.
+    bool synced = TransferJournal::syncFile(sink.file);
+    fclose(sink.file);
+    if (synced && sink.written != sink.checkpointed) {
+        sink.entry.offset = sink.written;
+        journal.record(journal_key, sink.entry);
+    }
 
-    for (const auto& item : info["_embedded"]["items"]) {
-        std::string name = item["name"].get<std::string>();
-        std::string type = item["type"].get<std::string>();
-        std::string remote_item_path = item["path"].get<std::string>();
-        fs::path local_item_path = local_fs / name;
+    if (!sink.error.empty()) throw std::runtime_error(sink.error);
+    if (res != CURLE_OK) {
+        throw std::runtime_error("File download error: " +
+                                 std::string(curl_easy_strerror(res)));
+    }
+    if (size > 0 && sink.written != size) {
+        throw std::runtime_error("Incomplete download of " + local_path + ": " +
+                                 std::to_string(sink.written) + " of " + std::to_string(size) + " bytes");
+    }
 
-        if (type == "dir") {
-            downloadDirectory(remote_item_path, local_item_path.string());
-        } else if (type == "file") {
-            downloadFile(remote_item_path, local_item_path.string());
-        }
+    if (!md5.empty() && sink.md5.hexDigest() != md5) {
+        fs::remove(part_path);
+        journal.record(journal_key, TransferJournal::Entry{0, size, md5, "", false});
+        throw std::runtime_error("Checksum mismatch for " + local_path);
     }
 
+    fs::rename(part_path, local_path);
+    journal.record(journal_key, TransferJournal::Entry{size, size, md5, "", true});
+    return true;
+}
+
+bool YandexDiskClient::uploadDirectory(
+        const std::string& disk_path,
+        const std::string& local_path)
+{
+    TransferReport report = uploadDirectory(disk_path, local_path, TransferOptions{});
+    throwOnTransferErrors(report);
+    return true;
+}
+
+bool YandexDiskClient::downloadDirectory(
+        const std::string& disk_path,
+        const std::string& local_path)
+{
+    TransferReport report = downloadDirectory(disk_path, local_path, TransferOptions{});
+    throwOnTransferErrors(report);
     return true;
 }
 
@@ -511,7 +1081,7 @@ bool YandexDiskClient::deleteFileOrDir(const std::string& disk_path) {
     std::string utf8_disk_path = makeDiskPath(disk_path);
 
     std::string url = buildUrl(
-            "https://cloud-api.yandex.net/v1/disk/resources?path=",
+            apiUrl("/resources?path="),
             utf8_disk_path,
             ""
             );
@@ -527,7 +1097,7 @@ bool YandexDiskClient::createDirectory(const std::string& disk_path) {
     std::string utf8_disk_path = makeDiskPath(disk_path);
 
     std::string url = buildUrl(
-            "https://cloud-api.yandex.net/v1/disk/resources?path=",
+            apiUrl("/resources?path="),
             utf8_disk_path,
             ""
     );
@@ -538,6 +1108,27 @@ bool YandexDiskClient::createDirectory(const std::string& disk_path) {
     return true;
 }
 
+bool YandexDiskClient::ensureDirectory(const std::string& disk_path) {
+    std::string url = buildUrl(
+            apiUrl("/resources?path="),
+            makeDiskPath(disk_path),
+            ""
+    );
+
+    long http_code = 0;
+    std::string resp = performRequest(url, "PUT", &http_code);
+    if (http_code == 409) {
+        auto json = nlohmann::json::parse(resp, nullptr, false);
+        if (json.is_object() &&
+            json.value("error", "") == "DiskPathPointsToExistentDirectoryError") {
+            return false;
+        }
+    }
+    checkApiError(resp);
+
+    return true;
+}
+
 void YandexDiskClient::checkApiError(const std::string& response) {
     auto json = nlohmann::json::parse(response, nullptr, false);
     if(json.is_object() && json.contains("error")) {
@@ -554,6 +1145,35 @@ bool YandexDiskClient::moveFileOrDir(
         const std::string& from_path,
         const std::string& to_path,
         bool overwrite /* = false */
+) {
+    return relocateResource(apiUrl("/resources/move"), from_path, to_path, overwrite);
+}
+
+bool YandexDiskClient::copyFileOrDir(
+        const std::string& from_path,
+        const std::string& to_path,
+        bool overwrite /* = false */
+) {
+    return relocateResource(apiUrl("/resources/copy"), from_path, to_path, overwrite);
+}
+
+bool YandexDiskClient::relocateResource(
+        const std::string& endpoint,
+        const std::string& from_path,
+        const std::string& to_path,
+        bool overwrite
+) {
+    std::string resp = performRequest(relocationUrl(endpoint, from_path, to_path, overwrite), "POST");
+    checkApiError(resp);
+
+    return true;
+}
+
+std::string YandexDiskClient::relocationUrl(
+        const std::string& endpoint,
+        const std::string& from_path,
+        const std::string& to_path,
+        bool overwrite
 ) {
     std::filesystem::path from_fs(from_path);
     std::filesystem::path to_fs(to_path);
@@ -567,20 +1187,13 @@ bool YandexDiskClient::moveFileOrDir(
     std::string from_utf8 = makeDiskPath(from_fs.string());
     std::string to_utf8 = makeDiskPath(to_fs.string());
 
-    std::map<std::string, std::string> params = {
-            {"from", from_utf8},
-            {"path", to_utf8}
-    };
+    UrlBuilder url(endpoint);
+    url.param("from", from_utf8).param("path", to_utf8);
     if (overwrite) {
-        params["overwrite"] = "true";
+        url.param("overwrite", "true");
     }
 
-    std::string url = buildUrl("https://cloud-api.yandex.net/v1/disk/resources/move", params);
-
-    std::string resp = performRequest(url, "POST");
-    checkApiError(resp);
-
-    return true;
+    return url.url();
 }
 
 bool YandexDiskClient::renameFileOrDir(
@@ -595,16 +1208,16 @@ bool YandexDiskClient::renameFileOrDir(
 
 bool YandexDiskClient::exists(const std::string& disk_path) {
     try {
-        std::map<std::string, std::string> params = {
-                {"path", makeDiskPath(disk_path)}
-        };
-        std::string url = buildUrl(
-                "https://cloud-api.yandex.net/v1/disk/resources",
-                params
-        );
+        UrlBuilder url(options.api_base_url, "/resources");
+        url.param("path", makeDiskPath(disk_path));
+
+        // The index cannot tell an unknown path from a missing one (empty
+        // directories made elsewhere are not in it), so only hits are final.
+        RemoteIndex::Entry indexed;
+        if (remote_index && remote_index->lookup(makeDiskPath(disk_path), indexed)) return true;
 
         long http_code = 0;
-        std::string resp = performRequest(url, "GET", &http_code);
+        std::string resp = cachedRequest(url.url(), disk_path, &http_code);
 
         return http_code == 200;
     } catch (const std::exception& ex) {
@@ -613,14 +1226,9 @@ bool YandexDiskClient::exists(const std::string& disk_path) {
 }
 
 nlohmann::json YandexDiskClient::getTrashResourceList(const std::string& trash_path /* = "trash:/" */) {
-    std::map<std::string, std::string> params = {
-            {"path", makeDiskPath(trash_path)}
-    };
-    std::string url = buildUrl(
-            "https://cloud-api.yandex.net/v1/disk/trash/resources",
-            params
-    );
-    std::string resp = performRequest(url, "GET");
+    UrlBuilder url(options.api_base_url, "/trash/resources");
+    url.param("path", makeDiskPath(trash_path));
+    std::string resp = performRequest(url.url(), "GET");
     checkApiError(resp);
     return nlohmann::json::parse(resp);
 }
@@ -658,100 +1266,53 @@ std::string YandexDiskClient::formatTrashResourceList(const nlohmann::json& json
 }
 
 bool YandexDiskClient::restoreFromTrash(const std::string& trash_path) {
-    std::map<std::string, std::string> params = {
-            {"path", makeDiskPath(trash_path)}
-    };
-    std::string url = buildUrl(
-            "https://cloud-api.yandex.net/v1/disk/trash/resources/restore",
-            params
-    );
-    std::string resp = performRequest(url, "PUT");
+    UrlBuilder url(options.api_base_url, "/trash/resources/restore");
+    url.param("path", makeDiskPath(trash_path));
+    std::string resp = performRequest(url.url(), "PUT");
     checkApiError(resp);
     return true;
 }
 
 bool YandexDiskClient::deleteFromTrash(const std::string& trash_path) {
-    std::map<std::string, std::string> params = {
-            {"path", makeDiskPath(trash_path)}
-    };
-    std::string url = buildUrl(
-            "https://cloud-api.yandex.net/v1/disk/trash/resources",
-            params
-    );
-    std::string resp = performRequest(url, "DELETE");
+    UrlBuilder url(options.api_base_url, "/trash/resources");
+    url.param("path", makeDiskPath(trash_path));
+    std::string resp = performRequest(url.url(), "DELETE");
     checkApiError(resp);
     return true;
 }
 
 bool YandexDiskClient::emptyTrash() {
-    std::string url = "https://cloud-api.yandex.net/v1/disk/trash/resources?path=";
+    std::string url = apiUrl("/trash/resources?path=");
     std::string resp = performRequest(url, "DELETE");
     checkApiError(resp);
     return true;
 }
 
-std::vector<std::string> YandexDiskClient::findPathsByName(
-        const std::string& name,
-        const std::string& start_path,
-        std::function<nlohmann::json(const std::string&)> listFunc,
-        bool recursive /* = true */)
-{
-    std::vector<std::string> results;
-    nlohmann::json resList = listFunc(start_path);
-    if (resList.contains("_embedded") && resList["_embedded"].contains("items")) {
-        for (const auto& item : resList["_embedded"]["items"]) {
-            if (item.value("name", "") == name) {
-                results.push_back(item.value("path", ""));
-            }
-            if (recursive && item.value("type", "") == "dir") {
-                auto subResults = findPathsByName(
-                        name,
-                        item.value("path", ""),
-                        listFunc,
-                        recursive);
-                results.insert(
-                        results.end(),
-                        subResults.begin(),
-                        subResults.end());
-            }
-        }
-    }
-    return results;
-}
-
 std::vector<std::string> YandexDiskClient::findTrashPathByName(const std::string& name) {
-    auto listTrash =
-            [this](const std::string& path) -> nlohmann::json {
-        return getTrashResourceList(path);
-    };
+    SearchOptions search;
+    search.name = name;
+    search.recursive = false;
 
-    return findPathsByName(name, "/", listTrash, false);
+    std::vector<std::string> results;
+    searchListing(apiUrl("/trash/resources"), "/", search, [&](const nlohmann::json& item) {
+        results.push_back(item.value("path", ""));
+        return true;
+    });
+    return results;
 }
 
 std::vector<std::string> YandexDiskClient::findResourcePathByName(
         const std::string& name,
         const std::string& start_path /* = "/" */) {
-    auto listDisk =
-            [this](const std::string& path) -> nlohmann::json {
-        return getResourceList(path);
-    };
+    // Not answered from the remote index: it misses empty directories made
+    // elsewhere and keeps items deleted elsewhere (see findIndexedPathsByName).
+    SearchOptions search;
+    search.name = name;
 
-    return findPathsByName(
-            name,
-            start_path.empty() ? "/" : start_path,
-            listDisk,
-            true);
+    std::vector<std::string> results;
+    searchResources(start_path.empty() ? "/" : start_path, search, [&](const nlohmann::json& item) {
+        results.push_back(item.value("path", ""));
+        return true;
+    });
+    return results;
 }
-
-
-
-
-
-
-
-
-
-
-
-
-
@@ -0,0 +1,156 @@
+// Asynchronous API: futures, chained transfers, retries on the loop and
+// shutdown with requests in flight.
+#include "MockDiskFixture.h"
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+    class AsyncApiTest : public MockDiskTest {
+    protected:
+        void SetUp() override {
+            MockDiskTest::SetUp();
+            server.putFile("/dir/a.txt", "alpha");
+        }
+
+        /// The message a failed future throws with (empty if it succeeded).
+        template <typename T>
+        static std::string failure(std::future<T>& future) {
+            try {
+                future.get();
+            } catch (const std::exception& ex) {
+                return ex.what();
+            }
+            return "";
+        }
+    };
+}
+
+TEST_F(AsyncApiTest, EveryCallResolves) {
+    auto quota = client->getQuotaInfoAsync();
+    auto listing = client->getResourceListAsync("/dir");
+    auto found = client->existsAsync("/dir/a.txt");
+    auto missing = client->existsAsync("/dir/none.txt");
+    EXPECT_TRUE(quota.get().contains("total_space"));
+    EXPECT_EQ(listing.get()["_embedded"]["items"].size(), 1u);
+    EXPECT_TRUE(found.get());
+    EXPECT_FALSE(missing.get());
+
+    EXPECT_TRUE(client->createDirectoryAsync("/new").get());
+    EXPECT_TRUE(client->copyFileOrDirAsync("/dir/a.txt", "/new/copy.txt").get());
+    EXPECT_TRUE(client->moveFileOrDirAsync("/new/copy.txt", "/new/moved.txt").get());
+    EXPECT_TRUE(client->publishAsync("/new/moved.txt").get());
+    EXPECT_TRUE(client->unpublishAsync("/new/moved.txt").get());
+    EXPECT_EQ(server.fileContent("/new/moved.txt"), "alpha");
+    EXPECT_FALSE(server.contains("/new/copy.txt"));
+    EXPECT_TRUE(client->deleteFileOrDirAsync("/new").get());
+    EXPECT_FALSE(server.contains("/new"));
+
+    // API errors surface as exceptions from get().
+    auto existing = client->createDirectoryAsync("/dir");
+    auto gone = client->deleteFileOrDirAsync("/missing");
+    auto busy = client->moveFileOrDirAsync("/dir/a.txt", "/dir/a.txt");
+    EXPECT_THROW(existing.get(), std::runtime_error);
+    EXPECT_THROW(gone.get(), std::runtime_error);
+    EXPECT_THROW(busy.get(), std::runtime_error);
+}
+
+TEST_F(AsyncApiTest, ChainedUploadsAndDownloadsComplete) {
+    server.makeDirectory("/up");
+    std::filesystem::create_directories(local("down"));
+    std::vector<std::future<bool>> uploads;
+    for (int i = 0; i < 8; ++i) {
+        std::string name = "file" + std::to_string(i) + ".bin";
+        writeFile(local("src/" + name), pattern(100000 + i * 7919, i + 1));
+        uploads.push_back(client->uploadFileAsync("/up", local("src/" + name)));
+    }
+    for (auto& upload : uploads) EXPECT_TRUE(upload.get());
+
+    std::vector<std::future<bool>> downloads;
+    for (int i = 0; i < 8; ++i) {
+        std::string name = "file" + std::to_string(i) + ".bin";
+        EXPECT_TRUE(server.fileContent("/up/" + name) == pattern(100000 + i * 7919, i + 1)) << name;
+        downloads.push_back(client->downloadFileAsync("/up/" + name, local("down")));
+    }
+    for (auto& download : downloads) EXPECT_TRUE(download.get());
+    for (int i = 0; i < 8; ++i) {
+        std::string name = "file" + std::to_string(i) + ".bin";
+        EXPECT_TRUE(readFile(local("down/" + name)) == pattern(100000 + i * 7919, i + 1)) << name;
+    }
+
+    auto directory = client->downloadFileAsync("/up", local("down"));
+    auto missing = client->downloadFileAsync("/up/none.bin", local("down"));
+    auto no_source = client->uploadFileAsync("/up", local("src/none.bin"));
+    EXPECT_NE(failure(directory).find("is a directory"), std::string::npos);
+    EXPECT_THROW(missing.get(), std::runtime_error);
+    EXPECT_THROW(no_source.get(), std::runtime_error);
+}
+
+TEST_F(AsyncApiTest, ThrottledRequestsAreRetriedOnTheLoop) {
+    // API requests only: file bodies are not retried, here or in the blocking calls.
+    YandexDiskClient::Options opts = options();
+    opts.retry_max_attempts = 12;
+    opts.retry_base_delay_ms = 1;
+    opts.retry_max_delay_ms = 5;
+    client = std::make_unique<YandexDiskClient>("test-token", opts);
+
+    for (int status : {429, 503}) {
+        MockServerConfig config = server.config();
+        config.error_rate = 0.4;
+        config.error_status = status;
+        server.setConfig(config);
+        server.resetStats();
+        YandexDiskClient::RetryStats before = client->retryStats();
+
+        std::vector<std::future<bool>> checks;
+        std::vector<std::future<nlohmann::json>> listings;
+        for (int i = 0; i < 20; ++i) {
+            checks.push_back(client->existsAsync("/dir/a.txt"));
+            listings.push_back(client->getResourceListAsync("/dir"));
+        }
+        auto created = client->createDirectoryAsync("/made" + std::to_string(status));
+
+        for (auto& check : checks) EXPECT_TRUE(check.get()) << status;
+        for (auto& listing : listings) EXPECT_EQ(listing.get()["path"], "disk:/dir") << status;
+        EXPECT_TRUE(created.get()) << status;
+
+        YandexDiskClient::RetryStats after = client->retryStats();
+        EXPECT_GT(server.stats().injected_errors, 0u) << status;
+        EXPECT_GE(after.retries - before.retries, server.stats().injected_errors) << status;
+        EXPECT_GE(after.throttled - before.throttled, server.stats().injected_errors) << status;
+        EXPECT_EQ(after.exhausted, 0u) << status;
+    }
+    EXPECT_TRUE(server.contains("/made429"));
+    EXPECT_TRUE(server.contains("/made503"));
+}
+
+TEST_F(AsyncApiTest, DestroyingTheClientFailsEveryPendingFuture) {
+    MockServerConfig config = server.config();
+    config.latency = std::chrono::milliseconds(3000);
+    server.setConfig(config);
+    writeFile(local("up.bin"), "payload");
+
+    std::vector<std::future<bool>> flags;
+    flags.push_back(client->existsAsync("/dir/a.txt"));
+    flags.push_back(client->createDirectoryAsync("/new"));
+    flags.push_back(client->deleteFileOrDirAsync("/dir/a.txt"));
+    flags.push_back(client->uploadFileAsync("/dir", local("up.bin")));
+    flags.push_back(client->downloadFileAsync("/dir/a.txt", local("")));
+    auto listing = client->getResourceListAsync("/dir");
+    auto quota = client->getQuotaInfoAsync();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    auto start = std::chrono::steady_clock::now();
+    client.reset();
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(2000));
+
+    for (auto& flag : flags) {
+        ASSERT_EQ(flag.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+        EXPECT_NE(failure(flag).find("shutting down"), std::string::npos);
+    }
+    EXPECT_NE(failure(listing).find("shutting down"), std::string::npos);
+    EXPECT_NE(failure(quota).find("shutting down"), std::string::npos);
+    EXPECT_FALSE(std::filesystem::exists(local("a.txt")));
+}
@@ -0,0 +1,126 @@
+// Bandwidth budget: pacing, weighted and prioritized flows, live changes.
+#include "MockDiskFixture.h"
+#include <chrono>
+#include <functional>
+#include <thread>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    constexpr uint64_t kRate = 1024 * 1024;
+
+    class BandwidthTest : public MockDiskTest {
+    protected:
+        void limitedClient(uint64_t upload, uint64_t download) {
+            YandexDiskClient::Options opts = options();
+            opts.upload_bytes_per_second = upload;
+            opts.download_bytes_per_second = download;
+            client = std::make_unique<YandexDiskClient>("test-token", opts);
+        }
+
+        static double seconds(const std::function<void()>& run) {
+            auto start = Clock::now();
+            run();
+            return std::chrono::duration<double>(Clock::now() - start).count();
+        }
+
+        void download(const std::string& path, std::size_t size) {
+            std::string buffer(size, '\0');
+            EXPECT_EQ(client->downloadFile(path, YandexDiskClient::DownloadSink::memory(&buffer[0], size)), size);
+            EXPECT_TRUE(buffer == server.fileContent(path));
+        }
+
+        /// Two directories of 1 MiB each, downloaded at once with the given
+        /// shares; returns when each finished.
+        std::pair<double, double> race(YandexDiskClient::BandwidthShare first,
+                                       YandexDiskClient::BandwidthShare second) {
+            for (const char* dir : {"/first", "/second"}) {
+                for (int i = 0; i < 4; ++i) {
+                    server.putFile(std::string(dir) + "/" + std::to_string(i), pattern(kRate / 4, i));
+                }
+            }
+            // Paced at the sender too, so bodies arrive in pieces rather than
+            // landing in the socket buffer at once and being read in one go.
+            MockServerConfig config = server.config();
+            config.bandwidth_bytes_per_sec = 8 * kRate;
+            server.setConfig(config);
+
+            auto start = Clock::now();
+            auto run = [&](const std::string& dir, YandexDiskClient::BandwidthShare share, double& done) {
+                YandexDiskClient::TransferOptions transfer;
+                transfer.workers = 2;
+                transfer.bandwidth = share;
+                EXPECT_EQ(client->downloadDirectory(dir, local("out"), transfer).files_failed, 0u);
+                done = std::chrono::duration<double>(Clock::now() - start).count();
+            };
+            double first_done = 0, second_done = 0;
+            std::thread other([&] { run("/second", second, second_done); });
+            run("/first", first, first_done);
+            other.join();
+            return {first_done, second_done};
+        }
+    };
+}
+
+TEST_F(BandwidthTest, LimitedTransfersStayNearTheRate) {
+    limitedClient(kRate, kRate);
+    const std::size_t size = kRate * 3 / 2;
+    server.putFile("/big.bin", pattern(size));
+
+    double down = seconds([&] { download("/big.bin", size); });
+    EXPECT_GT(down, 1.2);
+    EXPECT_LT(down, 2.5);
+
+    std::string data = pattern(size, 2);
+    double up = seconds([&] {
+        EXPECT_TRUE(client->uploadFile("/up.bin", YandexDiskClient::UploadSource::memory(data.data(), size)));
+    });
+    EXPECT_GT(up, 1.2);
+    EXPECT_LT(up, 2.5);
+    EXPECT_TRUE(server.fileContent("/up.bin") == data);
+}
+
+TEST_F(BandwidthTest, WeightedFlowsSplitTheRate) {
+    limitedClient(0, kRate);
+    // At 3:1 the heavy flow ends after about 1.33 s and the light one after
+    // about 2 s; equal shares would end both at about 2 s.
+    auto [heavy, light] = race({0, 3}, {0, 1});
+    EXPECT_GT(light, 1.6);
+    EXPECT_LT(heavy, light * 0.8);
+    EXPECT_GT(heavy, light * 0.5);
+}
+
+TEST_F(BandwidthTest, HigherPriorityPreemptsLower) {
+    limitedClient(0, kRate);
+    // The high flow gets the whole rate (about 1 s); the low one waits and
+    // ends after about 2 s.
+    auto [high, low] = race({1, 1}, {0, 1});
+    EXPECT_GT(low, 1.6);
+    EXPECT_LT(high, low * 0.65);
+}
+
+TEST_F(BandwidthTest, LimitChangesTakeEffectMidTransfer) {
+    const std::size_t size = 2 * kRate;
+    server.putFile("/big.bin", pattern(size));
+
+    // Lifted: 8 s at a quarter of the rate, but done soon after the change.
+    limitedClient(0, kRate / 4);
+    std::thread lift([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        client->setBandwidthLimits(0, 0);
+    });
+    double lifted = seconds([&] { download("/big.bin", size); });
+    lift.join();
+    EXPECT_LT(lifted, 1.5);
+
+    // Lowered: under 1 s at 2 MiB/s, but about half of it is left for 512 KiB/s.
+    limitedClient(0, 2 * kRate);
+    std::thread lower([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        client->setBandwidthLimits(0, kRate / 2);
+    });
+    double lowered = seconds([&] { download("/big.bin", size); });
+    lower.join();
+    EXPECT_GT(lowered, 1.5);
+    EXPECT_LT(lowered, 4.0);
+}
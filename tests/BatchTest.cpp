@@ -0,0 +1,104 @@
+// Batch runs and the polling of long-running operations.
+#include "MockDiskFixture.h"
+#include "OperationStatus.h"
+
+namespace {
+    class BatchTest : public MockDiskTest {
+    protected:
+        void SetUp() override {
+            MockDiskTest::SetUp();
+            for (int i = 0; i < 4; ++i) server.putFile("/src/dir" + std::to_string(i) + "/f.txt", "x");
+            server.makeDirectory("/dst");
+        }
+
+        void configure(const std::function<void(MockServerConfig&)>& change) {
+            MockServerConfig config = server.config();
+            config.async_operations = true;
+            config.operation_duration = std::chrono::milliseconds(20);
+            change(config);
+            server.setConfig(config);
+        }
+
+        static std::vector<YandexDiskClient::BatchOperation> moves() {
+            std::vector<YandexDiskClient::BatchOperation> ops;
+            for (int i = 0; i < 4; ++i) {
+                std::string name = "dir" + std::to_string(i);
+                ops.push_back({YandexDiskClient::BatchAction::Move, "/src/" + name, "/dst/" + name});
+            }
+            return ops;
+        }
+
+        static YandexDiskClient::BatchOptions fastPolling() {
+            YandexDiskClient::BatchOptions batch;
+            batch.poll_interval_ms = 1;
+            batch.max_poll_interval_ms = 10;
+            return batch;
+        }
+    };
+}
+
+TEST_F(BatchTest, WaitsForLongRunningOperations) {
+    configure([](MockServerConfig&) {});
+
+    YandexDiskClient::BatchReport report = client->runBatch(moves(), fastPolling());
+
+    EXPECT_TRUE(report.ok());
+    EXPECT_EQ(report.succeeded, 4u);
+    EXPECT_EQ(report.async_operations, 4u);
+    EXPECT_GE(report.status_checks, 4u);
+    for (int i = 0; i < 4; ++i) EXPECT_TRUE(server.contains("/dst/dir" + std::to_string(i) + "/f.txt"));
+}
+
+TEST_F(BatchTest, ReportsFailedOperations) {
+    configure([](MockServerConfig& config) { config.fail_operations = true; });
+
+    YandexDiskClient::BatchReport report = client->runBatch(moves(), fastPolling());
+
+    EXPECT_EQ(report.failed, 4u);
+    for (const auto& result : report.results) EXPECT_EQ(result.error, "Operation failed");
+    EXPECT_TRUE(server.contains("/src/dir0/f.txt"));
+}
+
+TEST_F(BatchTest, RefusedStatusCheckFailsAtOnce) {
+    configure([](MockServerConfig& config) { config.operation_status_error = 403; });
+
+    YandexDiskClient::BatchReport report = client->runBatch(moves(), fastPolling());
+
+    EXPECT_EQ(report.failed, 4u);
+    EXPECT_EQ(report.status_checks, 4u);
+}
+
+TEST_F(BatchTest, FailingStatusChecksGiveUpWithoutTimeout) {
+    configure([](MockServerConfig& config) { config.operation_status_error = 500; });
+    YandexDiskClient::Options options = MockDiskTest::options();
+    options.retry_max_attempts = 1;
+    YandexDiskClient quick_client("test-token", options);
+
+    YandexDiskClient::BatchOptions batch = fastPolling();
+    batch.max_failed_status_checks = 3;
+    ASSERT_EQ(batch.operation_timeout_ms, 0);
+    YandexDiskClient::BatchReport report = quick_client.runBatch(moves(), batch);
+
+    EXPECT_EQ(report.failed, 4u);
+    EXPECT_EQ(report.pending, 0u);
+    EXPECT_EQ(report.status_checks, 12u);
+}
+
+TEST(OperationStatusTest, ReadsStatusReplies) {
+    using State = OperationStatus::State;
+    EXPECT_EQ(OperationStatus::read(200, R"({"status":"success"})").state, State::Succeeded);
+    EXPECT_EQ(OperationStatus::read(200, R"({"status":"failed"})").state, State::Failed);
+    EXPECT_EQ(OperationStatus::read(200, R"({"status":"in-progress"})").state, State::Running);
+    EXPECT_EQ(OperationStatus::read(404, "{}").state, State::Failed);
+    EXPECT_EQ(OperationStatus::read(401, "{}").state, State::Failed);
+    EXPECT_EQ(OperationStatus::read(429, "{}").state, State::CheckFailed);
+    EXPECT_EQ(OperationStatus::read(503, "{}").state, State::CheckFailed);
+    EXPECT_EQ(OperationStatus::read(0, "", "Timeout was reached").state, State::CheckFailed);
+}
+
+TEST(OperationStatusTest, MalformedRepliesAreFailedChecks) {
+    using State = OperationStatus::State;
+    EXPECT_EQ(OperationStatus::read(200, R"({"status":1})").state, State::CheckFailed);
+    EXPECT_EQ(OperationStatus::read(200, R"(["success"])").state, State::CheckFailed);
+    EXPECT_EQ(OperationStatus::read(200, "not json").state, State::CheckFailed);
+}
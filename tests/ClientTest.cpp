@@ -0,0 +1,63 @@
+// Core client calls against the mock server: resources, transfers, trash.
+#include "MockDiskFixture.h"
+#include <stdexcept>
+
+using ClientTest = MockDiskTest;
+
+TEST_F(ClientTest, CreatesDirectoriesAndReportsExistence) {
+    EXPECT_FALSE(client->exists("/docs"));
+    EXPECT_TRUE(client->createDirectory("/docs"));
+    EXPECT_TRUE(client->exists("/docs"));
+    EXPECT_TRUE(server.contains("/docs"));
+    EXPECT_THROW(client->createDirectory("/docs"), std::runtime_error);
+}
+
+TEST_F(ClientTest, UploadsAndDownloadsFiles) {
+    std::string content = pattern(300 * 1024);
+    writeFile(local("report.bin"), content);
+    server.makeDirectory("/docs");
+
+    EXPECT_TRUE(client->uploadFile("/docs/", local("report.bin")));
+    EXPECT_TRUE(server.fileContent("/docs/report.bin") == content);
+
+    std::filesystem::create_directories(local("out"));
+    EXPECT_TRUE(client->downloadFile("/docs/report.bin", local("out")));
+    EXPECT_TRUE(readFile(local("out/report.bin")) == content);
+}
+
+TEST_F(ClientTest, DownloadOfMissingFileThrows) {
+    EXPECT_THROW(client->downloadFile("/missing.bin", local("out")), std::runtime_error);
+}
+
+TEST_F(ClientTest, ListsDirectoryItems) {
+    server.putFile("/docs/a.txt", "a");
+    server.putFile("/docs/b.txt", "bb");
+    server.makeDirectory("/docs/sub");
+
+    nlohmann::json listing = client->getResourceList("/docs");
+    ASSERT_TRUE(listing.contains("_embedded"));
+    EXPECT_EQ(listing["_embedded"]["items"].size(), 3u);
+}
+
+TEST_F(ClientTest, MovesDeletesAndRestoresFromTrash) {
+    server.putFile("/a.txt", "hello");
+
+    EXPECT_TRUE(client->moveFileOrDir("/a.txt", "/b.txt"));
+    EXPECT_FALSE(server.contains("/a.txt"));
+    EXPECT_EQ(server.fileContent("/b.txt"), "hello");
+
+    EXPECT_TRUE(client->deleteFileOrDir("/b.txt"));
+    EXPECT_FALSE(client->exists("/b.txt"));
+
+    std::vector<std::string> trashed = client->findTrashPathByName("b.txt");
+    ASSERT_EQ(trashed.size(), 1u);
+    EXPECT_TRUE(client->restoreFromTrash(trashed.front()));
+    EXPECT_EQ(server.fileContent("/b.txt"), "hello");
+}
+
+TEST_F(ClientTest, ReusesConnectionsAcrossCalls) {
+    for (int i = 0; i < 20; ++i) client->exists("/");
+    YandexDiskClient::ConnectionStats stats = client->connectionStats();
+    EXPECT_EQ(stats.requests, 20u);
+    EXPECT_LE(stats.connections_opened, 2u);
+}
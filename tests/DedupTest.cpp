@@ -0,0 +1,115 @@
+// Deduplicated uploads: the content index and server-side copies.
+#include "MockDiskFixture.h"
+#include <atomic>
+
+namespace {
+    class DedupTest : public MockDiskTest {
+    protected:
+        std::atomic<int> file_listings{0};
+
+        void SetUp() override {
+            MockDiskTest::SetUp();
+            YandexDiskClient::Options counting = options();
+            counting.on_request = [this](const YandexDiskClient::RequestSpan& span) {
+                if (span.endpoint == "/resources/files") ++file_listings;
+            };
+            client = std::make_unique<YandexDiskClient>("test-token", counting);
+        }
+    };
+}
+
+TEST_F(DedupTest, ConcurrentUploadsBuildTheIndexOnce) {
+    for (int i = 0; i < 8; ++i) {
+        writeFile(local("tree/f" + std::to_string(i) + ".bin"), pattern(4096, i));
+    }
+    server.makeDirectory("/up");
+    MockServerConfig config = server.config();
+    config.latency = std::chrono::milliseconds(20);
+    server.setConfig(config);
+
+    YandexDiskClient::TransferOptions transfer;
+    transfer.deduplicate = true;
+    transfer.workers = 8;
+    YandexDiskClient::TransferReport report = client->uploadDirectory("/up/", local("tree"), transfer);
+
+    EXPECT_TRUE(report.ok());
+    EXPECT_EQ(report.files_transferred, 8u);
+    EXPECT_EQ(file_listings.load(), 1);
+}
+
+namespace {
+    class DedupCopyTest : public MockDiskTest {
+    protected:
+        std::string content = pattern(64 * 1024, 7);
+
+        void SetUp() override {
+            MockDiskTest::SetUp();
+            server.putFile("/store/original.bin", content);
+            server.makeDirectory("/up");
+            writeFile(local("copy.bin"), content);
+        }
+
+        void asyncCopies(bool fail) {
+            MockServerConfig config = server.config();
+            config.async_operations = true;
+            config.async_file_operations = true;
+            config.fail_operations = fail;
+            config.operation_duration = std::chrono::milliseconds(30);
+            server.setConfig(config);
+        }
+
+        static YandexDiskClient::UploadOptions deduplicate() {
+            YandexDiskClient::UploadOptions upload;
+            upload.deduplicate = true;
+            return upload;
+        }
+    };
+}
+
+TEST_F(DedupCopyTest, CopiesMatchingContent) {
+    YandexDiskClient::UploadResult result = client->uploadFile("/up/", local("copy.bin"), deduplicate());
+
+    EXPECT_TRUE(result.deduplicated);
+    EXPECT_EQ(result.source_path, "/store/original.bin");
+    EXPECT_EQ(result.bytes_saved, content.size());
+    EXPECT_EQ(result.bytes_sent, 0u);
+    EXPECT_TRUE(server.fileContent("/up/copy.bin") == content);
+}
+
+TEST_F(DedupCopyTest, WaitsForAcceptedCopy) {
+    asyncCopies(false);
+
+    YandexDiskClient::UploadResult result = client->uploadFile("/up/", local("copy.bin"), deduplicate());
+
+    EXPECT_TRUE(result.deduplicated);
+    EXPECT_TRUE(result.copy_error.empty());
+    EXPECT_TRUE(server.fileContent("/up/copy.bin") == content);
+}
+
+TEST_F(DedupCopyTest, FailedCopyFallsBackToUpload) {
+    asyncCopies(true);
+
+    YandexDiskClient::UploadResult result = client->uploadFile("/up/", local("copy.bin"), deduplicate());
+
+    EXPECT_FALSE(result.deduplicated);
+    EXPECT_EQ(result.bytes_saved, 0u);
+    EXPECT_EQ(result.bytes_sent, content.size());
+    EXPECT_NE(result.copy_error.find("Operation failed"), std::string::npos);
+    EXPECT_TRUE(server.fileContent("/up/copy.bin") == content);
+}
+
+TEST_F(DedupCopyTest, JournaledDirectoryUploadNeverSkipsFailedCopies) {
+    asyncCopies(true);
+    writeFile(local("tree/a.bin"), content);
+    writeFile(local("tree/b.bin"), content);
+
+    YandexDiskClient::TransferOptions transfer;
+    transfer.deduplicate = true;
+    transfer.journal_path = local("journal");
+    YandexDiskClient::TransferReport report = client->uploadDirectory("/up/", local("tree"), transfer);
+
+    EXPECT_TRUE(report.ok());
+    EXPECT_EQ(report.bytes_deduplicated, 0u);
+    EXPECT_TRUE(server.fileContent("/up/tree/a.bin") == content);
+    EXPECT_TRUE(server.fileContent("/up/tree/b.bin") == content);
+}
@@ -0,0 +1,59 @@
+// Download sinks whose reader goes away mid-transfer.
+#include "MockDiskFixture.h"
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using DownloadSinkTest = MockDiskTest;
+
+TEST_F(DownloadSinkTest, ClosedPipeFailsTheDownload) {
+    server.putFile("/stream.bin", pattern(256 * 1024));
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    close(fds[0]);
+
+    EXPECT_THROW(client->downloadFile("/stream.bin", YandexDiskClient::DownloadSink::fileDescriptor(fds[1])),
+                 std::runtime_error);
+    close(fds[1]);
+}
+
+TEST_F(DownloadSinkTest, ClosedNonBlockingPipeFailsTheDownload) {
+    server.putFile("/stream.bin", pattern(256 * 1024));
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    fcntl(fds[1], F_SETFL, fcntl(fds[1], F_GETFL) | O_NONBLOCK);
+    close(fds[0]);
+
+    EXPECT_THROW(client->downloadFile("/stream.bin", YandexDiskClient::DownloadSink::fileDescriptor(fds[1])),
+                 std::runtime_error);
+    close(fds[1]);
+}
+
+TEST_F(DownloadSinkTest, ClosedSocketFailsTheDownload) {
+    server.putFile("/stream.bin", pattern(256 * 1024));
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    close(fds[0]);
+
+    EXPECT_THROW(client->downloadFile("/stream.bin", YandexDiskClient::DownloadSink::fileDescriptor(fds[1])),
+                 std::runtime_error);
+    close(fds[1]);
+}
+
+TEST_F(DownloadSinkTest, OpenPipeReceivesTheBody) {
+    std::string content = pattern(16 * 1024);
+    server.putFile("/small.bin", content);
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+
+    EXPECT_EQ(client->downloadFile("/small.bin", YandexDiskClient::DownloadSink::fileDescriptor(fds[1])),
+              content.size());
+    close(fds[1]);
+    std::string received(content.size(), '\0');
+    std::size_t got = 0;
+    ssize_t n;
+    while (got < received.size() && (n = read(fds[0], &received[got], received.size() - got)) > 0) got += n;
+    close(fds[0]);
+    EXPECT_TRUE(received == content);
+}
@@ -0,0 +1,86 @@
+// Paged directory listings, including servers that cap the page size.
+#include "MockDiskFixture.h"
+#include <set>
+
+namespace {
+    class ListingTest : public MockDiskTest {
+    protected:
+        static constexpr std::size_t kItems = 57;
+
+        void SetUp() override {
+            MockDiskTest::SetUp();
+            for (std::size_t i = 0; i < kItems; ++i) {
+                server.putFile("/many/file-" + std::to_string(1000 + i) + ".txt", "x");
+            }
+        }
+
+        void capPages(std::size_t size) {
+            MockServerConfig config = server.config();
+            config.max_page_size = size;
+            server.setConfig(config);
+        }
+
+        std::set<std::string> listNames(bool prefetch) {
+            YandexDiskClient::ListOptions list;
+            list.page_size = 20;
+            list.prefetch = prefetch;
+            std::set<std::string> names;
+            client->forEachResource("/many", [&](const nlohmann::json& item) {
+                names.insert(item["name"].get<std::string>());
+                return true;
+            }, list);
+            return names;
+        }
+
+        std::set<std::string> listEntryNames(bool prefetch) {
+            YandexDiskClient::ListOptions list;
+            list.page_size = 20;
+            list.prefetch = prefetch;
+            std::set<std::string> names;
+            client->forEachResourceEntry("/many", [&](const YandexDiskClient::ResourceEntry& entry) {
+                names.insert(std::string(entry.name));
+                return true;
+            }, list);
+            return names;
+        }
+    };
+}
+
+TEST_F(ListingTest, VisitsEveryPage) {
+    EXPECT_EQ(listNames(false).size(), kItems);
+    EXPECT_EQ(listNames(true).size(), kItems);
+    EXPECT_EQ(listEntryNames(false).size(), kItems);
+    EXPECT_EQ(listEntryNames(true).size(), kItems);
+}
+
+TEST_F(ListingTest, FollowsTotalWhenServerCapsPageSize) {
+    capPages(7);
+    EXPECT_EQ(listNames(false).size(), kItems);
+    EXPECT_EQ(listNames(true).size(), kItems);
+    EXPECT_EQ(listEntryNames(false).size(), kItems);
+    EXPECT_EQ(listEntryNames(true).size(), kItems);
+}
+
+TEST_F(ListingTest, StopsWhenCallbackReturnsFalse) {
+    std::size_t seen = 0;
+    YandexDiskClient::ListOptions list;
+    list.page_size = 10;
+    std::size_t visited = client->forEachResource("/many", [&](const nlohmann::json&) {
+        return ++seen < 15;
+    }, list);
+    EXPECT_EQ(visited, 15u);
+    EXPECT_EQ(seen, 15u);
+}
+
+TEST_F(ListingTest, EmptyDirectoryVisitsNothing) {
+    server.makeDirectory("/empty");
+    std::size_t visited = client->forEachResourceEntry("/empty", [](const YandexDiskClient::ResourceEntry&) {
+        return true;
+    });
+    EXPECT_EQ(visited, 0u);
+}
+
+TEST_F(ListingTest, ListingAFileThrows) {
+    EXPECT_THROW(client->forEachResource("/many/file-1000.txt", [](const nlohmann::json&) { return true; }),
+                 std::runtime_error);
+}
@@ -0,0 +1,207 @@
+// Metadata cache: TTL, revision revalidation, LRU budget, invalidation by
+// this client's changes and the cache file.
+#include "MockDiskFixture.h"
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace {
+    class MetadataCacheTest : public MockDiskTest {
+    protected:
+        void SetUp() override {
+            MockDiskTest::SetUp();
+            server.putFile("/dir/a.txt", "alpha");
+            server.putFile("/dir/sub/b.txt", "beta");
+            server.putFile("/other.txt", "other");
+        }
+
+        /// Replace the fixture client with one that caches metadata.
+        void cachedClient(long ttl_ms, std::size_t max_bytes = 16 * 1024 * 1024, bool revalidate = false,
+                          const std::string& cache_path = "") {
+            YandexDiskClient::Options opts = options();
+            opts.metadata_cache_ttl_ms = ttl_ms;
+            opts.metadata_cache_max_bytes = max_bytes;
+            opts.metadata_cache_revalidate = revalidate;
+            opts.metadata_cache_path = cache_path;
+            client = std::make_unique<YandexDiskClient>("test-token", opts);
+        }
+
+        /// List a path; returns whether the server had to be asked.
+        bool fetched(const std::string& path) {
+            uint64_t before = server.stats().requests;
+            client->getResourceList(path);
+            return server.stats().requests > before;
+        }
+
+        /// Paths cached by warm(), in a tree of /dir/a.txt, /dir/sub/b.txt and /other.txt.
+        static std::vector<std::string> warmPaths() {
+            return {"/", "/dir", "/dir/a.txt", "/dir/sub", "/dir/sub/b.txt", "/other.txt"};
+        }
+
+        void warm() {
+            for (const std::string& path : warmPaths()) fetched(path);
+            for (const std::string& path : warmPaths()) ASSERT_FALSE(fetched(path)) << path;
+        }
+
+        /// Paths the change made the client fetch again.
+        std::vector<std::string> refetched() {
+            std::vector<std::string> paths;
+            for (const std::string& path : warmPaths()) {
+                if (fetched(path)) paths.push_back(path);
+            }
+            return paths;
+        }
+
+        /// Warm the cache, run a change and return the paths it invalidated.
+        std::vector<std::string> invalidatedBy(const std::function<void()>& change) {
+            server.putFile("/dir/sub/b.txt", "beta");
+            cachedClient(60000);
+            warm();
+            change();
+            std::size_t invalidations = client->metadataCacheStats().invalidations;
+            std::vector<std::string> paths = refetched();
+            EXPECT_EQ(invalidations, paths.size());
+            return paths;
+        }
+    };
+
+    using Paths = std::vector<std::string>;
+
+    // A change to /dir/sub: the path, its subtree and its parent listing.
+    const Paths kSubtree = {"/dir", "/dir/sub", "/dir/sub/b.txt"};
+    // An upload of /dir/sub/b.txt: the file and its parent listing.
+    const Paths kUpload = {"/dir/sub", "/dir/sub/b.txt"};
+}
+
+TEST_F(MetadataCacheTest, HitWithinTheTtlMissAfterIt) {
+    cachedClient(300);
+    EXPECT_TRUE(fetched("/dir/a.txt"));
+    EXPECT_FALSE(fetched("/dir/a.txt"));
+
+    // A change made elsewhere stays invisible until the entry expires.
+    server.putFile("/dir/a.txt", "changed elsewhere");
+    EXPECT_EQ(client->getResourceList("/dir/a.txt")["size"].get<uint64_t>(), 5u);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(400));
+    EXPECT_TRUE(fetched("/dir/a.txt"));
+    EXPECT_EQ(client->getResourceList("/dir/a.txt")["size"].get<uint64_t>(), 17u);
+
+    YandexDiskClient::MetadataCacheStats stats = client->metadataCacheStats();
+    EXPECT_EQ(stats.hits, 3u);
+    EXPECT_EQ(stats.misses, 2u);
+    EXPECT_EQ(stats.revalidations, 0u);
+    EXPECT_EQ(stats.entries, 1u);
+}
+
+TEST_F(MetadataCacheTest, ExpiredEntryIsRevalidatedWhileTheRevisionHolds) {
+    cachedClient(200, 16 * 1024 * 1024, true);
+    uint64_t before = server.stats().requests;
+    client->getResourceList("/dir/a.txt");
+    // The first miss also learns the disk revision.
+    EXPECT_EQ(server.stats().requests - before, 2u);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    before = server.stats().requests;
+    EXPECT_EQ(client->getResourceList("/dir/a.txt")["size"].get<uint64_t>(), 5u);
+    EXPECT_EQ(server.stats().requests - before, 1u);
+    EXPECT_EQ(client->metadataCacheStats().revalidations, 1u);
+
+    // Any change moves the revision: the entry is fetched again.
+    server.putFile("/dir/a.txt", "changed elsewhere");
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    before = server.stats().requests;
+    EXPECT_EQ(client->getResourceList("/dir/a.txt")["size"].get<uint64_t>(), 17u);
+    EXPECT_EQ(server.stats().requests - before, 2u);
+
+    YandexDiskClient::MetadataCacheStats stats = client->metadataCacheStats();
+    EXPECT_EQ(stats.revalidations, 1u);
+    EXPECT_EQ(stats.misses, 2u);
+}
+
+TEST_F(MetadataCacheTest, EvictsTheLeastRecentlyUsedEntry) {
+    for (int i = 1; i <= 3; ++i) server.putFile("/f" + std::to_string(i) + ".txt", "same size");
+    cachedClient(60000);
+    fetched("/f1.txt");
+    const std::size_t entry_bytes = client->metadataCacheStats().bytes;
+    ASSERT_GT(entry_bytes, 0u);
+
+    // Room for two entries of the same size.
+    cachedClient(60000, entry_bytes * 2 + entry_bytes / 2);
+    EXPECT_TRUE(fetched("/f1.txt"));
+    EXPECT_TRUE(fetched("/f2.txt"));
+    EXPECT_FALSE(fetched("/f1.txt"));
+    EXPECT_TRUE(fetched("/f3.txt"));
+
+    YandexDiskClient::MetadataCacheStats stats = client->metadataCacheStats();
+    EXPECT_EQ(stats.evictions, 1u);
+    EXPECT_EQ(stats.entries, 2u);
+    EXPECT_LE(stats.bytes, entry_bytes * 2 + entry_bytes / 2);
+    EXPECT_FALSE(fetched("/f1.txt"));
+    EXPECT_FALSE(fetched("/f3.txt"));
+    EXPECT_TRUE(fetched("/f2.txt"));
+
+    // An entry larger than the whole budget is not kept.
+    cachedClient(60000, entry_bytes / 2);
+    EXPECT_TRUE(fetched("/f1.txt"));
+    EXPECT_TRUE(fetched("/f1.txt"));
+    EXPECT_EQ(client->metadataCacheStats().entries, 0u);
+}
+
+TEST_F(MetadataCacheTest, ChangesInvalidateThePathItsSubtreeAndItsParent) {
+    EXPECT_EQ(invalidatedBy([&] { EXPECT_TRUE(client->deleteFileOrDir("/dir/sub")); }), kSubtree);
+    EXPECT_EQ(invalidatedBy([&] { EXPECT_TRUE(client->moveFileOrDir("/dir/sub", "/dir/moved")); }), kSubtree);
+    EXPECT_EQ(invalidatedBy([&] { EXPECT_TRUE(client->publish("/dir/sub")); }), kSubtree);
+    EXPECT_EQ(invalidatedBy([&] {
+        EXPECT_TRUE(client->uploadFile("/dir/sub/b.txt", YandexDiskClient::UploadSource::memory("new", 3)));
+    }), kUpload);
+}
+
+TEST_F(MetadataCacheTest, AsyncChangesInvalidate) {
+    EXPECT_EQ(invalidatedBy([&] { EXPECT_TRUE(client->deleteFileOrDirAsync("/dir/sub").get()); }), kSubtree);
+    EXPECT_EQ(invalidatedBy([&] { EXPECT_TRUE(client->moveFileOrDirAsync("/dir/sub", "/dir/moved").get()); }),
+              kSubtree);
+    EXPECT_EQ(invalidatedBy([&] { EXPECT_TRUE(client->publishAsync("/dir/sub").get()); }), kSubtree);
+    writeFile(local("b.txt"), "new");
+    EXPECT_EQ(invalidatedBy([&] { EXPECT_TRUE(client->uploadFileAsync("/dir/sub", local("b.txt")).get()); }),
+              kUpload);
+}
+
+TEST_F(MetadataCacheTest, BatchChangesInvalidate) {
+    using Action = YandexDiskClient::BatchAction;
+    for (Action action : {Action::Delete, Action::Move, Action::Publish}) {
+        EXPECT_EQ(invalidatedBy([&] {
+            YandexDiskClient::BatchOperation operation{action, "/dir/sub", "/dir/moved"};
+            EXPECT_EQ(client->runBatch({operation}).succeeded, 1u);
+        }), kSubtree) << static_cast<int>(action);
+    }
+}
+
+TEST_F(MetadataCacheTest, SurvivesInTheCacheFile) {
+    const std::string cache_file = local("metadata.cache");
+    cachedClient(60000, 16 * 1024 * 1024, false, cache_file);
+    fetched("/dir");
+    fetched("/dir/a.txt");
+    client.reset();
+    ASSERT_TRUE(std::filesystem::exists(cache_file));
+
+    cachedClient(60000, 16 * 1024 * 1024, false, cache_file);
+    EXPECT_EQ(client->metadataCacheStats().entries, 2u);
+    EXPECT_FALSE(fetched("/dir"));
+    EXPECT_FALSE(fetched("/dir/a.txt"));
+    EXPECT_TRUE(fetched("/other.txt"));
+
+    // Changes made through the reloaded cache still invalidate it.
+    EXPECT_TRUE(client->deleteFileOrDir("/dir/a.txt"));
+    EXPECT_TRUE(fetched("/dir"));
+    client.reset();
+
+    // A damaged file is read as far as it goes.
+    {
+        std::ofstream out(cache_file, std::ios::app);
+        out << "{not json\n";
+    }
+    cachedClient(60000, 16 * 1024 * 1024, false, cache_file);
+    EXPECT_FALSE(fetched("/other.txt"));
+    EXPECT_FALSE(fetched("/dir"));
+}
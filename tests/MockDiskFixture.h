@@ -0,0 +1,78 @@
+#ifndef YANDEX_DISK_CPP_CLIENT_MOCKDISKFIXTURE_H
+#define YANDEX_DISK_CPP_CLIENT_MOCKDISKFIXTURE_H
+
+#pragma once
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include "YandexDiskClient.h"
+#include "MockDiskServer.h"
+
+/**
+ * @brief Test fixture with a fresh in-process mock server, a client
+ *        pointed at it and an empty local scratch directory.
+ */
+class MockDiskTest : public ::testing::Test {
+protected:
+    MockDiskServer server;
+    std::unique_ptr<YandexDiskClient> client;
+    std::filesystem::path local_root;
+
+    void SetUp() override {
+        server.start();
+        client = std::make_unique<YandexDiskClient>("test-token", options());
+        const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+        local_root = std::filesystem::temp_directory_path() /
+                     ("ydisk-test-" + std::to_string(getpid()) + "-" +
+                      info->test_suite_name() + "-" + info->name());
+        std::filesystem::remove_all(local_root);
+        std::filesystem::create_directories(local_root);
+    }
+
+    void TearDown() override {
+        client.reset();
+        server.stop();
+        std::error_code ec;
+        std::filesystem::remove_all(local_root, ec);
+    }
+
+    /// Client options for the mock; tests may start from these for a second client.
+    YandexDiskClient::Options options() const {
+        YandexDiskClient::Options options;
+        options.api_base_url = server.apiUrl();
+        return options;
+    }
+
+    /// Path below the scratch directory.
+    std::string local(const std::string& relative) const {
+        return (local_root / relative).string();
+    }
+
+    static void writeFile(const std::string& path, const std::string& content) {
+        std::filesystem::create_directories(std::filesystem::path(path).parent_path());
+        std::ofstream out(path, std::ios::binary);
+        out << content;
+    }
+
+    static std::string readFile(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    /// Bytes of a recognizable, non-repeating pattern.
+    static std::string pattern(std::size_t size, unsigned seed = 1) {
+        std::string data(size, '\0');
+        uint32_t state = seed * 2654435761u + 1;
+        for (auto& c : data) {
+            state = state * 1664525u + 1013904223u;
+            c = static_cast<char>(state >> 24);
+        }
+        return data;
+    }
+};
+
+#endif //YANDEX_DISK_CPP_CLIENT_MOCKDISKFIXTURE_H
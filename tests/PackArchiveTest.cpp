@@ -0,0 +1,229 @@
+// Pack archives: the ustar/pax writer, the streaming extractor, the index
+// and packed directory transfers.
+#include "MockDiskFixture.h"
+#include "PackArchive.h"
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace {
+    class PackArchiveTest : public MockDiskTest {
+    protected:
+        using Files = std::vector<std::pair<std::string, std::string>>;
+
+        /// Write the files below local("src") and pack them.
+        std::pair<std::string, PackIndex> pack(const Files& files, bool compress) {
+            PackIndex index;
+            index.archive = compress ? "test.tar.zst" : "test.tar";
+            for (const auto& [path, content] : files) {
+                writeFile(local("src/" + path), content);
+                index.members.push_back({path, content.size(), 1700000000, 0});
+            }
+            PackBody body(local("src"), index, compress);
+            std::string archive;
+            std::vector<char> buffer(50000);
+            std::size_t n;
+            while ((n = body.read(buffer.data(), buffer.size())) > 0) archive.append(buffer.data(), n);
+            if (!compress) EXPECT_EQ(body.size(), archive.size());
+            return {archive, body.index()};
+        }
+
+        /// Extract into local("out") in uneven pieces; returns the extracted members.
+        std::vector<std::pair<std::string, uint64_t>> unpack(const std::string& archive, bool compressed) {
+            std::vector<std::pair<std::string, uint64_t>> members;
+            PackTarget target(local("out"), compressed, [&](const std::string& path, uint64_t size) {
+                members.emplace_back(path, size);
+            });
+            for (std::size_t pos = 0; pos < archive.size(); pos += 3001) {
+                target.write(archive.data() + pos, std::min<std::size_t>(3001, archive.size() - pos));
+            }
+            target.finish();
+            return members;
+        }
+
+        /// A path of exactly `length` characters with a slash every 40.
+        static std::string longPath(std::size_t length, char fill) {
+            std::string path;
+            while (path.size() < length) path += (path.size() % 40 == 39) ? '/' : fill;
+            path.back() = 'z';
+            return path;
+        }
+    };
+}
+
+TEST_F(PackArchiveTest, RoundTripsPathsOfEveryLength) {
+    const std::string exact = longPath(100, 'a');
+    const std::string split = longPath(180, 'b');
+    // A 120-character component fits neither the name nor the prefix field.
+    const std::string pax = "deep/" + std::string(120, 'c') + "/" + longPath(130, 'd');
+    Files files = {
+            {"short.txt", "short"},
+            {exact, pattern(513)},
+            {split, pattern(1024, 2)},
+            {pax, pattern(2000, 3)},
+            {"empty.txt", ""},
+            {"sub/dir/tail.bin", pattern(511, 4)},
+    };
+    auto [archive, index] = pack(files, false);
+
+    ASSERT_EQ(index.members.size(), files.size());
+    for (std::size_t i = 0; i < files.size(); ++i) {
+        const PackIndex::Member& member = index.members[i];
+        EXPECT_EQ(member.path, files[i].first);
+        EXPECT_EQ(member.offset % 512, 0u);
+        EXPECT_TRUE(archive.compare(member.offset, member.size, files[i].second) == 0) << member.path;
+    }
+    // The split path uses the ustar prefix field; the long one a pax header.
+    EXPECT_NE(archive[index.find(split)->offset - 512 + 345], '\0');
+    EXPECT_NE(archive.find(" path=" + pax + "\n"), std::string::npos);
+
+    auto members = unpack(archive, false);
+    ASSERT_EQ(members.size(), files.size());
+    for (const auto& [path, content] : files) {
+        EXPECT_TRUE(readFile(local("out/" + path)) == content) << path;
+    }
+    EXPECT_TRUE(std::filesystem::is_regular_file(local("out/empty.txt")));
+}
+
+TEST_F(PackArchiveTest, RecordSizesAddUpToTheArchive) {
+    Files files = {{"a", "x"}, {longPath(180, 'b'), ""}, {std::string(150, 'p'), pattern(700)}};
+    auto [archive, index] = pack(files, false);
+    uint64_t total = 1024;
+    for (const auto& [path, content] : files) total += PackIndex::recordSize(path, content.size());
+    EXPECT_EQ(total, archive.size());
+}
+
+TEST_F(PackArchiveTest, IndexRoundTripsThroughJson) {
+    auto [archive, index] = pack({{"a.txt", "alpha"}, {"b/c.txt", "gamma"}}, false);
+    PackIndex parsed = PackIndex::parse(index.dump());
+    EXPECT_EQ(parsed.archive, "test.tar");
+    EXPECT_FALSE(parsed.compressed);
+    ASSERT_EQ(parsed.members.size(), 2u);
+    ASSERT_NE(parsed.find("b/c.txt"), nullptr);
+    EXPECT_EQ(parsed.find("b/c.txt")->offset, index.members[1].offset);
+    EXPECT_EQ(parsed.find("b/c.txt")->mtime, 1700000000);
+    EXPECT_EQ(parsed.find("missing"), nullptr);
+
+    EXPECT_THROW(PackIndex::parse("{}"), std::runtime_error);
+    EXPECT_THROW(PackIndex::parse("not json"), std::runtime_error);
+}
+
+TEST_F(PackArchiveTest, RejectsUnsafeMemberNames) {
+    // Packed from a nested root so "../escape.txt" exists to be read.
+    writeFile(local("src/escape.txt"), "outside");
+    writeFile(local("src/inner/abs.txt"), "absolute");
+    for (const std::string& name : {std::string("../escape.txt"), std::string("/abs.txt")}) {
+        PackIndex index;
+        index.archive = "evil.tar";
+        index.members.push_back({name, name == "/abs.txt" ? 8u : 7u, 0, 0});
+        PackBody body(local("src/inner"), index, false);
+        std::string archive;
+        char buffer[4096];
+        std::size_t n;
+        while ((n = body.read(buffer, sizeof(buffer))) > 0) archive.append(buffer, n);
+
+        EXPECT_THROW(unpack(archive, false), std::runtime_error) << name;
+        EXPECT_FALSE(std::filesystem::exists(local("escape.txt"))) << name;
+        EXPECT_FALSE(std::filesystem::exists("/abs.txt")) << name;
+    }
+}
+
+TEST_F(PackArchiveTest, RejectsTruncatedArchives) {
+    auto [archive, index] = pack({{"a.bin", pattern(3000)}, {"b.bin", pattern(100, 2)}}, false);
+
+    // Mid-member, mid-header and without the closing zero blocks.
+    for (std::size_t keep : {std::size_t{1500}, index.members[1].offset - 100, archive.size() - 1024}) {
+        std::filesystem::remove_all(local("out"));
+        EXPECT_THROW(unpack(archive.substr(0, keep), false), std::runtime_error) << keep;
+    }
+}
+
+TEST_F(PackArchiveTest, RejectsACorruptHeaderChecksum) {
+    auto [archive, index] = pack({{"a.txt", "alpha"}, {"b.txt", "beta"}}, false);
+    std::string corrupt = archive;
+    corrupt[index.members[1].offset - 512] ^= 0x20; // first character of "b.txt"
+    EXPECT_THROW(unpack(corrupt, false), std::runtime_error);
+}
+
+#if defined(YDISK_WITH_ZSTD)
+TEST_F(PackArchiveTest, CompressedPackSplitsIntoMemberAlignedFrames) {
+    Files files;
+    for (int i = 0; i < 40; ++i) {
+        files.emplace_back("f/" + std::to_string(i) + ".bin", pattern(30000 + i, i + 1));
+    }
+    files.emplace_back("f/empty", "");
+    auto [plain, plain_index] = pack(files, false);
+    auto [archive, index] = pack(files, true);
+
+    EXPECT_TRUE(index.compressed);
+    ASSERT_GT(index.frames.size(), 2u);
+    EXPECT_EQ(index.frames.front().offset, 0u);
+    EXPECT_EQ(index.frames.front().tar_offset, 0u);
+    for (std::size_t i = 1; i < index.frames.size(); ++i) {
+        EXPECT_EQ(index.frames[i].offset, index.frames[i - 1].offset + index.frames[i - 1].size);
+        EXPECT_GT(index.frames[i].tar_offset, index.frames[i - 1].tar_offset);
+    }
+    EXPECT_EQ(index.frames.back().offset + index.frames.back().size, archive.size());
+    // The zstd stream is the same tar, with the same member offsets.
+    EXPECT_TRUE(decompressPackFrame(archive) == plain);
+    for (std::size_t i = 0; i < files.size(); ++i) {
+        EXPECT_EQ(index.members[i].offset, plain_index.members[i].offset);
+    }
+
+    // One frame on its own yields each of its members: a single-member range fetch.
+    for (std::size_t i = 0; i < files.size(); ++i) {
+        const PackIndex::Member& member = index.members[i];
+        const PackIndex::Frame& frame = index.frameOf(member);
+        std::string tar = decompressPackFrame(archive.substr(frame.offset, frame.size));
+        ASSERT_LE(member.offset - frame.tar_offset + member.size, tar.size()) << member.path;
+        EXPECT_TRUE(tar.compare(member.offset - frame.tar_offset, member.size, files[i].second) == 0)
+                << member.path;
+    }
+
+    auto members = unpack(archive, true);
+    EXPECT_EQ(members.size(), files.size());
+    for (const auto& [path, content] : files) EXPECT_TRUE(readFile(local("out/" + path)) == content) << path;
+
+    std::filesystem::remove_all(local("out"));
+    EXPECT_THROW(unpack(archive.substr(0, archive.size() - 10), true), std::runtime_error);
+}
+#endif
+
+TEST_F(PackArchiveTest, PackedDirectoryRoundTripsThroughTheDisk) {
+    writeFile(local("tree/small/a.txt"), "alpha");
+    writeFile(local("tree/small/b.txt"), "");
+    writeFile(local("tree/small/" + longPath(180, 'n')), pattern(900));
+    writeFile(local("tree/big.bin"), pattern(200000, 9));
+
+    YandexDiskClient::TransferOptions up;
+    up.pack_threshold = 64 * 1024;
+#if defined(YDISK_WITH_ZSTD)
+    up.pack_compress = true;
+#endif
+    YandexDiskClient::TransferReport sent = client->uploadDirectory("/backup", local("tree"), up);
+    EXPECT_EQ(sent.files_failed, 0u);
+    EXPECT_EQ(sent.files_packed, 3u);
+    EXPECT_TRUE(server.fileContent("/backup/big.bin") == pattern(200000, 9));
+    EXPECT_FALSE(server.contains("/backup/small/a.txt"));
+    EXPECT_TRUE(server.contains("/backup/.ydisk-packs"));
+
+    std::string member(5, '\0');
+    EXPECT_EQ(client->downloadPackedFile("/backup", "small/a.txt",
+                                         YandexDiskClient::DownloadSink::memory(&member[0], member.size())),
+              5u);
+    EXPECT_EQ(member, "alpha");
+    EXPECT_THROW(client->downloadPackedFile("/backup", "small/none.txt",
+                                            YandexDiskClient::DownloadSink::memory(&member[0], member.size())),
+                 std::runtime_error);
+
+    YandexDiskClient::TransferOptions down;
+    down.unpack = true;
+    YandexDiskClient::TransferReport received = client->downloadDirectory("/backup", local("restore"), down);
+    EXPECT_EQ(received.files_failed, 0u);
+    EXPECT_EQ(received.files_packed, 3u);
+    EXPECT_EQ(readFile(local("restore/backup/small/a.txt")), "alpha");
+    EXPECT_TRUE(std::filesystem::is_regular_file(local("restore/backup/small/b.txt")));
+    EXPECT_TRUE(readFile(local("restore/backup/small/" + longPath(180, 'n'))) == pattern(900));
+    EXPECT_TRUE(readFile(local("restore/backup/big.bin")) == pattern(200000, 9));
+    EXPECT_FALSE(std::filesystem::exists(local("restore/backup/.ydisk-packs")));
+}
@@ -0,0 +1,76 @@
+// Query escaping and the thread-buffer URL builder.
+#include "QueryString.h"
+#include <curl/curl.h>
+#include <gtest/gtest.h>
+#include <string>
+
+namespace {
+    std::string curlEscape(const std::string& value) {
+        char* escaped = curl_easy_escape(nullptr, value.data(), static_cast<int>(value.size()));
+        std::string result(escaped);
+        curl_free(escaped);
+        return result;
+    }
+
+    std::string escape(const std::string& value) {
+        std::string out;
+        QueryString::appendEscaped(out, value);
+        return out;
+    }
+}
+
+TEST(QueryStringTest, EscapesEveryByteAsCurlDoes) {
+    std::string all;
+    for (int byte = 0; byte < 256; ++byte) {
+        std::string one(1, static_cast<char>(byte));
+        EXPECT_EQ(escape(one), curlEscape(one)) << "byte " << byte;
+        all += one;
+    }
+    EXPECT_EQ(escape(all), curlEscape(all));
+    EXPECT_EQ(escape("disk:/Фото/a b+c.txt"), curlEscape("disk:/Фото/a b+c.txt"));
+}
+
+TEST(QueryStringTest, DecodeReversesEscaping) {
+    std::string all;
+    for (int byte = 0; byte < 256; ++byte) all += static_cast<char>(byte);
+    EXPECT_EQ(QueryString::decode(escape(all)), all);
+
+    auto params = QueryString::parse("https://host/v1/disk/resources?path=disk%3A%2Fa%20b&limit=5");
+    EXPECT_EQ(params["path"], "disk:/a b");
+    EXPECT_EQ(params["limit"], "5");
+    EXPECT_EQ(QueryString::route("https://host/v1/disk/resources?path=x"), "https://host/v1/disk/resources");
+}
+
+TEST(QueryStringTest, BuilderMatchesBuild) {
+    UrlBuilder url("https://host/v1/disk", "/resources");
+    url.param("fields", "type,size").param("limit", uint64_t{20}).param("path", "disk:/a b");
+    EXPECT_EQ(url.url(), QueryString::build("https://host/v1/disk/resources",
+                                            {{"fields", "type,size"}, {"limit", "20"}, {"path", "disk:/a b"}}));
+    EXPECT_EQ(UrlBuilder("https://host/v1/disk").url(), "https://host/v1/disk");
+}
+
+TEST(QueryStringTest, NestedBuilderLeavesTheOuterUrlAlone) {
+    const std::string* thread_buffer = nullptr;
+    {
+        UrlBuilder outer("https://host/v1/disk", "/resources");
+        outer.param("path", "disk:/outer");
+        thread_buffer = &outer.url();
+        const std::string expected = outer.url();
+        {
+            UrlBuilder inner("https://other/v1/disk", "/resources/upload");
+            inner.param("path", "disk:/inner with a path long enough to grow any buffer it shared")
+                 .param("overwrite", "true");
+            EXPECT_NE(&inner.url(), thread_buffer);
+            EXPECT_EQ(outer.url(), expected);
+            EXPECT_EQ(inner.url(), "https://other/v1/disk/resources/upload?path=disk%3A%2Finner%20with%20a%20path"
+                                   "%20long%20enough%20to%20grow%20any%20buffer%20it%20shared&overwrite=true");
+        }
+        outer.param("limit", uint64_t{1});
+        EXPECT_EQ(outer.url(), expected + "&limit=1");
+        EXPECT_EQ(&outer.url(), thread_buffer);
+    }
+    // Released with the outer builder, the thread buffer serves the next one.
+    UrlBuilder next("https://host", "/next");
+    EXPECT_EQ(&next.url(), thread_buffer);
+    EXPECT_EQ(next.url(), "https://host/next");
+}
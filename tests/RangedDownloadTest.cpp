@@ -0,0 +1,65 @@
+// Parallel ranged downloads: content, fallbacks and failed chunks.
+#include "MockDiskFixture.h"
+#include <atomic>
+#include <stdexcept>
+
+namespace {
+    class RangedDownloadTest : public MockDiskTest {
+    protected:
+        static YandexDiskClient::RangedDownloadOptions smallChunks() {
+            YandexDiskClient::RangedDownloadOptions ranged;
+            ranged.chunk_size = 64 * 1024;
+            ranged.min_chunk_size = 64 * 1024;
+            ranged.max_chunk_size = 64 * 1024;
+            ranged.max_streams = 4;
+            ranged.adaptive = false;
+            return ranged;
+        }
+    };
+}
+
+TEST_F(RangedDownloadTest, AssemblesChunksInPlace) {
+    std::string content = pattern(1024 * 1024 + 123);
+    server.putFile("/big.bin", content);
+
+    YandexDiskClient::RangedDownloadReport report =
+            client->downloadFileRanged("/big.bin", local_root.string(), smallChunks());
+
+    EXPECT_TRUE(report.ranged);
+    EXPECT_GT(report.chunks, 1u);
+    EXPECT_EQ(report.bytes_transferred, content.size());
+    EXPECT_TRUE(readFile(local("big.bin")) == content);
+    EXPECT_FALSE(std::filesystem::exists(local("big.bin.part")));
+}
+
+TEST_F(RangedDownloadTest, SmallFilesUseOneStream) {
+    server.putFile("/small.txt", "tiny");
+
+    YandexDiskClient::RangedDownloadReport report =
+            client->downloadFileRanged("/small.txt", local_root.string(), smallChunks());
+
+    EXPECT_FALSE(report.ranged);
+    EXPECT_EQ(readFile(local("small.txt")), "tiny");
+    EXPECT_FALSE(std::filesystem::exists(local("small.txt.part")));
+}
+
+TEST_F(RangedDownloadTest, FailedChunkLeavesNoFileBehind) {
+    server.putFile("/big.bin", pattern(2 * 1024 * 1024));
+    writeFile(local("big.bin"), "previous version");
+
+    // Every request after the first finished chunk fails.
+    YandexDiskClient::RangedDownloadOptions ranged = smallChunks();
+    std::atomic<bool> broken{false};
+    ranged.on_progress = [&](uint64_t, uint64_t) {
+        if (broken.exchange(true)) return;
+        MockServerConfig config = server.config();
+        config.error_rate = 1.0;
+        config.error_status = 500;
+        server.setConfig(config);
+    };
+
+    EXPECT_THROW(client->downloadFileRanged("/big.bin", local_root.string(), ranged), std::runtime_error);
+    EXPECT_TRUE(broken);
+    EXPECT_EQ(readFile(local("big.bin")), "previous version");
+    EXPECT_FALSE(std::filesystem::exists(local("big.bin.part")));
+}
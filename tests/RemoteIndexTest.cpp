@@ -0,0 +1,62 @@
+// The memory-mapped remote index and the lookups answered from it.
+#include "MockDiskFixture.h"
+#include <algorithm>
+
+namespace {
+    class RemoteIndexTest : public MockDiskTest {
+    protected:
+        void SetUp() override {
+            MockDiskTest::SetUp();
+            server.putFile("/docs/report.pdf", "v1");
+            server.putFile("/old/report.pdf", "v0");
+            YandexDiskClient::Options indexed = options();
+            indexed.remote_index_path = local("tree.idx");
+            client = std::make_unique<YandexDiskClient>("test-token", indexed);
+            client->refreshRemoteIndex();
+        }
+
+        static bool has(const std::vector<std::string>& paths, const std::string& path) {
+            return std::find(paths.begin(), paths.end(), path) != paths.end();
+        }
+    };
+}
+
+TEST_F(RemoteIndexTest, AnswersLookupsFromTheIndex) {
+    std::vector<std::string> paths = client->findIndexedPathsByName("report.pdf");
+    EXPECT_EQ(paths.size(), 2u);
+    EXPECT_TRUE(has(paths, "disk:/docs/report.pdf"));
+
+    YandexDiskClient::IndexedResource info;
+    ASSERT_TRUE(client->findIndexedResource("/docs/report.pdf", info));
+    EXPECT_EQ(info.type, "file");
+    EXPECT_EQ(info.size, 2u);
+    EXPECT_TRUE(client->exists("/docs"));
+}
+
+TEST_F(RemoteIndexTest, AppliesOwnChanges) {
+    server.makeDirectory("/new");
+    writeFile(local("report.pdf"), "new");
+    client->uploadFile("/new/", local("report.pdf"));
+    client->deleteFileOrDir("/old/report.pdf");
+
+    std::vector<std::string> paths = client->findIndexedPathsByName("report.pdf");
+    EXPECT_TRUE(has(paths, "disk:/new/report.pdf"));
+    EXPECT_FALSE(has(paths, "disk:/old/report.pdf"));
+}
+
+TEST_F(RemoteIndexTest, SearchByNameSeesChangesMadeElsewhere) {
+    server.makeDirectory("/projects/archive");
+    YandexDiskClient other("test-token", options());
+    other.deleteFileOrDir("/old/report.pdf");
+
+    // The index knows neither change ...
+    EXPECT_TRUE(client->findIndexedPathsByName("archive").empty());
+    EXPECT_TRUE(has(client->findIndexedPathsByName("report.pdf"), "disk:/old/report.pdf"));
+
+    // ... but the server-side search does.
+    EXPECT_TRUE(has(client->findResourcePathByName("archive"), "disk:/projects/archive"));
+    std::vector<std::string> reports = client->findResourcePathByName("report.pdf");
+    EXPECT_EQ(reports.size(), 1u);
+    EXPECT_TRUE(has(reports, "disk:/docs/report.pdf"));
+    EXPECT_TRUE(client->exists("/projects/archive"));
+}
@@ -0,0 +1,139 @@
+// Resource search: glob matching and the concurrent tree walk.
+#include "MockDiskFixture.h"
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    using Names = std::vector<std::string>;
+
+    class ResourceSearchTest : public MockDiskTest {
+    protected:
+        /// Names below /g matching a glob, sorted.
+        Names glob(const std::string& pattern, bool ignore_case = false) {
+            for (const char* name : {"a.txt", "b.txt", "ab.txt", "x.jpg", "X.JPG", "[x].txt", "c1", "c2", "cz", "c-"}) {
+                if (!server.contains(std::string("/g/") + name)) server.putFile(std::string("/g/") + name, "");
+            }
+            YandexDiskClient::SearchOptions search;
+            search.glob = pattern;
+            search.ignore_case = ignore_case;
+            search.recursive = false;
+            Names names;
+            client->searchResources("/g", search, [&](const nlohmann::json& item) {
+                names.push_back(item["name"].get<std::string>());
+                return true;
+            });
+            std::sort(names.begin(), names.end());
+            return names;
+        }
+
+        /// /tree/d0../tree/d3 with five files each, and a nested directory in d1.
+        void makeTree() {
+            for (int d = 0; d < 4; ++d) {
+                for (int f = 0; f < 5; ++f) {
+                    server.putFile("/tree/d" + std::to_string(d) + "/f" + std::to_string(f) + ".txt", "x");
+                }
+            }
+            server.putFile("/tree/d1/deep/f.txt", "x");
+            server.putFile("/tree/top.bin", "x");
+        }
+    };
+}
+
+TEST_F(ResourceSearchTest, GlobStarAndQuestionMark) {
+    EXPECT_EQ(glob("*"), (Names{"X.JPG", "[x].txt", "a.txt", "ab.txt", "b.txt", "c-", "c1", "c2", "cz", "x.jpg"}));
+    EXPECT_EQ(glob("*.txt"), (Names{"[x].txt", "a.txt", "ab.txt", "b.txt"}));
+    EXPECT_EQ(glob("*b.txt"), (Names{"ab.txt", "b.txt"}));
+    EXPECT_EQ(glob("?.txt"), (Names{"a.txt", "b.txt"}));
+    EXPECT_EQ(glob("c?"), (Names{"c-", "c1", "c2", "cz"}));
+    EXPECT_EQ(glob("??"), (Names{"c-", "c1", "c2", "cz"}));
+    EXPECT_EQ(glob("a.tx"), Names{});
+}
+
+TEST_F(ResourceSearchTest, GlobClasses) {
+    EXPECT_EQ(glob("[a-b].txt"), (Names{"a.txt", "b.txt"}));
+    EXPECT_EQ(glob("c[0-9]"), (Names{"c1", "c2"}));
+    EXPECT_EQ(glob("c[!0-9]"), (Names{"c-", "cz"}));
+    EXPECT_EQ(glob("c[^0-9z]"), Names{"c-"});
+    EXPECT_EQ(glob("c[-]"), Names{"c-"});
+    EXPECT_EQ(glob("[ab]*"), (Names{"a.txt", "ab.txt", "b.txt"}));
+    // An unclosed class is a literal '['.
+    EXPECT_EQ(glob("[x*"), Names{"[x].txt"});
+    EXPECT_EQ(glob("[x"), Names{});
+}
+
+TEST_F(ResourceSearchTest, GlobIgnoringCase) {
+    EXPECT_EQ(glob("*.jpg"), Names{"x.jpg"});
+    EXPECT_EQ(glob("*.jpg", true), (Names{"X.JPG", "x.jpg"}));
+    EXPECT_EQ(glob("[A-B].TXT", true), (Names{"a.txt", "b.txt"}));
+    EXPECT_EQ(glob("[A-B].TXT"), Names{});
+    EXPECT_EQ(glob("C[!A-Z]", true), (Names{"c-", "c1", "c2"}));
+}
+
+TEST_F(ResourceSearchTest, WalksTheTreeConcurrently) {
+    makeTree();
+    YandexDiskClient::SearchOptions search;
+    search.glob = "*.txt";
+    search.max_in_flight = 3;
+    Names paths;
+    // Never called concurrently, so no lock is needed.
+    YandexDiskClient::SearchReport report = client->searchResources("/tree", search, [&](const nlohmann::json& item) {
+        paths.push_back(item["path"].get<std::string>());
+        return true;
+    });
+    EXPECT_EQ(report.matches, 21u);
+    EXPECT_EQ(paths.size(), 21u);
+    EXPECT_EQ(report.directories_listed, 6u);
+    EXPECT_FALSE(report.stopped_early);
+    EXPECT_TRUE(report.errors.empty());
+    EXPECT_NE(std::find(paths.begin(), paths.end(), "disk:/tree/d1/deep/f.txt"), paths.end());
+}
+
+TEST_F(ResourceSearchTest, StopsAtMaxResults) {
+    makeTree();
+    YandexDiskClient::SearchOptions search;
+    search.glob = "*.txt";
+    search.max_results = 3;
+    search.max_in_flight = 4;
+    std::size_t delivered = 0;
+    YandexDiskClient::SearchReport report = client->searchResources("/tree", search, [&](const nlohmann::json&) {
+        ++delivered;
+        return true;
+    });
+    EXPECT_EQ(delivered, 3u);
+    EXPECT_EQ(report.matches, 3u);
+    EXPECT_TRUE(report.stopped_early);
+
+    // The callback can stop the search as well.
+    delivered = 0;
+    search.max_results = 0;
+    report = client->searchResources("/tree", search, [&](const nlohmann::json&) { return ++delivered < 2; });
+    EXPECT_EQ(delivered, 2u);
+    EXPECT_TRUE(report.stopped_early);
+}
+
+TEST_F(ResourceSearchTest, FailingSubdirectoryIsReportedAndSkipped) {
+    makeTree();
+    MockServerConfig config = server.config();
+    config.forbidden_path = "/tree/d2";
+    server.setConfig(config);
+
+    YandexDiskClient::SearchOptions search;
+    search.glob = "*.txt";
+    search.max_in_flight = 3;
+    std::size_t delivered = 0;
+    YandexDiskClient::SearchReport report = client->searchResources("/tree", search, [&](const nlohmann::json&) {
+        ++delivered;
+        return true;
+    });
+    EXPECT_EQ(report.matches, 16u);
+    EXPECT_EQ(delivered, 16u);
+    EXPECT_FALSE(report.stopped_early);
+    ASSERT_EQ(report.errors.size(), 1u);
+    EXPECT_NE(report.errors[0].disk_path.find("/tree/d2"), std::string::npos);
+    EXPECT_FALSE(report.errors[0].message.empty());
+
+    // The start directory failing is an error of the whole search.
+    EXPECT_THROW(client->searchResources("/tree/d2", search, [](const nlohmann::json&) { return true; }),
+                 std::runtime_error);
+}
@@ -0,0 +1,117 @@
+// Resumable downloads driven by the checkpoint journal.
+#include "MockDiskFixture.h"
+#include <stdexcept>
+
+namespace {
+    constexpr std::size_t kSize = 3 * 1024 * 1024 + 5;
+    constexpr uint64_t kCut = 1024 * 1024;
+
+    class ResumableTransferTest : public MockDiskTest {
+    protected:
+        std::string content = pattern(kSize, 7);
+
+        void SetUp() override {
+            MockDiskTest::SetUp();
+            server.putFile("/big.bin", content);
+            std::filesystem::create_directories(local("out"));
+        }
+
+        void cutDownloads(uint64_t after) {
+            MockServerConfig config = server.config();
+            config.cut_downloads_after = after;
+            server.setConfig(config);
+        }
+
+        /// Leave a checkpointed partial download of /big.bin behind.
+        void interrupt() {
+            cutDownloads(kCut);
+            EXPECT_THROW(client->downloadFile("/big.bin", local("out"), local("journal")), std::runtime_error);
+            cutDownloads(0);
+            ASSERT_TRUE(std::filesystem::exists(local("out/big.bin.part")));
+            ASSERT_FALSE(std::filesystem::exists(local("out/big.bin")));
+        }
+
+        /// Body bytes the mock sent for the next download.
+        uint64_t downloadBytes() {
+            server.resetStats();
+            EXPECT_TRUE(client->downloadFile("/big.bin", local("out"), local("journal")));
+            return server.stats().bytes_sent;
+        }
+    };
+}
+
+TEST_F(ResumableTransferTest, ResumesFromTheCheckpoint) {
+    interrupt();
+    EXPECT_EQ(std::filesystem::file_size(local("out/big.bin.part")), kCut);
+
+    uint64_t sent = downloadBytes();
+    EXPECT_LT(sent, kSize - kCut + 64 * 1024);
+    EXPECT_TRUE(readFile(local("out/big.bin")) == content);
+    EXPECT_FALSE(std::filesystem::exists(local("out/big.bin.part")));
+}
+
+TEST_F(ResumableTransferTest, ChangedRemoteContentDiscardsTheCheckpoint) {
+    interrupt();
+    std::string changed = pattern(kSize, 8);
+    server.putFile("/big.bin", changed);
+
+    EXPECT_GE(downloadBytes(), kSize);
+    EXPECT_TRUE(readFile(local("out/big.bin")) == changed);
+}
+
+TEST_F(ResumableTransferTest, ChangedRemoteSizeDiscardsTheCheckpoint) {
+    interrupt();
+    std::string longer = content + "tail";
+    server.putFile("/big.bin", longer);
+
+    EXPECT_GE(downloadBytes(), longer.size());
+    EXPECT_TRUE(readFile(local("out/big.bin")) == longer);
+}
+
+TEST_F(ResumableTransferTest, ChecksumMismatchDropsThePartialFile) {
+    interrupt();
+    {
+        // Damage a byte the checkpoint vouches for.
+        std::fstream part(local("out/big.bin.part"), std::ios::in | std::ios::out | std::ios::binary);
+        part.seekp(100);
+        part.put(static_cast<char>(content[100] ^ 0x5a));
+    }
+
+    EXPECT_THROW(client->downloadFile("/big.bin", local("out"), local("journal")), std::runtime_error);
+    EXPECT_FALSE(std::filesystem::exists(local("out/big.bin")));
+    EXPECT_FALSE(std::filesystem::exists(local("out/big.bin.part")));
+
+    EXPECT_GE(downloadBytes(), kSize);
+    EXPECT_TRUE(readFile(local("out/big.bin")) == content);
+}
+
+TEST_F(ResumableTransferTest, ServerWithoutRangeSupportStartsOver) {
+    interrupt();
+    MockServerConfig config = server.config();
+    config.ignore_range = true;
+    server.setConfig(config);
+
+    EXPECT_GE(downloadBytes(), kSize);
+    EXPECT_TRUE(readFile(local("out/big.bin")) == content);
+    EXPECT_FALSE(std::filesystem::exists(local("out/big.bin.part")));
+}
+
+TEST_F(ResumableTransferTest, DirectoryRerunSkipsCompletedFiles) {
+    server.putFile("/tree/small.txt", "small");
+    server.putFile("/tree/big.bin", content);
+    YandexDiskClient::TransferOptions transfer;
+    transfer.journal_path = local("journal");
+    transfer.workers = 1;
+
+    cutDownloads(kCut);
+    YandexDiskClient::TransferReport first = client->downloadDirectory("/tree", local_root.string(), transfer);
+    EXPECT_EQ(first.files_failed, 1u);
+    cutDownloads(0);
+
+    YandexDiskClient::TransferReport second = client->downloadDirectory("/tree", local_root.string(), transfer);
+    EXPECT_EQ(second.files_failed, 0u);
+    EXPECT_EQ(second.files_skipped, 1u);
+    EXPECT_EQ(second.files_transferred, 1u);
+    EXPECT_EQ(readFile(local("tree/small.txt")), "small");
+    EXPECT_TRUE(readFile(local("tree/big.bin")) == content);
+}
@@ -0,0 +1,40 @@
+// Concurrency slots of the retry policy.
+#include "RetryPolicy.h"
+#include <gtest/gtest.h>
+#include <stdexcept>
+
+namespace {
+    RetryPolicy::Settings oneSlot() {
+        RetryPolicy::Settings settings;
+        settings.max_concurrency = 1;
+        settings.min_concurrency = 1;
+        return settings;
+    }
+}
+
+TEST(RetryPolicyTest, SlotIsReturnedWhenTheAttemptThrows) {
+    RetryPolicy policy(oneSlot());
+    try {
+        RetryPolicy::Slot slot(policy);
+        throw std::runtime_error("transfer failed");
+    } catch (const std::runtime_error&) {
+    }
+    EXPECT_TRUE(policy.tryAcquire());
+    policy.release(200);
+}
+
+TEST(RetryPolicyTest, SlotIsReturnedOnceWithItsStatus) {
+    RetryPolicy::Settings settings = oneSlot();
+    settings.max_concurrency = 4;
+    RetryPolicy policy(settings);
+    {
+        RetryPolicy::Slot slot(policy);
+        slot.release(429);
+    }
+    EXPECT_EQ(policy.stats().concurrency_decreases, 1u);
+    EXPECT_EQ(policy.stats().concurrency_limit, 2u);
+    for (int i = 0; i < 2; ++i) EXPECT_TRUE(policy.tryAcquire());
+    EXPECT_FALSE(policy.tryAcquire());
+    policy.release(200);
+    policy.release(200);
+}
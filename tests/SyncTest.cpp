@@ -0,0 +1,171 @@
+// Directory sync: one-way and two-way plans, pruning, the hash index and
+// downloads that break off.
+#include "MockDiskFixture.h"
+#include <chrono>
+
+namespace {
+    class SyncTest : public MockDiskTest {
+    protected:
+        static YandexDiskClient::SyncOptions direction(YandexDiskClient::SyncDirection d) {
+            YandexDiskClient::SyncOptions sync;
+            sync.direction = d;
+            sync.workers = 4;
+            return sync;
+        }
+
+        /// Backdate a local file so the remote copy counts as newer.
+        static void makeOld(const std::string& path) {
+            std::filesystem::last_write_time(
+                    path, std::filesystem::file_time_type::clock::now() - std::chrono::hours(24));
+        }
+    };
+}
+
+TEST_F(SyncTest, UploadMirrorsTheLocalTreeAndPrunesExtras) {
+    writeFile(local("tree/a.txt"), "alpha");
+    writeFile(local("tree/sub/b.txt"), pattern(70000));
+    server.putFile("/sync/extra.txt", "stale");
+    server.putFile("/sync/gone/c.txt", "stale");
+
+    auto sync = direction(YandexDiskClient::SyncDirection::Upload);
+    sync.delete_extraneous = true;
+    YandexDiskClient::SyncReport report = client->syncDirectory("/sync", local("tree"), sync);
+
+    EXPECT_TRUE(report.ok());
+    EXPECT_EQ(report.files_uploaded, 2u);
+    EXPECT_EQ(report.bytes_uploaded, 5u + 70000u);
+    EXPECT_EQ(report.files_deleted, 2u);
+    EXPECT_EQ(server.fileContent("/sync/a.txt"), "alpha");
+    EXPECT_TRUE(server.fileContent("/sync/sub/b.txt") == pattern(70000));
+    EXPECT_FALSE(server.contains("/sync/extra.txt"));
+    EXPECT_FALSE(server.contains("/sync/gone"));
+
+    report = client->syncDirectory("/sync", local("tree"), sync);
+    EXPECT_TRUE(report.ok());
+    EXPECT_EQ(report.files_uploaded, 0u);
+    EXPECT_EQ(report.files_unchanged, 2u);
+    EXPECT_EQ(report.files_deleted, 0u);
+}
+
+TEST_F(SyncTest, UploadKeepsExtrasWithoutDeleteExtraneous) {
+    writeFile(local("tree/a.txt"), "alpha");
+    server.putFile("/sync/extra.txt", "kept");
+
+    YandexDiskClient::SyncReport report =
+            client->syncDirectory("/sync", local("tree"), direction(YandexDiskClient::SyncDirection::Upload));
+
+    EXPECT_TRUE(report.ok());
+    EXPECT_EQ(report.files_deleted, 0u);
+    EXPECT_EQ(server.fileContent("/sync/extra.txt"), "kept");
+}
+
+TEST_F(SyncTest, DownloadMirrorsTheDiskAndPrunesExtras) {
+    server.putFile("/sync/a.txt", "alpha");
+    server.putFile("/sync/sub/b.txt", "beta");
+    writeFile(local("tree/a.txt"), "older");
+    makeOld(local("tree/a.txt"));
+    writeFile(local("tree/local-only.txt"), "extra");
+    writeFile(local("tree/old/c.txt"), "extra");
+
+    auto sync = direction(YandexDiskClient::SyncDirection::Download);
+    sync.delete_extraneous = true;
+    YandexDiskClient::SyncReport report = client->syncDirectory("/sync", local("tree"), sync);
+
+    EXPECT_TRUE(report.ok());
+    EXPECT_EQ(report.files_downloaded, 2u);
+    EXPECT_EQ(report.files_deleted, 2u);
+    EXPECT_EQ(readFile(local("tree/a.txt")), "alpha");
+    EXPECT_EQ(readFile(local("tree/sub/b.txt")), "beta");
+    EXPECT_FALSE(std::filesystem::exists(local("tree/local-only.txt")));
+    EXPECT_FALSE(std::filesystem::exists(local("tree/old")));
+    EXPECT_EQ(server.fileContent("/sync/a.txt"), "alpha");
+}
+
+TEST_F(SyncTest, TwoWayCopiesBothSidesAndNewerWins) {
+    server.putFile("/sync/remote-only.txt", "from the disk");
+    server.putFile("/sync/both.txt", "newer remote");
+    writeFile(local("tree/local-only.txt"), "from here");
+    writeFile(local("tree/both.txt"), "old local");
+    makeOld(local("tree/both.txt"));
+
+    auto sync = direction(YandexDiskClient::SyncDirection::TwoWay);
+    // Ignored for two-way runs: nothing is missing "on the source side".
+    sync.delete_extraneous = true;
+    YandexDiskClient::SyncReport report = client->syncDirectory("/sync", local("tree"), sync);
+
+    EXPECT_TRUE(report.ok());
+    EXPECT_EQ(report.files_uploaded, 1u);
+    EXPECT_EQ(report.files_downloaded, 2u);
+    EXPECT_EQ(report.files_deleted, 0u);
+    EXPECT_EQ(server.fileContent("/sync/local-only.txt"), "from here");
+    EXPECT_EQ(readFile(local("tree/remote-only.txt")), "from the disk");
+    EXPECT_EQ(readFile(local("tree/both.txt")), "newer remote");
+}
+
+TEST_F(SyncTest, HashIndexSkipsRehashingUnchangedFiles) {
+    writeFile(local("tree/a.txt"), "alpha");
+    writeFile(local("tree/sub/b.txt"), "beta");
+    server.putFile("/sync/a.txt", "alpha");
+    server.putFile("/sync/sub/b.txt", "beta");
+
+    auto sync = direction(YandexDiskClient::SyncDirection::Upload);
+    sync.index_path = local("sync.index");
+    YandexDiskClient::SyncReport first = client->syncDirectory("/sync", local("tree"), sync);
+    EXPECT_TRUE(first.ok());
+    EXPECT_EQ(first.files_hashed, 2u);
+    EXPECT_EQ(first.hash_cache_hits, 0u);
+    EXPECT_EQ(first.files_unchanged, 2u);
+
+    // A fresh client reads the index back from disk.
+    client = std::make_unique<YandexDiskClient>("test-token", options());
+    YandexDiskClient::SyncReport second = client->syncDirectory("/sync", local("tree"), sync);
+    EXPECT_TRUE(second.ok());
+    EXPECT_EQ(second.files_hashed, 0u);
+    EXPECT_EQ(second.hash_cache_hits, 2u);
+    EXPECT_EQ(second.files_unchanged, 2u);
+    EXPECT_EQ(second.files_uploaded, 0u);
+}
+
+TEST_F(SyncTest, BrokenDownloadIsNotPushedBackNextRun) {
+    const std::string newer = pattern(300000, 2);
+    server.putFile("/sync/data.bin", newer);
+    writeFile(local("tree/data.bin"), pattern(1000, 3));
+    makeOld(local("tree/data.bin"));
+
+    MockServerConfig config = server.config();
+    config.cut_downloads_after = 4096;
+    server.setConfig(config);
+
+    auto sync = direction(YandexDiskClient::SyncDirection::TwoWay);
+    YandexDiskClient::SyncReport broken = client->syncDirectory("/sync", local("tree"), sync);
+    EXPECT_FALSE(broken.ok());
+    EXPECT_EQ(broken.files_downloaded, 0u);
+    // The old copy is untouched and nothing is left half-written.
+    EXPECT_TRUE(readFile(local("tree/data.bin")) == pattern(1000, 3));
+    EXPECT_FALSE(std::filesystem::exists(local("tree/data.bin.part")));
+
+    config.cut_downloads_after = 0;
+    server.setConfig(config);
+    YandexDiskClient::SyncReport retry = client->syncDirectory("/sync", local("tree"), sync);
+    EXPECT_TRUE(retry.ok());
+    EXPECT_EQ(retry.files_uploaded, 0u);
+    EXPECT_EQ(retry.files_downloaded, 1u);
+    EXPECT_TRUE(server.fileContent("/sync/data.bin") == newer);
+    EXPECT_TRUE(readFile(local("tree/data.bin")) == newer);
+}
+
+TEST_F(SyncTest, BrokenDownloadOfANewFileLeavesNothingBehind) {
+    server.putFile("/sync/data.bin", pattern(300000));
+    std::filesystem::create_directories(local("tree"));
+
+    MockServerConfig config = server.config();
+    config.cut_downloads_after = 4096;
+    server.setConfig(config);
+    YandexDiskClient::SyncReport broken =
+            client->syncDirectory("/sync", local("tree"), direction(YandexDiskClient::SyncDirection::TwoWay));
+
+    EXPECT_FALSE(broken.ok());
+    EXPECT_FALSE(std::filesystem::exists(local("tree/data.bin")));
+    EXPECT_FALSE(std::filesystem::exists(local("tree/data.bin.part")));
+    EXPECT_TRUE(server.fileContent("/sync/data.bin") == pattern(300000));
+}
@@ -0,0 +1,255 @@
+// Compression and encryption stages: round trips, tampering and headers.
+#include "MockDiskFixture.h"
+#include "TransformPipeline.h"
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+    using Stage = YandexDiskClient::TransformStage;
+
+    constexpr std::size_t kChunk = 64 * 1024;
+
+    YandexDiskClient::TransformOptions transform(std::vector<Stage> stages, std::size_t threads = 4) {
+        YandexDiskClient::TransformOptions options;
+        options.stages = std::move(stages);
+        options.chunk_size = kChunk;
+        options.threads = threads;
+        return options;
+    }
+
+    /// Half text, half noise: compressible, but not trivially.
+    std::string sample(std::size_t size) {
+        std::string data(size / 2, '\0');
+        uint32_t state = 5;
+        for (char& c : data) {
+            state = state * 1664525u + 1013904223u;
+            c = static_cast<char>(state >> 24);
+        }
+        while (data.size() < size) data += "line of a log file, repeated often enough to compress\n";
+        data.resize(size);
+        return data;
+    }
+
+    std::string encode(const YandexDiskClient::TransformOptions& options, const std::string& plain) {
+        TransformBody body(std::make_shared<MemoryBody>(plain.data(), plain.size()), options);
+        std::string out;
+        char buffer[10000];
+        std::size_t n;
+        while ((n = body.read(buffer, sizeof(buffer))) > 0) out.append(buffer, n);
+        return out;
+    }
+
+    /// Fed in uneven pieces, as a network transfer would be.
+    std::string decode(const YandexDiskClient::TransformOptions& options, const std::string& encoded) {
+        std::ostringstream out;
+        StreamTarget stream(out);
+        TransformTarget target(stream, options);
+        for (std::size_t pos = 0; pos < encoded.size(); pos += 7777) {
+            target.write(encoded.data() + pos, std::min<std::size_t>(7777, encoded.size() - pos));
+        }
+        target.finish();
+        return out.str();
+    }
+
+    /// A transformed body split into its header and whole records.
+    struct Records {
+        std::string header;
+        std::vector<std::string> records;
+
+        Records(const YandexDiskClient::TransformOptions& options, const std::string& body) {
+            std::unique_ptr<ChunkCodec> codec;
+            std::size_t pos = ChunkCodec::parseHeader(options.stages, body.data(), body.size(), codec);
+            header = body.substr(0, pos);
+            while (pos < body.size()) {
+                uint32_t word = 0;
+                for (int i = 0; i < 4; ++i) word = (word << 8) | static_cast<unsigned char>(body[pos + i]);
+                std::size_t length = 4 + (word & 0x7fffffffu);
+                records.push_back(body.substr(pos, length));
+                pos += length;
+            }
+        }
+
+        std::string join() const {
+            std::string body = header;
+            for (const std::string& record : records) body += record;
+            return body;
+        }
+    };
+
+    std::string key(char fill) { return std::string(32, fill); }
+
+    void roundTrip(const YandexDiskClient::TransformOptions& options) {
+        for (std::size_t size : {std::size_t{0}, std::size_t{1}, kChunk, 5 * kChunk, 7 * kChunk + 123}) {
+            std::string plain = sample(size);
+            std::string encoded = encode(options, plain);
+            EXPECT_TRUE(decode(options, encoded) == plain) << "size " << size;
+            // One record per started chunk, plus the empty last one after a full chunk.
+            EXPECT_EQ(Records(options, encoded).records.size(), size / kChunk + 1) << "size " << size;
+        }
+    }
+}
+
+TEST(TransformPipelineTest, StageNeedsItsLibraryInTheBuild) {
+    std::vector<Stage> stages;
+#if !defined(YDISK_WITH_ZSTD)
+    stages.push_back(Stage::zstd());
+#endif
+#if !defined(YDISK_WITH_ZLIB)
+    stages.push_back(Stage::gzip());
+#endif
+#if !defined(YDISK_WITH_OPENSSL)
+    stages.push_back(Stage::aesGcm(key('k')));
+#endif
+    for (const Stage& stage : stages) {
+        EXPECT_THROW(ChunkCodec({stage}, kChunk), std::runtime_error);
+    }
+    EXPECT_THROW(Stage::aesGcm("short"), std::runtime_error);
+}
+
+TEST(TransformPipelineTest, RejectsABadHeader) {
+    std::vector<Stage> none;
+    std::unique_ptr<ChunkCodec> codec;
+    EXPECT_THROW(ChunkCodec::parseHeader(none, "NOPE", 4, codec), std::runtime_error);
+    // A prefix of the magic waits for more bytes.
+    EXPECT_EQ(ChunkCodec::parseHeader(none, "YDX", 3, codec), 0u);
+}
+
+#if defined(YDISK_WITH_ZSTD)
+TEST(TransformPipelineTest, ZstdRoundTrips) {
+    roundTrip(transform({Stage::zstd()}));
+    std::string plain = sample(8 * kChunk);
+    EXPECT_LT(encode(transform({Stage::zstd()}), plain).size(), plain.size());
+}
+
+TEST(TransformPipelineTest, RejectsAMismatchedHeader) {
+    auto options = transform({Stage::zstd()});
+    std::string good = encode(options, sample(kChunk));
+
+    std::string version = good;
+    version[4] = 9;
+    EXPECT_THROW(decode(options, version), std::runtime_error);
+
+    std::string chunk_size = good;
+    for (int i = 6; i < 10; ++i) chunk_size[i] = 0;
+    EXPECT_THROW(decode(options, chunk_size), std::runtime_error);
+
+    std::string magic = good;
+    magic[0] = 'X';
+    EXPECT_THROW(decode(options, magic), std::runtime_error);
+
+    EXPECT_THROW(decode(transform({Stage::zstd(), Stage::zstd()}), good), std::runtime_error);
+#if defined(YDISK_WITH_ZLIB)
+    EXPECT_THROW(decode(transform({Stage::gzip()}), good), std::runtime_error);
+#endif
+}
+
+TEST(TransformPipelineTest, TruncatedBodyIsRejected) {
+    auto options = transform({Stage::zstd()});
+    Records body(options, encode(options, sample(3 * kChunk + 10)));
+
+    Records missing_last = body;
+    missing_last.records.pop_back();
+    EXPECT_THROW(decode(options, missing_last.join()), std::runtime_error);
+
+    // A record cut short.
+    std::string cut = body.join();
+    cut.resize(cut.size() - 3);
+    EXPECT_THROW(decode(options, cut), std::runtime_error);
+
+    EXPECT_THROW(decode(options, body.header), std::runtime_error);
+    EXPECT_THROW(decode(options, body.join() + "tail"), std::runtime_error);
+}
+#endif
+
+#if defined(YDISK_WITH_ZLIB)
+TEST(TransformPipelineTest, GzipRoundTrips) {
+    roundTrip(transform({Stage::gzip()}));
+}
+#endif
+
+#if defined(YDISK_WITH_OPENSSL)
+TEST(TransformPipelineTest, AesGcmRoundTrips) {
+    roundTrip(transform({Stage::aesGcm(key('k'))}));
+    roundTrip(transform({Stage::aesGcm(key('k'))}, 1));
+
+    // Fresh nonces: the same plaintext never encrypts the same way twice.
+    auto options = transform({Stage::aesGcm(key('k'))});
+    std::string plain = sample(kChunk);
+    EXPECT_FALSE(encode(options, plain) == encode(options, plain));
+}
+
+TEST(TransformPipelineTest, WrongKeyIsRejected) {
+    std::string encoded = encode(transform({Stage::aesGcm(key('k'))}), sample(3 * kChunk));
+    EXPECT_THROW(decode(transform({Stage::aesGcm(key('x'))}), encoded), std::runtime_error);
+}
+
+TEST(TransformPipelineTest, TamperedCiphertextIsRejected) {
+    auto options = transform({Stage::aesGcm(key('k'))});
+    Records body(options, encode(options, sample(3 * kChunk + 10)));
+
+    Records flipped = body;
+    flipped.records[1][100] ^= 0x01;
+    EXPECT_THROW(decode(options, flipped.join()), std::runtime_error);
+
+    // The nonce base is authenticated with the records.
+    std::string nonce = body.join();
+    nonce[body.header.size() - 1] ^= 0x01;
+    EXPECT_THROW(decode(options, nonce), std::runtime_error);
+}
+
+TEST(TransformPipelineTest, ReorderedOrDuplicatedRecordsAreRejected) {
+    auto options = transform({Stage::aesGcm(key('k'))});
+    Records body(options, encode(options, sample(3 * kChunk + 10)));
+    ASSERT_EQ(body.records.size(), 4u);
+
+    Records swapped = body;
+    std::swap(swapped.records[0], swapped.records[1]);
+    EXPECT_THROW(decode(options, swapped.join()), std::runtime_error);
+
+    Records duplicated = body;
+    duplicated.records.insert(duplicated.records.begin() + 1, body.records[1]);
+    EXPECT_THROW(decode(options, duplicated.join()), std::runtime_error);
+
+    // Clearing the flag makes the last record claim more is to come, and
+    // setting it on an earlier one ends the body early: both fail to
+    // authenticate.
+    Records unflagged = body;
+    unflagged.records.back()[0] &= 0x7f;
+    EXPECT_THROW(decode(options, unflagged.join()), std::runtime_error);
+
+    Records early = body;
+    early.records.resize(2);
+    early.records.back()[0] |= static_cast<char>(0x80);
+    EXPECT_THROW(decode(options, early.join()), std::runtime_error);
+}
+#endif
+
+#if defined(YDISK_WITH_ZSTD) && defined(YDISK_WITH_ZLIB) && defined(YDISK_WITH_OPENSSL)
+TEST(TransformPipelineTest, ChainedStagesRoundTrip) {
+    roundTrip(transform({Stage::zstd(), Stage::gzip(), Stage::aesGcm(key('k'))}));
+    roundTrip(transform({Stage::aesGcm(key('k')), Stage::zstd()}, 8));
+}
+
+using TransformTransferTest = MockDiskTest;
+
+TEST_F(TransformTransferTest, StoresTheTransformedBodyAndReadsItBack) {
+    auto options = transform({Stage::zstd(), Stage::aesGcm(key('k'))});
+    std::string plain = sample(10 * kChunk + 321);
+
+    EXPECT_TRUE(client->uploadFile("/secret.bin", YandexDiskClient::UploadSource::memory(plain.data(), plain.size()),
+                                   options));
+    std::string stored = server.fileContent("/secret.bin");
+    EXPECT_EQ(stored.compare(0, 4, "YDXF"), 0);
+    EXPECT_EQ(stored.find("line of a log file"), std::string::npos);
+
+    std::string back(plain.size(), '\0');
+    EXPECT_EQ(client->downloadFile("/secret.bin", YandexDiskClient::DownloadSink::memory(&back[0], back.size()),
+                                   options),
+              plain.size());
+    EXPECT_TRUE(back == plain);
+
+    EXPECT_THROW(client->downloadFile("/secret.bin", YandexDiskClient::DownloadSink::memory(&back[0], back.size()),
+                                      transform({Stage::zstd(), Stage::aesGcm(key('x'))})),
+                 std::runtime_error);
+}
+#endif
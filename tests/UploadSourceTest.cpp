@@ -0,0 +1,51 @@
+// Upload bodies: files, caller buffers, producers, and files that shrink.
+#include "MockDiskFixture.h"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+using UploadSourceTest = MockDiskTest;
+
+TEST_F(UploadSourceTest, UploadsEveryKindOfSource) {
+    std::string content = pattern(3 * 1024 * 1024 + 17);
+    writeFile(local("data.bin"), content);
+
+    EXPECT_TRUE(client->uploadFile("/file.bin", YandexDiskClient::UploadSource::file(local("data.bin"))));
+    EXPECT_TRUE(client->uploadFile("/memory.bin",
+                                   YandexDiskClient::UploadSource::memory(content.data(), content.size())));
+
+    std::size_t offset = 0;
+    auto produce = [&](char* buffer, std::size_t capacity) {
+        std::size_t n = std::min(capacity, content.size() - offset);
+        std::memcpy(buffer, content.data() + offset, n);
+        offset += n;
+        return n;
+    };
+    EXPECT_TRUE(client->uploadFile("/producer.bin", YandexDiskClient::UploadSource::producer(produce)));
+
+    EXPECT_TRUE(server.fileContent("/file.bin") == content);
+    EXPECT_TRUE(server.fileContent("/memory.bin") == content);
+    EXPECT_TRUE(server.fileContent("/producer.bin") == content);
+}
+
+TEST_F(UploadSourceTest, EmptyFileUploads) {
+    writeFile(local("empty"), "");
+    EXPECT_TRUE(client->uploadFile("/", local("empty")));
+    EXPECT_TRUE(server.contains("/empty"));
+    EXPECT_EQ(server.fileContent("/empty"), "");
+}
+
+TEST_F(UploadSourceTest, FileTruncatedDuringPathUploadFailsOnlyThatTransfer) {
+    writeFile(local("growing.log"), pattern(16 * 1024 * 1024));
+    MockServerConfig config = server.config();
+    config.bandwidth_bytes_per_sec = 8 * 1024 * 1024;
+    server.setConfig(config);
+
+    std::thread rotate([path = local("growing.log")] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        std::filesystem::resize_file(path, 1024);
+    });
+    EXPECT_THROW(client->uploadFile("/", local("growing.log")), std::runtime_error);
+    rotate.join();
+    EXPECT_FALSE(server.contains("/growing.log"));
+}